@@ -426,7 +426,16 @@ parser_c::add_timecode(timestamp_c const &timecode) {
 
 void
 parser_c::add_bytes(memory_cptr const &mem) {
-  add_bytes(mem->get_buffer(), mem->get_size());
+  if (m_buffer.get_size() || !mem->is_free()) {
+    add_bytes(mem->get_buffer(), mem->get_size());
+    return;
+  }
+
+  // Nothing is buffered, and the memory owns its buffer: parse it
+  // directly so that the frames' payloads can be slices of it.
+  m_source                 = mem;
+  m_total_stream_position += mem->get_size();
+  parse();
 }
 
 void
@@ -564,7 +573,11 @@ parser_c::decode_adts_header(unsigned char const *buffer,
     if (frame.m_header.bytes <= frame.m_header.header_byte_size)
       return { failure, 1 };
 
-    if (m_copy_data) {
+    if (m_copy_data && m_source)
+      // ADTS headers always end on a byte boundary.
+      frame.m_data = memory_c::slice(m_source, buffer - m_source->get_buffer() + frame.m_header.header_byte_size, frame.m_header.data_byte_size);
+
+    else if (m_copy_data) {
       frame.m_data = memory_c::alloc(frame.m_header.data_byte_size);
       bc.get_bytes(frame.m_data->get_buffer(), frame.m_header.data_byte_size);
     }
@@ -700,14 +713,12 @@ parser_c::push_frame(frame_c &frame) {
 
 void
 parser_c::parse() {
-  if (m_abort_after_num_frames && (m_num_frames_found >= m_abort_after_num_frames))
-    return;
-
-  auto buffer      = m_fixed_buffer ? m_fixed_buffer      : m_buffer.get_buffer();
-  auto buffer_size = m_fixed_buffer ? m_fixed_buffer_size : m_buffer.get_size();
+  auto buffer      = m_fixed_buffer ? m_fixed_buffer      : m_source ? m_source->get_buffer() : m_buffer.get_buffer();
+  auto buffer_size = m_fixed_buffer ? m_fixed_buffer_size : m_source ? m_source->get_size()   : m_buffer.get_size();
   auto position    = 0u;
 
-  while (position < buffer_size) {
+  while (   (position < buffer_size)
+         && (!m_abort_after_num_frames || (m_num_frames_found < m_abort_after_num_frames))) {
     auto remaining_bytes = buffer_size - position;
     auto result          = decode_header(&buffer[position], remaining_bytes);
 
@@ -728,12 +739,13 @@ parser_c::parse() {
       if (!m_num_frames_found && m_require_frame_at_first_byte)
         break;
     }
-
-    if (m_abort_after_num_frames && (m_num_frames_found >= m_abort_after_num_frames))
-      break;
   }
 
-  if (!m_fixed_buffer)
+  if (m_source) {
+    m_buffer.add(buffer + position, buffer_size - position);
+    m_source.reset();
+
+  } else if (!m_fixed_buffer)
     m_buffer.remove(position);
 }
 
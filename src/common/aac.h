@@ -177,6 +177,7 @@ protected:
   byte_buffer_c m_buffer;
   unsigned char const *m_fixed_buffer;
   size_t m_fixed_buffer_size;
+  memory_cptr m_source;
   uint64_t m_parsed_stream_position, m_total_stream_position;
   size_t m_garbage_size, m_num_frames_found, m_abort_after_num_frames;
   bool m_require_frame_at_first_byte, m_copy_data;
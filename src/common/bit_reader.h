@@ -17,14 +17,20 @@
 
 #include "common/common_pch.h"
 
+#include "common/endian.h"
+#include "common/math.h"
 #include "common/mm_io_x.h"
 
+/* The bits not consumed yet are kept in a 64-bit cache, the first of
+   them in the most significant bit. The cache is refilled with whole
+   bytes only, and all bits below the valid ones are always zero. */
 class bit_reader_c {
 private:
   const unsigned char *m_end_of_data;
-  const unsigned char *m_byte_position;
+  const unsigned char *m_next_byte;
   const unsigned char *m_start_of_data;
-  std::size_t m_bits_valid;
+  uint64_t m_cache;
+  std::size_t m_cached_bits;
   bool m_out_of_data;
 
 public:
@@ -34,10 +40,11 @@ public:
 
   void init(const unsigned char *data, std::size_t len) {
     m_end_of_data   = data + len;
-    m_byte_position = data;
+    m_next_byte     = data;
     m_start_of_data = data;
-    m_bits_valid    = len ? 8 : 0;
-    m_out_of_data   = m_byte_position >= m_end_of_data;
+    m_cache         = 0;
+    m_cached_bits   = 0;
+    m_out_of_data   = !len;
   }
 
   bool eof() {
@@ -45,35 +52,26 @@ public:
   }
 
   uint64_t get_bits(std::size_t n) {
-    uint64_t r = 0;
-
-    while (n > 0) {
-      if (m_byte_position >= m_end_of_data) {
-        m_out_of_data = true;
-        throw mtx::mm_io::end_of_file_x();
-      }
-
-      std::size_t b = 8; // number of bits to extract from the current byte
-      if (b > n)
-        b = n;
-      if (b > m_bits_valid)
-        b = m_bits_valid;
-
-      std::size_t rshift = m_bits_valid - b;
-
-      r <<= b;
-      r  |= ((*m_byte_position) >> rshift) & (0xff >> (8 - b));
+    if (!n)
+      return 0;
 
-      m_bits_valid -= b;
-      if (0 == m_bits_valid) {
-        m_bits_valid     = 8;
-        m_byte_position += 1;
-      }
+    // refill() only guarantees 57 valid bits.
+    if (n > 57) {
+      auto high_bits = get_bits(n - 32);
+      return (high_bits << 32) | get_bits(32);
+    }
 
-      n -= b;
+    if (m_cached_bits < n) {
+      refill();
+      if (m_cached_bits < n)
+        throw_out_of_data();
     }
 
-    return r;
+    auto value     = m_cache >> (64 - n);
+    m_cache      <<= n;
+    m_cached_bits -= n;
+
+    return value;
   }
 
   inline int get_bit() {
@@ -97,14 +95,26 @@ public:
   }
 
   inline uint64_t get_unsigned_golomb() {
-    int n = 0;
+    std::size_t n = 0;
+
+    while (!m_cache) {
+      n             += m_cached_bits;
+      m_cached_bits  = 0;
+
+      refill();
+      if (!m_cached_bits)
+        throw_out_of_data();
+    }
 
-    while (get_bit() == 0)
-      ++n;
+    auto zeros     = mtx::math::count_leading_zeros(m_cache);
+    n             += zeros;
+    m_cache      <<= zeros;
+    m_cache      <<= 1;
+    m_cached_bits -= zeros + 1;
 
     auto bits = get_bits(n);
 
-    return (1u << n) - 1 + bits;
+    return (n < 64 ? (uint64_t{1} << n) - 1 : ~uint64_t{}) + bits;
   }
 
   inline int64_t get_signed_golomb() {
@@ -113,39 +123,12 @@ public:
   }
 
   uint64_t peek_bits(std::size_t n) {
-    uint64_t r                             = 0;
-    const unsigned char *tmp_byte_position = m_byte_position;
-    std::size_t tmp_bits_valid                  = m_bits_valid;
-
-    while (0 < n) {
-      if (tmp_byte_position >= m_end_of_data)
-        throw mtx::mm_io::end_of_file_x();
-
-      std::size_t b = 8; // number of bits to extract from the current byte
-      if (b > n)
-        b = n;
-      if (b > tmp_bits_valid)
-        b = tmp_bits_valid;
-
-      std::size_t rshift = tmp_bits_valid - b;
-
-      r <<= b;
-      r  |= ((*tmp_byte_position) >> rshift) & (0xff >> (8 - b));
-
-      tmp_bits_valid -= b;
-      if (0 == tmp_bits_valid) {
-        tmp_bits_valid     = 8;
-        tmp_byte_position += 1;
-      }
-
-      n -= b;
-    }
-
-    return r;
+    auto copy = *this;
+    return copy.get_bits(n);
   }
 
   void get_bytes(unsigned char *buf, std::size_t n) {
-    if (8 == m_bits_valid) {
+    if (0 == (m_cached_bits % 8)) {
       get_bytes_byte_aligned(buf, n);
       return;
     }
@@ -155,36 +138,40 @@ public:
   }
 
   void byte_align() {
-    if (8 != m_bits_valid)
-      skip_bits(m_bits_valid);
+    skip_cached_bits(m_cached_bits % 8);
   }
 
   void set_bit_position(std::size_t pos) {
-    if (pos > (static_cast<std::size_t>(m_end_of_data - m_start_of_data) * 8)) {
-      m_byte_position = m_end_of_data;
-      m_out_of_data   = true;
+    if (pos > (static_cast<std::size_t>(m_end_of_data - m_start_of_data) * 8))
+      throw_out_of_data();
 
-      throw mtx::mm_io::end_of_file_x();
-    }
+    m_next_byte   = m_start_of_data + (pos / 8);
+    m_cache       = 0;
+    m_cached_bits = 0;
 
-    m_byte_position = m_start_of_data + (pos / 8);
-    m_bits_valid    = 8 - (pos % 8);
+    if (pos % 8) {
+      refill();
+      skip_cached_bits(pos % 8);
+    }
   }
 
   int get_bit_position() const {
-    return (m_byte_position - m_start_of_data) * 8 + 8 - m_bits_valid;
+    return (m_next_byte - m_start_of_data) * 8 - m_cached_bits;
   }
 
   int get_remaining_bits() const {
-    return (m_end_of_data - m_byte_position) * 8 - 8 + m_bits_valid;
+    return (m_end_of_data - m_next_byte) * 8 + m_cached_bits;
   }
 
   void skip_bits(std::size_t num) {
-    set_bit_position(get_bit_position() + num);
+    if (num <= m_cached_bits)
+      skip_cached_bits(num);
+    else
+      set_bit_position(get_bit_position() + num);
   }
 
   void skip_bit() {
-    set_bit_position(get_bit_position() + 1);
+    skip_bits(1);
   }
 
   uint64_t skip_get_bits(std::size_t to_skip,
@@ -194,11 +181,53 @@ public:
   }
 
 protected:
+  void refill() {
+    if (m_cached_bits > 56)
+      return;
+
+    if ((m_end_of_data - m_next_byte) >= 8) {
+      auto num_bytes  = (64 - m_cached_bits) / 8;
+      auto num_bits   = m_cached_bits + num_bytes * 8;
+      m_cache        |= get_uint64_be(m_next_byte) >> m_cached_bits;
+      if (num_bits < 64)
+        m_cache      &= ~(~uint64_t{} >> num_bits);
+      m_cached_bits   = num_bits;
+      m_next_byte    += num_bytes;
+
+      return;
+    }
+
+    while ((m_cached_bits <= 56) && (m_next_byte < m_end_of_data)) {
+      m_cache       |= static_cast<uint64_t>(*m_next_byte) << (56 - m_cached_bits);
+      m_cached_bits += 8;
+      ++m_next_byte;
+    }
+  }
+
+  void skip_cached_bits(std::size_t num) {
+    m_cache        = num < 64 ? m_cache << num : 0;
+    m_cached_bits -= num;
+  }
+
+  void throw_out_of_data() {
+    m_next_byte   = m_end_of_data;
+    m_cache       = 0;
+    m_cached_bits = 0;
+    m_out_of_data = true;
+
+    throw mtx::mm_io::end_of_file_x();
+  }
+
   void get_bytes_byte_aligned(unsigned char *buf, std::size_t n) {
-    auto bytes_to_copy = std::min<std::size_t>(n, m_end_of_data - m_byte_position);
-    std::memcpy(buf, m_byte_position, bytes_to_copy);
+    // Hand the whole bytes still in the cache back to the buffer.
+    m_next_byte   -= m_cached_bits / 8;
+    m_cache        = 0;
+    m_cached_bits  = 0;
+
+    auto bytes_to_copy = std::min<std::size_t>(n, m_end_of_data - m_next_byte);
+    std::memcpy(buf, m_next_byte, bytes_to_copy);
 
-    m_byte_position += bytes_to_copy;
+    m_next_byte += bytes_to_copy;
 
     if (bytes_to_copy < n) {
       m_out_of_data = true;
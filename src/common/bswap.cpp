@@ -14,10 +14,173 @@
 #include <stdexcept>
 
 #include "common/bswap.h"
+#include "common/cpu_features.h"
 #include "common/endian.h"
 
+#if defined(MTX_CPU_X86_SIMD)
+# include <immintrin.h>
+#endif
+
+#if defined(MTX_CPU_ARM_NEON)
+# include <arm_neon.h>
+#endif
+
 namespace mtx {
 
+namespace {
+
+// All kernels process as many complete blocks as possible and return
+// the number of bytes they've swapped. The rest is left for the
+// scalar code.
+
+template<typename T, T (*Tswap)(T)>
+void
+bswap_words_scalar(unsigned char const *src,
+                   unsigned char *dst,
+                   std::size_t num_bytes) {
+  for (std::size_t idx = 0; idx < num_bytes; idx += sizeof(T))
+    mtx::endian::store(&dst[idx], Tswap(mtx::endian::load<T>(&src[idx])));
+}
+
+void
+bswap_buffer_scalar(unsigned char const *src,
+                    unsigned char *dst,
+                    std::size_t num_bytes,
+                    std::size_t word_length) {
+  if (2 == word_length)
+    bswap_words_scalar<uint16_t, bswap_16>(src, dst, num_bytes);
+
+  else if (4 == word_length)
+    bswap_words_scalar<uint32_t, bswap_32>(src, dst, num_bytes);
+
+  else if (8 == word_length)
+    bswap_words_scalar<uint64_t, bswap_64>(src, dst, num_bytes);
+
+  else if (3 == word_length) {
+    for (std::size_t idx = 0; idx < num_bytes; idx += 3) {
+      auto first   = src[idx];
+      dst[idx]     = src[idx + 2];
+      dst[idx + 1] = src[idx + 1];
+      dst[idx + 2] = first;
+    }
+
+  } else {
+    // Swapping pairs from the outside in works in place, too.
+    for (std::size_t idx = 0; idx < num_bytes; idx += word_length)
+      for (std::size_t lo = 0, hi = word_length - 1; lo <= hi; ++lo, --hi) {
+        auto byte         = src[idx + lo];
+        dst[idx + lo]     = src[idx + hi];
+        dst[idx + hi]     = byte;
+        if (!hi)
+          break;
+      }
+  }
+}
+
+#if defined(MTX_CPU_X86_SIMD)
+
+// Shuffle masks for pshufb. The one for three-byte words reverses five
+// words (15 bytes) and leaves the 16th byte where it is.
+alignas(16) unsigned char const s_shuffle_masks[4][16] = {
+  {  1,  0,  3,  2,  5,  4,  7,  6,  9,  8, 11, 10, 13, 12, 15, 14 },
+  {  2,  1,  0,  5,  4,  3,  8,  7,  6, 11, 10,  9, 14, 13, 12, 15 },
+  {  3,  2,  1,  0,  7,  6,  5,  4, 11, 10,  9,  8, 15, 14, 13, 12 },
+  {  7,  6,  5,  4,  3,  2,  1,  0, 15, 14, 13, 12, 11, 10,  9,  8 },
+};
+
+unsigned char const *
+shuffle_mask_for(std::size_t word_length) {
+  return 2 == word_length ? s_shuffle_masks[0]
+       : 3 == word_length ? s_shuffle_masks[1]
+       : 4 == word_length ? s_shuffle_masks[2]
+       :                    s_shuffle_masks[3];
+}
+
+__attribute__((target("ssse3")))
+std::size_t
+bswap_buffer_ssse3(unsigned char const *src,
+                   unsigned char *dst,
+                   std::size_t num_bytes,
+                   std::size_t word_length) {
+  auto mask   = _mm_load_si128(reinterpret_cast<__m128i const *>(shuffle_mask_for(word_length)));
+  auto step   = 3 == word_length ? 15u : 16u;
+  auto offset = std::size_t{};
+
+  // For three-byte words each block overlaps the next one by one
+  // byte. That byte is stored unchanged and overwritten with its
+  // swapped value by the next block; as its original value is written
+  // back, this works in place, too.
+  while ((num_bytes - offset) >= 16) {
+    auto block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + offset));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + offset), _mm_shuffle_epi8(block, mask));
+    offset += step;
+  }
+
+  return offset;
+}
+
+__attribute__((target("avx2")))
+std::size_t
+bswap_buffer_avx2(unsigned char const *src,
+                  unsigned char *dst,
+                  std::size_t num_bytes,
+                  std::size_t word_length) {
+  // vpshufb shuffles within each 128-bit lane, so the 16-byte mask is
+  // simply used for both lanes. Three-byte words are left to SSSE3 as
+  // they straddle the lanes.
+  auto mask   = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const *>(shuffle_mask_for(word_length))));
+  auto offset = std::size_t{};
+
+  while ((num_bytes - offset) >= 32) {
+    auto block = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + offset));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + offset), _mm256_shuffle_epi8(block, mask));
+    offset += 32;
+  }
+
+  return offset;
+}
+
+#endif  // defined(MTX_CPU_X86_SIMD)
+
+#if defined(MTX_CPU_ARM_NEON)
+
+std::size_t
+bswap_buffer_neon(unsigned char const *src,
+                  unsigned char *dst,
+                  std::size_t num_bytes,
+                  std::size_t word_length) {
+  auto offset = std::size_t{};
+
+  if (3 == word_length) {
+    // vld3 de-interleaves 16 words into one register per byte
+    // position; swapping the first and third register reverses all of
+    // them.
+    while ((num_bytes - offset) >= 48) {
+      auto words = vld3q_u8(src + offset);
+      std::swap(words.val[0], words.val[2]);
+      vst3q_u8(dst + offset, words);
+      offset += 48;
+    }
+
+    return offset;
+  }
+
+  while ((num_bytes - offset) >= 16) {
+    auto block = vld1q_u8(src + offset);
+    block      = 2 == word_length ? vrev16q_u8(block)
+               : 4 == word_length ? vrev32q_u8(block)
+               :                    vrev64q_u8(block);
+    vst1q_u8(dst + offset, block);
+    offset += 16;
+  }
+
+  return offset;
+}
+
+#endif  // defined(MTX_CPU_ARM_NEON)
+
+} // anonymous namespace
+
 void
 bswap_buffer(unsigned char const *src,
              unsigned char *dst,
@@ -26,8 +189,25 @@ bswap_buffer(unsigned char const *src,
   if ((num_bytes % word_length) != 0)
     throw std::invalid_argument((boost::format(Y("The number of bytes to swap isn't divisible by %1%.")) % word_length).str());
 
-  for (std::size_t idx = 0; idx < num_bytes; idx += word_length)
-    put_uint_le(&dst[idx], get_uint_be(&src[idx], word_length), word_length);
+  auto offset   = std::size_t{};
+  auto has_simd = (2 == word_length) || (3 == word_length) || (4 == word_length) || (8 == word_length);
+
+#if defined(MTX_CPU_X86_SIMD)
+  if (has_simd && (3 != word_length) && mtx::cpu::has(mtx::cpu::feature_e::avx2))
+    offset = bswap_buffer_avx2(src, dst, num_bytes, word_length);
+
+  if (has_simd && mtx::cpu::has(mtx::cpu::feature_e::ssse3))
+    offset += bswap_buffer_ssse3(src + offset, dst + offset, num_bytes - offset, word_length);
+#endif
+
+#if defined(MTX_CPU_ARM_NEON)
+  if (has_simd && mtx::cpu::has(mtx::cpu::feature_e::arm_neon))
+    offset = bswap_buffer_neon(src, dst, num_bytes, word_length);
+#endif
+
+  static_cast<void>(has_simd);
+
+  bswap_buffer_scalar(src + offset, dst + offset, num_bytes - offset, word_length);
 }
 
 }
@@ -19,6 +19,25 @@
 
 namespace mtx {
 
+#if defined(__GNUC__) || defined(__clang__)
+
+inline uint16_t
+bswap_16(uint16_t x) {
+  return __builtin_bswap16(x);
+}
+
+inline uint32_t
+bswap_32(uint32_t x) {
+  return __builtin_bswap32(x);
+}
+
+inline uint64_t
+bswap_64(uint64_t x) {
+  return __builtin_bswap64(x);
+}
+
+#else  // defined(__GNUC__) || defined(__clang__)
+
 inline uint16_t
 bswap_16(uint16_t x) {
   return (x >> 8) | (x << 8);
@@ -46,6 +65,12 @@ bswap_64(uint64_t x) {
   return r.ll;
 }
 
+#endif  // defined(__GNUC__) || defined(__clang__)
+
+// Reverses the order of the bytes in each word of 'word_length'
+// bytes. 'src' and 'dst' may be identical but must not overlap
+// otherwise. Words of two, three, four and eight bytes are swapped
+// with SIMD instructions if the CPU supports them.
 void bswap_buffer(unsigned char const *src, unsigned char *dst, std::size_t num_bytes, std::size_t word_length);
 
 }
@@ -18,10 +18,138 @@
 
 #include "common/bswap.h"
 #include "common/checksums/crc.h"
+#include "common/cpu_features.h"
 #include "common/endian.h"
 
+#if defined(MTX_CPU_X86_SIMD)
+# include <immintrin.h>
+#endif
+
+#if defined(MTX_CPU_ARM_CRC32)
+# include <arm_acle.h>
+#endif
+
 namespace mtx { namespace checksum {
 
+namespace {
+
+// Number of bytes processed per iteration of the table-driven
+// implementation. Each one needs its own table of 256 entries.
+unsigned int const s_num_slices = 16;
+
+// Compilers turn this into a single load on little-endian
+// architectures, unlike the out-of-line get_uint32_le().
+inline uint32_t
+load_uint32_le(unsigned char const *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+#if defined(MTX_CPU_X86_SIMD)
+
+// Folding constants for the reflected polynomial 0xEDB88320 as
+// described in Intel's paper "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction".
+alignas(16) uint64_t const s_pclmul_k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+alignas(16) uint64_t const s_pclmul_k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+alignas(16) uint64_t const s_pclmul_k5k0[] = { 0x0163cd6124, 0x0000000000 };
+alignas(16) uint64_t const s_pclmul_poly[] = { 0x01db710641, 0x01f7011641 };
+
+__attribute__((target("sse4.1,pclmul")))
+inline __m128i
+pclmul_load(unsigned char const *p) {
+  return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+}
+
+__attribute__((target("sse4.1,pclmul")))
+inline __m128i
+pclmul_fold(__m128i x,
+            __m128i k,
+            __m128i data) {
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), data), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+// size must be at least 64 and a multiple of 16.
+__attribute__((target("sse4.1,pclmul")))
+uint32_t
+crc32_ieee_le_pclmul(unsigned char const *buffer,
+                     size_t size,
+                     uint32_t crc) {
+  auto x1 = _mm_xor_si128(pclmul_load(buffer), _mm_cvtsi32_si128(crc));
+  auto x2 = pclmul_load(buffer + 16);
+  auto x3 = pclmul_load(buffer + 32);
+  auto x4 = pclmul_load(buffer + 48);
+  auto k  = _mm_load_si128(reinterpret_cast<__m128i const *>(s_pclmul_k1k2));
+
+  buffer += 64;
+  size   -= 64;
+
+  // Fold four 128-bit lanes in parallel…
+  while (size >= 64) {
+    x1 = pclmul_fold(x1, k, pclmul_load(buffer));
+    x2 = pclmul_fold(x2, k, pclmul_load(buffer + 16));
+    x3 = pclmul_fold(x3, k, pclmul_load(buffer + 32));
+    x4 = pclmul_fold(x4, k, pclmul_load(buffer + 48));
+
+    buffer += 64;
+    size   -= 64;
+  }
+
+  // …reduce them to a single one…
+  k  = _mm_load_si128(reinterpret_cast<__m128i const *>(s_pclmul_k3k4));
+  x1 = pclmul_fold(x1, k, x2);
+  x1 = pclmul_fold(x1, k, x3);
+  x1 = pclmul_fold(x1, k, x4);
+
+  // …and fold the remaining blocks into it.
+  while (size >= 16) {
+    x1 = pclmul_fold(x1, k, pclmul_load(buffer));
+
+    buffer += 16;
+    size   -= 16;
+  }
+
+  // 128 bits down to 64 bits
+  auto mask = _mm_setr_epi32(~0, 0, ~0, 0);
+  x2        = _mm_clmulepi64_si128(x1, k, 0x10);
+  x1        = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+  k         = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(s_pclmul_k5k0));
+  x2        = _mm_srli_si128(x1, 4);
+  x1        = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00), x2);
+
+  // Barrett reduction down to 32 bits
+  k         = _mm_load_si128(reinterpret_cast<__m128i const *>(s_pclmul_poly));
+  x2        = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+  x2        = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+  x1        = _mm_xor_si128(x1, x2);
+
+  return _mm_extract_epi32(x1, 1);
+}
+
+#endif  // defined(MTX_CPU_X86_SIMD)
+
+#if defined(MTX_CPU_ARM_CRC32)
+
+// The ARMv8 CRC32 instructions (not CRC32C) use the same reflected
+// polynomial 0xEDB88320.
+__attribute__((target("+crc")))
+uint32_t
+crc32_ieee_le_arm(unsigned char const *buffer,
+                  size_t size,
+                  uint32_t crc) {
+  for (; size >= 8; buffer += 8, size -= 8)
+    crc = __crc32d(crc, load_uint32_le(buffer) | (static_cast<uint64_t>(load_uint32_le(buffer + 4)) << 32));
+
+  for (; size > 0; ++buffer, --size)
+    crc = __crc32b(crc, *buffer);
+
+  return crc;
+}
+
+#endif  // defined(MTX_CPU_ARM_CRC32)
+
+} // anonymous namespace
+
 crc_base_c::table_parameters_t const crc_base_c::ms_table_parameters[5] = {
   { 0,  8,       0x07 },
   { 0, 16,     0x8005 },
@@ -57,7 +185,7 @@ crc_base_c::init_table() {
   if ((parameters.bits < 8) || (parameters.bits > 32) || (parameters.poly >= (1LL<<parameters.bits)))
     throw std::domain_error{"Invalid CRC parameters"};
 
-  m_table.resize(256);
+  m_table.resize(s_num_slices * 256);
 
   for (auto i = 0u; i < 256u; i++) {
     if (parameters.le) {
@@ -74,6 +202,13 @@ crc_base_c::init_table() {
     }
   }
 
+  // Table n contains the CRC of a byte followed by n zero bytes.
+  for (auto slice = 1u; slice < s_num_slices; ++slice)
+    for (auto i = 0u; i < 256u; i++) {
+      auto previous            = m_table[(slice - 1) * 256 + i];
+      m_table[slice * 256 + i] = m_table[previous & 0xff] ^ (previous >> 8);
+    }
+
   // for (auto row = 0u; row < (256u / 4); ++row)
   //   mxinfo(boost::format("0x%|1$08x| 0x%|2$08x| 0x%|3$08x| 0x%|4$08x|\n")
   //          % m_table[row * 4 + 0] % m_table[row * 4 + 1] % m_table[row * 4 + 2] % m_table[row * 4 + 3]);
@@ -127,12 +262,61 @@ crc_base_c::set_result_in_le(bool result_in_le) {
 void
 crc_base_c::add_impl(unsigned char const *buffer,
                      size_t size) {
-  auto end = buffer + size;
+  if (crc_32_ieee_le == m_type) {
+#if defined(MTX_CPU_X86_SIMD)
+    if ((size >= 64) && mtx::cpu::has(mtx::cpu::feature_e::pclmul)) {
+      auto num_bytes  = size & ~static_cast<size_t>(15);
+      m_crc           = crc32_ieee_le_pclmul(buffer, num_bytes, m_crc);
+      buffer         += num_bytes;
+      size           -= num_bytes;
+    }
+#endif
+
+#if defined(MTX_CPU_ARM_CRC32)
+    if (mtx::cpu::has(mtx::cpu::feature_e::arm_crc32)) {
+      m_crc = crc32_ieee_le_arm(buffer, size, m_crc);
+      return;
+    }
+#endif
+  }
+
+  add_sliced(buffer, size);
+}
+
+void
+crc_base_c::add_sliced(unsigned char const *buffer,
+                       size_t size) {
+  // Slicing-by-16: the bytes of each block are looked up
+  // independently of each other in tables for their distance to the
+  // end of the block.
+  auto crc   = m_crc;
+  auto table = m_table.data();
+  auto end   = buffer + size;
+
+  while ((end - buffer) >= static_cast<std::ptrdiff_t>(s_num_slices)) {
+    auto one   = load_uint32_le(buffer) ^ crc;
+    auto two   = load_uint32_le(buffer +  4);
+    auto three = load_uint32_le(buffer +  8);
+    auto four  = load_uint32_le(buffer + 12);
+
+    crc = table[15 * 256 + ( one          & 0xff)] ^ table[14 * 256 + ((one   >>  8) & 0xff)]
+        ^ table[13 * 256 + ((one   >> 16) & 0xff)] ^ table[12 * 256 + ( one   >> 24        )]
+        ^ table[11 * 256 + ( two          & 0xff)] ^ table[10 * 256 + ((two   >>  8) & 0xff)]
+        ^ table[ 9 * 256 + ((two   >> 16) & 0xff)] ^ table[ 8 * 256 + ( two   >> 24        )]
+        ^ table[ 7 * 256 + ( three        & 0xff)] ^ table[ 6 * 256 + ((three >>  8) & 0xff)]
+        ^ table[ 5 * 256 + ((three >> 16) & 0xff)] ^ table[ 4 * 256 + ( three >> 24        )]
+        ^ table[ 3 * 256 + ( four         & 0xff)] ^ table[ 2 * 256 + ((four  >>  8) & 0xff)]
+        ^ table[ 1 * 256 + ((four  >> 16) & 0xff)] ^ table[ 0 * 256 + ( four  >> 24        )];
+
+    buffer += s_num_slices;
+  }
 
   while (buffer < end) {
-    m_crc = m_table[(m_crc & 0xff) ^ *buffer] ^ (m_crc >> 8);
+    crc = table[(crc & 0xff) ^ *buffer] ^ (crc >> 8);
     ++buffer;
   }
+
+  m_crc = crc;
 }
 
 // ----------------------------------------------------------------------
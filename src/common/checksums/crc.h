@@ -63,6 +63,7 @@ public:
 
 protected:
   virtual void add_impl(unsigned char const *buffer, size_t size);
+  void add_sliced(unsigned char const *buffer, size_t size);
 
   virtual void set_initial_value_impl(uint64_t initial_value) ;
   virtual void set_initial_value_impl(unsigned char const *buffer, size_t size);
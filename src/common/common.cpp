@@ -28,6 +28,7 @@
 
 #include "common/fs_sys_helpers.h"
 #include "common/hacks.h"
+#include "common/memory_pool.h"
 #include "common/random.h"
 #include "common/stereo_mode.h"
 #include "common/strings/editing.h"
@@ -94,6 +95,7 @@ mtx_common_cleanup() {
 
   random_c::cleanup();
   mm_file_io_c::cleanup();
+  mtx::mem::pool_c::dump_statistics();
 
   matroska_done();
 }
@@ -62,7 +62,7 @@ header_removal_compressor_c::do_compress(memory_cptr const &buffer) {
                                              "Wanted bytes:%1%; found:%2%.")) % b_bytes % b_buffer);
   }
 
-  return memory_c::clone(buffer->get_buffer() + size, buffer->get_size() - size);
+  return memory_c::slice(buffer, size, buffer->get_size() - size);
 }
 
 void
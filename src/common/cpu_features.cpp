@@ -0,0 +1,71 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   run-time detection of CPU features
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/cpu_features.h"
+
+#if defined(MTX_CPU_ARM_CRC32)
+# include <asm/hwcap.h>
+# include <sys/auxv.h>
+#endif
+
+namespace mtx { namespace cpu {
+
+static bool s_simd_disabled = false;
+
+void
+disable_simd(bool disable) {
+  s_simd_disabled = disable;
+}
+
+bool
+has(feature_e feature) {
+  static debugging_option_c s_debug_no_simd{"no_simd"};
+
+  if (s_simd_disabled || s_debug_no_simd)
+    return false;
+
+#if defined(MTX_CPU_X86_SIMD)
+  static auto s_initialized = []() -> bool {
+    __builtin_cpu_init();
+    return true;
+  }();
+
+  static_cast<void>(s_initialized);
+
+  switch (feature) {
+    case feature_e::sse2:   return __builtin_cpu_supports("sse2");
+    case feature_e::ssse3:  return __builtin_cpu_supports("ssse3");
+    case feature_e::avx2:   return __builtin_cpu_supports("avx2");
+    case feature_e::pclmul: return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    default:                return false;
+  }
+#endif
+
+#if defined(MTX_CPU_ARM_CRC32)
+  if (feature_e::arm_crc32 == feature)
+    return getauxval(AT_HWCAP) & HWCAP_CRC32;
+#endif
+
+#if defined(MTX_CPU_ARM_NEON)
+  if (feature_e::arm_neon == feature)
+    return true;
+#endif
+
+  static_cast<void>(feature);
+
+  return false;
+}
+
+}}
@@ -0,0 +1,51 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   run-time detection of CPU features
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_CPU_FEATURES_H
+#define MTX_COMMON_CPU_FEATURES_H
+
+#include "common/common_pch.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+# define MTX_CPU_X86_SIMD 1
+#endif
+
+#if defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+# define MTX_CPU_ARM_CRC32 1
+#endif
+
+// NEON is mandatory on AArch64 and therefore not detected at run time.
+#if defined(__aarch64__) && defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+# define MTX_CPU_ARM_NEON 1
+#endif
+
+namespace mtx { namespace cpu {
+
+enum class feature_e {
+  sse2,
+  ssse3,
+  avx2,
+  pclmul,                       // PCLMULQDQ together with SSE4.1
+  arm_crc32,
+  arm_neon,
+};
+
+bool has(feature_e feature);
+
+// Used by the unit tests in order to exercise the scalar code paths,
+// too. Can also be turned on via the debugging option "no_simd".
+void disable_simd(bool disable);
+
+}}
+
+#endif // MTX_COMMON_CPU_FEATURES_H
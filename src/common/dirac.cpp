@@ -17,6 +17,7 @@
 #include "common/bit_reader.h"
 #include "common/dirac.h"
 #include "common/endian.h"
+#include "common/mpeg.h"
 
 #define MAX_STANDARD_VIDEO_FORMAT 23
 
@@ -224,79 +225,71 @@ dirac::es_parser_c::~es_parser_c() {
 void
 dirac::es_parser_c::add_bytes(unsigned char *buffer,
                               size_t size) {
-  memory_slice_cursor_c cursor;
-
   bool previous_found         = false;
   size_t previous_pos         = 0;
   int64_t previous_stream_pos = m_stream_pos;
 
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
+  m_unparsed_buffer.add(buffer, size);
 
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker = (1 << 24) | ((unsigned int)cursor.get_char() << 16) | ((unsigned int)cursor.get_char() << 8) | (unsigned int)cursor.get_char();
+  auto data       = m_unparsed_buffer.get_buffer();
+  auto data_size  = m_unparsed_buffer.get_size();
+  auto end        = data + data_size;
+  auto resume_pos = data_size >= 3 ? data_size - 3 : 0;
 
-    while (1) {
-      if (DIRAC_SYNC_WORD == marker) {
-        if (!previous_found) {
-          previous_found = true;
-          previous_pos   = cursor.get_position() - 4;
-          m_stream_pos   = previous_stream_pos + previous_pos;
+  // Everything before the scan offset has already been searched for
+  // sync words.
+  auto scan_offset = m_unparsed_scan_offset;
 
-          if (!cursor.char_available())
-            break;
+  if ((4 <= data_size) && (DIRAC_SYNC_WORD == get_uint32_be(data))) {
+    previous_found = true;
+    scan_offset    = std::max<std::size_t>(scan_offset, 4);
+  }
 
-          marker <<= 8;
-          marker  |= (unsigned int)cursor.get_char();
+  auto sync_word = mtx::mpeg::find_marker(data + std::min(scan_offset, data_size), end, DIRAC_SYNC_WORD);
 
-          continue;
-        }
+  while (sync_word != end) {
+    size_t sync_word_pos = sync_word - data;
 
-        unsigned char offset_buffer[4];
-        cursor.copy(offset_buffer, previous_pos + 4 + 1, 4);
-        uint32_t next_offset = get_uint32_be(offset_buffer);
+    if (!previous_found) {
+      previous_found = true;
+      previous_pos   = sync_word_pos;
+      m_stream_pos   = previous_stream_pos + previous_pos;
 
-        if ((0 == next_offset) || ((previous_pos + next_offset) <= (cursor.get_position() - 4))) {
-          int new_size = cursor.get_position() - 4 - previous_pos;
+    } else {
+      // The parse info header containing the offset to the next one
+      // must be complete.
+      if ((previous_pos + 4 + 1 + 4) > data_size) {
+        resume_pos = sync_word_pos;
+        break;
+      }
 
-          memory_cptr packet = memory_c::alloc(new_size);
-          cursor.copy(packet->get_buffer(), previous_pos, new_size);
+      uint32_t next_offset = get_uint32_be(data + previous_pos + 4 + 1);
 
-          handle_unit(packet);
+      if ((0 == next_offset) || ((previous_pos + next_offset) <= sync_word_pos)) {
+        handle_unit(memory_c::clone(data + previous_pos, sync_word_pos - previous_pos));
 
-          previous_pos = cursor.get_position() - 4;
-          m_stream_pos = previous_stream_pos + previous_pos;
-        }
+        previous_pos = sync_word_pos;
+        m_stream_pos = previous_stream_pos + previous_pos;
       }
-
-      if (!cursor.char_available())
-        break;
-
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
     }
-  }
 
-  unsigned int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    memory_cptr new_unparsed_buffer = memory_c::alloc(new_size);
-    cursor.copy(new_unparsed_buffer->get_buffer(), previous_pos, new_size);
-    m_unparsed_buffer = new_unparsed_buffer;
+    sync_word = mtx::mpeg::find_marker(sync_word + 4, end, DIRAC_SYNC_WORD);
+  }
 
-  } else
-    m_unparsed_buffer.reset();
+  m_unparsed_buffer.remove(previous_pos);
+  m_unparsed_scan_offset = std::max<std::size_t>(resume_pos - previous_pos, previous_found ? 1 : 0);
 }
 
 void
 dirac::es_parser_c::flush() {
-  if (m_unparsed_buffer && (4 <= m_unparsed_buffer->get_size())) {
-    uint32_t marker = get_uint32_be(m_unparsed_buffer->get_buffer());
+  if (4 <= m_unparsed_buffer.get_size()) {
+    uint32_t marker = get_uint32_be(m_unparsed_buffer.get_buffer());
     if (DIRAC_SYNC_WORD == marker)
-      handle_unit(memory_c::clone(m_unparsed_buffer->get_buffer(), m_unparsed_buffer->get_size()));
+      handle_unit(memory_c::clone(m_unparsed_buffer.get_buffer(), m_unparsed_buffer.get_size()));
   }
 
-  m_unparsed_buffer.reset();
+  m_unparsed_buffer.clear();
+  m_unparsed_scan_offset = 0;
 
   flush_frame();
 }
@@ -17,6 +17,8 @@
 
 #include "common/common_pch.h"
 
+#include "common/byte_buffer.h"
+
 #define DIRAC_SYNC_WORD            0x42424344 // 'BBCD'
 #define DIRAC_UNIT_SEQUENCE_HEADER 0x00
 #define DIRAC_UNIT_END_OF_SEQUENCE 0x10
@@ -77,7 +79,8 @@ namespace dirac {
     sequence_header_t m_seqhdr;
     memory_cptr m_raw_seqhdr;
 
-    memory_cptr m_unparsed_buffer;
+    byte_buffer_c m_unparsed_buffer;
+    std::size_t m_unparsed_scan_offset{};
 
     std::deque<memory_cptr> m_pre_frame_extra_data;
     std::deque<memory_cptr> m_post_frame_extra_data;
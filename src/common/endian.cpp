@@ -17,26 +17,6 @@
 
 #include "common/endian.h"
 
-uint16_t
-get_uint16_le(const void *buf) {
-  return get_uint_le(buf, 2);
-}
-
-uint32_t
-get_uint24_le(const void *buf) {
-  return get_uint_le(buf, 3);
-}
-
-uint32_t
-get_uint32_le(const void *buf) {
-  return get_uint_le(buf, 4);
-}
-
-uint64_t
-get_uint64_le(const void *buf) {
-  return get_uint_le(buf, 8);
-}
-
 uint64_t
 get_uint_le(const void *buf,
             int num_bytes) {
@@ -50,26 +30,6 @@ get_uint_le(const void *buf,
   return ret;
 }
 
-uint16_t
-get_uint16_be(const void *buf) {
-  return get_uint_be(buf, 2);
-}
-
-uint32_t
-get_uint24_be(const void *buf) {
-  return get_uint_be(buf, 3);
-}
-
-uint32_t
-get_uint32_be(const void *buf) {
-  return get_uint_be(buf, 4);
-}
-
-uint64_t
-get_uint64_be(const void *buf) {
-  return get_uint_be(buf, 8);
-}
-
 uint64_t
 get_uint_be(const void *buf,
             int num_bytes) {
@@ -108,51 +68,3 @@ put_uint_be(void *buf,
     value                  >>= 8;
   }
 }
-
-void
-put_uint16_le(void *buf,
-              uint16_t value) {
-  put_uint_le(buf, value, 2);
-}
-
-void
-put_uint24_le(void *buf,
-              uint32_t value) {
-  put_uint_le(buf, value, 3);
-}
-
-void
-put_uint32_le(void *buf,
-              uint32_t value) {
-  put_uint_le(buf, value, 4);
-}
-
-void
-put_uint64_le(void *buf,
-              uint64_t value) {
-  put_uint_le(buf, value, 8);
-}
-
-void
-put_uint16_be(void *buf,
-              uint16_t value) {
-  put_uint_be(buf, value, 2);
-}
-
-void
-put_uint24_be(void *buf,
-              uint32_t value) {
-  put_uint_be(buf, value, 3);
-}
-
-void
-put_uint32_be(void *buf,
-              uint32_t value) {
-  put_uint_be(buf, value, 4);
-}
-
-void
-put_uint64_be(void *buf,
-              uint64_t value) {
-  put_uint_be(buf, value, 8);
-}
@@ -16,26 +16,148 @@
 
 #include "common/common_pch.h"
 
+#include "common/bswap.h"
+
 #define get_fourcc(b) get_uint32_be(b)
-uint16_t get_uint16_le(const void *buf);
-uint32_t get_uint24_le(const void *buf);
-uint32_t get_uint32_le(const void *buf);
-uint64_t get_uint64_le(const void *buf);
+
 uint64_t get_uint_le(const void *buf, int max_bytes);
-uint16_t get_uint16_be(const void *buf);
-uint32_t get_uint24_be(const void *buf);
-uint32_t get_uint32_be(const void *buf);
-uint64_t get_uint64_be(const void *buf);
 uint64_t get_uint_be(const void *buf, int max_bytes);
 void put_uint_le(void *buf, uint64_t value, size_t num_bytes);
-void put_uint16_le(void *buf, uint16_t value);
-void put_uint24_le(void *buf, uint32_t value);
-void put_uint32_le(void *buf, uint32_t value);
-void put_uint64_le(void *buf, uint64_t value);
 void put_uint_be(void *buf, uint64_t value, size_t num_bytes);
-void put_uint16_be(void *buf, uint16_t value);
-void put_uint24_be(void *buf, uint32_t value);
-void put_uint32_be(void *buf, uint32_t value);
-void put_uint64_be(void *buf, uint64_t value);
+
+// The fixed-size variants are called for each sample or header field
+// and are therefore defined inline. memcpy() lets the compiler emit
+// single unaligned loads & stores.
+
+namespace mtx { namespace endian {
+
+template<typename T>
+inline T
+load(const void *buf) {
+  T value;
+  std::memcpy(&value, buf, sizeof(T));
+  return value;
+}
+
+template<typename T>
+inline void
+store(void *buf,
+      T value) {
+  std::memcpy(buf, &value, sizeof(T));
+}
+
+#if defined(ARCH_BIGENDIAN)
+inline uint16_t from_le(uint16_t value) { return mtx::bswap_16(value); }
+inline uint32_t from_le(uint32_t value) { return mtx::bswap_32(value); }
+inline uint64_t from_le(uint64_t value) { return mtx::bswap_64(value); }
+inline uint16_t from_be(uint16_t value) { return value; }
+inline uint32_t from_be(uint32_t value) { return value; }
+inline uint64_t from_be(uint64_t value) { return value; }
+#else
+inline uint16_t from_le(uint16_t value) { return value; }
+inline uint32_t from_le(uint32_t value) { return value; }
+inline uint64_t from_le(uint64_t value) { return value; }
+inline uint16_t from_be(uint16_t value) { return mtx::bswap_16(value); }
+inline uint32_t from_be(uint32_t value) { return mtx::bswap_32(value); }
+inline uint64_t from_be(uint64_t value) { return mtx::bswap_64(value); }
+#endif
+
+}}
+
+inline uint16_t
+get_uint16_le(const void *buf) {
+  return mtx::endian::from_le(mtx::endian::load<uint16_t>(buf));
+}
+
+inline uint32_t
+get_uint24_le(const void *buf) {
+  auto tmp = static_cast<unsigned char const *>(buf);
+  return tmp[0] | (tmp[1] << 8) | (static_cast<uint32_t>(tmp[2]) << 16);
+}
+
+inline uint32_t
+get_uint32_le(const void *buf) {
+  return mtx::endian::from_le(mtx::endian::load<uint32_t>(buf));
+}
+
+inline uint64_t
+get_uint64_le(const void *buf) {
+  return mtx::endian::from_le(mtx::endian::load<uint64_t>(buf));
+}
+
+inline uint16_t
+get_uint16_be(const void *buf) {
+  return mtx::endian::from_be(mtx::endian::load<uint16_t>(buf));
+}
+
+inline uint32_t
+get_uint24_be(const void *buf) {
+  auto tmp = static_cast<unsigned char const *>(buf);
+  return (static_cast<uint32_t>(tmp[0]) << 16) | (tmp[1] << 8) | tmp[2];
+}
+
+inline uint32_t
+get_uint32_be(const void *buf) {
+  return mtx::endian::from_be(mtx::endian::load<uint32_t>(buf));
+}
+
+inline uint64_t
+get_uint64_be(const void *buf) {
+  return mtx::endian::from_be(mtx::endian::load<uint64_t>(buf));
+}
+
+inline void
+put_uint16_le(void *buf,
+              uint16_t value) {
+  mtx::endian::store(buf, mtx::endian::from_le(value));
+}
+
+inline void
+put_uint24_le(void *buf,
+              uint32_t value) {
+  auto tmp = static_cast<unsigned char *>(buf);
+  tmp[0]   =  value        & 0xff;
+  tmp[1]   = (value >>  8) & 0xff;
+  tmp[2]   = (value >> 16) & 0xff;
+}
+
+inline void
+put_uint32_le(void *buf,
+              uint32_t value) {
+  mtx::endian::store(buf, mtx::endian::from_le(value));
+}
+
+inline void
+put_uint64_le(void *buf,
+              uint64_t value) {
+  mtx::endian::store(buf, mtx::endian::from_le(value));
+}
+
+inline void
+put_uint16_be(void *buf,
+              uint16_t value) {
+  mtx::endian::store(buf, mtx::endian::from_be(value));
+}
+
+inline void
+put_uint24_be(void *buf,
+              uint32_t value) {
+  auto tmp = static_cast<unsigned char *>(buf);
+  tmp[0]   = (value >> 16) & 0xff;
+  tmp[1]   = (value >>  8) & 0xff;
+  tmp[2]   =  value        & 0xff;
+}
+
+inline void
+put_uint32_be(void *buf,
+              uint32_t value) {
+  mtx::endian::store(buf, mtx::endian::from_be(value));
+}
+
+inline void
+put_uint64_be(void *buf,
+              uint64_t value) {
+  mtx::endian::store(buf, mtx::endian::from_be(value));
+}
 
 #endif  // MTX_COMMON_ENDIAN_H
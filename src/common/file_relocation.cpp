@@ -0,0 +1,276 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   moving data within a file towards its end
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <future>
+
+#if !defined(SYS_WINDOWS)
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <unistd.h>
+# if defined(SYS_LINUX)
+#  include <linux/falloc.h>
+#  include <sys/vfs.h>
+# endif
+#endif
+
+#include "common/at_scope_exit.h"
+#include "common/file_relocation.h"
+#include "common/locale.h"
+#include "common/mm_io.h"
+#include "common/mm_io_x.h"
+
+namespace mtx { namespace file {
+
+namespace {
+
+debugging_option_c s_debug{"file_relocation|rerender"};
+
+size_t const s_block_size = 16 * 1024 * 1024;
+
+#if !defined(SYS_WINDOWS)
+
+bool
+read_fully(int fd,
+           unsigned char *buffer,
+           size_t size,
+           uint64_t position) {
+  while (size) {
+    auto num_read = ::pread(fd, buffer, size, position);
+    if ((num_read < 0) && (EINTR == errno))
+      continue;
+    if (num_read <= 0)
+      return false;
+
+    buffer   += num_read;
+    size     -= num_read;
+    position += num_read;
+  }
+
+  return true;
+}
+
+bool
+write_fully(int fd,
+            unsigned char const *buffer,
+            size_t size,
+            uint64_t position) {
+  while (size) {
+    auto num_written = ::pwrite(fd, buffer, size, position);
+    if ((num_written < 0) && (EINTR == errno))
+      continue;
+    if (num_written <= 0)
+      return false;
+
+    buffer   += num_written;
+    size     -= num_written;
+    position += num_written;
+  }
+
+  return true;
+}
+
+#endif  // !defined(SYS_WINDOWS)
+
+#if defined(SYS_LINUX) && defined(FALLOC_FL_INSERT_RANGE)
+
+debugging_option_c s_debug_no_insert_range{"no_insert_range"};
+
+uint64_t
+get_insert_range_block_size(int fd) {
+  struct statfs fs_st;
+  struct stat st;
+
+  if (s_debug_no_insert_range || (0 != fstatfs(fd, &fs_st)) || (0 != fstat(fd, &st)))
+    return 0;
+
+  auto type = static_cast<uint32_t>(fs_st.f_type);
+
+  // Only these file systems support FALLOC_FL_INSERT_RANGE.
+  if (   (type != 0xef53u)       // ext4
+      && (type != 0x58465342u))  // XFS
+    return 0;
+
+  return st.st_blksize;
+}
+
+bool
+insert_range(int fd,
+             uint64_t position,
+             uint64_t size,
+             uint64_t distance) {
+  auto block_size = get_insert_range_block_size(fd);
+  if (!block_size || (distance % block_size))
+    return false;
+
+  // The file system only inserts whole blocks. Therefore the bytes
+  // between the start of the block and the requested position are
+  // moved, too, and have to be copied back afterwards.
+  auto aligned_position = position - (position % block_size);
+
+  if (0 != fallocate(fd, FALLOC_FL_INSERT_RANGE, aligned_position, distance)) {
+    mxdebug_if(s_debug, boost::format("file_relocation: inserting %1% bytes at %2% failed: %3%\n") % distance % aligned_position % std::strerror(errno));
+    return false;
+  }
+
+  auto num_head_bytes = position - aligned_position;
+  if (num_head_bytes) {
+    auto buffer = memory_c::alloc(num_head_bytes);
+
+    if (   !read_fully(fd,  buffer->get_buffer(), num_head_bytes, aligned_position + distance)
+        || !write_fully(fd, buffer->get_buffer(), num_head_bytes, aligned_position))
+      throw mtx::mm_io::read_write_x{mtx::mm_io::make_error_code()};
+  }
+
+  // The file had already been extended by the caller. Those bytes
+  // have been moved beyond the end of the data now.
+  if (0 != ftruncate(fd, position + size + distance))
+    throw mtx::mm_io::read_write_x{mtx::mm_io::make_error_code()};
+
+  mxdebug_if(s_debug, boost::format("file_relocation: inserted %1% bytes at %2% (block size %3%)\n") % distance % aligned_position % block_size);
+
+  return true;
+}
+
+#elif !defined(SYS_WINDOWS)
+
+bool
+insert_range(int,
+             uint64_t,
+             uint64_t,
+             uint64_t) {
+  return false;
+}
+
+#endif  // defined(SYS_LINUX) && defined(FALLOC_FL_INSERT_RANGE)
+
+#if !defined(SYS_WINDOWS)
+
+void
+copy_with_read_ahead(int fd,
+                     uint64_t position,
+                     uint64_t size,
+                     uint64_t distance) {
+  // Copying from back to front means that no block overwrites data
+  // that hasn't been read yet. The block being read in the background
+  // always lies before the block being written.
+  memory_cptr buffers[2] = { memory_c::alloc(std::min<uint64_t>(size, s_block_size)), memory_c::alloc(std::min<uint64_t>(size, s_block_size)) };
+  auto current           = 0u;
+  auto remaining         = size;
+  auto num_bytes         = std::min<uint64_t>(remaining, s_block_size);
+  auto source            = position + remaining - num_bytes;
+
+  auto read_block = [fd](unsigned char *buffer, size_t block_size, uint64_t block_position) {
+    return read_fully(fd, buffer, block_size, block_position);
+  };
+
+  auto pending = std::async(std::launch::async, read_block, buffers[current]->get_buffer(), num_bytes, source);
+
+  while (remaining) {
+    if (!pending.get())
+      throw mtx::mm_io::read_write_x{mtx::mm_io::make_error_code()};
+
+    auto current_num_bytes = num_bytes;
+    auto current_source    = source;
+    remaining             -= num_bytes;
+
+    if (remaining) {
+      num_bytes = std::min<uint64_t>(remaining, s_block_size);
+      source    = position + remaining - num_bytes;
+      pending   = std::async(std::launch::async, read_block, buffers[current ^ 1]->get_buffer(), num_bytes, source);
+    }
+
+    if (!write_fully(fd, buffers[current]->get_buffer(), current_num_bytes, current_source + distance))
+      throw mtx::mm_io::read_write_x{mtx::mm_io::make_error_code()};
+
+    current ^= 1;
+  }
+}
+
+#endif  // !defined(SYS_WINDOWS)
+
+void
+copy_sequentially(mm_io_c &file,
+                  uint64_t position,
+                  uint64_t size,
+                  uint64_t distance) {
+  auto buffer    = memory_c::alloc(std::min<uint64_t>(size, s_block_size));
+  auto remaining = size;
+
+  while (remaining) {
+    auto num_bytes = std::min<uint64_t>(remaining, s_block_size);
+    auto source    = position + remaining - num_bytes;
+
+    file.setFilePointer(source);
+    if (file.read(buffer->get_buffer(), num_bytes) != num_bytes)
+      throw mtx::mm_io::end_of_file_x{};
+
+    file.setFilePointer(source + distance);
+    file.write(buffer->get_buffer(), num_bytes);
+
+    remaining -= num_bytes;
+  }
+}
+
+} // anonymous namespace
+
+uint64_t
+get_insert_range_granularity(mm_io_c &file) {
+#if defined(SYS_LINUX) && defined(FALLOC_FL_INSERT_RANGE)
+  auto fd = ::open(g_cc_local_utf8->native(file.get_file_name()).c_str(), O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  auto close_fd = at_scope_exit_c{[fd]() { ::close(fd); }};
+
+  return get_insert_range_block_size(fd);
+
+#else
+  static_cast<void>(file);
+
+  return 0;
+#endif
+}
+
+void
+move_towards_end(mm_io_c &file,
+                 uint64_t position,
+                 uint64_t size,
+                 uint64_t distance) {
+  if (!size || !distance)
+    return;
+
+  mxdebug_if(s_debug, boost::format("file_relocation: moving %1% bytes at %2% by %3% in %4%\n") % size % position % distance % file.get_file_name());
+
+  file.flush();
+
+#if !defined(SYS_WINDOWS)
+  // Work on a descriptor of our own. That allows reading and writing
+  // at the same time without disturbing the file's own position.
+  auto fd = ::open(g_cc_local_utf8->native(file.get_file_name()).c_str(), O_RDWR);
+  if (fd >= 0) {
+    auto close_fd = at_scope_exit_c{[fd]() { ::close(fd); }};
+
+    if (!insert_range(fd, position, size, distance))
+      copy_with_read_ahead(fd, position, size, distance);
+
+    return;
+  }
+#endif
+
+  copy_sequentially(file, position, size, distance);
+}
+
+}}
@@ -0,0 +1,45 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   moving data within a file towards its end
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_FILE_RELOCATION_H
+#define MTX_COMMON_FILE_RELOCATION_H
+
+#include "common/common_pch.h"
+
+class mm_io_c;
+
+namespace mtx { namespace file {
+
+/* Moves the 'size' bytes starting at 'position' towards the end of the
+   file by 'distance' bytes. The file must already have been extended
+   to at least 'position + size + distance' bytes. The content of the
+   'distance' bytes starting at 'position' is undefined afterwards.
+
+   The file system is asked to insert the space if possible, which
+   requires 'distance' to be a multiple of its block size. Otherwise
+   the data is copied from back to front in large blocks, reading the
+   next block while writing the current one.
+
+   Throws mtx::mm_io::exception on errors.
+*/
+void move_towards_end(mm_io_c &file, uint64_t position, uint64_t size, uint64_t distance);
+
+/* Returns the block size the file system inserts space in, or 0 if
+   the file system cannot insert space into files. Moving data by a
+   multiple of it avoids copying the data.
+*/
+uint64_t get_insert_range_granularity(mm_io_c &file);
+
+}}
+
+#endif // MTX_COMMON_FILE_RELOCATION_H
@@ -60,6 +60,19 @@ get_application_data_folder() {
   return bfs::path{home} / ".config" / "mkvtoolnix";
 }
 
+bfs::path
+get_cache_folder() {
+  auto xdg_cache_home = getenv("XDG_CACHE_HOME");
+  if (xdg_cache_home)
+    return bfs::path{xdg_cache_home} / "mkvtoolnix";
+
+  auto home = getenv("HOME");
+  if (!home)
+    return bfs::path{};
+
+  return bfs::path{home} / ".cache" / "mkvtoolnix";
+}
+
 std::string
 get_environment_variable(std::string const &key) {
   auto var = getenv(key.c_str());
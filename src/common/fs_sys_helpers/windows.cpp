@@ -86,6 +86,16 @@ get_application_data_folder() {
   return bfs::path{};
 }
 
+bfs::path
+get_cache_folder() {
+  wchar_t szPath[MAX_PATH];
+
+  if (SUCCEEDED(SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE, nullptr, 0, szPath)))
+    return bfs::path{to_utf8(std::wstring(szPath))} / "mkvtoolnix" / "cache";
+
+  return bfs::path{};
+}
+
 int
 system(std::string const &command) {
   std::wstring wcommand = to_wide(command);
@@ -43,6 +43,12 @@ static const struct {
   { ENGAGE_KEEP_LAST_CHAPTER_IN_MPLS,    "keep_last_chapter_in_mpls"    },
   { ENGAGE_KEEP_TRACK_STATISTICS_TAGS,   "keep_track_statistics_tags"   },
   { ENGAGE_ALL_I_SLICES_ARE_KEY_FRAMES,  "all_i_slices_are_key_frames"  },
+  { ENGAGE_PARALLEL_READING,             "parallel_reading"             },
+  { ENGAGE_SPILL_CUES_TO_DISK,           "spill_cues_to_disk"           },
+  { ENGAGE_PARALLEL_NALU_PROCESSING,     "parallel_nalu_processing"     },
+  { ENGAGE_PREDICT_HEADER_GROWTH,        "predict_header_growth"        },
+  { ENGAGE_NO_ASYNC_WRITING,             "no_async_writing"             },
+  { ENGAGE_MMAP_INPUT,                   "mmap_input"                   },
   { 0,                                   nullptr },
 };
 static std::vector<bool> s_engaged_hacks(ENGAGE_MAX_IDX + 1, false);
@@ -40,7 +40,13 @@
 #define ENGAGE_KEEP_LAST_CHAPTER_IN_MPLS    19
 #define ENGAGE_KEEP_TRACK_STATISTICS_TAGS   20
 #define ENGAGE_ALL_I_SLICES_ARE_KEY_FRAMES  21
-#define ENGAGE_MAX_IDX                      21
+#define ENGAGE_PARALLEL_READING             22
+#define ENGAGE_SPILL_CUES_TO_DISK           23
+#define ENGAGE_PARALLEL_NALU_PROCESSING     24
+#define ENGAGE_PREDICT_HEADER_GROWTH        25
+#define ENGAGE_NO_ASYNC_WRITING             26
+#define ENGAGE_MMAP_INPUT                   27
+#define ENGAGE_MAX_IDX                      27
 
 void engage_hacks(const std::string &hacks);
 void engage_hack(unsigned int id);
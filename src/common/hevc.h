@@ -16,6 +16,7 @@
 
 #include "common/common_pch.h"
 
+#include "common/byte_buffer.h"
 #include "common/math.h"
 
 #define NALU_START_CODE 0x00000001
@@ -454,7 +455,8 @@ protected:
   user_data_t m_user_data;
   codec_private_t m_codec_private;
 
-  memory_cptr m_unparsed_buffer;
+  byte_buffer_c m_unparsed_buffer;
+  std::size_t m_unparsed_scan_offset{};
   uint64_t m_stream_position, m_parsed_position;
 
   frame_t m_incomplete_frame;
@@ -0,0 +1,446 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   Matroska cluster parser working directly on the cluster's data
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/endian.h"
+#include "common/kax_cluster_parser.h"
+#include "common/list_utils.h"
+
+namespace {
+
+// Cluster children
+uint32_t const s_id_cluster_timestamp  = 0xe7;
+uint32_t const s_id_silent_tracks      = 0x5854;
+uint32_t const s_id_position           = 0xa7;
+uint32_t const s_id_prev_size          = 0xab;
+uint32_t const s_id_simple_block       = 0xa3;
+uint32_t const s_id_block_group        = 0xa0;
+
+// Block group children
+uint32_t const s_id_block              = 0xa1;
+uint32_t const s_id_block_additions    = 0x75a1;
+uint32_t const s_id_block_duration     = 0x9b;
+uint32_t const s_id_reference_priority = 0xfa;
+uint32_t const s_id_reference_block    = 0xfb;
+uint32_t const s_id_codec_state        = 0xa4;
+uint32_t const s_id_discard_padding    = 0x75a2;
+uint32_t const s_id_slices             = 0x8e;
+
+// Block additions children
+uint32_t const s_id_block_more         = 0xa6;
+uint32_t const s_id_block_add_id       = 0xee;
+uint32_t const s_id_block_additional   = 0xa5;
+
+// Global elements
+uint32_t const s_id_void               = 0xec;
+uint32_t const s_id_crc32              = 0xbf;
+
+unsigned int const s_lacing_none       = 0;
+unsigned int const s_lacing_xiph       = 1;
+unsigned int const s_lacing_fixed      = 2;
+unsigned int const s_lacing_ebml       = 3;
+
+unsigned int
+vint_length(unsigned char first_byte,
+            unsigned int max_length) {
+  for (auto length = 1u; length <= max_length; ++length)
+    if (first_byte & (0x80 >> (length - 1)))
+      return length;
+
+  return 0;
+}
+
+bool
+read_vint(unsigned char const *data,
+          size_t &pos,
+          size_t end,
+          uint64_t &value,
+          unsigned int &length) {
+  if (pos >= end)
+    return false;
+
+  length = vint_length(data[pos], 8);
+  if (!length || ((pos + length) > end))
+    return false;
+
+  value = data[pos] & (0xff >> length);
+  for (auto idx = 1u; idx < length; ++idx)
+    value = (value << 8) | data[pos + idx];
+
+  pos += length;
+
+  return true;
+}
+
+bool
+is_global_element(uint32_t id) {
+  return (s_id_void == id) || (s_id_crc32 == id);
+}
+
+uint64_t
+read_uint(unsigned char const *data,
+          size_t size) {
+  return size ? get_uint_be(data, size) : 0;
+}
+
+int64_t
+read_int(unsigned char const *data,
+         size_t size) {
+  if (!size)
+    return 0;
+
+  auto value = get_uint_be(data, size);
+  if ((size < 8) && (data[0] & 0x80))
+    value |= ~uint64_t{} << (size * 8);
+
+  return static_cast<int64_t>(value);
+}
+
+}
+
+void
+kax_cluster_parser_c::block_t::reset(bool simple_block) {
+  track_number    = 0;
+  timestamp       = 0;
+  is_simple_block = simple_block;
+  is_keyframe     = false;
+  is_discardable  = false;
+
+  frames.clear();
+  duration.reset();
+  references.clear();
+  codec_state.reset();
+  discard_padding.reset();
+  additions.clear();
+}
+
+bool
+kax_cluster_parser_c::read_element_head(size_t &pos,
+                                        size_t end,
+                                        uint32_t &id,
+                                        size_t &size)
+  const {
+  if (pos >= end)
+    return false;
+
+  auto id_length = vint_length(m_data[pos], 4);
+  if (!id_length || ((pos + id_length) > end))
+    return false;
+
+  id = get_uint_be(&m_data[pos], id_length);
+  pos += id_length;
+
+  auto value  = uint64_t{};
+  auto length = 0u;
+  if (!read_vint(m_data, pos, end, value, length))
+    return false;
+
+  // All bits set means "unknown size". Such elements are left to
+  // libmatroska.
+  if (value == (~uint64_t{} >> (64 - 7 * length)))
+    return false;
+
+  if (value > (end - pos))
+    return false;
+
+  size = value;
+
+  return true;
+}
+
+kax_cluster_parser_c::block_t &
+kax_cluster_parser_c::add_block(bool simple_block) {
+  if (m_num_blocks == m_blocks.size())
+    m_blocks.emplace_back();
+
+  auto &block = m_blocks[m_num_blocks++];
+  block.reset(simple_block);
+
+  return block;
+}
+
+bool
+kax_cluster_parser_c::parse(memory_cptr const &payload,
+                            int64_t timestamp_scale) {
+  m_payload    = payload;
+  m_data       = payload->get_buffer();
+  m_num_blocks = 0;
+  m_timestamp  = 0;
+
+  auto pos = size_t{};
+  auto end = payload->get_size();
+
+  while (pos < end) {
+    auto id   = uint32_t{};
+    auto size = size_t{};
+
+    if (!read_element_head(pos, end, id, size))
+      return false;
+
+    if (s_id_cluster_timestamp == id) {
+      if (size > 8)
+        return false;
+      m_timestamp = read_uint(&m_data[pos], size);
+
+    } else if (s_id_simple_block == id) {
+      if (!parse_block(pos, size, add_block(true)))
+        return false;
+
+    } else if (s_id_block_group == id) {
+      if (!parse_block_group(pos, size))
+        return false;
+
+    } else if (!mtx::included_in(id, s_id_silent_tracks, s_id_position, s_id_prev_size) && !is_global_element(id))
+      return false;
+
+    pos += size;
+  }
+
+  // The cluster timestamp may come after the blocks. Only now can the
+  // blocks' timestamps be made absolute.
+  for (auto idx = 0u; idx < m_num_blocks; ++idx) {
+    auto &block     = m_blocks[idx];
+    block.timestamp = (static_cast<int64_t>(m_timestamp) + block.timestamp) * timestamp_scale;
+  }
+
+  return true;
+}
+
+bool
+kax_cluster_parser_c::parse_block(size_t pos,
+                                  size_t size,
+                                  block_t &block) {
+  auto end    = pos + size;
+  auto length = 0u;
+
+  if (!read_vint(m_data, pos, end, block.track_number, length) || ((pos + 3) > end))
+    return false;
+
+  auto flags           = m_data[pos + 2];
+  auto lacing          = (flags >> 1) & 0x03;
+  block.timestamp      = static_cast<int16_t>(get_uint16_be(&m_data[pos]));
+  block.is_keyframe    = block.is_simple_block && (flags & 0x80);
+  block.is_discardable = block.is_simple_block && (flags & 0x01);
+  pos                 += 3;
+
+  if (s_lacing_none == lacing) {
+    block.frames.emplace_back(memory_c::slice(m_payload, pos, end - pos));
+    return true;
+  }
+
+  if (pos >= end)
+    return false;
+
+  auto num_frames = static_cast<size_t>(m_data[pos]) + 1;
+  ++pos;
+
+  if (!parse_lace_sizes(lacing, pos, end, num_frames))
+    return false;
+
+  for (auto frame_size : m_lace_sizes) {
+    block.frames.emplace_back(memory_c::slice(m_payload, pos, frame_size));
+    pos += frame_size;
+  }
+
+  return true;
+}
+
+bool
+kax_cluster_parser_c::parse_lace_sizes(unsigned int lacing,
+                                       size_t &pos,
+                                       size_t end,
+                                       size_t num_frames) {
+  m_lace_sizes.clear();
+
+  auto total = uint64_t{};
+
+  if (s_lacing_xiph == lacing) {
+    for (auto idx = 1u; idx < num_frames; ++idx) {
+      auto frame_size = uint64_t{};
+      auto byte       = 0u;
+
+      do {
+        if (pos >= end)
+          return false;
+
+        byte        = m_data[pos++];
+        frame_size += byte;
+      } while (0xff == byte);
+
+      m_lace_sizes.push_back(frame_size);
+      total += frame_size;
+    }
+
+  } else if ((s_lacing_ebml == lacing) && (1 < num_frames)) {
+    auto frame_size = uint64_t{};
+    auto length     = 0u;
+
+    if (!read_vint(m_data, pos, end, frame_size, length))
+      return false;
+
+    m_lace_sizes.push_back(frame_size);
+    total = frame_size;
+
+    for (auto idx = 2u; idx < num_frames; ++idx) {
+      auto value = uint64_t{};
+      if (!read_vint(m_data, pos, end, value, length))
+        return false;
+
+      // Differences to the previous size are stored as signed values
+      // shifted into the unsigned range.
+      auto difference  = static_cast<int64_t>(value) - ((int64_t{1} << (7 * length - 1)) - 1);
+      auto signed_size = static_cast<int64_t>(frame_size) + difference;
+      if (signed_size < 0)
+        return false;
+
+      frame_size = signed_size;
+      m_lace_sizes.push_back(frame_size);
+      total += frame_size;
+    }
+
+  } else if (s_lacing_fixed == lacing) {
+    if ((end - pos) % num_frames)
+      return false;
+
+    auto frame_size = (end - pos) / num_frames;
+    m_lace_sizes.assign(num_frames - 1, frame_size);
+    total = frame_size * (num_frames - 1);
+  }
+
+  if (total > (end - pos))
+    return false;
+
+  m_lace_sizes.push_back((end - pos) - total);
+
+  return true;
+}
+
+bool
+kax_cluster_parser_c::parse_block_group(size_t pos,
+                                        size_t size) {
+  auto &block    = add_block(false);
+  auto end       = pos + size;
+  auto has_block = false;
+
+  while (pos < end) {
+    auto id         = uint32_t{};
+    auto child_size = size_t{};
+
+    if (!read_element_head(pos, end, id, child_size))
+      return false;
+
+    if (s_id_block == id) {
+      if (has_block || !parse_block(pos, child_size, block))
+        return false;
+      has_block = true;
+
+    } else if (s_id_block_duration == id) {
+      if (child_size > 8)
+        return false;
+      block.duration = read_uint(&m_data[pos], child_size);
+
+    } else if (s_id_reference_block == id) {
+      if (child_size > 8)
+        return false;
+      block.references.push_back(read_int(&m_data[pos], child_size));
+
+    } else if (s_id_discard_padding == id) {
+      if (child_size > 8)
+        return false;
+      block.discard_padding = read_int(&m_data[pos], child_size);
+
+    } else if (s_id_codec_state == id)
+      block.codec_state = memory_c::slice(m_payload, pos, child_size);
+
+    else if (s_id_block_additions == id) {
+      if (!parse_block_additions(pos, child_size, block))
+        return false;
+
+    } else if (!mtx::included_in(id, s_id_reference_priority, s_id_slices) && !is_global_element(id))
+      return false;
+
+    pos += child_size;
+  }
+
+  // libmatroska's path ignores block groups without a block, too.
+  if (!has_block)
+    --m_num_blocks;
+
+  return true;
+}
+
+bool
+kax_cluster_parser_c::parse_block_additions(size_t pos,
+                                            size_t size,
+                                            block_t &block) {
+  auto end = pos + size;
+
+  while (pos < end) {
+    auto id         = uint32_t{};
+    auto child_size = size_t{};
+
+    if (!read_element_head(pos, end, id, child_size))
+      return false;
+
+    if (s_id_block_more == id) {
+      auto more_pos   = pos;
+      auto more_end   = pos + child_size;
+      auto additional = memory_cptr{};
+
+      while (more_pos < more_end) {
+        auto more_id   = uint32_t{};
+        auto more_size = size_t{};
+
+        if (!read_element_head(more_pos, more_end, more_id, more_size))
+          return false;
+
+        if (s_id_block_additional == more_id) {
+          if (!additional)
+            additional = memory_c::slice(m_payload, more_pos, more_size);
+
+        } else if ((s_id_block_add_id != more_id) && !is_global_element(more_id))
+          return false;
+
+        more_pos += more_size;
+      }
+
+      // Same as libmatroska: a missing BlockAdditional is an empty one.
+      block.additions.emplace_back(additional ? additional : memory_c::alloc(0));
+
+    } else if (!is_global_element(id))
+      return false;
+
+    pos += child_size;
+  }
+
+  return true;
+}
+
+uint64_t
+kax_cluster_parser_c::get_timestamp()
+  const {
+  return m_timestamp;
+}
+
+size_t
+kax_cluster_parser_c::get_num_blocks()
+  const {
+  return m_num_blocks;
+}
+
+kax_cluster_parser_c::block_t const &
+kax_cluster_parser_c::get_block(size_t idx)
+  const {
+  return m_blocks[idx];
+}
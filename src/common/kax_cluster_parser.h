@@ -0,0 +1,77 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   Matroska cluster parser working directly on the cluster's data
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_KAX_CLUSTER_PARSER_H
+#define MTX_COMMON_KAX_CLUSTER_PARSER_H
+
+#include "common/common_pch.h"
+
+#include <boost/optional.hpp>
+
+/* Parses the content of a cluster without building libmatroska's
+   element tree. Frames, codec states and block additions are slices
+   of the cluster's buffer. The storage for the blocks is re-used from
+   one cluster to the next.
+
+   Only the elements mkvmerge actually uses are supported. parse()
+   returns false for anything else, e.g. BlockVirtual or
+   EncryptedBlock, for clusters with elements of unknown size and for
+   damaged data. The caller must then fall back to reading the cluster
+   with libmatroska.
+*/
+class kax_cluster_parser_c {
+public:
+  struct block_t {
+    uint64_t track_number{};
+    int64_t timestamp{};            // global timestamp in ns
+    bool is_simple_block{}, is_keyframe{}, is_discardable{};
+    std::vector<memory_cptr> frames;
+
+    // The following are only set for blocks in block groups.
+    boost::optional<uint64_t> duration; // in timestamp scale units
+    std::vector<int64_t> references;    // in timestamp scale units
+    memory_cptr codec_state;
+    boost::optional<int64_t> discard_padding;
+    std::vector<memory_cptr> additions;
+
+    void reset(bool simple_block);
+  };
+
+protected:
+  std::vector<block_t> m_blocks;
+  std::vector<uint64_t> m_lace_sizes;
+  size_t m_num_blocks{};
+  uint64_t m_timestamp{};
+
+  memory_cptr m_payload;
+  unsigned char const *m_data{};
+
+public:
+  bool parse(memory_cptr const &payload, int64_t timestamp_scale);
+
+  uint64_t get_timestamp() const;
+  size_t get_num_blocks() const;
+  block_t const &get_block(size_t idx) const;
+
+protected:
+  block_t &add_block(bool simple_block);
+
+  bool parse_block(size_t pos, size_t size, block_t &block);
+  bool parse_block_group(size_t pos, size_t size);
+  bool parse_block_additions(size_t pos, size_t size, block_t &block);
+  bool parse_lace_sizes(unsigned int lacing, size_t &pos, size_t end, size_t num_frames);
+
+  bool read_element_head(size_t &pos, size_t end, uint32_t &id, size_t &size) const;
+};
+
+#endif // MTX_COMMON_KAX_CLUSTER_PARSER_H
@@ -25,6 +25,11 @@
 #include "common/mm_io_x.h"
 #include "common/strings/formatting.h"
 
+// Larger clusters are left to libmatroska. A damaged size field must
+// not make read_next_cluster_payload() read gigabytes into memory
+// before the content turns out to be invalid.
+#define MAX_CLUSTER_PAYLOAD_SIZE (64 * 1024 * 1024)
+
 kax_file_c::kax_file_c(mm_io_c &in)
   : m_in(in)
   , m_resynced{}
@@ -297,6 +302,50 @@ kax_file_c::read_next_cluster() {
   return static_cast<KaxCluster *>(read_next_level1_element(EBML_ID_VALUE(EBML_ID(KaxCluster))));
 }
 
+/** \brief Read the content of the cluster at the current position
+
+   This only succeeds if a cluster with a known size of at most
+   MAX_CLUSTER_PAYLOAD_SIZE bytes starts right at the current position
+   and ends within the segment. The content is
+   returned without being parsed. Otherwise the position is left
+   unchanged and an empty pointer is returned; read_next_cluster()
+   must be used in that case as it handles all the other situations
+   including re-syncing after damaged parts.
+*/
+memory_cptr
+kax_file_c::read_next_cluster_payload() {
+  auto start_pos = m_in.getFilePointer();
+  auto end_pos   = m_segment_end ? m_segment_end : m_file_size;
+
+  if (start_pos >= end_pos)
+    return {};
+
+  try {
+    auto id = vint_c::read_ebml_id(m_in);
+    if (id.is_valid() && (EBML_ID_VALUE(EBML_ID(KaxCluster)) == id.m_value)) {
+      auto size = vint_c::read(m_in);
+
+      if (   size.is_valid()
+          && !size.is_unknown()
+          && (size.m_value <= MAX_CLUSTER_PAYLOAD_SIZE)
+          && ((m_in.getFilePointer() + size.m_value) <= end_pos)) {
+        auto payload = m_in.read_slice(size.m_value);
+
+        m_resynced         = false;
+        m_resync_start_pos = 0;
+
+        return payload;
+      }
+    }
+
+  } catch (mtx::mm_io::exception &) {
+  }
+
+  m_in.setFilePointer(start_pos);
+
+  return {};
+}
+
 bool
 kax_file_c::was_resynced() const {
   return m_resynced;
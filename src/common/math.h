@@ -31,6 +31,19 @@ count_1_bits(uint64_t value) {
 #endif
 }
 
+// Number of zero bits above the most significant set bit. value must
+// not be 0.
+inline unsigned int
+count_leading_zeros(uint64_t value) {
+#if defined(COMP_MSC)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return 63 - index;
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
 uint64_t round_to_nearest_pow2(uint64_t value);
 int int_log2(uint64_t value);
 double int_to_double(int64_t value);
@@ -16,6 +16,54 @@
 #include "common/memory.h"
 #include "common/error.h"
 
+memory_c::counter *
+memory_c::counter::create(size_t s) {
+  static_assert(sizeof(counter) <= header_size, "memory_c::counter::header_size is too small");
+
+  size_t capacity{};
+  auto block = mtx::mem::pool_c::allocate(header_size + s, capacity);
+
+  if (!block)
+    return new counter(static_cast<unsigned char *>(safemalloc(s)), s, true);
+
+  auto c      = new (block) counter(nullptr, s, true);
+  c->ptr      = c->block_buffer();
+  c->capacity = capacity - header_size;
+
+  return c;
+}
+
+memory_c::counter *
+memory_c::counter::create_view(unsigned char *p,
+                               size_t s) {
+  // Views only need the counter itself, not a buffer.
+  size_t capacity{};
+  auto block = mtx::mem::pool_c::allocate(header_size, capacity);
+
+  if (!block)
+    return new counter(p, s, false);
+
+  auto c      = new (block) counter(p, s, false);
+  c->capacity = capacity - header_size;
+
+  return c;
+}
+
+void
+memory_c::counter::destroy(counter *c) {
+  if (c->is_free && !c->uses_block())
+    free(c->ptr);
+
+  if (!c->capacity) {
+    delete c;
+    return;
+  }
+
+  auto capacity = c->capacity;
+  c->~counter();
+  mtx::mem::pool_c::release(c, header_size + capacity);
+}
+
 void
 memory_c::resize(size_t new_size)
   throw()
@@ -26,7 +74,23 @@ memory_c::resize(size_t new_size)
   if (new_size == its_counter->size)
     return;
 
-  if (its_counter->is_free) {
+  if (its_counter->uses_block()) {
+    // Stay within the block if possible; otherwise move the content
+    // to a buffer of its own. The block itself stays allocated as
+    // long as the counter is in use.
+    auto full_size = new_size + its_counter->offset;
+
+    if (full_size <= its_counter->capacity)
+      its_counter->size = full_size;
+
+    else {
+      auto tmp = static_cast<unsigned char *>(safemalloc(full_size));
+      memcpy(tmp, its_counter->ptr, std::min(full_size, its_counter->size));
+      its_counter->ptr  = tmp;
+      its_counter->size = full_size;
+    }
+
+  } else if (its_counter->is_free) {
     its_counter->ptr  = (unsigned char *)saferealloc(its_counter->ptr, new_size + its_counter->offset);
     its_counter->size = new_size + its_counter->offset;
 
@@ -36,9 +100,53 @@ memory_c::resize(size_t new_size)
     its_counter->ptr     = tmp;
     its_counter->is_free = true;
     its_counter->size    = new_size;
+    its_counter->offset  = 0;
+    m_backing.reset();
   }
 }
 
+/** \brief Create a view on a part of another buffer
+
+   The slice has its own offset and size but shares the bytes with
+   \c backing; nothing is copied. It keeps \c backing alive for as
+   long as it exists. Slices of slices refer to the original buffer
+   directly.
+
+   The backing buffer must not be resized while slices of it exist.
+*/
+memory_cptr
+memory_c::slice(memory_cptr const &backing,
+                size_t offset,
+                size_t size) {
+  if (!backing || ((offset + size) > backing->get_size()))
+    throw false;
+
+  auto mem         = std::make_shared<memory_c>();
+  mem->its_counter = counter::create_view(backing->get_buffer() + offset, size);
+  mem->m_backing   = backing->is_slice() ? backing->m_backing : backing;
+
+  return mem;
+}
+
+/** \brief Manage a buffer that has to be released in a special way
+
+   The buffer, e.g. a memory mapping, is released by calling \c
+   release once the returned memory_c is destroyed. Slices of it keep
+   it alive; therefore memory_c::grab() doesn't copy them.
+*/
+memory_cptr
+memory_c::take_ownership(void *buffer,
+                         size_t size,
+                         std::function<void()> const &release) {
+  auto mem = memory_cptr{new memory_c(buffer, size, false), [release](memory_c *m) {
+      delete m;
+      release();
+    }};
+  mem->m_released_by_deleter = true;
+
+  return mem;
+}
+
 void
 memory_c::add(unsigned char const *new_buffer,
               size_t new_size) {
@@ -118,7 +226,7 @@ unlace_memory_xiph(memory_cptr &buffer) {
     if ((ptr + sizes[i]) > end)
       throw mtx::mem::lacing_x("End-of-buffer while assigning the blocks");
 
-    blocks.push_back(memory_cptr(new memory_c(ptr, sizes[i], false)));
+    blocks.push_back(memory_c::slice(buffer, ptr - buffer->get_buffer(), sizes[i]));
     ptr += sizes[i];
   }
 
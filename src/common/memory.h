@@ -16,9 +16,11 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
 #include <deque>
 
 #include "common/error.h"
+#include "common/memory_pool.h"
 
 namespace mtx {
   namespace mem {
@@ -95,7 +97,7 @@ public:
   }
 
   explicit memory_c(size_t s)
-    : its_counter(new counter(static_cast<unsigned char *>(safemalloc(s)), s, true))
+    : its_counter(counter::create(s))
   {
   }
 
@@ -103,7 +105,9 @@ public:
     release();
   }
 
-  memory_c(const memory_c &r) throw() {
+  memory_c(const memory_c &r) throw()
+    : m_backing(r.m_backing)
+  {
     acquire(r.its_counter);
   }
 
@@ -111,6 +115,7 @@ public:
     if (this != &r) {
       release();
       acquire(r.its_counter);
+      m_backing = r.m_backing;
     }
     return *this;
   }
@@ -150,19 +155,44 @@ public:
     return its_counter && its_counter->is_free;
   }
 
+  bool is_slice() const {
+    return its_counter && !its_counter->is_free && m_backing;
+  }
+
+  // Whether or not the buffer stays valid for as long as this
+  // memory_c exists.
+  bool owns_buffer() const {
+    return is_free() || m_released_by_deleter;
+  }
+
   void grab() {
-    if (!its_counter || its_counter->is_free)
+    // A slice of a buffer that is owned by its backing memory_c
+    // doesn't have to be copied; the slice keeps the backing alive.
+    if (!its_counter || its_counter->is_free || (is_slice() && m_backing->owns_buffer()))
       return;
 
     its_counter->ptr      = static_cast<unsigned char *>(safememdup(get_buffer(), get_size()));
     its_counter->is_free  = true;
     its_counter->size    -= its_counter->offset;
     its_counter->offset   = 0;
+    m_backing.reset();
   }
 
   void lock() {
-    if (its_counter)
-      its_counter->is_free = false;
+    if (!its_counter)
+      return;
+
+    // Whoever takes over the buffer will free() it. Neither blocks
+    // from the pool nor slices of other buffers can be handed over,
+    // therefore copy their content.
+    if (its_counter->uses_block() || is_slice()) {
+      its_counter->ptr     = static_cast<unsigned char *>(safememdup(get_buffer(), get_size()));
+      its_counter->size   -= its_counter->offset;
+      its_counter->offset  = 0;
+      m_backing.reset();
+    }
+
+    its_counter->is_free = false;
   }
 
   void resize(size_t new_size) throw();
@@ -180,13 +210,19 @@ public:
 public:
   static memory_cptr
   alloc(size_t size) {
-    return memory_cptr(new memory_c(static_cast<unsigned char *>(safemalloc(size)), size, true));
+    return std::make_shared<memory_c>(size);
   };
 
   static inline memory_cptr
   clone(const void *buffer,
         size_t size) {
-    return memory_cptr(new memory_c(static_cast<unsigned char *>(safememdup(buffer, size)), size, true));
+    if (!buffer)
+      return std::make_shared<memory_c>();
+
+    auto mem = std::make_shared<memory_c>(size);
+    std::memcpy(mem->get_buffer(), buffer, size);
+
+    return mem;
   }
 
   static inline memory_cptr
@@ -199,13 +235,22 @@ public:
     return std::make_shared<memory_c>(reinterpret_cast<unsigned char *>(&buffer[0]), buffer.length(), false);
   }
 
+  static memory_cptr slice(memory_cptr const &backing, size_t offset, size_t size);
+  static memory_cptr take_ownership(void *buffer, size_t size, std::function<void()> const &release);
+
 private:
+  // Counters for buffers allocated by memory_c itself live at the
+  // start of a block from mtx::mem::pool_c. The buffer follows the
+  // counter; 'capacity' is its usable size. Copies of a memory_c
+  // share the counter and may be released in different threads,
+  // e.g. with the "parallel_reading" hack engaged.
   struct counter {
     unsigned char *ptr;
     size_t size;
     bool is_free;
-    unsigned count;
+    std::atomic<unsigned> count;
     size_t offset;
+    size_t capacity;
 
     counter(unsigned char *p = nullptr,
             size_t s = 0,
@@ -216,9 +261,32 @@ private:
       , is_free(f)
       , count(c)
       , offset(0)
+      , capacity(0)
     { }
+
+    static size_t const header_size = (sizeof(size_t) * 6 + 15) & ~static_cast<size_t>(15);
+
+    unsigned char *block_buffer() {
+      return reinterpret_cast<unsigned char *>(this) + header_size;
+    }
+
+    bool uses_block() {
+      return capacity && (ptr == block_buffer());
+    }
+
+    static counter *create(size_t s);
+    static counter *create_view(unsigned char *p, size_t s);
+    static void destroy(counter *c);
   } *its_counter;
 
+  // Set for slices only: the memory_c whose buffer the slice points
+  // into. Holding it keeps that buffer alive.
+  memory_cptr m_backing;
+
+  // Set by take_ownership(): the buffer is released once this
+  // memory_c is destroyed.
+  bool m_released_by_deleter{};
+
   void acquire(counter *c) throw() { // increment the count
     its_counter = c;
     if (c)
@@ -227,11 +295,8 @@ private:
 
   void release() { // decrement the count, delete if it is 0
     if (its_counter) {
-      if (--its_counter->count == 0) {
-        if (its_counter->is_free)
-          free(its_counter->ptr);
-        delete its_counter;
-      }
+      if (--its_counter->count == 0)
+        counter::destroy(its_counter);
       its_counter = 0;
     }
   }
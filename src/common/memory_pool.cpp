@@ -0,0 +1,227 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   size-classed pool of memory blocks backing memory_c
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "common/memory_pool.h"
+
+namespace mtx { namespace mem {
+
+namespace {
+
+std::size_t const s_min_bits        = 6;                // 64 bytes
+std::size_t const s_max_bits        = 22;               // 4 MiB
+std::size_t const s_num_classes     = 1 + (s_max_bits - s_min_bits) * 4;
+std::size_t const s_max_cached_size = 16 * 1024 * 1024; // per size class
+std::size_t const s_max_total_size  = 64 * 1024 * 1024; // all size classes
+
+struct size_class_t {
+  std::mutex mutex;
+  std::vector<void *> free_blocks;
+};
+
+struct statistics_t {
+  std::atomic<uint64_t> num_allocated{}, num_reused{}, num_too_large{}, num_released{}, num_freed{};
+  std::atomic<uint64_t> cached_size{}, max_cached_size{};
+};
+
+struct pool_t {
+  size_class_t classes[s_num_classes];
+  statistics_t stats;
+
+  ~pool_t();
+
+  void release_cached_blocks();
+};
+
+// Blocks released during global destruction after the pool itself
+// has been destroyed are simply freed.
+bool s_pool_destroyed = false;
+
+pool_t &
+pool() {
+  static pool_t s_pool;
+  return s_pool;
+}
+
+pool_t::~pool_t() {
+  release_cached_blocks();
+
+  s_pool_destroyed = true;
+}
+
+std::size_t
+highest_bit(std::size_t value) {
+  auto bit = std::size_t{};
+  while (value >>= 1)
+    ++bit;
+
+  return bit;
+}
+
+// Returns s_num_classes if the size is too large.
+std::size_t
+class_for_size(std::size_t size,
+               std::size_t &capacity) {
+  if (size <= (std::size_t{1} << s_min_bits)) {
+    capacity = std::size_t{1} << s_min_bits;
+    return 0;
+  }
+
+  // With 2^bits <= size - 1 < 2^(bits + 1) the quarter steps between
+  // both powers of two are the size classes.
+  auto bits = highest_bit(size - 1);
+  if (bits >= s_max_bits)
+    return s_num_classes;
+
+  auto quarter = (size - 1) >> (bits - 2); // 4…7
+  capacity     = (quarter + 1) << (bits - 2);
+
+  return 1 + (bits - s_min_bits) * 4 + (quarter - 4);
+}
+
+std::size_t
+capacity_for_class(std::size_t idx) {
+  if (!idx)
+    return std::size_t{1} << s_min_bits;
+
+  auto bits    = s_min_bits + (idx - 1) / 4;
+  auto quarter = 4 + (idx - 1) % 4;
+
+  return (quarter + 1) << (bits - 2);
+}
+
+void
+update_max(std::atomic<uint64_t> &max,
+           uint64_t value) {
+  auto current = max.load();
+  while ((current < value) && !max.compare_exchange_weak(current, value))
+    ;
+}
+
+void
+pool_t::release_cached_blocks() {
+  for (auto idx = std::size_t{}; idx < s_num_classes; ++idx) {
+    auto &size_class = classes[idx];
+
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+
+    for (auto block : size_class.free_blocks)
+      std::free(block);
+
+    stats.num_freed   += size_class.free_blocks.size();
+    stats.cached_size -= size_class.free_blocks.size() * capacity_for_class(idx);
+
+    size_class.free_blocks.clear();
+  }
+}
+
+} // anonymous namespace
+
+void *
+pool_c::allocate(std::size_t size,
+                 std::size_t &capacity) {
+  if (s_pool_destroyed)
+    return nullptr;
+
+  auto idx = class_for_size(size, capacity);
+  if (idx == s_num_classes) {
+    ++pool().stats.num_too_large;
+    return nullptr;
+  }
+
+  auto &p          = pool();
+  auto &size_class = p.classes[idx];
+
+  {
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+
+    if (!size_class.free_blocks.empty()) {
+      auto block = size_class.free_blocks.back();
+      size_class.free_blocks.pop_back();
+
+      ++p.stats.num_reused;
+      p.stats.cached_size -= capacity;
+
+      return block;
+    }
+  }
+
+  ++p.stats.num_allocated;
+
+  return safemalloc(capacity);
+}
+
+void
+pool_c::release(void *block,
+                std::size_t capacity) {
+  if (s_pool_destroyed) {
+    std::free(block);
+    return;
+  }
+
+  auto &p          = pool();
+  auto actual      = std::size_t{};
+  auto &size_class = p.classes[class_for_size(capacity, actual)];
+
+  {
+    std::lock_guard<std::mutex> lock{size_class.mutex};
+
+    if (((size_class.free_blocks.size() + 1) * capacity) <= s_max_cached_size) {
+      auto cached_size = p.stats.cached_size += capacity;
+
+      if (cached_size <= s_max_total_size) {
+        size_class.free_blocks.push_back(block);
+
+        ++p.stats.num_released;
+        update_max(p.stats.max_cached_size, cached_size);
+
+        return;
+      }
+
+      p.stats.cached_size -= capacity;
+    }
+  }
+
+  ++p.stats.num_freed;
+  std::free(block);
+}
+
+void
+pool_c::release_cached_blocks() {
+  if (!s_pool_destroyed)
+    pool().release_cached_blocks();
+}
+
+uint64_t
+pool_c::get_cached_size() {
+  return s_pool_destroyed ? 0 : pool().stats.cached_size.load();
+}
+
+void
+pool_c::dump_statistics() {
+  static debugging_option_c s_debug{"memory_pool"};
+
+  if (!s_debug)
+    return;
+
+  auto &stats = pool().stats;
+
+  mxdebug(boost::format("memory_pool: blocks allocated: %1% re-used: %2% too large for pooling: %3% released to the pool: %4% freed: %5%; currently cached: %6% bytes, at most: %7% bytes\n")
+          % stats.num_allocated % stats.num_reused % stats.num_too_large % stats.num_released % stats.num_freed % stats.cached_size % stats.max_cached_size);
+}
+
+}}
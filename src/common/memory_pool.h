@@ -0,0 +1,44 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   size-classed pool of memory blocks backing memory_c
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_MEMORY_POOL_H
+#define MTX_COMMON_MEMORY_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mtx { namespace mem {
+
+/* Blocks are rounded up to one of four size classes per power of two
+   (e.g. 1024, 1280, 1536, 1792, 2048 bytes). Released blocks are kept
+   per size class for re-use up to a certain amount of memory per
+   class and in total. All functions are thread-safe.
+*/
+class pool_c {
+public:
+  // Returns nullptr if the size is too large for being pooled. The
+  // usable size of the block is stored in 'capacity'.
+  static void *allocate(std::size_t size, std::size_t &capacity);
+  static void release(void *block, std::size_t capacity);
+
+  // Frees all blocks currently kept for re-use, e.g. once muxing is
+  // done.
+  static void release_cached_blocks();
+  static uint64_t get_cached_size();
+
+  static void dump_statistics();
+};
+
+}}
+
+#endif  // MTX_COMMON_MEMORY_POOL_H
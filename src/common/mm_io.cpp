@@ -129,6 +129,12 @@ mm_file_io_c::clear_eof() {
   clearerr(static_cast<FILE *>(m_file));
 }
 
+void
+mm_file_io_c::flush() {
+  if (m_file)
+    fflush(static_cast<FILE *>(m_file));
+}
+
 int
 mm_file_io_c::truncate(int64_t pos) {
   m_cached_size = -1;
@@ -291,6 +297,18 @@ mm_io_c::read(size_t size) {
   return buffer;
 }
 
+/** \brief Read data without copying it if possible
+
+   Classes that can hand out their data without copying it, e.g.
+   mm_mmap_io_c, return slices of their own buffers. All others
+   read into a new buffer. Throws mtx::mm_io::end_of_file_x if
+   fewer than \c size bytes are available.
+*/
+memory_cptr
+mm_io_c::read_slice(size_t size) {
+  return read(size);
+}
+
 uint32_t
 mm_io_c::read(void *buffer,
               size_t size) {
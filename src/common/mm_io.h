@@ -49,6 +49,7 @@ public:
   virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning) = 0;
   virtual bool setFilePointer2(int64 offset, seek_mode mode = seek_beginning);
   virtual memory_cptr read(size_t size);
+  virtual memory_cptr read_slice(size_t size);
   virtual uint32 read(void *buffer, size_t size);
   virtual uint32_t read(std::string &buffer, size_t size, size_t offset = 0);
   virtual uint32_t read(memory_cptr &buffer, size_t size, int offset = 0);
@@ -143,6 +144,9 @@ public:
   virtual void close();
   virtual bool eof();
   virtual void clear_eof();
+#if !defined(SYS_WINDOWS)
+  virtual void flush();
+#endif
 
   virtual std::string get_file_name() const {
     return m_file_name;
@@ -0,0 +1,259 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   IO callback class implementation
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#if !defined(SYS_WINDOWS)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <unistd.h>
+# if defined(SYS_LINUX)
+#  include <sys/vfs.h>
+# endif
+#endif
+
+#include "common/at_scope_exit.h"
+#include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
+
+namespace {
+
+// The kernel is asked to read this much ahead of the current
+// position.
+uint64_t const s_advice_window     = 8 * 1024 * 1024;
+
+// Seeks further away than this count as random access. After a
+// couple of them the kernel's read-ahead is reset to normal.
+uint64_t const s_far_seek_distance = 1024 * 1024;
+unsigned int const s_max_far_seeks = 8;
+
+#if defined(SYS_LINUX)
+bool
+on_network_file_system(int fd) {
+  // Pages of files on network file systems can vanish under our
+  // feet. Accessing them results in SIGBUS instead of a read error.
+  struct statfs st;
+  if (fstatfs(fd, &st) != 0)
+    return true;
+
+  auto type = static_cast<uint32_t>(st.f_type);
+
+  return (type == 0x6969u)      // NFS
+      || (type == 0x517bu)      // SMB
+      || (type == 0xff534d42u)  // CIFS
+      || (type == 0xfe534d42u)  // SMB2
+      || (type == 0x65735546u); // FUSE
+}
+#else
+bool
+on_network_file_system(int) {
+  return false;
+}
+#endif
+
+}
+
+mm_mmap_io_c::mm_mmap_io_c(std::string const &file_name)
+  : m_file_name{file_name}
+  , m_data{}
+  , m_size{}
+  , m_pos{}
+  , m_advised_from{}
+  , m_advised_to{}
+  , m_num_far_seeks{}
+  , m_eof{}
+  , m_sequential{true}
+  , m_debug{"mmap_io"}
+{
+#if defined(SYS_WINDOWS)
+  throw mtx::mm_io::open_x{};
+
+#else
+  auto fd = ::open(g_cc_local_utf8->native(file_name).c_str(), O_RDONLY);
+  if (-1 == fd)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  auto close_fd = at_scope_exit_c{[fd]() { ::close(fd); }};
+
+  // Pipes, devices and empty files cannot be mapped.
+  struct stat st;
+  if (   (0 != fstat(fd, &st))
+      || !S_ISREG(st.st_mode)
+      || (0 == st.st_size)
+      || (static_cast<uint64_t>(st.st_size) > std::numeric_limits<size_t>::max())
+      || on_network_file_system(fd))
+    throw mtx::mm_io::open_x{};
+
+  auto size = static_cast<size_t>(st.st_size);
+  auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (MAP_FAILED == data)
+    throw mtx::mm_io::open_x{mtx::mm_io::make_error_code()};
+
+  m_data    = static_cast<unsigned char *>(data);
+  m_size    = size;
+  m_mapping = memory_c::take_ownership(m_data, m_size, [data, size]() { munmap(data, size); });
+
+  madvise(m_data, m_size, MADV_SEQUENTIAL);
+
+  mxdebug_if(m_debug, boost::format("mmap_io: mapped %1% bytes of %2%\n") % m_size % m_file_name);
+#endif
+}
+
+mm_mmap_io_c::~mm_mmap_io_c() {
+  close();
+}
+
+mm_io_cptr
+mm_mmap_io_c::open(std::string const &file_name) {
+  try {
+    return mm_io_cptr{new mm_mmap_io_c{file_name}};
+  } catch (mtx::mm_io::exception &) {
+  }
+
+  return {};
+}
+
+uint64
+mm_mmap_io_c::getFilePointer() {
+  return m_pos;
+}
+
+void
+mm_mmap_io_c::setFilePointer(int64 offset,
+                             seek_mode mode) {
+  int64_t new_pos
+    = seek_beginning == mode ? offset
+    : seek_end       == mode ? static_cast<int64_t>(m_size) + offset // offsets from the end are negative already
+    :                          static_cast<int64_t>(m_pos)  + offset;
+
+  if (0 > new_pos)
+    throw mtx::mm_io::seek_x{std::make_error_code(std::errc::invalid_argument)};
+
+  track_seek(new_pos);
+
+  m_pos              = new_pos;
+  m_current_position = new_pos;
+  m_eof              = false;
+}
+
+void
+mm_mmap_io_c::track_seek(uint64_t new_pos) {
+  auto distance = new_pos > m_pos ? new_pos - m_pos : m_pos - new_pos;
+  if (distance <= s_far_seek_distance)
+    return;
+
+  // Read ahead anew at the destination.
+  m_advised_from = 0;
+  m_advised_to   = 0;
+
+  if (!m_sequential || (++m_num_far_seeks < s_max_far_seeks))
+    return;
+
+  // Lots of jumping around, e.g. in files with badly interleaved
+  // tracks. Reading far ahead only wastes I/O then.
+  m_sequential = false;
+
+#if !defined(SYS_WINDOWS)
+  if (m_data)
+    madvise(m_data, m_size, MADV_NORMAL);
+#endif
+
+  mxdebug_if(m_debug, boost::format("mmap_io: switching to random access for %1%\n") % m_file_name);
+}
+
+void
+mm_mmap_io_c::advise(uint64_t pos,
+                     size_t size) {
+#if !defined(SYS_WINDOWS)
+  if (!m_sequential)
+    return;
+
+  auto end = std::min<uint64_t>(pos + size, m_size);
+
+  // Only ask again once half of the previous window has been used.
+  if ((pos >= m_advised_from) && ((end + s_advice_window / 2) <= m_advised_to))
+    return;
+
+  static auto s_page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+  m_advised_from = pos - (pos % s_page_size);
+  m_advised_to   = std::min<uint64_t>(end + s_advice_window, m_size);
+
+  madvise(m_data + m_advised_from, m_advised_to - m_advised_from, MADV_WILLNEED);
+#endif
+}
+
+uint32
+mm_mmap_io_c::_read(void *buffer,
+                    size_t size) {
+  auto available = m_data && (m_pos < m_size) ? std::min<uint64_t>(size, m_size - m_pos) : 0;
+  if (available < size)
+    m_eof = true;
+
+  if (!available)
+    return 0;
+
+  advise(m_pos, available);
+  std::memcpy(buffer, m_data + m_pos, available);
+
+  m_pos              += available;
+  m_current_position  = m_pos;
+
+  return available;
+}
+
+memory_cptr
+mm_mmap_io_c::read_slice(size_t size) {
+  if (!m_data || (m_pos > m_size) || (size > (m_size - m_pos))) {
+    m_eof = true;
+    throw mtx::mm_io::end_of_file_x{};
+  }
+
+  advise(m_pos, size);
+
+  auto slice          = memory_c::slice(m_mapping, m_pos, size);
+  m_pos              += size;
+  m_current_position  = m_pos;
+
+  return slice;
+}
+
+size_t
+mm_mmap_io_c::_write(const void *,
+                     size_t) {
+  throw mtx::mm_io::wrong_read_write_access_x{};
+}
+
+int64_t
+mm_mmap_io_c::get_size() {
+  return m_size;
+}
+
+void
+mm_mmap_io_c::close() {
+  // Slices handed out keep the mapping itself alive.
+  m_mapping.reset();
+  m_data = nullptr;
+}
+
+bool
+mm_mmap_io_c::eof() {
+  return m_eof;
+}
+
+void
+mm_mmap_io_c::clear_eof() {
+  m_eof = false;
+}
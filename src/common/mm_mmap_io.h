@@ -0,0 +1,74 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   IO callback class definitions
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_MM_MMAP_IO_H
+#define MTX_COMMON_MM_MMAP_IO_H
+
+#include "common/common_pch.h"
+
+#include "common/mm_io.h"
+
+/* Reads a local file through a memory mapping. read() copies from
+   the mapping; read_slice() returns slices of it without copying.
+
+   The mapping is private: changes made to its pages, e.g. by a
+   packetizer modifying a frame in place, are never written back to
+   the file. It stays alive for as long as slices of it exist, even
+   after the file has been closed. Therefore memory_c::grab() doesn't
+   have to copy the slices.
+
+   The file must not be truncated while it is mapped: accessing pages
+   beyond its new end raises SIGBUS instead of returning a read
+   error. Files on network file systems, where this can happen
+   without the file being touched locally, are not mapped. mkvmerge
+   only maps its input files if the "mmap_input" hack is engaged.
+*/
+class mm_mmap_io_c: public mm_io_c {
+protected:
+  std::string m_file_name;
+  memory_cptr m_mapping;
+  unsigned char *m_data;
+  uint64_t m_size, m_pos, m_advised_from, m_advised_to;
+  unsigned int m_num_far_seeks;
+  bool m_eof, m_sequential;
+  debugging_option_c m_debug;
+
+public:
+  mm_mmap_io_c(std::string const &file_name);
+  virtual ~mm_mmap_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning);
+  virtual memory_cptr read_slice(size_t size);
+  virtual int64_t get_size();
+  virtual void close();
+  virtual bool eof();
+  virtual void clear_eof();
+
+  virtual std::string get_file_name() const {
+    return m_file_name;
+  }
+
+  static mm_io_cptr open(std::string const &file_name);
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  virtual size_t _write(const void *buffer, size_t size);
+
+  void advise(uint64_t pos, size_t size);
+  void track_seek(uint64_t new_pos);
+};
+
+using mm_mmap_io_cptr = std::shared_ptr<mm_mmap_io_c>;
+
+#endif // MTX_COMMON_MM_MMAP_IO_H
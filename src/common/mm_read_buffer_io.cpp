@@ -137,10 +137,7 @@ mm_read_buffer_io_c::_read(void *buffer,
         break;
       }
 
-      int64_t previous_pos = m_proxy_io->getFilePointer();
-
-      m_fill = m_proxy_io->read(m_buffer, avail);
-      mxdebug_if(m_debug_read, boost::format("physical read from position %3% for %1% returned %2%\n") % avail % m_fill % previous_pos);
+      m_fill = fill_buffer(avail);
       if (m_fill != avail) {
         m_eof = true;
         if (!m_fill)
@@ -152,6 +149,16 @@ mm_read_buffer_io_c::_read(void *buffer,
   return res;
 }
 
+size_t
+mm_read_buffer_io_c::fill_buffer(size_t size) {
+  int64_t previous_pos = m_proxy_io->getFilePointer();
+
+  auto num_read = m_proxy_io->read(m_buffer, size);
+  mxdebug_if(m_debug_read, boost::format("physical read from position %3% for %1% returned %2%\n") % size % num_read % previous_pos);
+
+  return num_read;
+}
+
 size_t
 mm_read_buffer_io_c::_write(const void *,
                             size_t) {
@@ -168,3 +175,235 @@ mm_read_buffer_io_c::enable_buffering(bool enable) {
     m_fill   = 0;
   }
 }
+
+// ------------------------------------------------------------
+
+mm_read_ahead_buffer_io_c::mm_read_ahead_buffer_io_c(mm_io_c *in,
+                                                     size_t buffer_size,
+                                                     size_t num_blocks,
+                                                     bool delete_in)
+  : mm_read_buffer_io_c(in, buffer_size, delete_in)
+  , m_num_blocks{std::max<size_t>(num_blocks, 1)}
+  , m_next_offset{m_offset}
+  , m_generation{}
+  , m_stopping{}
+  , m_paused{}
+  , m_done{}
+{
+  m_thread = std::thread{[this]() { run(); }};
+}
+
+mm_read_ahead_buffer_io_c::~mm_read_ahead_buffer_io_c() {
+  close();
+}
+
+mm_io_cptr
+mm_read_ahead_buffer_io_c::open(const std::string &file_name,
+                                size_t buffer_size,
+                                size_t num_blocks) {
+  return mm_io_cptr(new mm_read_ahead_buffer_io_c(new mm_file_io_c(file_name), buffer_size, num_blocks));
+}
+
+uint64
+mm_read_ahead_buffer_io_c::getFilePointer() {
+  if (m_buffering)
+    return mm_read_buffer_io_c::getFilePointer();
+
+  std::lock_guard<std::recursive_mutex> io_lock{m_io_mutex};
+  return mm_read_buffer_io_c::getFilePointer();
+}
+
+void
+mm_read_ahead_buffer_io_c::setFilePointer(int64 offset,
+                                          seek_mode mode) {
+  std::lock_guard<std::recursive_mutex> io_lock{m_io_mutex};
+  mm_read_buffer_io_c::setFilePointer(offset, mode);
+}
+
+int64_t
+mm_read_ahead_buffer_io_c::get_size() {
+  std::lock_guard<std::recursive_mutex> io_lock{m_io_mutex};
+  return mm_read_buffer_io_c::get_size();
+}
+
+void
+mm_read_ahead_buffer_io_c::close() {
+  stop_reader();
+  mm_read_buffer_io_c::close();
+}
+
+void
+mm_read_ahead_buffer_io_c::enable_buffering(bool enable) {
+  if (enable == m_buffering)
+    return;
+
+  {
+    std::lock_guard<std::recursive_mutex> io_lock{m_io_mutex};
+
+    // The unbuffered code path continues reading wherever the proxy
+    // is positioned; the buffered one wherever the buffer ends.
+    if (!enable) {
+      m_proxy_io->setFilePointer(getFilePointer());
+      mm_read_buffer_io_c::enable_buffering(false);
+
+    } else {
+      mm_read_buffer_io_c::enable_buffering(true);
+      m_offset = m_proxy_io->getFilePointer();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_paused = !enable;
+  }
+
+  m_blocks_changed.notify_all();
+}
+
+uint32
+mm_read_ahead_buffer_io_c::_read(void *buffer,
+                                 size_t size) {
+  if (m_buffering)
+    return mm_read_buffer_io_c::_read(buffer, size);
+
+  std::lock_guard<std::recursive_mutex> io_lock{m_io_mutex};
+  return mm_read_buffer_io_c::_read(buffer, size);
+}
+
+size_t
+mm_read_ahead_buffer_io_c::fill_buffer(size_t size) {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  auto expected_offset = m_blocks.empty() ? m_next_offset : m_blocks.front().m_offset;
+  if (expected_offset != m_offset) {
+    mxdebug_if(m_debug_seek, boost::format("read-ahead: restarting at %1% instead of %2%\n") % m_offset % expected_offset);
+    restart_at(m_offset);
+    lock.unlock();
+    m_blocks_changed.notify_all();
+    lock.lock();
+  }
+
+  m_blocks_changed.wait(lock, [this]() { return !m_blocks.empty() || m_done; });
+
+  if (m_blocks.empty()) {
+    if (!m_error)
+      return 0;
+
+    auto error = m_error;
+    restart_at(m_offset);
+    lock.unlock();
+    m_blocks_changed.notify_all();
+
+    std::rethrow_exception(error);
+  }
+
+  auto block = m_blocks.front();
+  m_blocks.pop_front();
+
+  // Hand the buffer currently in use over to the reader thread and use
+  // the one it has filled instead.
+  m_free_buffers.push_back(m_af_buffer);
+  m_af_buffer = block.m_buffer;
+  m_buffer    = m_af_buffer->get_buffer();
+
+  lock.unlock();
+  m_blocks_changed.notify_all();
+
+  return std::min(block.m_fill, size);
+}
+
+void
+mm_read_ahead_buffer_io_c::run() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  while (true) {
+    m_blocks_changed.wait(lock, [this]() { return m_stopping || (!m_paused && !m_done && (m_blocks.size() < m_num_blocks)); });
+
+    if (m_stopping)
+      break;
+
+    auto offset     = m_next_offset;
+    auto generation = m_generation;
+    auto buffer     = memory_cptr{};
+
+    if (!m_free_buffers.empty()) {
+      buffer = m_free_buffers.back();
+      m_free_buffers.pop_back();
+    } else
+      buffer = memory_c::alloc(m_size);
+
+    lock.unlock();
+
+    auto fill = size_t{};
+    std::exception_ptr error;
+
+    try {
+      std::lock_guard<std::recursive_mutex> io_lock{m_io_mutex};
+
+      auto avail = std::max<int64_t>(std::min<int64_t>(m_proxy_io->get_size() - offset, m_size), 0);
+
+      if (avail) {
+        // Leave the proxy where it was for the unbuffered code path.
+        auto previous_pos = m_proxy_io->getFilePointer();
+
+        m_proxy_io->setFilePointer(offset);
+        fill = m_proxy_io->read(buffer->get_buffer(), avail);
+        m_proxy_io->setFilePointer(previous_pos);
+      }
+
+      mxdebug_if(m_debug_read, boost::format("read-ahead: physical read from position %3% for %1% returned %2%\n") % avail % fill % offset);
+
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+
+    if (generation != m_generation) {
+      m_free_buffers.push_back(buffer);
+      continue;
+    }
+
+    if (error || !fill) {
+      m_free_buffers.push_back(buffer);
+      m_error = error;
+      m_done  = true;
+
+    } else {
+      m_blocks.push_back(block_t{buffer, offset, fill});
+      m_next_offset += fill;
+    }
+
+    lock.unlock();
+    m_blocks_changed.notify_all();
+    lock.lock();
+  }
+}
+
+void
+mm_read_ahead_buffer_io_c::restart_at(int64_t offset) {
+  // Must be called with m_mutex being held.
+  for (auto const &block : m_blocks)
+    m_free_buffers.push_back(block.m_buffer);
+
+  m_blocks.clear();
+
+  m_next_offset = offset;
+  m_done        = false;
+  m_error       = nullptr;
+  ++m_generation;
+}
+
+void
+mm_read_ahead_buffer_io_c::stop_reader() {
+  if (!m_thread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stopping = true;
+  }
+
+  m_blocks_changed.notify_all();
+  m_thread.join();
+}
@@ -17,6 +17,12 @@
 
 #include "common/common_pch.h"
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 #include "common/mm_io.h"
 
 class mm_read_buffer_io_c: public mm_proxy_io_c {
@@ -45,8 +51,56 @@ public:
 protected:
   virtual uint32 _read(void *buffer, size_t size);
   virtual size_t _write(const void *buffer, size_t size);
+  virtual size_t fill_buffer(size_t size);
 };
 
 using mm_read_buffer_io_cptr = std::shared_ptr<mm_read_buffer_io_c>;
 
+/* Reads ahead of the current position in a background thread. Up to
+   the given number of buffers following the one currently in use are
+   kept filled. Seeking outside of the current buffer discards them
+   and restarts reading ahead at the new position.
+*/
+class mm_read_ahead_buffer_io_c: public mm_read_buffer_io_c {
+protected:
+  struct block_t {
+    memory_cptr m_buffer;
+    int64_t m_offset;
+    size_t m_fill;
+  };
+
+  std::deque<block_t> m_blocks;
+  std::vector<memory_cptr> m_free_buffers;
+  size_t m_num_blocks;
+  int64_t m_next_offset;
+  uint64_t m_generation;
+  bool m_stopping, m_paused, m_done;
+  std::exception_ptr m_error;
+
+  std::mutex m_mutex;
+  std::recursive_mutex m_io_mutex;
+  std::condition_variable m_blocks_changed;
+  std::thread m_thread;
+
+public:
+  mm_read_ahead_buffer_io_c(mm_io_c *in, size_t buffer_size, size_t num_blocks, bool delete_in = true);
+  virtual ~mm_read_ahead_buffer_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning);
+  virtual int64_t get_size();
+  virtual void close();
+  virtual void enable_buffering(bool enable);
+
+  static mm_io_cptr open(const std::string &file_name, size_t buffer_size, size_t num_blocks);
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  virtual size_t fill_buffer(size_t size);
+
+  void run();
+  void restart_at(int64_t offset);
+  void stop_reader();
+};
+
 #endif // MTX_COMMON_MM_READ_BUFFER_IO_H
@@ -143,3 +143,297 @@ void
 mm_write_buffer_io_c::discard_buffer() {
   m_fill = 0;
 }
+
+// ------------------------------------------------------------
+
+mm_async_write_buffer_io_c::mm_async_write_buffer_io_c(mm_io_c *out,
+                                                       size_t buffer_size,
+                                                       size_t max_in_flight,
+                                                       bool delete_out)
+  : mm_write_buffer_io_c(out, buffer_size, delete_out)
+  , m_max_in_flight{std::max<size_t>(max_in_flight, 1)}
+  , m_position{out->getFilePointer()}
+  , m_logical_size{out->get_size()}
+  , m_proxy_position{-1}
+  , m_stopping{}
+  , m_discarding{}
+{
+  m_thread = std::thread{[this]() { run(); }};
+}
+
+mm_async_write_buffer_io_c::~mm_async_write_buffer_io_c() {
+  // Exceptions must not escape from the destructor. Call close()
+  // explicitly in order to get errors from pending writes reported.
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+mm_io_cptr
+mm_async_write_buffer_io_c::open(const std::string &file_name,
+                                 size_t buffer_size,
+                                 size_t max_in_flight) {
+  return mm_io_cptr(new mm_async_write_buffer_io_c(new mm_file_io_c(file_name, MODE_CREATE), buffer_size, max_in_flight));
+}
+
+uint64
+mm_async_write_buffer_io_c::getFilePointer() {
+  return m_position + m_fill;
+}
+
+void
+mm_async_write_buffer_io_c::setFilePointer(int64 offset,
+                                           seek_mode mode) {
+  int64_t new_pos
+    = seek_beginning == mode ? offset
+    : seek_end       == mode ? get_size()       + offset // offsets from the end are negative already
+    :                          getFilePointer() + offset;
+
+  if (new_pos == static_cast<int64_t>(getFilePointer()))
+    return;
+
+  flush_buffer();
+
+  mxdebug_if(m_debug_seek, boost::format("seek from %1% to %2% diff %3%\n") % m_position % new_pos % (new_pos - static_cast<int64_t>(m_position)));
+
+  m_position = new_pos;
+}
+
+int64_t
+mm_async_write_buffer_io_c::get_size() {
+  return std::max<int64_t>(m_logical_size, getFilePointer());
+}
+
+void
+mm_async_write_buffer_io_c::flush() {
+  flush_buffer();
+  wait_for_pending_writes(0, std::numeric_limits<uint64_t>::max());
+
+  std::lock_guard<std::mutex> io_lock{m_io_mutex};
+  if (m_proxy_io)
+    m_proxy_io->flush();
+}
+
+void
+mm_async_write_buffer_io_c::close() {
+  if (!m_thread.joinable()) {
+    mm_write_buffer_io_c::close();
+    return;
+  }
+
+  std::exception_ptr error;
+
+  try {
+    flush_buffer();
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  stop_writer();
+
+  if (!error)
+    std::swap(error, m_error);
+
+  mm_proxy_io_c::close();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void
+mm_async_write_buffer_io_c::discard_buffer() {
+  m_fill = 0;
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_discarding = true;
+    m_error      = nullptr;
+  }
+
+  m_pending_changed.notify_all();
+}
+
+uint32
+mm_async_write_buffer_io_c::_read(void *buffer,
+                                  size_t size) {
+  flush_buffer();
+  wait_for_pending_writes(m_position, size);
+
+  std::lock_guard<std::mutex> io_lock{m_io_mutex};
+
+  m_proxy_io->setFilePointer(m_position);
+  auto num_read     = m_proxy_io->read(buffer, size);
+  m_position       += num_read;
+  m_proxy_position  = -1;
+
+  return num_read;
+}
+
+size_t
+mm_async_write_buffer_io_c::_write(const void *buffer,
+                                   size_t size) {
+  auto buf    = static_cast<const unsigned char *>(buffer);
+  auto remain = size;
+
+  // Always copy into the buffer as it is handed over to the writer
+  // thread as a whole.
+  while (remain) {
+    auto to_copy = std::min(remain, m_size - m_fill);
+
+    memcpy(m_buffer + m_fill, buf, to_copy);
+    m_fill += to_copy;
+    remain -= to_copy;
+    buf    += to_copy;
+
+    if (m_fill == m_size)
+      flush_buffer();
+  }
+
+  m_logical_size = std::max<int64_t>(m_logical_size, getFilePointer());
+
+  return size;
+}
+
+void
+mm_async_write_buffer_io_c::flush_buffer() {
+  if (!m_fill)
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock{m_mutex};
+
+    m_pending_changed.wait(lock, [this]() { return m_error || (m_pending.size() < m_max_in_flight); });
+
+    if (m_error) {
+      auto error = m_error;
+      m_error    = nullptr;
+      m_fill     = 0;
+      std::rethrow_exception(error);
+    }
+
+    // Small buffers are the result of seeking around, e.g. for
+    // updating element sizes. Don't give away the large buffer for
+    // those.
+    pending_write_t pending{m_af_buffer, m_position, m_fill};
+
+    if (m_fill < (m_size / 4))
+      pending.m_buffer = memory_c::clone(m_buffer, m_fill);
+
+    else if (!m_free_buffers.empty()) {
+      m_af_buffer = m_free_buffers.back();
+      m_free_buffers.pop_back();
+
+    } else
+      m_af_buffer = memory_c::alloc(m_size);
+
+    m_buffer = m_af_buffer->get_buffer();
+
+    m_pending.emplace_back(pending);
+  }
+
+  m_pending_changed.notify_all();
+
+  mxdebug_if(m_debug_write, boost::format("flush_buffer() at %1% for %2% queued\n") % m_position % m_fill);
+
+  m_position += m_fill;
+  m_fill      = 0;
+}
+
+void
+mm_async_write_buffer_io_c::run() {
+  while (true) {
+    pending_write_t pending;
+    auto discarding = false;
+
+    {
+      std::unique_lock<std::mutex> lock{m_mutex};
+      m_pending_changed.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+
+      if (m_pending.empty())
+        break;
+
+      pending    = m_pending.front();
+      discarding = m_discarding || m_error;
+    }
+
+    std::exception_ptr error;
+
+    if (!discarding) {
+      try {
+        std::lock_guard<std::mutex> io_lock{m_io_mutex};
+
+        if (m_proxy_position != static_cast<int64_t>(pending.m_position))
+          m_proxy_io->setFilePointer(pending.m_position);
+
+        auto written     = m_proxy_io->write(pending.m_buffer->get_buffer(), pending.m_size);
+        m_proxy_position = pending.m_position + written;
+
+        mxdebug_if(m_debug_write, boost::format("async write at %1% for %2% written %3%\n") % pending.m_position % pending.m_size % written);
+
+        if (written != pending.m_size)
+          throw mtx::mm_io::insufficient_space_x();
+
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      if (error) {
+        std::lock_guard<std::mutex> io_lock{m_io_mutex};
+        m_proxy_position = -1;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+
+      m_pending.pop_front();
+
+      if (pending.m_buffer->get_size() == m_size)
+        m_free_buffers.push_back(pending.m_buffer);
+
+      if (error && !m_error && !m_discarding)
+        m_error = error;
+    }
+
+    m_pending_changed.notify_all();
+  }
+}
+
+void
+mm_async_write_buffer_io_c::wait_for_pending_writes(uint64_t position,
+                                                    uint64_t size) {
+  auto end = size > (std::numeric_limits<uint64_t>::max() - position) ? std::numeric_limits<uint64_t>::max() : position + size;
+
+  std::unique_lock<std::mutex> lock{m_mutex};
+
+  m_pending_changed.wait(lock, [this, position, end]() {
+    if (m_error)
+      return true;
+
+    for (auto const &pending : m_pending)
+      if ((pending.m_position < end) && (position < (pending.m_position + pending.m_size)))
+        return false;
+
+    return true;
+  });
+
+  if (m_error) {
+    auto error = m_error;
+    m_error    = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void
+mm_async_write_buffer_io_c::stop_writer() {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stopping = true;
+  }
+
+  m_pending_changed.notify_all();
+
+  if (m_thread.joinable())
+    m_thread.join();
+}
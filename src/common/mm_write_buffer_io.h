@@ -17,6 +17,12 @@
 
 #include "common/common_pch.h"
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 #include "common/mm_io.h"
 
 class mm_write_buffer_io_c: public mm_proxy_io_c {
@@ -46,4 +52,54 @@ protected:
 };
 using mm_write_buffer_io_cptr = std::shared_ptr<mm_write_buffer_io_c>;
 
+/* Hands full buffers over to a background thread that writes them at
+   the position they were filled for. Writes are executed in the
+   order they were issued in. Seeking and writing never wait for
+   pending writes unless more than the given number of buffers are in
+   flight. Reading only waits for pending writes overlapping the range
+   to read.
+*/
+class mm_async_write_buffer_io_c: public mm_write_buffer_io_c {
+protected:
+  struct pending_write_t {
+    memory_cptr m_buffer;
+    uint64_t m_position;
+    size_t m_size;
+  };
+
+  std::deque<pending_write_t> m_pending;
+  std::vector<memory_cptr> m_free_buffers;
+  size_t m_max_in_flight;
+  uint64_t m_position;
+  int64_t m_logical_size, m_proxy_position;
+  bool m_stopping, m_discarding;
+  std::exception_ptr m_error;
+
+  std::mutex m_mutex, m_io_mutex;
+  std::condition_variable m_pending_changed;
+  std::thread m_thread;
+
+public:
+  mm_async_write_buffer_io_c(mm_io_c *out, size_t buffer_size, size_t max_in_flight, bool delete_out = true);
+  virtual ~mm_async_write_buffer_io_c();
+
+  virtual uint64 getFilePointer();
+  virtual void setFilePointer(int64 offset, seek_mode mode = seek_beginning);
+  virtual int64_t get_size();
+  virtual void flush();
+  virtual void close();
+  virtual void discard_buffer();
+
+  static mm_io_cptr open(const std::string &file_name, size_t buffer_size, size_t max_in_flight);
+
+protected:
+  virtual uint32 _read(void *buffer, size_t size);
+  virtual size_t _write(const void *buffer, size_t size);
+  virtual void flush_buffer();
+
+  void run();
+  void wait_for_pending_writes(uint64_t position, uint64_t size);
+  void stop_writer();
+};
+
 #endif // MTX_COMMON_MM_BUFFERED_IO_H
@@ -12,12 +12,170 @@
 
 #include "common/common_pch.h"
 
+#include "common/cpu_features.h"
 #include "common/debugging.h"
 #include "common/endian.h"
 #include "common/mpeg.h"
 
+#if defined(MTX_CPU_X86_SIMD)
+# include <immintrin.h>
+#endif
+
 namespace mtx { namespace mpeg {
 
+namespace {
+
+// The pattern searched for is given as up to four bytes; only the
+// first 'size' ones are used.
+struct pattern_t {
+  unsigned char bytes[4];
+  unsigned int size;
+};
+
+unsigned char const *
+find_start_code_scalar(unsigned char const *begin,
+                       unsigned char const *end) {
+  auto p = begin;
+
+  // Skip as many bytes as possible depending on the value of the
+  // third byte: no start code can begin at p, p + 1 or p + 2 if it is
+  // bigger than 1.
+  while ((end - p) >= 3) {
+    if (p[2] > 1)
+      p += 3;
+    else if (p[1])
+      p += 2;
+    else if (p[0] || (p[2] != 1))
+      ++p;
+    else
+      return p;
+  }
+
+  return end;
+}
+
+unsigned char const *
+find_pattern_scalar(unsigned char const *begin,
+                    unsigned char const *end,
+                    pattern_t const &pattern) {
+  if ((3 == pattern.size) && !pattern.bytes[0] && !pattern.bytes[1] && (1 == pattern.bytes[2]))
+    return find_start_code_scalar(begin, end);
+
+  auto p = begin;
+
+  while (static_cast<std::size_t>(end - p) >= pattern.size) {
+    p = static_cast<unsigned char const *>(std::memchr(p, pattern.bytes[0], end - p - pattern.size + 1));
+    if (!p)
+      return end;
+
+    if (!std::memcmp(p, pattern.bytes, pattern.size))
+      return p;
+
+    ++p;
+  }
+
+  return end;
+}
+
+#if defined(MTX_CPU_X86_SIMD)
+
+__attribute__((target("sse2")))
+unsigned char const *
+find_pattern_sse2(unsigned char const *begin,
+                  unsigned char const *end,
+                  pattern_t const &pattern) {
+  auto p  = begin;
+  auto b0 = _mm_set1_epi8(static_cast<char>(pattern.bytes[0]));
+  auto b1 = _mm_set1_epi8(static_cast<char>(pattern.bytes[1]));
+  auto b2 = _mm_set1_epi8(static_cast<char>(pattern.bytes[2]));
+  auto b3 = _mm_set1_epi8(static_cast<char>(pattern.bytes[3]));
+
+  // Compare 16 candidate positions at once: byte n of the pattern
+  // against the block shifted by n bytes.
+  while ((end - p) >= static_cast<std::ptrdiff_t>(16 + pattern.size - 1)) {
+    auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)),     b0)))
+              & static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 1)), b1)))
+              & static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 2)), b2)));
+
+    if (mask && (4 == pattern.size))
+      mask &= static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 3)), b3)));
+
+    if (mask)
+      return p + __builtin_ctz(mask);
+
+    p += 16;
+  }
+
+  return find_pattern_scalar(p, end, pattern);
+}
+
+__attribute__((target("avx2")))
+unsigned char const *
+find_pattern_avx2(unsigned char const *begin,
+                  unsigned char const *end,
+                  pattern_t const &pattern) {
+  auto p  = begin;
+  auto b0 = _mm256_set1_epi8(static_cast<char>(pattern.bytes[0]));
+  auto b1 = _mm256_set1_epi8(static_cast<char>(pattern.bytes[1]));
+  auto b2 = _mm256_set1_epi8(static_cast<char>(pattern.bytes[2]));
+  auto b3 = _mm256_set1_epi8(static_cast<char>(pattern.bytes[3]));
+
+  while ((end - p) >= static_cast<std::ptrdiff_t>(32 + pattern.size - 1)) {
+    auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)),     b0)))
+              & static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + 1)), b1)))
+              & static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + 2)), b2)));
+
+    if (mask && (4 == pattern.size))
+      mask &= static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p + 3)), b3)));
+
+    if (mask)
+      return p + __builtin_ctz(mask);
+
+    p += 32;
+  }
+
+  return find_pattern_sse2(p, end, pattern);
+}
+
+#endif  // defined(MTX_CPU_X86_SIMD)
+
+unsigned char const *
+find_pattern(unsigned char const *begin,
+             unsigned char const *end,
+             pattern_t const &pattern) {
+  if (!begin || (begin >= end))
+    return end;
+
+#if defined(MTX_CPU_X86_SIMD)
+  if (mtx::cpu::has(mtx::cpu::feature_e::avx2))
+    return find_pattern_avx2(begin, end, pattern);
+
+  if (mtx::cpu::has(mtx::cpu::feature_e::sse2))
+    return find_pattern_sse2(begin, end, pattern);
+#endif
+
+  return find_pattern_scalar(begin, end, pattern);
+}
+
+} // anonymous namespace
+
+unsigned char const *
+find_start_code(unsigned char const *begin,
+                unsigned char const *end) {
+  static pattern_t const s_start_code{ { 0x00, 0x00, 0x01, 0x00 }, 3 };
+
+  return find_pattern(begin, end, s_start_code);
+}
+
+unsigned char const *
+find_marker(unsigned char const *begin,
+            unsigned char const *end,
+            uint32_t marker) {
+  pattern_t pattern{ { static_cast<unsigned char>(marker >> 24), static_cast<unsigned char>(marker >> 16), static_cast<unsigned char>(marker >> 8), static_cast<unsigned char>(marker) }, 4 };
+
+  return find_pattern(begin, end, pattern);
+}
+
 memory_cptr
 nalu_to_rbsp(memory_cptr const &buffer) {
   int pos, size = buffer->get_size();
@@ -103,6 +261,63 @@ create_nalu_with_size(memory_cptr const &src,
   return buffer;
 }
 
+void
+change_nalu_size_length(memory_cptr &data,
+                        std::size_t src_length,
+                        std::size_t dst_length) {
+  auto src  = data->get_buffer();
+  auto size = data->get_size();
+
+  if (!src || !size || (src_length == dst_length))
+    return;
+
+  // Offsets of the NALUs' payloads and their sizes. Trailing bytes too
+  // short for a size field are dropped; a size exceeding the buffer is
+  // cut down to the bytes actually present.
+  std::vector<std::pair<std::size_t, std::size_t>> nalus;
+  std::size_t src_pos = 0, largest_size = 0;
+
+  while ((size - src_pos) >= src_length) {
+    auto nalu_size = std::min<uint64_t>(get_uint_be(&src[src_pos], src_length), size - src_pos - src_length);
+    src_pos       += src_length;
+    largest_size   = std::max<std::size_t>(largest_size, nalu_size);
+
+    nalus.emplace_back(src_pos, nalu_size);
+
+    src_pos       += nalu_size;
+  }
+
+  if ((dst_length < 8) && (largest_size >= (1llu << (dst_length * 8)))) {
+    auto required_bytes = dst_length + 1;
+    while ((required_bytes < 8) && (largest_size >= (1llu << (required_bytes * 8))))
+      ++required_bytes;
+
+    throw nalu_size_length_x{required_bytes};
+  }
+
+  auto new_size = src_pos - nalus.size() * src_length + nalus.size() * dst_length;
+  auto dst_data = dst_length > src_length ? memory_c::alloc(new_size) : data;
+  auto dst      = dst_data->get_buffer();
+  auto dst_pos  = std::size_t{};
+
+  // When shrinking, each NALU ends up at or before its old position,
+  // and its new size field ends before the payload's old position.
+  // Moving them front to back therefore never overwrites bytes not
+  // processed yet.
+  for (auto const &nalu : nalus) {
+    put_uint_be(&dst[dst_pos], nalu.second, dst_length);
+    dst_pos += dst_length;
+
+    if ((dst != src) || (dst_pos != nalu.first))
+      std::memmove(&dst[dst_pos], &src[nalu.first], nalu.second);
+
+    dst_pos += nalu.second;
+  }
+
+  dst_data->set_size(dst_pos);
+  data = dst_data;
+}
+
 void
 remove_trailing_zero_bytes(memory_c &buffer) {
   static debugging_option_c s_debug_trailing_zero_byte_removal{"avc_parser|avc_trailing_zero_byte_removal"};
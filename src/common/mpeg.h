@@ -47,8 +47,24 @@ memory_cptr rbsp_to_nalu(memory_cptr const &buffer);
 void write_nalu_size(unsigned char *buffer, std::size_t size, std::size_t nalu_size_length, bool ignore_nalu_size_length_errors = false);
 memory_cptr create_nalu_with_size(memory_cptr const &src, std::size_t nalu_size_length, std::vector<memory_cptr> extra_data);
 
+// Changes the length of the size fields in front of each NALU in
+// 'data' from 'src_length' to 'dst_length' bytes. The positions of
+// all NALUs are determined first. Fields that don't grow are
+// rewritten in place; otherwise 'data' is replaced by a new buffer.
+// Throws nalu_size_length_x without modifying 'data' if a NALU is too
+// big for the new length.
+void change_nalu_size_length(memory_cptr &data, std::size_t src_length, std::size_t dst_length);
+
 void remove_trailing_zero_bytes(memory_c &buffer);
 
+// Both return a pointer to the first byte of the first occurrence in
+// [begin, end) or end if there's none. find_start_code() looks for
+// the prefix 00 00 01, find_marker() for an arbitrary four-byte
+// big-endian marker. SSE2 or AVX2 versions are used if the CPU
+// supports them.
+unsigned char const *find_start_code(unsigned char const *begin, unsigned char const *end);
+unsigned char const *find_marker(unsigned char const *begin, unsigned char const *end, uint32_t marker);
+
 }}
 
 #endif  // MTX_COMMON_MPEG_COMMON_H
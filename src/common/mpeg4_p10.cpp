@@ -927,50 +927,50 @@ mpeg4::p10::avc_es_parser_c::discard_actual_frames(bool discard) {
 void
 mpeg4::p10::avc_es_parser_c::add_bytes(unsigned char *buffer,
                                        size_t size) {
-  memory_slice_cursor_c cursor;
-  int marker_size              = 0;
   int previous_marker_size     = 0;
   int previous_pos             = -1;
   uint64_t previous_parsed_pos = m_parsed_position;
 
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
+  m_unparsed_buffer.add(buffer, size);
 
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker =                               1 << 24
-                    | (unsigned int)cursor.get_char() << 16
-                    | (unsigned int)cursor.get_char() <<  8
-                    | (unsigned int)cursor.get_char();
+  auto data      = m_unparsed_buffer.get_buffer();
+  auto data_size = m_unparsed_buffer.get_size();
+  auto end       = data + data_size;
 
-    while (1) {
-      if (NALU_START_CODE == marker)
-        marker_size = 4;
-      else if (NALU_START_CODE == (marker & 0x00ffffff))
-        marker_size = 3;
-
-      if (0 != marker_size) {
-        if (-1 != previous_pos) {
-          int new_size = cursor.get_position() - marker_size - previous_pos - previous_marker_size;
-          auto nalu = memory_c::alloc(new_size);
-          cursor.copy(nalu->get_buffer(), previous_pos + previous_marker_size, new_size);
-          m_parsed_position = previous_parsed_pos + previous_pos;
-
-          mtx::mpeg::remove_trailing_zero_bytes(*nalu);
-          if (nalu->get_size())
-            handle_nalu(nalu, m_parsed_position);
-        }
-        previous_pos         = cursor.get_position() - marker_size;
-        previous_marker_size = marker_size;
-        marker_size          = 0;
-      }
+  // The unparsed data always starts with the marker of the NALU
+  // that is still incomplete, if any. Everything before the scan
+  // offset has already been searched for markers.
+  if ((4 <= data_size) && (NALU_START_CODE == get_uint32_be(data)))
+    previous_marker_size = 4;
+  else if ((3 <= data_size) && (NALU_START_CODE == get_uint24_be(data)))
+    previous_marker_size = 3;
 
-      if (!cursor.char_available())
-        break;
+  if (previous_marker_size)
+    previous_pos = 0;
+
+  auto start_code = mtx::mpeg::find_start_code(data + std::min<std::size_t>(std::max<std::size_t>(m_unparsed_scan_offset, previous_marker_size), data_size), end);
+
+  while (start_code != end) {
+    int marker_pos  = start_code - data;
+    int marker_size = 3;
 
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
+    if (marker_pos && !data[marker_pos - 1]) {
+      --marker_pos;
+      marker_size = 4;
     }
+
+    if (-1 != previous_pos) {
+      auto nalu         = memory_c::clone(data + previous_pos + previous_marker_size, marker_pos - previous_pos - previous_marker_size);
+      m_parsed_position = previous_parsed_pos + previous_pos;
+
+      mtx::mpeg::remove_trailing_zero_bytes(*nalu);
+      if (nalu->get_size())
+        handle_nalu(nalu, m_parsed_position);
+    }
+
+    previous_pos         = marker_pos;
+    previous_marker_size = marker_size;
+    start_code           = mtx::mpeg::find_start_code(start_code + 3, end);
   }
 
   if (-1 == previous_pos)
@@ -979,25 +979,22 @@ mpeg4::p10::avc_es_parser_c::add_bytes(unsigned char *buffer,
   m_stream_position += size;
   m_parsed_position  = previous_parsed_pos + previous_pos;
 
-  int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    m_unparsed_buffer = memory_c::alloc(new_size);
-    cursor.copy(m_unparsed_buffer->get_buffer(), previous_pos, new_size);
-
-  } else
-    m_unparsed_buffer.reset();
+  auto remaining_size = data_size - previous_pos;
+  m_unparsed_buffer.remove(previous_pos);
+  m_unparsed_scan_offset = std::max<std::size_t>(previous_marker_size, remaining_size >= 2 ? remaining_size - 2 : 0);
 }
 
 void
 mpeg4::p10::avc_es_parser_c::flush() {
-  if (m_unparsed_buffer && (5 <= m_unparsed_buffer->get_size())) {
-    m_parsed_position += m_unparsed_buffer->get_size();
-    int marker_size = get_uint32_be(m_unparsed_buffer->get_buffer()) == NALU_START_CODE ? 4 : 3;
-    auto nalu_size  = m_unparsed_buffer->get_size() - marker_size;
-    handle_nalu(memory_c::clone(m_unparsed_buffer->get_buffer() + marker_size, nalu_size), m_parsed_position - nalu_size);
+  if (5 <= m_unparsed_buffer.get_size()) {
+    m_parsed_position += m_unparsed_buffer.get_size();
+    auto marker_size   = get_uint32_be(m_unparsed_buffer.get_buffer()) == NALU_START_CODE ? 4 : 3;
+    auto nalu_size     = m_unparsed_buffer.get_size() - marker_size;
+    handle_nalu(memory_c::clone(m_unparsed_buffer.get_buffer() + marker_size, nalu_size), m_parsed_position - nalu_size);
   }
 
-  m_unparsed_buffer.reset();
+  m_unparsed_buffer.clear();
+  m_unparsed_scan_offset = 0;
   if (m_have_incomplete_frame) {
     m_frames.push_back(m_incomplete_frame);
     m_have_incomplete_frame = false;
@@ -17,6 +17,7 @@
 
 #include "common/common_pch.h"
 
+#include "common/byte_buffer.h"
 #include "common/math.h"
 
 #define NALU_START_CODE 0x00000001
@@ -246,7 +247,8 @@ protected:
   std::vector<sps_info_t> m_sps_info_list;
   std::vector<pps_info_t> m_pps_info_list;
 
-  memory_cptr m_unparsed_buffer;
+  byte_buffer_c m_unparsed_buffer;
+  std::size_t m_unparsed_scan_offset{};
   uint64_t m_stream_position, m_parsed_position;
 
   avc_frame_t m_incomplete_frame;
@@ -14,6 +14,7 @@
 #include "common/common_pch.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <mutex>
 #include <sstream>
 
 #include "common/command_line.h"
@@ -38,6 +39,7 @@ charset_converter_cptr g_cc_stdio = charset_converter_cptr(new charset_converter
 std::shared_ptr<mm_io_c> g_mm_stdio   = std::shared_ptr<mm_io_c>(new mm_stdio_c);
 
 static mxmsg_handler_t s_mxmsg_info_handler, s_mxmsg_warning_handler, s_mxmsg_error_handler;
+static thread_local bool s_mxerror_throws = false;
 static std::vector<std::string> s_warnings_emitted, s_errors_emitted;
 
 static nlohmann::json
@@ -58,6 +60,11 @@ display_json_output(nlohmann::json json) {
   mxinfo(boost::format("%1%\n") % mtx::json::dump(json, 2));
 }
 
+std::vector<std::string> const &
+get_json_warnings() {
+  return s_warnings_emitted;
+}
+
 static void
 json_warning_error_handler(unsigned int level,
                            std::string const &message) {
@@ -102,12 +109,29 @@ set_mxmsg_handler(unsigned int level,
     assert(false);
 }
 
+mxmsg_handler_t
+get_mxmsg_handler(unsigned int level) {
+  if (MXMSG_INFO == level)
+    return s_mxmsg_info_handler;
+  else if (MXMSG_WARNING == level)
+    return s_mxmsg_warning_handler;
+  else if (MXMSG_ERROR == level)
+    return s_mxmsg_error_handler;
+
+  assert(false);
+  return {};
+}
+
 void
 mxmsg(unsigned int level,
       std::string message) {
   static debugging_option_c s_timestamped_messages{"timestamped_messages"};
   static debugging_option_c s_memory_usage_in_messages{"memory_usage_in_messages"};
   static bool s_saw_cr_after_nl = false;
+  static std::recursive_mutex s_mutex;
+
+  // mkvmerge's reader threads may output messages, too.
+  std::lock_guard<std::recursive_mutex> lock{s_mutex};
 
   if (g_suppress_info && (MXMSG_INFO == level))
     return;
@@ -196,8 +220,16 @@ default_mxerror(unsigned int,
   mxexit(2);
 }
 
+void
+mxerror_throws_in_this_thread() {
+  s_mxerror_throws = true;
+}
+
 void
 mxerror(std::string const &error) {
+  if (s_mxerror_throws)
+    throw mtx::output::error_x{error};
+
   if (s_mxmsg_error_handler)
     s_mxmsg_error_handler(MXMSG_ERROR, error);
 }
@@ -20,6 +20,7 @@
 
 #include <ebml/EbmlElement.h>
 
+#include "common/error.h"
 #include "common/json.h"
 #include "common/locale.h"
 #include "common/mm_io.h"
@@ -28,6 +29,7 @@ using namespace libebml;
 
 using mxmsg_handler_t = std::function<void(unsigned int level, std::string const &)>;
 void set_mxmsg_handler(unsigned int level, mxmsg_handler_t const &handler);
+mxmsg_handler_t get_mxmsg_handler(unsigned int level);
 
 extern bool g_suppress_info, g_suppress_warnings;
 extern std::string g_stdio_charset;
@@ -39,6 +41,7 @@ bool stdio_redirected();
 
 void redirect_warnings_and_errors_to_json();
 void display_json_output(nlohmann::json json);
+std::vector<std::string> const &get_json_warnings();
 
 void init_common_output(bool no_charset_detection);
 void set_cc_stdio(const std::string &charset);
@@ -72,6 +75,39 @@ mxerror(const boost::format &error) {
   mxerror(error.str());
 }
 
+namespace mtx { namespace output {
+
+// Thrown by mxerror() instead of terminating the program in threads
+// that have called mxerror_throws_in_this_thread().
+class error_x: public mtx::exception {
+protected:
+  std::string m_message;
+
+public:
+  explicit error_x(std::string const &message)
+    : m_message{message}
+  {
+  }
+  virtual ~error_x() throw() { }
+
+  virtual const char *what() const throw() {
+    return m_message.c_str();
+  }
+
+  virtual std::string error() const throw() {
+    return m_message;
+  }
+};
+
+}}
+
+// Worker threads must not exit() the program themselves: exit() runs
+// the destructors of static objects that may join the very same
+// thread. After calling this function mxerror() throws
+// mtx::output::error_x in the calling thread instead. Whoever joins
+// the thread must report the message with mxerror().
+void mxerror_throws_in_this_thread();
+
 #define mxverb(level, message)        \
   if (verbose >= level)               \
     mxinfo(message);
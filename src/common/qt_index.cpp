@@ -0,0 +1,160 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   the compact sample index used by the MP4/QuickTime reader
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/qt_index.h"
+
+static void
+put_varint(std::vector<unsigned char> &data,
+           uint64_t value) {
+  while (value >= 0x80) {
+    data.push_back(static_cast<unsigned char>(value) | 0x80);
+    value >>= 7;
+  }
+
+  data.push_back(static_cast<unsigned char>(value));
+}
+
+static uint64_t
+get_varint(unsigned char const *&ptr) {
+  auto value = uint64_t{};
+  auto shift = 0u;
+
+  while (*ptr & 0x80) {
+    value |= static_cast<uint64_t>(*ptr & 0x7f) << shift;
+    shift += 7;
+    ++ptr;
+  }
+
+  value |= static_cast<uint64_t>(*ptr) << shift;
+  ++ptr;
+
+  return value;
+}
+
+// The deltas are stored relative to the sum of two reference values
+// and zig-zag encoded, mapping small negative and positive deltas to
+// small unsigned numbers. Calculating in unsigned arithmetic avoids
+// overflows for arbitrary values.
+static void
+put_delta(std::vector<unsigned char> &data,
+          int64_t value,
+          int64_t reference,
+          int64_t reference_offset = 0) {
+  auto delta = static_cast<uint64_t>(value) - static_cast<uint64_t>(reference) - static_cast<uint64_t>(reference_offset);
+  put_varint(data, (delta << 1) ^ (0 - (delta >> 63)));
+}
+
+static int64_t
+get_delta(unsigned char const *&ptr,
+          int64_t reference,
+          int64_t reference_offset = 0) {
+  auto zigzag = get_varint(ptr);
+  return static_cast<int64_t>(static_cast<uint64_t>(reference) + static_cast<uint64_t>(reference_offset) + ((zigzag >> 1) ^ (0 - (zigzag & 1))));
+}
+
+void
+qt_index_c::push_back(qt_index_t const &entry) {
+  auto idx = m_keyframes.size();
+
+  if (!(idx % block_size)) {
+    m_block_offsets.push_back(m_data.size());
+    m_previous = qt_index_t{};
+  }
+
+  auto timecode = static_cast<int64_t>(static_cast<uint64_t>(entry.timecode) - static_cast<uint64_t>(m_timecode_offset));
+
+  put_delta(m_data, entry.file_pos, m_previous.file_pos, m_previous.size);
+  put_delta(m_data, entry.size,     m_previous.size);
+  put_delta(m_data, timecode,       m_previous.timecode, m_previous.duration);
+  put_delta(m_data, entry.duration, m_previous.duration);
+
+  m_previous          = entry;
+  m_previous.timecode = timecode;
+
+  m_keyframes.push_back(entry.is_keyframe);
+
+  if (m_cached_block_idx == (idx / block_size))
+    m_cached_block_idx = std::numeric_limits<std::size_t>::max();
+}
+
+void
+qt_index_c::decode_block(std::size_t block_idx,
+                         std::vector<qt_index_t> &entries)
+  const {
+  auto first_idx   = block_idx * block_size;
+  auto num_entries = std::min<std::size_t>(size() - first_idx, static_cast<std::size_t>(block_size));
+  auto ptr         = &m_data[m_block_offsets[block_idx]];
+  auto previous    = qt_index_t{};
+
+  entries.resize(num_entries);
+
+  for (auto idx = 0u; idx < num_entries; ++idx) {
+    auto &entry    = entries[idx];
+    entry.file_pos = get_delta(ptr, previous.file_pos, previous.size);
+    entry.size     = get_delta(ptr, previous.size);
+    entry.timecode = get_delta(ptr, previous.timecode, previous.duration);
+    entry.duration = get_delta(ptr, previous.duration);
+    previous       = entry;
+  }
+}
+
+qt_index_t
+qt_index_c::finish_entry(qt_index_t entry,
+                         std::size_t idx)
+  const {
+  entry.timecode    += m_timecode_offset;
+  entry.is_keyframe  = m_keyframes[idx];
+
+  return entry;
+}
+
+qt_index_t
+qt_index_c::operator [](std::size_t idx)
+  const {
+  auto block_idx = idx / block_size;
+
+  if (block_idx != m_cached_block_idx) {
+    decode_block(block_idx, m_cached_block);
+    m_cached_block_idx = block_idx;
+  }
+
+  return finish_entry(m_cached_block[idx % block_size], idx);
+}
+
+qt_index_t
+qt_index_c::cursor_c::get() {
+  auto block_idx = m_idx / block_size;
+
+  // Entries may have been added to the current block in the meantime.
+  if ((block_idx != m_block_idx) || ((m_idx % block_size) >= m_block.size())) {
+    m_index.decode_block(block_idx, m_block);
+    m_block_idx = block_idx;
+  }
+
+  return m_index.finish_entry(m_block[m_idx % block_size], m_idx);
+}
+
+void
+qt_index_c::shrink_to_fit() {
+  m_data.shrink_to_fit();
+  m_block_offsets.shrink_to_fit();
+  m_keyframes.shrink_to_fit();
+}
+
+std::size_t
+qt_index_c::get_memory_usage()
+  const {
+  return m_data.capacity() + m_block_offsets.capacity() * sizeof(std::size_t) + m_keyframes.capacity() / 8;
+}
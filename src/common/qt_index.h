@@ -0,0 +1,145 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   the compact sample index used by the MP4/QuickTime reader
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_QT_INDEX_H
+#define MTX_COMMON_QT_INDEX_H
+
+#include "common/common_pch.h"
+
+struct qt_index_t {
+  int64_t file_pos, size;
+  int64_t timecode, duration;
+  bool    is_keyframe;
+
+  qt_index_t()
+    : file_pos{}
+    , size{}
+    , timecode{}
+    , duration{}
+    , is_keyframe{}
+  {
+  };
+
+  qt_index_t(int64_t p_file_pos, int64_t p_size, int64_t p_timecode, int64_t p_duration, bool p_is_keyframe)
+    : file_pos{p_file_pos}
+    , size{p_size}
+    , timecode{p_timecode}
+    , duration{p_duration}
+    , is_keyframe{p_is_keyframe}
+  {
+  }
+};
+
+// The sample index of a track. Huge files contain millions of
+// samples, therefore the entries are stored in blocks of varint
+// encoded deltas instead of one qt_index_t per sample: within a block
+// each entry's file position is stored relative to the end of the
+// previous entry, its timestamp relative to the previous entry's end
+// timestamp and its size and duration relative to the previous
+// ones. The first entry of each block is relative to zero so that
+// each block can be decoded on its own. Entries are returned by value;
+// the last block decoded is cached so that sequential access decodes
+// each block only once. Code scanning ahead while another part keeps
+// accessing the index sequentially should use a cursor_c which
+// decodes into a buffer of its own.
+//
+// The cache is modified by const member functions without any
+// synchronization. An index must therefore not be accessed from more
+// than one thread at a time, not even for reading. Cursors don't
+// modify the index.
+class qt_index_c {
+public:
+  static std::size_t const block_size = 64;
+
+  // Iterates over the entries in ascending order. The cursor must not
+  // outlive the index it was created for.
+  class cursor_c {
+  protected:
+    qt_index_c const &m_index;
+    std::size_t m_idx, m_block_idx{std::numeric_limits<std::size_t>::max()};
+    std::vector<qt_index_t> m_block;
+
+  public:
+    cursor_c(qt_index_c const &index, std::size_t idx)
+      : m_index(index)
+      , m_idx{idx}
+    {
+    }
+
+    bool at_end() const {
+      return m_idx >= m_index.size();
+    }
+
+    std::size_t get_idx() const {
+      return m_idx;
+    }
+
+    qt_index_t get();
+
+    cursor_c &operator ++() {
+      ++m_idx;
+      return *this;
+    }
+  };
+
+protected:
+  std::vector<unsigned char> m_data;
+  std::vector<std::size_t> m_block_offsets;
+  std::vector<bool> m_keyframes;
+  int64_t m_timecode_offset{};
+  qt_index_t m_previous;
+
+  mutable std::vector<qt_index_t> m_cached_block;
+  mutable std::size_t m_cached_block_idx{std::numeric_limits<std::size_t>::max()};
+
+public:
+  void push_back(qt_index_t const &entry);
+  void emplace_back(int64_t file_pos, int64_t size, int64_t timecode, int64_t duration, bool is_keyframe) {
+    push_back(qt_index_t{file_pos, size, timecode, duration, is_keyframe});
+  }
+
+  qt_index_t operator [](std::size_t idx) const;
+
+  cursor_c cursor(std::size_t idx = 0) const {
+    return cursor_c{*this, idx};
+  }
+
+  std::size_t size() const {
+    return m_keyframes.size();
+  }
+
+  bool empty() const {
+    return m_keyframes.empty();
+  }
+
+  bool is_keyframe(std::size_t idx) const {
+    return m_keyframes[idx];
+  }
+
+  void set_keyframe(std::size_t idx) {
+    m_keyframes[idx] = true;
+  }
+
+  void adjust_timecodes(int64_t delta) {
+    m_timecode_offset += delta;
+  }
+
+  void shrink_to_fit();
+  std::size_t get_memory_usage() const;
+
+protected:
+  void decode_block(std::size_t block_idx, std::vector<qt_index_t> &entries) const;
+  qt_index_t finish_entry(qt_index_t entry, std::size_t idx) const;
+};
+
+#endif  // MTX_COMMON_QT_INDEX_H
@@ -0,0 +1,105 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   a fixed-size pool of worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "common/thread_pool.h"
+
+namespace mtx {
+
+struct thread_pool_c::impl_t {
+  std::vector<std::thread> threads;
+  std::deque<std::packaged_task<void()>> queue;
+
+  std::mutex mutex;
+  std::condition_variable produced;
+  bool stopping{};
+};
+
+thread_pool_c::thread_pool_c(std::size_t num_threads)
+  : m{new thread_pool_c::impl_t{}}
+{
+  if (!num_threads)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  for (auto idx = 0u; idx < num_threads; ++idx)
+    m->threads.emplace_back([this]() { run(); });
+}
+
+thread_pool_c::~thread_pool_c() {
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    m->stopping = true;
+  }
+
+  m->produced.notify_all();
+
+  for (auto &thread : m->threads)
+    thread.join();
+}
+
+std::size_t
+thread_pool_c::get_num_threads()
+  const {
+  return m->threads.size();
+}
+
+std::future<void>
+thread_pool_c::submit(std::function<void()> job) {
+  std::packaged_task<void()> task{std::move(job)};
+  auto result = task.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    m->queue.emplace_back(std::move(task));
+  }
+
+  m->produced.notify_one();
+
+  return result;
+}
+
+void
+thread_pool_c::run() {
+  while (true) {
+    std::packaged_task<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock{m->mutex};
+
+      m->produced.wait(lock, [this]() { return m->stopping || !m->queue.empty(); });
+
+      if (m->queue.empty())
+        return;
+
+      task = std::move(m->queue.front());
+      m->queue.pop_front();
+    }
+
+    // Exceptions are stored in the task's future.
+    task();
+  }
+}
+
+thread_pool_c &
+thread_pool_c::global() {
+  static thread_pool_c s_pool;
+  return s_pool;
+}
+
+}
@@ -0,0 +1,51 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   a fixed-size pool of worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_COMMON_THREAD_POOL_H
+#define MTX_COMMON_THREAD_POOL_H
+
+#include "common/common_pch.h"
+
+#include <future>
+
+namespace mtx {
+
+/* Jobs are started in the order they've been submitted. The future
+   returned by submit() becomes ready once the job has run;
+   exceptions thrown by the job are re-thrown by its get()
+   function. Jobs still queued on destruction are run before the
+   threads are joined.
+*/
+class thread_pool_c {
+private:
+  struct impl_t;
+  std::unique_ptr<impl_t> m;
+
+public:
+  // Uses one thread per CPU core if 'num_threads' is 0.
+  explicit thread_pool_c(std::size_t num_threads = 0);
+  ~thread_pool_c();
+
+  std::size_t get_num_threads() const;
+  std::future<void> submit(std::function<void()> job);
+
+  // A pool shared by all users that is created on first use.
+  static thread_pool_c &global();
+
+private:
+  void run();
+};
+
+}
+
+#endif  // MTX_COMMON_THREAD_POOL_H
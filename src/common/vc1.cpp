@@ -16,6 +16,7 @@
 
 #include "common/bit_reader.h"
 #include "common/endian.h"
+#include "common/mpeg.h"
 #include "common/strings/formatting.h"
 #include "common/vc1.h"
 
@@ -301,63 +302,57 @@ es_parser_c::~es_parser_c() {
 void
 es_parser_c::add_bytes(unsigned char *buffer,
                        int size) {
-  memory_slice_cursor_c cursor;
-
   int previous_pos            = -1;
   int64_t previous_stream_pos = m_stream_pos;
 
-  if (m_unparsed_buffer && (0 != m_unparsed_buffer->get_size()))
-    cursor.add_slice(m_unparsed_buffer);
-  cursor.add_slice(buffer, size);
+  m_unparsed_buffer.add(buffer, size);
 
-  if (3 <= cursor.get_remaining_size()) {
-    uint32_t marker = (1 << 24) | ((unsigned int)cursor.get_char() << 16) | ((unsigned int)cursor.get_char() << 8) | (unsigned int)cursor.get_char();
+  auto data      = m_unparsed_buffer.get_buffer();
+  auto data_size = m_unparsed_buffer.get_size();
 
-    while (1) {
-      if (is_marker(marker)) {
-        if (-1 != previous_pos) {
-          int new_size = cursor.get_position() - 4 - previous_pos;
+  // A marker consists of a start code and the byte following it.
+  // Everything before the scan offset has already been searched.
+  auto scan_offset = m_unparsed_scan_offset;
 
-          memory_cptr packet(new memory_c(safemalloc(new_size), new_size, true));
-          cursor.copy(packet->get_buffer(), previous_pos, new_size);
+  if ((4 <= data_size) && is_marker(get_uint32_be(data))) {
+    previous_pos = 0;
+    scan_offset  = std::max<std::size_t>(scan_offset, 3);
+  }
 
-          handle_packet(packet);
-        }
+  if (4 <= data_size) {
+    auto end    = data + data_size - 1;
+    auto marker = mtx::mpeg::find_start_code(data + std::min<std::size_t>(scan_offset, data_size - 1), end);
 
-        previous_pos = cursor.get_position() - 4;
-        m_stream_pos = previous_stream_pos + previous_pos;
-      }
+    while (marker != end) {
+      int marker_pos = marker - data;
 
-      if (!cursor.char_available())
-        break;
+      if (-1 != previous_pos)
+        handle_packet(memory_c::clone(data + previous_pos, marker_pos - previous_pos));
 
-      marker <<= 8;
-      marker  |= (unsigned int)cursor.get_char();
+      previous_pos = marker_pos;
+      m_stream_pos = previous_stream_pos + previous_pos;
+      marker       = mtx::mpeg::find_start_code(marker + 3, end);
     }
   }
 
   if (-1 == previous_pos)
     previous_pos = 0;
 
-  int new_size = cursor.get_size() - previous_pos;
-  if (0 != new_size) {
-    memory_cptr new_unparsed_buffer = memory_c::alloc(new_size);
-    cursor.copy(new_unparsed_buffer->get_buffer(), previous_pos, new_size);
-    m_unparsed_buffer = new_unparsed_buffer;
-
-  } else
-    m_unparsed_buffer.reset();
+  auto remaining_size = data_size - previous_pos;
+  m_unparsed_buffer.remove(previous_pos);
+  m_unparsed_scan_offset = remaining_size >= 3 ? remaining_size - 3 : 0;
 }
 
 void
 es_parser_c::flush() {
-  if (m_unparsed_buffer && (4 <= m_unparsed_buffer->get_size())) {
-    uint32_t marker = get_uint32_be(m_unparsed_buffer->get_buffer());
+  if (4 <= m_unparsed_buffer.get_size()) {
+    uint32_t marker = get_uint32_be(m_unparsed_buffer.get_buffer());
     if (is_marker(marker))
-      handle_packet(memory_c::clone(m_unparsed_buffer->get_buffer(), m_unparsed_buffer->get_size()));
+      handle_packet(memory_c::clone(m_unparsed_buffer.get_buffer(), m_unparsed_buffer.get_size()));
   }
 
-  m_unparsed_buffer.reset();
+  m_unparsed_buffer.clear();
+  m_unparsed_scan_offset = 0;
 
   flush_frame();
 }
@@ -604,9 +599,7 @@ es_parser_c::add_extra_data_if_not_present(std::deque<memory_cptr> &extra_data,
 void
 es_parser_c::add_timecode(int64_t timecode,
                           int64_t position) {
-  position += m_stream_pos;
-  if (m_unparsed_buffer)
-    position += m_unparsed_buffer->get_size();
+  position += m_stream_pos + m_unparsed_buffer.get_size();
 
   m_timecodes.push_back(timecode);
   m_timecode_positions.push_back(position);
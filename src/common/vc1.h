@@ -19,6 +19,7 @@
 
 #include <deque>
 
+#include "common/byte_buffer.h"
 #include "common/vc1_fwd.h"
 
 #define VC1_PROFILE_SIMPLE    0x00000000
@@ -155,7 +156,8 @@ protected:
   memory_cptr m_raw_seqhdr;
   memory_cptr m_raw_entrypoint;
 
-  memory_cptr m_unparsed_buffer;
+  byte_buffer_c m_unparsed_buffer;
+  std::size_t m_unparsed_scan_offset{};
 
   std::deque<memory_cptr> m_pre_frame_extra_data;
   std::deque<memory_cptr> m_post_frame_extra_data;
@@ -15,6 +15,7 @@
 
 #include "common/ebml.h"
 #include "common/iso639.h"
+#include "common/strings/editing.h"
 #include "common/strings/formatting.h"
 #include "common/strings/parsing.h"
 #include "common/translation.h"
@@ -70,6 +71,8 @@ extract_cli_parser_c::init_parser() {
   OPT("blockadd=level", set_blockadd, YT("Keep only the BlockAdditions up to this level (default: keep all levels)"));
   OPT("raw",            set_raw,      YT("Extract the data to a raw file."));
   OPT("fullraw",        set_fullraw,  YT("Extract the data to a raw file including the CodecPrivate as a header."));
+  OPT("range=start-end", set_range,   YT("Only extract the frames between the two timestamps. The cues are used for seeking to the key frame at or before 'start'."));
+  OPT("parallel",       set_parallel, YT("Process and write the tracks in one thread per destination file."));
   add_informational_option("TID:out", YT("Write track with the ID TID to the file 'out'."));
 
   add_section_header(YT("Example"));
@@ -178,6 +181,25 @@ extract_cli_parser_c::set_fullraw() {
   m_target_mode = track_spec_t::tm_full_raw;
 }
 
+void
+extract_cli_parser_c::set_range() {
+  assert_mode(options_c::em_tracks);
+
+  auto parts = split(m_next_arg, "-", 2);
+  if (   (2 != parts.size())
+      || !parse_timestamp(strip_copy(parts[0]), m_options.m_range_start)
+      || !parse_timestamp(strip_copy(parts[1]), m_options.m_range_end)
+      || (m_options.m_range_start >= m_options.m_range_end))
+    mxerror(boost::format(Y("Invalid range '%1%'. It must consist of two timestamps separated by '-' with the first one being smaller than the second one.\n")) % m_next_arg);
+}
+
+void
+extract_cli_parser_c::set_parallel() {
+  assert_mode(options_c::em_tracks);
+
+  m_options.m_parallel = true;
+}
+
 void
 extract_cli_parser_c::set_simple() {
   assert_mode(options_c::em_chapters);
@@ -48,6 +48,8 @@ protected:
   void set_blockadd();
   void set_raw();
   void set_fullraw();
+  void set_range();
+  void set_parallel();
   void set_simple();
   void set_simple_language();
   void set_mode_or_extraction_spec();
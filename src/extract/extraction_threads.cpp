@@ -0,0 +1,194 @@
+/*
+   mkvextract -- extract tracks from Matroska files into other files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   running the extractors in worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "extract/extraction_threads.h"
+#include "extract/xtr_base.h"
+
+struct extraction_threads_c::impl_t {
+  struct worker_t {
+    std::thread thread;
+    std::deque<std::function<void()>> queue;
+    std::condition_variable produced;
+  };
+
+  std::vector<std::unique_ptr<worker_t>> workers;
+  std::unordered_map<xtr_base_c *, worker_t *> workers_by_extractor;
+  std::size_t max_queued_jobs{};
+
+  std::mutex mutex;
+  std::condition_variable consumed;
+  bool finishing{}, aborting{};
+  std::exception_ptr error;
+
+  debugging_option_c debug{"extraction_threads"};
+};
+
+extraction_threads_c::extraction_threads_c(std::vector<xtr_base_c *> const &extractors,
+                                           std::size_t max_queued_jobs)
+  : m{new extraction_threads_c::impl_t{}}
+{
+  m->max_queued_jobs = std::max<std::size_t>(max_queued_jobs, 1);
+
+  // Extractors writing to the same file share their master's worker.
+  for (auto extractor : extractors) {
+    auto &worker = m->workers_by_extractor[extractor->m_master ? extractor->m_master : extractor];
+    if (!worker) {
+      m->workers.emplace_back(std::make_unique<impl_t::worker_t>());
+      worker = m->workers.back().get();
+    }
+
+    m->workers_by_extractor[extractor] = worker;
+  }
+}
+
+extraction_threads_c::~extraction_threads_c() {
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    m->aborting = true;
+  }
+
+  for (auto &worker : m->workers)
+    worker->produced.notify_all();
+
+  // Never join the calling thread, e.g. if a worker ends up here
+  // while the program is exiting.
+  for (auto &worker : m->workers)
+    if (worker->thread.joinable() && (worker->thread.get_id() != std::this_thread::get_id()))
+      worker->thread.join();
+}
+
+void
+extraction_threads_c::start() {
+  mxdebug_if(m->debug, boost::format("extraction_threads: starting %1% thread(s) for %2% extractor(s), at most %3% queued job(s) each\n") % m->workers.size() % m->workers_by_extractor.size() % m->max_queued_jobs);
+
+  for (auto idx = 0u; idx < m->workers.size(); ++idx)
+    m->workers[idx]->thread = std::thread{[this, idx]() { run(idx); }};
+}
+
+/** \brief Queue a job for an extractor's worker
+
+   Blocks while the worker's queue is full. Errors that occurred in
+   any of the worker threads are reported here.
+*/
+void
+extraction_threads_c::add(xtr_base_c &extractor,
+                          std::function<void()> job) {
+  auto &worker = *m->workers_by_extractor.at(&extractor);
+
+  {
+    std::unique_lock<std::mutex> lock{m->mutex};
+
+    m->consumed.wait(lock, [this, &worker]() { return m->error || (worker.queue.size() < m->max_queued_jobs); });
+
+    if (m->error)
+      handle_error(lock);
+
+    worker.queue.emplace_back(std::move(job));
+  }
+
+  worker.produced.notify_one();
+}
+
+/** \brief Wait until all queued jobs have been executed
+
+   Must be called before the extractors finish their tracks and
+   files. Errors that occurred in any of the worker threads are
+   reported here.
+*/
+void
+extraction_threads_c::finish() {
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    m->finishing = true;
+  }
+
+  for (auto &worker : m->workers)
+    worker->produced.notify_all();
+
+  for (auto &worker : m->workers)
+    if (worker->thread.joinable())
+      worker->thread.join();
+
+  std::unique_lock<std::mutex> lock{m->mutex};
+  if (m->error)
+    handle_error(lock);
+}
+
+/** \brief Report an error that occurred in a worker thread
+
+   Messages passed to mxerror() in a worker are reported again in the
+   calling thread which terminates the program as usual. All other
+   exceptions are re-thrown.
+*/
+void
+extraction_threads_c::handle_error(std::unique_lock<std::mutex> &lock) {
+  auto error = m->error;
+
+  lock.unlock();
+
+  try {
+    std::rethrow_exception(error);
+
+  } catch (mtx::output::error_x &ex) {
+    mxerror(ex.error());
+  }
+}
+
+void
+extraction_threads_c::run(std::size_t worker_idx) {
+  auto &worker = *m->workers[worker_idx];
+
+  mxerror_throws_in_this_thread();
+
+  try {
+    while (true) {
+      std::function<void()> job;
+
+      {
+        std::unique_lock<std::mutex> lock{m->mutex};
+
+        worker.produced.wait(lock, [this, &worker]() { return m->aborting || m->error || m->finishing || !worker.queue.empty(); });
+
+        if (m->aborting || m->error || worker.queue.empty())
+          break;
+
+        job = std::move(worker.queue.front());
+        worker.queue.pop_front();
+      }
+
+      m->consumed.notify_all();
+
+      job();
+    }
+
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock{m->mutex};
+      if (!m->error)
+        m->error = std::current_exception();
+    }
+
+    // Wake up the other workers and a producer waiting for room in
+    // any of the queues.
+    for (auto &other : m->workers)
+      other->produced.notify_all();
+
+    m->consumed.notify_all();
+  }
+}
@@ -0,0 +1,49 @@
+/*
+   mkvextract -- extract tracks from Matroska files into other files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   running the extractors in worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_EXTRACT_EXTRACTION_THREADS_H
+#define MTX_EXTRACT_EXTRACTION_THREADS_H
+
+#include "common/common_pch.h"
+
+#include <mutex>
+
+class xtr_base_c;
+
+/* Runs the extractors on one thread per destination file. Extractors
+   writing to the same file share a thread. The demuxing thread stays
+   the only producer: it queues one job per frame or codec state, and
+   each thread executes the jobs for its extractors in the order they
+   were queued. Therefore the output is the same as without threads.
+
+   Errors in a worker thread, including calls to mxerror(), are
+   forwarded to the demuxing thread and reported there.
+*/
+class extraction_threads_c {
+private:
+  struct impl_t;
+  std::unique_ptr<impl_t> m;
+
+public:
+  extraction_threads_c(std::vector<xtr_base_c *> const &extractors, std::size_t max_queued_jobs);
+  ~extraction_threads_c();
+
+  void start();
+  void add(xtr_base_c &extractor, std::function<void()> job);
+  void finish();
+
+private:
+  void run(std::size_t worker_idx);
+  void handle_error(std::unique_lock<std::mutex> &lock);
+};
+
+#endif // MTX_EXTRACT_EXTRACTION_THREADS_H
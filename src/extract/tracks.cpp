@@ -13,6 +13,7 @@
 #include "common/common_pch.h"
 
 #include <cassert>
+#include <unordered_map>
 
 #include <ebml/EbmlHead.h>
 #include <ebml/EbmlSubHead.h>
@@ -24,6 +25,8 @@
 #include <matroska/KaxBlockData.h>
 #include <matroska/KaxCluster.h>
 #include <matroska/KaxClusterData.h>
+#include <matroska/KaxCues.h>
+#include <matroska/KaxCuesData.h>
 #include <matroska/KaxInfo.h>
 #include <matroska/KaxInfoData.h>
 #include <matroska/KaxSegment.h>
@@ -36,7 +39,9 @@
 #include "common/ebml.h"
 #include "common/kax_file.h"
 #include "common/mm_io_x.h"
+#include "common/mm_read_buffer_io.h"
 #include "common/mm_write_buffer_io.h"
+#include "extract/extraction_threads.h"
 #include "extract/mkvextract.h"
 #include "extract/xtr_base.h"
 
@@ -44,6 +49,20 @@ using namespace libmatroska;
 
 static std::vector<xtr_base_c *> extractors;
 
+// Only used if the extractors run in threads of their own.
+static std::unique_ptr<extraction_threads_c> s_extraction_threads;
+
+// Only used if a range is extracted. Each track's frames up to the
+// start of the range are held back until it is known which key frame
+// extraction starts at: the last one at or before the start.
+struct range_start_state_t {
+  bool started{};
+  std::vector<std::function<void()>> held_back_frames;
+};
+
+static timestamp_c s_range_start;
+static std::unordered_map<xtr_base_c *, range_start_state_t> s_range_start_states;
+
 // ------------------------------------------------------------------------
 
 static void
@@ -121,16 +140,104 @@ create_extractors(KaxTracks &kax_tracks,
     extractors[i]->headers_done();
 }
 
+/** \brief Pass a frame on to its extractor
+
+   If the extractors run in threads then the frame is queued for the
+   extractor's thread. The frame and the block additions point into
+   the cluster; the job therefore keeps the cluster alive.
+*/
+static void
+pass_frame_on(xtr_base_c &extractor,
+              xtr_frame_t &f,
+              std::shared_ptr<KaxCluster> const &cluster) {
+  if (!s_extraction_threads) {
+    extractor.decode_and_handle_frame(f);
+    return;
+  }
+
+  // f.frame refers to a variable of the caller. The job uses its own
+  // copy of the pointer instead.
+  s_extraction_threads->add(extractor, [&extractor, cluster, f, frame = f.frame]() mutable {
+    auto job_f = xtr_frame_t{frame, f.additions, f.timecode, f.duration, f.bref, f.fref, f.keyframe, f.discardable, f.references_valid, f.discard_duration};
+    extractor.decode_and_handle_frame(job_f);
+  });
+}
+
+static void
+start_range(range_start_state_t &state) {
+  state.started = true;
+
+  for (auto const &frame : state.held_back_frames)
+    frame();
+
+  state.held_back_frames.clear();
+}
+
+/** \brief Pass a frame on to its extractor unless it precedes the range
+
+   Frames at or before the start of the range are only passed on
+   starting with the last key frame at or before it. Until a frame
+   after the start is seen it isn't known which key frame that is;
+   therefore they're held back until then.
+*/
+static void
+decode_and_handle_frame(xtr_base_c &extractor,
+                        xtr_frame_t &f,
+                        bool key_frame,
+                        std::shared_ptr<KaxCluster> const &cluster) {
+  if (!s_range_start.valid()) {
+    pass_frame_on(extractor, f, cluster);
+    return;
+  }
+
+  auto &state = s_range_start_states[&extractor];
+
+  if (!state.started) {
+    if (f.timecode > s_range_start.to_ns())
+      start_range(state);
+
+    else {
+      if (key_frame)
+        state.held_back_frames.clear();
+
+      if (key_frame || !state.held_back_frames.empty())
+        state.held_back_frames.emplace_back([&extractor, cluster, f, frame = f.frame]() mutable {
+          auto held_f = xtr_frame_t{frame, f.additions, f.timecode, f.duration, f.bref, f.fref, f.keyframe, f.discardable, f.references_valid, f.discard_duration};
+          pass_frame_on(extractor, held_f, cluster);
+        });
+
+      return;
+    }
+  }
+
+  pass_frame_on(extractor, f, cluster);
+}
+
+static void
+handle_codec_state(xtr_base_c &extractor,
+                   memory_cptr &codec_state,
+                   std::shared_ptr<KaxCluster> const &cluster) {
+  if (!s_extraction_threads) {
+    extractor.handle_codec_state(codec_state);
+    return;
+  }
+
+  s_extraction_threads->add(extractor, [&extractor, cluster, codec_state]() mutable {
+    extractor.handle_codec_state(codec_state);
+  });
+}
+
 static int64_t
 handle_blockgroup(KaxBlockGroup &blockgroup,
-                  KaxCluster &cluster,
-                  int64_t tc_scale) {
+                  std::shared_ptr<KaxCluster> const &cluster,
+                  int64_t tc_scale,
+                  timestamp_c const &range_end) {
   // Only continue if this block group actually contains a block.
   KaxBlock *block = FindChild<KaxBlock>(&blockgroup);
   if (!block || (0 == block->NumberFrames()))
     return -1;
 
-  block->SetParent(cluster);
+  block->SetParent(*cluster);
 
   // Do we need this block group?
   xtr_base_c *extractor = nullptr;
@@ -152,6 +259,7 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
   int64_t bref    = 0;
   int64_t fref    = 0;
   auto kreference = FindChild<KaxReferenceBlock>(&blockgroup);
+  auto key_frame  = !kreference;
   for (i = 0; (2 > i) && kreference; i++) {
     if (0 > kreference->GetValue())
       bref = kreference->GetValue();
@@ -169,7 +277,7 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
   KaxCodecState *kcstate = FindChild<KaxCodecState>(&blockgroup);
   if (kcstate) {
     memory_cptr codec_state(new memory_c(kcstate->GetBuffer(), kcstate->GetSize(), false));
-    extractor->handle_codec_state(codec_state);
+    handle_codec_state(*extractor, codec_state, cluster);
   }
 
   for (i = 0; i < block->NumberFrames(); i++) {
@@ -184,6 +292,9 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
       this_duration = duration / block->NumberFrames();
     }
 
+    if (range_end.valid() && (this_timecode >= range_end.to_ns()))
+      continue;
+
     auto discard_padding  = timestamp_c::ns(0);
     auto kdiscard_padding = FindChild<KaxDiscardPadding>(blockgroup);
     if (kdiscard_padding)
@@ -192,7 +303,7 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
     auto &data = block->GetBuffer(i);
     auto frame = std::make_shared<memory_c>(data.Buffer(), data.Size(), false);
     auto f     = xtr_frame_t{frame, kadditions, this_timecode, this_duration, bref, fref, false, false, true, discard_padding};
-    extractor->decode_and_handle_frame(f);
+    decode_and_handle_frame(*extractor, f, key_frame, cluster);
 
     max_timecode = std::max(max_timecode, this_timecode);
   }
@@ -202,11 +313,12 @@ handle_blockgroup(KaxBlockGroup &blockgroup,
 
 static int64_t
 handle_simpleblock(KaxSimpleBlock &simpleblock,
-                   KaxCluster &cluster) {
+                   std::shared_ptr<KaxCluster> const &cluster,
+                   timestamp_c const &range_end) {
   if (0 == simpleblock.NumberFrames())
     return - 1;
 
-  simpleblock.SetParent(cluster);
+  simpleblock.SetParent(*cluster);
 
   // Do we need this block group?
   xtr_base_c *extractor = nullptr;
@@ -234,10 +346,13 @@ handle_simpleblock(KaxSimpleBlock &simpleblock,
       this_duration = duration / simpleblock.NumberFrames();
     }
 
+    if (range_end.valid() && (this_timecode >= range_end.to_ns()))
+      continue;
+
     auto &data = simpleblock.GetBuffer(i);
     auto frame = std::make_shared<memory_c>(data.Buffer(), data.Size(), false);
     auto f     = xtr_frame_t{frame, nullptr, this_timecode, this_duration, -1, -1, simpleblock.IsKeyframe(), simpleblock.IsDiscardable(), false, timestamp_c::ns(0)};
-    extractor->decode_and_handle_frame(f);
+    decode_and_handle_frame(*extractor, f, simpleblock.IsKeyframe(), cluster);
 
     max_timecode = std::max(max_timecode, this_timecode);
   }
@@ -249,6 +364,18 @@ static void
 close_extractors() {
   size_t i;
 
+  // Tracks ending at or before the start of the range.
+  for (auto &state : s_range_start_states)
+    if (!state.second.started)
+      start_range(state.second);
+
+  s_range_start_states.clear();
+
+  if (s_extraction_threads) {
+    s_extraction_threads->finish();
+    s_extraction_threads.reset();
+  }
+
   for (i = 0; i < extractors.size(); i++)
     extractors[i]->finish_track();
 
@@ -342,10 +469,115 @@ handle_segment_info(EbmlMaster *info,
   file->set_timecode_scale(tc_scale);
 }
 
+static void
+collect_chapters(KaxChapters &chapters,
+                 KaxChapters &all_chapters) {
+  while (chapters.ListSize() > 0) {
+    if (Is<KaxEditionEntry>(chapters[0])) {
+      KaxEditionEntry &entry = *static_cast<KaxEditionEntry *>(chapters[0]);
+      while (entry.ListSize() > 0) {
+        if (Is<KaxChapterAtom>(entry[0]))
+          all_chapters.PushElement(*entry[0]);
+        entry.Remove(0);
+      }
+    }
+    chapters.Remove(0);
+  }
+}
+
+static void
+collect_tags(KaxTags &tags,
+             KaxTags &all_tags) {
+  while (tags.ListSize() > 0) {
+    all_tags.PushElement(*tags[0]);
+    tags.Remove(0);
+  }
+}
+
+/** \brief Find the position of the cluster to start extracting a range at
+
+   For each track to extract the latest cue point at or before \c
+   range_start referencing that track is used, or the latest cue point
+   of any track at or before it for tracks without cue points. Returns
+   the absolute position of the earliest of the clusters referenced by
+   them.
+*/
+static boost::optional<uint64_t>
+find_range_start_position(kax_analyzer_c &analyzer,
+                          timestamp_c const &range_start,
+                          uint64_t tc_scale) {
+  auto cues_m = analyzer.read_all(EBML_INFO(KaxCues));
+  auto cues   = dynamic_cast<KaxCues *>(cues_m.get());
+
+  if (!cues)
+    return boost::none;
+
+  struct cue_t {
+    uint64_t timecode, position;
+  };
+
+  boost::optional<cue_t> latest_cue;
+
+  auto update = [](boost::optional<cue_t> &latest, cue_t const &cue) {
+    if (   !latest
+        || (cue.timecode > latest->timecode)
+        || ((cue.timecode == latest->timecode) && (cue.position < latest->position)))
+      latest = cue;
+  };
+
+  std::unordered_map<uint64_t, boost::optional<cue_t>> latest_cues_by_track;
+
+  for (auto const &elt : *cues) {
+    auto kcue_point = dynamic_cast<KaxCuePoint *>(elt);
+    auto ktime      = kcue_point ? FindChild<KaxCueTime>(*kcue_point) : nullptr;
+    if (!ktime)
+      continue;
+
+    auto timecode = ktime->GetValue() * tc_scale;
+    if (timecode > static_cast<uint64_t>(range_start.to_ns()))
+      continue;
+
+    for (auto const &cue_elt : *kcue_point) {
+      auto ktrack_pos = dynamic_cast<KaxCueTrackPositions *>(cue_elt);
+      auto kposition  = ktrack_pos ? FindChild<KaxCueClusterPosition>(*ktrack_pos) : nullptr;
+      if (!kposition)
+        continue;
+
+      auto ktrack = FindChild<KaxCueTrack>(*ktrack_pos);
+      auto cue    = cue_t{timecode, kposition->GetValue()};
+
+      update(latest_cue, cue);
+      if (ktrack)
+        update(latest_cues_by_track[ktrack->GetValue()], cue);
+    }
+  }
+
+  if (!latest_cue)
+    return boost::none;
+
+  boost::optional<uint64_t> position;
+
+  for (auto const &extractor : extractors) {
+    auto itr = latest_cues_by_track.find(extractor->m_track_num);
+    auto cue = itr != latest_cues_by_track.end() ? *itr->second : *latest_cue;
+
+    if (!position || (cue.position < position.get()))
+      position = cue.position;
+  }
+
+  if (!position)
+    return boost::none;
+
+  return analyzer.get_segment_data_start_pos() + position.get();
+}
+
 bool
 extract_tracks(const std::string &file_name,
                std::vector<track_spec_t> &tspecs,
-               kax_analyzer_c::parse_mode_e parse_mode) {
+               kax_analyzer_c::parse_mode_e parse_mode,
+               timestamp_c const &range_start,
+               timestamp_c const &range_end,
+               bool parallel) {
   if (tspecs.empty())
     mxerror(Y("Nothing to do.\n"));
 
@@ -353,7 +585,7 @@ extract_tracks(const std::string &file_name,
   mm_io_cptr in;
   kax_file_cptr file;
   try {
-    in   = mm_file_io_c::open(file_name);
+    in   = mm_read_ahead_buffer_io_c::open(file_name, 1024 * 1024, 16);
     file = std::make_shared<kax_file_c>(*in);
   } catch (mtx::mm_io::exception &ex) {
     show_error(boost::format(Y("The file '%1%' could not be opened for reading: %2%.\n")) % file_name % ex);
@@ -383,6 +615,35 @@ extract_tracks(const std::string &file_name,
     }
   }
 
+  // When extracting a range, seek directly to the cluster referenced
+  // by the cue point at or before its start. Level 1 elements located
+  // after the clusters are skipped, therefore chapters & tags for cue
+  // sheets are taken from the analyzer. Either way the frames before
+  // the start are dropped by decode_and_handle_frame().
+  boost::optional<uint64_t> range_start_position;
+  KaxChapters all_chapters;
+  KaxTags all_tags;
+
+  s_range_start = range_start;
+
+  if (range_start.valid()) {
+    if (analyzer && tracks_found)
+      range_start_position = find_range_start_position(*analyzer, range_start, tc_scale);
+
+    if (!range_start_position)
+      mxwarn(Y("No cues were found for the start of the range. The file will be read from the start.\n"));
+
+    else {
+      auto af_chapters = ebml_master_cptr{ analyzer->read_all(EBML_INFO(KaxChapters)) };
+      if (dynamic_cast<KaxChapters *>(af_chapters.get()))
+        collect_chapters(*static_cast<KaxChapters *>(af_chapters.get()), all_chapters);
+
+      auto af_tags = ebml_master_cptr{ analyzer->read_all(EBML_INFO(KaxTags)) };
+      if (dynamic_cast<KaxTags *>(af_tags.get()))
+        collect_tags(*static_cast<KaxTags *>(af_tags.get()), all_tags);
+    }
+  }
+
   try {
     in->setFilePointer(0);
     EbmlStream *es = new EbmlStream(*in);
@@ -420,8 +681,8 @@ extract_tracks(const std::string &file_name,
 
     EbmlElement *l1   = nullptr;
 
-    KaxChapters all_chapters;
-    KaxTags all_tags;
+    if (range_start_position)
+      in->setFilePointer(range_start_position.get());
 
     while ((l1 = file->read_next_level1_element())) {
       if (Is<KaxInfo>(l1) && !segment_info_found) {
@@ -435,7 +696,13 @@ extract_tracks(const std::string &file_name,
 
       } else if (Is<KaxCluster>(l1)) {
         show_element(l1, 1, Y("Cluster"));
-        KaxCluster *cluster = static_cast<KaxCluster *>(l1);
+        auto cluster = std::shared_ptr<KaxCluster>{static_cast<KaxCluster *>(l1)};
+        l1           = nullptr;
+
+        if (parallel && !s_extraction_threads && !extractors.empty()) {
+          s_extraction_threads = std::make_unique<extraction_threads_c>(extractors, 128);
+          s_extraction_threads->start();
+        }
 
         if (0 == verbose) {
           auto current_percentage = in->getFilePointer() * 100 / file_size;
@@ -446,13 +713,14 @@ extract_tracks(const std::string &file_name,
             mxinfo(boost::format(Y("Progress: %1%%%%2%")) % current_percentage % "\r");
         }
 
-        KaxClusterTimecode *ctc = FindChild<KaxClusterTimecode>(l1);
-        if (ctc) {
-          uint64_t cluster_tc = ctc->GetValue();
+        KaxClusterTimecode *ctc = FindChild<KaxClusterTimecode>(*cluster);
+        uint64_t cluster_tc     = ctc ? ctc->GetValue() : 0;
+        if (ctc)
           show_element(ctc, 2, boost::format(Y("Cluster timecode: %|1$.3f|s")) % ((float)cluster_tc * (float)tc_scale / 1000000000.0));
-          cluster->InitTimecode(cluster_tc, tc_scale);
-        } else
-          cluster->InitTimecode(0, tc_scale);
+        cluster->InitTimecode(cluster_tc, tc_scale);
+
+        if (range_end.valid() && (static_cast<int64_t>(cluster_tc * tc_scale) >= range_end.to_ns()))
+          break;
 
         size_t i;
         int64_t max_timecode = -1;
@@ -463,11 +731,11 @@ extract_tracks(const std::string &file_name,
 
           if (Is<KaxBlockGroup>(el)) {
             show_element(el, 2, Y("Block group"));
-            max_bg_timecode = handle_blockgroup(*static_cast<KaxBlockGroup *>(el), *cluster, tc_scale);
+            max_bg_timecode = handle_blockgroup(*static_cast<KaxBlockGroup *>(el), cluster, tc_scale, range_end);
 
           } else if (Is<KaxSimpleBlock>(el)) {
             show_element(el, 2, Y("SimpleBlock"));
-            max_bg_timecode = handle_simpleblock(*static_cast<KaxSimpleBlock *>(el), *cluster);
+            max_bg_timecode = handle_simpleblock(*static_cast<KaxSimpleBlock *>(el), cluster, range_end);
           }
 
           max_timecode = std::max(max_timecode, max_bg_timecode);
@@ -476,30 +744,11 @@ extract_tracks(const std::string &file_name,
         if (-1 != max_timecode)
           file->set_last_timecode(max_timecode);
 
-      } else if (Is<KaxChapters>(l1)) {
-        KaxChapters &chapters = *static_cast<KaxChapters *>(l1);
-
-        while (chapters.ListSize() > 0) {
-          if (Is<KaxEditionEntry>(chapters[0])) {
-            KaxEditionEntry &entry = *static_cast<KaxEditionEntry *>(chapters[0]);
-            while (entry.ListSize() > 0) {
-              if (Is<KaxChapterAtom>(entry[0]))
-                all_chapters.PushElement(*entry[0]);
-              entry.Remove(0);
-            }
-          }
-          chapters.Remove(0);
-        }
+      } else if (Is<KaxChapters>(l1) && !range_start_position)
+        collect_chapters(*static_cast<KaxChapters *>(l1), all_chapters);
 
-      } else if (Is<KaxTags>(l1)) {
-        KaxTags &tags = *static_cast<KaxTags *>(l1);
-
-        while (tags.ListSize() > 0) {
-          all_tags.PushElement(*tags[0]);
-          tags.Remove(0);
-        }
-
-      }
+      else if (Is<KaxTags>(l1) && !range_start_position)
+        collect_tags(*static_cast<KaxTags *>(l1), all_tags);
 
       delete l1;
 
@@ -523,7 +772,13 @@ extract_tracks(const std::string &file_name,
     }
 
     return true;
+  } catch (mtx::exception &ex) {
+    s_extraction_threads.reset();
+    show_error(boost::format(Y("Caught exception: %1%")) % ex);
+
+    return false;
   } catch (...) {
+    s_extraction_threads.reset();
     show_error(Y("Caught exception"));
 
     return false;
@@ -46,6 +46,9 @@ info_cli_parser_c::init_parser() {
   OPT("X|full-hexdump",  set_full_hexdump,  YT("Show all bytes of each frame as a hex dump."));
   OPT("p|hex-positions", set_hex_positions, YT("Show positions in hexadecimal."));
   OPT("z|size",          set_size,          YT("Show the size of each element including its header."));
+  OPT("statistics",      set_statistics,    YT("Only output statistics for each track in JSON format. Only the headers of the blocks are read, not the frames themselves."));
+  OPT("statistics-from-cues", set_statistics_from_cues, YT("Same as '--statistics' but calculate the statistics from the cues if the file contains them. "
+                                                           "Only the number of key frames, the intervals between them and the range of timestamps are available in that case."));
 
   add_common_options();
 
@@ -124,6 +127,17 @@ info_cli_parser_c::set_hex_positions() {
   m_options.m_hex_positions = true;
 }
 
+void
+info_cli_parser_c::set_statistics() {
+  m_options.m_statistics = true;
+}
+
+void
+info_cli_parser_c::set_statistics_from_cues() {
+  m_options.m_statistics           = true;
+  m_options.m_statistics_from_cues = true;
+}
+
 options_c
 info_cli_parser_c::run() {
   init_parser();
@@ -77,6 +77,7 @@
 #include "common/xml/ebml_tags_converter.h"
 #include "info/mkvinfo.h"
 #include "info/info_cli_parser.h"
+#include "info/statistics.h"
 
 using namespace libmatroska;
 
@@ -1862,6 +1863,9 @@ console_main() {
   if (g_options.m_file_name.empty())
     mxerror(Y("No file name given.\n"));
 
+  if (g_options.m_statistics)
+    return show_statistics(g_options.m_file_name, g_options.m_statistics_from_cues) ? 0 : 1;
+
   return process_file(g_options.m_file_name.c_str()) ? 0 : 1;
 }
 
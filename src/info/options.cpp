@@ -21,6 +21,8 @@ options_c::options_c()
   , m_show_size(false)
   , m_show_track_info(false)
   , m_hex_positions{}
+  , m_statistics{}
+  , m_statistics_from_cues{}
   , m_hexdump_max_size(16)
   , m_verbose(0)
 {
@@ -0,0 +1,610 @@
+/*
+   mkvinfo -- utility for gathering information about Matroska files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   per-track statistics gathered from block headers or cues
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/json.h"
+#include "common/mm_io_x.h"
+#include "common/mm_read_buffer_io.h"
+#include "common/output.h"
+#include "info/mkvinfo.h"
+#include "info/statistics.h"
+
+namespace {
+
+// Level 0 & 1
+uint32_t const s_id_ebml_head           = 0x1a45dfa3;
+uint32_t const s_id_segment             = 0x18538067;
+uint32_t const s_id_seek_head           = 0x114d9b74;
+uint32_t const s_id_info                = 0x1549a966;
+uint32_t const s_id_tracks              = 0x1654ae6b;
+uint32_t const s_id_cues                = 0x1c53bb6b;
+uint32_t const s_id_cluster             = 0x1f43b675;
+uint32_t const s_id_attachments         = 0x1941a469;
+uint32_t const s_id_chapters            = 0x1043a770;
+uint32_t const s_id_tags                = 0x1254c367;
+
+// Seek head
+uint32_t const s_id_seek                = 0x4dbb;
+uint32_t const s_id_seek_id             = 0x53ab;
+uint32_t const s_id_seek_position       = 0x53ac;
+
+// Segment info
+uint32_t const s_id_timestamp_scale     = 0x2ad7b1;
+
+// Tracks
+uint32_t const s_id_track_entry         = 0xae;
+uint32_t const s_id_track_number        = 0xd7;
+uint32_t const s_id_track_type          = 0x83;
+uint32_t const s_id_codec_id            = 0x86;
+uint32_t const s_id_default_duration    = 0x23e383;
+
+// Cues
+uint32_t const s_id_cue_point           = 0xbb;
+uint32_t const s_id_cue_time            = 0xb3;
+uint32_t const s_id_cue_track_positions = 0xb7;
+uint32_t const s_id_cue_track           = 0xf7;
+
+// Clusters
+uint32_t const s_id_cluster_timestamp   = 0xe7;
+uint32_t const s_id_simple_block        = 0xa3;
+uint32_t const s_id_block_group         = 0xa0;
+uint32_t const s_id_block               = 0xa1;
+uint32_t const s_id_block_duration      = 0x9b;
+uint32_t const s_id_reference_block     = 0xfb;
+
+unsigned int const s_lacing_xiph        = 1;
+unsigned int const s_lacing_ebml        = 3;
+
+struct element_t {
+  uint32_t id{};
+  uint64_t data_position{}, size{};
+  bool unknown_size{};
+
+  uint64_t
+  end()
+    const {
+    return data_position + size;
+  }
+};
+
+struct track_t {
+  uint64_t number{}, type{}, default_duration{};
+  std::string codec_id;
+
+  uint64_t num_frames{}, num_key_frames{}, size{};
+  boost::optional<int64_t> first_timestamp, last_timestamp, end_timestamp, previous_key_frame;
+
+  uint64_t num_key_frame_intervals{};
+  int64_t min_key_frame_interval{}, max_key_frame_interval{}, sum_key_frame_intervals{};
+
+  void add_timestamp(int64_t timestamp, int64_t duration);
+  void add_key_frame(int64_t timestamp);
+  nlohmann::json to_json(bool from_cues) const;
+};
+
+void
+track_t::add_timestamp(int64_t timestamp,
+                       int64_t duration) {
+  first_timestamp = std::min(first_timestamp.value_or(timestamp), timestamp);
+  last_timestamp  = std::max(last_timestamp.value_or(timestamp),  timestamp);
+  end_timestamp   = std::max(end_timestamp.value_or(timestamp),   timestamp + duration);
+}
+
+void
+track_t::add_key_frame(int64_t timestamp) {
+  ++num_key_frames;
+
+  if (previous_key_frame && (timestamp > *previous_key_frame)) {
+    auto interval           = timestamp - *previous_key_frame;
+    min_key_frame_interval  = num_key_frame_intervals ? std::min(min_key_frame_interval, interval) : interval;
+    max_key_frame_interval  = std::max(max_key_frame_interval, interval);
+    sum_key_frame_intervals += interval;
+    ++num_key_frame_intervals;
+  }
+
+  previous_key_frame = timestamp;
+}
+
+nlohmann::json
+track_t::to_json(bool from_cues)
+  const {
+  static std::map<uint64_t, std::string> const s_types{
+    { 0x01, "video"     },
+    { 0x02, "audio"     },
+    { 0x03, "complex"   },
+    { 0x10, "logo"      },
+    { 0x11, "subtitles" },
+    { 0x12, "buttons"   },
+    { 0x20, "control"   },
+  };
+
+  auto type_itr = s_types.find(type);
+  auto duration = end_timestamp && first_timestamp ? *end_timestamp - *first_timestamp : 0;
+
+  auto json = nlohmann::json{
+    { "number",             number                                                                },
+    { "type",               type_itr != s_types.end() ? type_itr->second : std::string{}          },
+    { "codec_id",           codec_id                                                              },
+    { "key_frames",         num_key_frames                                                        },
+    { "first_timestamp",    first_timestamp ? nlohmann::json(*first_timestamp) : nlohmann::json{} },
+    { "last_timestamp",     last_timestamp  ? nlohmann::json(*last_timestamp)  : nlohmann::json{} },
+    { "key_frame_interval", nullptr                                                               },
+    { "frames",             nullptr                                                               },
+    { "size",               nullptr                                                               },
+    { "duration",           nullptr                                                               },
+    { "bitrate",            nullptr                                                               },
+  };
+
+  if (num_key_frame_intervals)
+    json["key_frame_interval"] = nlohmann::json{
+      { "minimum", min_key_frame_interval                                                },
+      { "maximum", max_key_frame_interval                                                },
+      { "average", sum_key_frame_intervals / static_cast<int64_t>(num_key_frame_intervals) },
+    };
+
+  // The cues contain neither the number of frames nor their sizes.
+  if (from_cues)
+    return json;
+
+  json["frames"]   = num_frames;
+  json["size"]     = size;
+  json["duration"] = duration;
+  json["bitrate"]  = duration ? static_cast<uint64_t>(size * 8000000000.0 / duration) : 0;
+
+  return json;
+}
+
+class statistics_c {
+protected:
+  mm_io_c &m_in;
+  bool m_from_cues;
+  uint64_t m_timestamp_scale, m_segment_data_position;
+  boost::optional<uint64_t> m_cues_position;
+  std::vector<track_t> m_tracks;
+  std::unordered_map<uint64_t, size_t> m_track_indexes;
+
+public:
+  statistics_c(mm_io_c &in, bool from_cues);
+
+  bool process();
+  nlohmann::json to_json() const;
+
+protected:
+  bool read_element_head(uint64_t position, element_t &element);
+  uint64_t read_vint(unsigned int max_length, unsigned int &length, bool keep_marker);
+  uint64_t read_uint(element_t const &element);
+  std::string read_string(element_t const &element);
+
+  template<typename Tfunc>
+  void for_each_child(element_t const &parent, Tfunc const &handle_child);
+
+  void handle_seek_head(element_t const &seek_head);
+  void handle_info(element_t const &info);
+  void handle_tracks(element_t const &tracks);
+  void handle_cues(element_t const &cues);
+  uint64_t handle_cluster(element_t const &cluster, uint64_t segment_end);
+  void handle_block_group(element_t const &block_group, uint64_t cluster_timestamp);
+  void handle_block(element_t const &block, uint64_t cluster_timestamp, bool simple_block, boost::optional<uint64_t> duration, unsigned int num_references);
+
+  track_t *find_track(uint64_t number);
+};
+
+statistics_c::statistics_c(mm_io_c &in,
+                           bool from_cues)
+  : m_in(in)
+  , m_from_cues{from_cues}
+  , m_timestamp_scale{TIMECODE_SCALE}
+  , m_segment_data_position{}
+{
+}
+
+uint64_t
+statistics_c::read_vint(unsigned int max_length,
+                        unsigned int &length,
+                        bool keep_marker) {
+  auto first = m_in.read_uint8();
+
+  for (length = 1; length <= max_length; ++length)
+    if (first & (0x80 >> (length - 1)))
+      break;
+
+  if (length > max_length)
+    throw mtx::mm_io::end_of_file_x{};
+
+  uint64_t value = keep_marker ? first : first & (0xff >> length);
+  for (auto idx = 1u; idx < length; ++idx)
+    value = (value << 8) | m_in.read_uint8();
+
+  return value;
+}
+
+bool
+statistics_c::read_element_head(uint64_t position,
+                                element_t &element) {
+  try {
+    auto length = 0u;
+
+    m_in.setFilePointer(position);
+
+    element.id            = read_vint(4, length, true);
+    element.size          = read_vint(8, length, false);
+    element.unknown_size  = element.size == (~uint64_t{} >> (64 - 7 * length));
+    element.data_position = m_in.getFilePointer();
+
+    return true;
+
+  } catch (mtx::mm_io::exception &) {
+    return false;
+  }
+}
+
+uint64_t
+statistics_c::read_uint(element_t const &element) {
+  if (element.size > 8)
+    return 0;
+
+  m_in.setFilePointer(element.data_position);
+
+  auto value = uint64_t{};
+  for (auto idx = 0u; idx < element.size; ++idx)
+    value = (value << 8) | m_in.read_uint8();
+
+  return value;
+}
+
+std::string
+statistics_c::read_string(element_t const &element) {
+  if (element.size > 1024)
+    return {};
+
+  std::string value(element.size, '\0');
+
+  m_in.setFilePointer(element.data_position);
+  if (m_in.read(&value[0], element.size) != element.size)
+    throw mtx::mm_io::end_of_file_x{};
+
+  return value.substr(0, value.find('\0'));
+}
+
+template<typename Tfunc>
+void
+statistics_c::for_each_child(element_t const &parent,
+                             Tfunc const &handle_child) {
+  auto position = parent.data_position;
+  element_t child;
+
+  while ((position < parent.end()) && read_element_head(position, child) && !child.unknown_size && (child.end() <= parent.end())) {
+    handle_child(child);
+    position = child.end();
+  }
+}
+
+void
+statistics_c::handle_seek_head(element_t const &seek_head) {
+  for_each_child(seek_head, [this](element_t const &seek) {
+    if (s_id_seek != seek.id)
+      return;
+
+    auto id       = uint64_t{};
+    auto position = boost::optional<uint64_t>{};
+
+    for_each_child(seek, [this, &id, &position](element_t const &child) {
+      if (s_id_seek_id == child.id)
+        id = read_uint(child);
+      else if (s_id_seek_position == child.id)
+        position = read_uint(child);
+    });
+
+    if ((s_id_cues == id) && position)
+      m_cues_position = m_segment_data_position + *position;
+  });
+}
+
+void
+statistics_c::handle_info(element_t const &info) {
+  for_each_child(info, [this](element_t const &child) {
+    if (s_id_timestamp_scale == child.id)
+      m_timestamp_scale = read_uint(child);
+  });
+}
+
+void
+statistics_c::handle_tracks(element_t const &tracks) {
+  for_each_child(tracks, [this](element_t const &entry) {
+    if (s_id_track_entry != entry.id)
+      return;
+
+    track_t track;
+
+    for_each_child(entry, [this, &track](element_t const &child) {
+      if (s_id_track_number == child.id)
+        track.number = read_uint(child);
+      else if (s_id_track_type == child.id)
+        track.type = read_uint(child);
+      else if (s_id_default_duration == child.id)
+        track.default_duration = read_uint(child);
+      else if (s_id_codec_id == child.id)
+        track.codec_id = read_string(child);
+    });
+
+    if (!track.number || m_track_indexes.count(track.number))
+      return;
+
+    m_track_indexes[track.number] = m_tracks.size();
+    m_tracks.push_back(track);
+  });
+}
+
+void
+statistics_c::handle_cues(element_t const &cues) {
+  for_each_child(cues, [this](element_t const &point) {
+    if (s_id_cue_point != point.id)
+      return;
+
+    auto timestamp = int64_t{};
+    std::vector<uint64_t> track_numbers;
+
+    for_each_child(point, [this, &timestamp, &track_numbers](element_t const &child) {
+      if (s_id_cue_time == child.id)
+        timestamp = read_uint(child) * m_timestamp_scale;
+
+      else if (s_id_cue_track_positions == child.id)
+        for_each_child(child, [this, &track_numbers](element_t const &position) {
+          if (s_id_cue_track == position.id)
+            track_numbers.push_back(read_uint(position));
+        });
+    });
+
+    for (auto number : track_numbers) {
+      auto track = find_track(number);
+      if (!track)
+        continue;
+
+      track->add_timestamp(timestamp, 0);
+      track->add_key_frame(timestamp);
+    }
+  });
+}
+
+/** \brief Gather the statistics for all blocks in a cluster
+
+   Returns the position following the cluster. For clusters with an
+   unknown size that is the position of the first level 1 element
+   following it.
+*/
+uint64_t
+statistics_c::handle_cluster(element_t const &cluster,
+                             uint64_t segment_end) {
+  static std::vector<uint32_t> const s_level1_ids{ s_id_seek_head, s_id_info, s_id_tracks, s_id_cues, s_id_cluster, s_id_attachments, s_id_chapters, s_id_tags };
+
+  auto end               = cluster.unknown_size ? segment_end : std::min(cluster.end(), segment_end);
+  auto position          = cluster.data_position;
+  auto cluster_timestamp = uint64_t{};
+  element_t child;
+
+  while ((position < end) && read_element_head(position, child)) {
+    if (cluster.unknown_size && (brng::find(s_level1_ids, child.id) != s_level1_ids.end()))
+      return position;
+
+    if (child.unknown_size)
+      return end;
+
+    if (s_id_cluster_timestamp == child.id)
+      cluster_timestamp = read_uint(child);
+
+    else if (s_id_simple_block == child.id)
+      handle_block(child, cluster_timestamp, true, boost::none, 0);
+
+    else if (s_id_block_group == child.id)
+      handle_block_group(child, cluster_timestamp);
+
+    position = child.end();
+  }
+
+  return std::min(position, end);
+}
+
+void
+statistics_c::handle_block_group(element_t const &block_group,
+                                 uint64_t cluster_timestamp) {
+  boost::optional<element_t> block;
+  boost::optional<uint64_t> duration;
+  auto num_references = 0u;
+
+  for_each_child(block_group, [this, &block, &duration, &num_references](element_t const &child) {
+    if (s_id_block == child.id)
+      block = child;
+    else if (s_id_block_duration == child.id)
+      duration = read_uint(child);
+    else if (s_id_reference_block == child.id)
+      ++num_references;
+  });
+
+  if (block)
+    handle_block(*block, cluster_timestamp, false, duration, num_references);
+}
+
+/** \brief Account for a block without reading its frames
+
+   Only the block header and the lace sizes are read. The size of all
+   frames is the remaining size of the block.
+*/
+void
+statistics_c::handle_block(element_t const &block,
+                           uint64_t cluster_timestamp,
+                           bool simple_block,
+                           boost::optional<uint64_t> duration,
+                           unsigned int num_references) {
+  try {
+    auto length = 0u;
+
+    m_in.setFilePointer(block.data_position);
+
+    auto track_number = read_vint(8, length, false);
+    auto track        = find_track(track_number);
+    if (!track)
+      return;
+
+    auto relative_ts  = static_cast<int16_t>(m_in.read_uint16_be());
+    auto flags        = m_in.read_uint8();
+    auto lacing       = (flags >> 1) & 0x03;
+    auto num_frames   = 1u;
+
+    if (lacing) {
+      num_frames = m_in.read_uint8() + 1u;
+
+      if (s_lacing_xiph == lacing) {
+        for (auto idx = 1u; idx < num_frames; ++idx)
+          while (0xff == m_in.read_uint8())
+            ;
+
+      } else if (s_lacing_ebml == lacing) {
+        for (auto idx = 1u; idx < num_frames; ++idx)
+          read_vint(8, length, false);
+      }
+    }
+
+    auto header_size  = m_in.getFilePointer() - block.data_position;
+    auto is_key_frame = simple_block ? !!(flags & 0x80) : !num_references;
+    auto timestamp    = (static_cast<int64_t>(cluster_timestamp) + relative_ts) * static_cast<int64_t>(m_timestamp_scale);
+    auto total_length = duration ? *duration * m_timestamp_scale : track->default_duration * num_frames;
+
+    track->num_frames += num_frames;
+    track->size       += block.size > header_size ? block.size - header_size : 0;
+    track->add_timestamp(timestamp, total_length);
+
+    if (is_key_frame)
+      track->add_key_frame(timestamp);
+
+  } catch (mtx::mm_io::exception &) {
+  }
+}
+
+track_t *
+statistics_c::find_track(uint64_t number) {
+  auto itr = m_track_indexes.find(number);
+  return itr != m_track_indexes.end() ? &m_tracks[itr->second] : nullptr;
+}
+
+bool
+statistics_c::process() {
+  element_t element;
+
+  if (!read_element_head(0, element) || (s_id_ebml_head != element.id) || element.unknown_size)
+    return false;
+
+  if (!read_element_head(element.end(), element) || (s_id_segment != element.id))
+    return false;
+
+  auto file_size          = static_cast<uint64_t>(m_in.get_size());
+  auto segment_end        = element.unknown_size ? file_size : std::min(element.end(), file_size);
+  auto position           = element.data_position;
+  auto clusters_scanned   = false;
+  m_segment_data_position = element.data_position;
+
+  while ((position < segment_end) && read_element_head(position, element)) {
+    if (s_id_cluster == element.id) {
+      // The clusters don't have to be read if the seek head has
+      // already pointed to the cues.
+      if (m_from_cues && m_cues_position)
+        break;
+
+      position         = handle_cluster(element, segment_end);
+      clusters_scanned = true;
+      continue;
+    }
+
+    if (element.unknown_size)
+      break;
+
+    if (s_id_seek_head == element.id)
+      handle_seek_head(element);
+
+    else if (s_id_info == element.id)
+      handle_info(element);
+
+    else if (s_id_tracks == element.id)
+      handle_tracks(element);
+
+    else if ((s_id_cues == element.id) && !m_cues_position)
+      m_cues_position = position;
+
+    position = element.end();
+  }
+
+  // If the cues were only found after the clusters then the statistics
+  // have already been gathered from the clusters. Adding the cues
+  // would count the key frames twice.
+  if (clusters_scanned)
+    m_from_cues = false;
+
+  if (!m_from_cues)
+    return true;
+
+  if (!m_cues_position || !read_element_head(*m_cues_position, element) || (s_id_cues != element.id) || element.unknown_size) {
+    // Without usable cues everything has to be calculated from the clusters.
+    m_from_cues     = false;
+    m_cues_position = boost::none;
+    m_tracks.clear();
+    m_track_indexes.clear();
+
+    return process();
+  }
+
+  handle_cues(element);
+
+  return true;
+}
+
+nlohmann::json
+statistics_c::to_json()
+  const {
+  auto tracks = nlohmann::json::array();
+
+  for (auto const &track : m_tracks)
+    tracks.push_back(track.to_json(m_from_cues));
+
+  return nlohmann::json{
+    { "source", m_from_cues ? "cues" : "clusters" },
+    { "tracks", tracks                             },
+  };
+}
+
+}
+
+bool
+show_statistics(std::string const &file_name,
+                bool from_cues) {
+  mm_io_cptr in;
+
+  try {
+    in = std::make_shared<mm_read_buffer_io_c>(new mm_file_io_c(file_name), 64 * 1024);
+  } catch (mtx::mm_io::exception &ex) {
+    ui_show_error((boost::format(Y("Error: Couldn't open source file %1% (%2%).")) % file_name % ex).str());
+    return false;
+  }
+
+  statistics_c statistics{*in, from_cues};
+
+  if (!statistics.process()) {
+    ui_show_error(Y("No EBML head found."));
+    return false;
+  }
+
+  auto json         = statistics.to_json();
+  json["file_name"] = file_name;
+
+  display_json_output(json);
+
+  return true;
+}
@@ -0,0 +1,30 @@
+/*
+   mkvinfo -- utility for gathering information about Matroska files
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   per-track statistics gathered from block headers or cues
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_INFO_STATISTICS_H
+#define MTX_INFO_STATISTICS_H
+
+#include "common/common_pch.h"
+
+/* Outputs statistics for each track in JSON format: the number of
+   frames & key frames, their total size, the timestamp range, the
+   bitrate and the intervals between key frames.
+
+   Only the headers of blocks and their lacing are read; the frames
+   themselves are skipped. If 'from_cues' is true and the file
+   contains cues then the statistics are calculated from the cues
+   alone. In that case only the key frame related values and the
+   timestamp range are available.
+*/
+bool show_statistics(std::string const &file_name, bool from_cues);
+
+#endif // MTX_INFO_STATISTICS_H
@@ -54,6 +54,7 @@
 #include "common/iso639.h"
 #include "common/ivf.h"
 #include "common/kax_analyzer.h"
+#include "common/kax_cluster_parser.h"
 #include "common/mm_io.h"
 #include "common/strings/formatting.h"
 #include "common/strings/parsing.h"
@@ -2181,39 +2182,13 @@ kax_reader_c::read(generic_packetizer_c *requested_ptzr,
   }
 
   try {
-    KaxCluster *cluster = m_in_file->read_next_cluster();
-    if (!cluster) {
+    if (!read_next_cluster_directly() && !read_next_cluster_via_libmatroska()) {
       flush_packetizers();
 
       m_file_status = FILE_STATUS_DONE;
       return FILE_STATUS_DONE;
     }
 
-    auto cluster_tc = FindChildValue<KaxClusterTimecode>(cluster);
-    cluster->InitTimecode(cluster_tc, m_tc_scale);
-
-    if (-1 == m_first_timecode) {
-      m_first_timecode = cluster_tc * m_tc_scale;
-
-      // If we're appending this file to another one then the core
-      // needs the timecodes shifted to zero.
-      if (m_appending && m_chapters && (0 < m_first_timecode))
-        adjust_chapter_timecodes(*m_chapters, -m_first_timecode);
-    }
-
-    size_t bgidx;
-    for (bgidx = 0; bgidx < cluster->ListSize(); bgidx++) {
-      EbmlElement *element = (*cluster)[bgidx];
-
-      if (Is<KaxSimpleBlock>(element))
-        process_simple_block(cluster, static_cast<KaxSimpleBlock *>(element));
-
-      else if (Is<KaxBlockGroup>(element))
-        process_block_group(cluster, static_cast<KaxBlockGroup *>(element));
-    }
-
-    delete cluster;
-
   } catch (...) {
     mxwarn(boost::format("%1% %2% %3%\n")
            % (boost::format(Y("%1%: an unknown exception occurred.")) % "kax_reader_c::read()")
@@ -2225,21 +2200,168 @@ kax_reader_c::read(generic_packetizer_c *requested_ptzr,
   return FILE_STATUS_MOREDATA;
 }
 
+/** \brief Read and process the next cluster without libmatroska
+
+   Most clusters only contain elements kax_cluster_parser_c can
+   handle. Parsing them directly from the cluster's data avoids
+   allocating an object for each element and copying each frame.
+
+   Returns \c false if the next element isn't a cluster or if the
+   cluster contains something the parser doesn't support. The file
+   position is the same as before the call in that case.
+*/
+bool
+kax_reader_c::read_next_cluster_directly() {
+  static debugging_option_c s_debug{"kax_cluster_parser"}, s_debug_disable{"no_kax_cluster_parser"};
+
+  if (s_debug_disable)
+    return false;
+
+  auto cluster_pos = m_in->getFilePointer();
+  auto payload     = m_in_file->read_next_cluster_payload();
+
+  if (!payload)
+    return false;
+
+  if (!m_cluster_parser.parse(payload, m_tc_scale)) {
+    mxdebug_if(s_debug, boost::format("kax_cluster_parser: unsupported content in cluster at %1%; using libmatroska instead\n") % cluster_pos);
+    m_in->setFilePointer(cluster_pos);
+    return false;
+  }
+
+  process_cluster_timestamp(m_cluster_parser.get_timestamp());
+
+  for (auto idx = 0u, num_blocks = m_cluster_parser.get_num_blocks(); idx < num_blocks; ++idx) {
+    auto const &block = m_cluster_parser.get_block(idx);
+
+    if (block.is_simple_block)
+      process_simple_block(block);
+    else
+      process_block_group(block);
+  }
+
+  return true;
+}
+
+bool
+kax_reader_c::read_next_cluster_via_libmatroska() {
+  auto cluster = std::unique_ptr<KaxCluster>{m_in_file->read_next_cluster()};
+  if (!cluster)
+    return false;
+
+  auto cluster_tc = FindChildValue<KaxClusterTimecode>(*cluster);
+  cluster->InitTimecode(cluster_tc, m_tc_scale);
+
+  process_cluster_timestamp(cluster_tc);
+
+  kax_cluster_parser_c::block_t block;
+
+  for (auto element : *cluster) {
+    if (Is<KaxSimpleBlock>(element)) {
+      block_from_simple_block(*cluster, *static_cast<KaxSimpleBlock *>(element), block);
+      process_simple_block(block);
+
+    } else if (Is<KaxBlockGroup>(element) && block_from_block_group(*cluster, *static_cast<KaxBlockGroup *>(element), block))
+      process_block_group(block);
+  }
+
+  return true;
+}
+
+void
+kax_reader_c::process_cluster_timestamp(uint64_t cluster_tc) {
+  if (-1 != m_first_timecode)
+    return;
+
+  m_first_timecode = cluster_tc * m_tc_scale;
+
+  // If we're appending this file to another one then the core
+  // needs the timecodes shifted to zero.
+  if (m_appending && m_chapters && (0 < m_first_timecode))
+    adjust_chapter_timecodes(*m_chapters, -m_first_timecode);
+}
+
+void
+kax_reader_c::block_from_simple_block(KaxCluster &cluster,
+                                      KaxSimpleBlock &block_simple,
+                                      kax_cluster_parser_c::block_t &block) {
+  block.reset(true);
+  block_simple.SetParent(cluster);
+
+  block.track_number   = block_simple.TrackNum();
+  block.timestamp      = mtx::math::to_signed(block_simple.GlobalTimecode());
+  block.is_keyframe    = block_simple.IsKeyframe();
+  block.is_discardable = block_simple.IsDiscardable();
+
+  for (auto idx = 0u, num_frames = block_simple.NumberFrames(); idx < num_frames; ++idx) {
+    auto &data_buffer = block_simple.GetBuffer(idx);
+    block.frames.emplace_back(std::make_shared<memory_c>(data_buffer.Buffer(), data_buffer.Size(), false));
+  }
+}
+
+bool
+kax_reader_c::block_from_block_group(KaxCluster &cluster,
+                                     KaxBlockGroup &block_group,
+                                     kax_cluster_parser_c::block_t &block) {
+  auto kblock = FindChild<KaxBlock>(block_group);
+  if (!kblock)
+    return false;
+
+  block.reset(false);
+  kblock->SetParent(cluster);
+
+  block.track_number = kblock->TrackNum();
+  block.timestamp    = mtx::math::to_signed(kblock->GlobalTimecode());
+
+  for (auto idx = 0u, num_frames = kblock->NumberFrames(); idx < num_frames; ++idx) {
+    auto &data_buffer = kblock->GetBuffer(idx);
+    block.frames.emplace_back(std::make_shared<memory_c>(data_buffer.Buffer(), data_buffer.Size(), false));
+  }
+
+  auto duration = FindChild<KaxBlockDuration>(block_group);
+  if (duration)
+    block.duration = duration->GetValue();
+
+  for (auto ref_block = FindChild<KaxReferenceBlock>(block_group); ref_block; ref_block = FindNextChild<KaxReferenceBlock>(&block_group, ref_block))
+    block.references.push_back(ref_block->GetValue());
+
+  auto codec_state = FindChild<KaxCodecState>(block_group);
+  if (codec_state)
+    block.codec_state = std::make_shared<memory_c>(codec_state->GetBuffer(), codec_state->GetSize(), false);
+
+  auto discard_padding = FindChild<KaxDiscardPadding>(block_group);
+  if (discard_padding)
+    block.discard_padding = discard_padding->GetValue();
+
+  auto blockadd = FindChild<KaxBlockAdditions>(block_group);
+  if (!blockadd)
+    return true;
+
+  for (auto &child : *blockadd) {
+    if (!(Is<KaxBlockMore>(child)))
+      continue;
+
+    auto blockadd_data = &GetChild<KaxBlockAdditional>(*static_cast<KaxBlockMore *>(child));
+    block.additions.emplace_back(std::make_shared<memory_c>(blockadd_data->GetBuffer(), blockadd_data->GetSize(), false));
+  }
+
+  return true;
+}
+
 void
-kax_reader_c::process_simple_block(KaxCluster *cluster,
-                                   KaxSimpleBlock *block_simple) {
+kax_reader_c::process_simple_block(kax_cluster_parser_c::block_t const &block) {
   int64_t block_duration = -1;
   int64_t block_bref     = VFT_IFRAME;
   int64_t block_fref     = VFT_NOBFRAME;
 
-  block_simple->SetParent(*cluster);
-  auto block_track     = find_track_by_num(block_simple->TrackNum());
-  auto block_timestamp = mtx::math::to_signed(block_simple->GlobalTimecode()) + m_global_timestamp_offset;
+  auto block_track     = find_track_by_num(block.track_number);
+  auto block_timestamp = block.timestamp + m_global_timestamp_offset;
+  auto num_frames      = block.frames.size();
 
   if (!block_track) {
     mxwarn_fn(m_ti.m_fname,
               boost::format(Y("A block was found at timestamp %1% for track number %2%. However, no headers where found for that track number. "
-                              "The block will be skipped.\n")) % format_timestamp(block_timestamp) % block_simple->TrackNum());
+                              "The block will be skipped.\n")) % format_timestamp(block_timestamp) % block.track_number);
     return;
   }
 
@@ -2256,16 +2378,16 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
       block_duration = 0;
   }
 
-  if (!block_simple->IsKeyframe()) {
-    if (block_simple->IsDiscardable())
+  if (!block.is_keyframe) {
+    if (block.is_discardable)
       block_fref = block_track->previous_timecode;
     else
       block_bref = block_track->previous_timecode;
   }
 
   m_last_timecode = block_timestamp;
-  if (0 < block_simple->NumberFrames())
-    m_in_file->set_last_timecode(m_last_timecode + (block_simple->NumberFrames() - 1) * frame_duration);
+  if (0 < num_frames)
+    m_in_file->set_last_timecode(m_last_timecode + (num_frames - 1) * frame_duration);
 
   // If we're appending this file to another one then the core
   // needs the timecodes shifted to zero.
@@ -2277,9 +2399,8 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
     // any special cases, e.g. 0 terminating a string for the subs
     // and stuff. Just pass everything through as it is.
     size_t i;
-    for (i = 0; block_simple->NumberFrames() > i; ++i) {
-      DataBuffer &data_buffer = block_simple->GetBuffer(i);
-      memory_cptr data(new memory_c(data_buffer.Buffer(), data_buffer.Size(), false));
+    for (i = 0; num_frames > i; ++i) {
+      auto data = block.frames[i];
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
       packet_cptr packet(new packet_t(data, m_last_timecode + i * frame_duration, block_duration, block_bref, block_fref));
 
@@ -2288,9 +2409,8 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
 
   } else if (-1 != block_track->ptzr) {
     size_t i;
-    for (i = 0; i < block_simple->NumberFrames(); i++) {
-      DataBuffer &data_buffer = block_simple->GetBuffer(i);
-      memory_cptr data(new memory_c(data_buffer.Buffer(), data_buffer.Size(), false));
+    for (i = 0; i < num_frames; i++) {
+      auto data = block.frames[i];
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
       if (('s' == block_track->type) && ('t' == block_track->sub_type)) {
@@ -2306,33 +2426,22 @@ kax_reader_c::process_simple_block(KaxCluster *cluster,
   }
 
   block_track->previous_timecode  = m_last_timecode;
-  block_track->units_processed   += block_simple->NumberFrames();
+  block_track->units_processed   += num_frames;
 }
 
 void
-kax_reader_c::process_block_group_common(KaxBlockGroup *block_group,
+kax_reader_c::process_block_group_common(kax_cluster_parser_c::block_t const &block,
                                          packet_t *packet,
                                          kax_track_t &block_track) {
-  auto codec_state     = FindChild<KaxCodecState>(block_group);
-  auto discard_padding = FindChild<KaxDiscardPadding>(block_group);
-  auto blockadd        = FindChild<KaxBlockAdditions>(block_group);
-
-  if (codec_state)
-    packet->codec_state = memory_c::clone(codec_state->GetBuffer(), codec_state->GetSize());
-
-  if (discard_padding)
-    packet->discard_padding = timestamp_c::ns(discard_padding->GetValue());
-
-  if (!blockadd)
-    return;
+  if (block.codec_state)
+    packet->codec_state = memory_c::clone(block.codec_state->get_buffer(), block.codec_state->get_size());
 
-  for (auto &child : *blockadd) {
-    if (!(Is<KaxBlockMore>(child)))
-      continue;
+  if (block.discard_padding)
+    packet->discard_padding = timestamp_c::ns(*block.discard_padding);
 
-    auto blockmore     = static_cast<KaxBlockMore *>(child);
-    auto blockadd_data = &GetChild<KaxBlockAdditional>(*blockmore);
-    auto blockadded    = std::make_shared<memory_c>(blockadd_data->GetBuffer(), blockadd_data->GetSize(), false);
+  for (auto const &addition : block.additions) {
+    // Each packet gets its own buffer object as decoding may replace it.
+    auto blockadded = memory_c::slice(addition, 0, addition->get_size());
     block_track.content_decoder.reverse(blockadded, CONTENT_ENCODING_SCOPE_BLOCK);
 
     packet->data_adds.push_back(blockadded);
@@ -2340,32 +2449,26 @@ kax_reader_c::process_block_group_common(KaxBlockGroup *block_group,
 }
 
 void
-kax_reader_c::process_block_group(KaxCluster *cluster,
-                                  KaxBlockGroup *block_group) {
-  auto block = FindChild<KaxBlock>(block_group);
-  if (!block)
-    return;
-
-  block->SetParent(*cluster);
-  auto block_track     = find_track_by_num(block->TrackNum());
-  auto block_timestamp = mtx::math::to_signed(block->GlobalTimecode()) + m_global_timestamp_offset;
+kax_reader_c::process_block_group(kax_cluster_parser_c::block_t const &block) {
+  auto block_track     = find_track_by_num(block.track_number);
+  auto block_timestamp = block.timestamp + m_global_timestamp_offset;
+  auto num_frames      = block.frames.size();
 
   if (!block_track) {
     mxwarn_fn(m_ti.m_fname,
               boost::format(Y("A block was found at timestamp %1% for track number %2%. However, no headers where found for that track number. "
-                              "The block will be skipped.\n")) % format_timestamp(block_timestamp) % block->TrackNum());
+                              "The block will be skipped.\n")) % format_timestamp(block_timestamp) % block.track_number);
     return;
   }
 
-  auto duration       = FindChild<KaxBlockDuration>(block_group);
-  auto block_duration = duration             ? static_cast<int64_t>(duration->GetValue() * m_tc_scale / block->NumberFrames())
+  auto block_duration = block.duration       ? static_cast<int64_t>(*block.duration * m_tc_scale / num_frames)
                       : block_track->v_frate ? static_cast<int64_t>(1000000000.0 / block_track->v_frate)
                       :                        int64_t{-1};
   auto frame_duration = -1 == block_duration ? int64_t{0} : block_duration;
   m_last_timecode     = block_timestamp;
 
-  if (0 < block->NumberFrames())
-    m_in_file->set_last_timecode(m_last_timecode + (block->NumberFrames() - 1) * frame_duration);
+  if (0 < num_frames)
+    m_in_file->set_last_timecode(m_last_timecode + (num_frames - 1) * frame_duration);
 
   // If we're appending this file to another one then the core
   // needs the timecodes shifted to zero.
@@ -2379,18 +2482,15 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
   auto block_fref = int64_t{VFT_NOBFRAME};
   bool bref_found = false;
   bool fref_found = false;
-  auto ref_block  = FindChild<KaxReferenceBlock>(block_group);
 
-  while (ref_block) {
-    if (0 >= ref_block->GetValue()) {
-      block_bref = ref_block->GetValue() * m_tc_scale;
+  for (auto reference : block.references) {
+    if (0 >= reference) {
+      block_bref = reference * m_tc_scale;
       bref_found = true;
     } else {
-      block_fref = ref_block->GetValue() * m_tc_scale;
+      block_fref = reference * m_tc_scale;
       fref_found = true;
     }
-
-    ref_block = FindNextChild<KaxReferenceBlock>(block_group, ref_block);
   }
 
   if (('s' == block_track->type) && (-1 == block_duration))
@@ -2412,15 +2512,14 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
       block_fref += m_last_timecode;
 
     size_t i;
-    for (i = 0; i < block->NumberFrames(); i++) {
-      auto &data_buffer = block->GetBuffer(i);
-      auto data         = std::make_shared<memory_c>(data_buffer.Buffer(), data_buffer.Size(), false);
+    for (i = 0; i < num_frames; i++) {
+      auto data = block.frames[i];
       block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
       auto packet                = std::make_shared<packet_t>(data, m_last_timecode + i * frame_duration, block_duration, block_bref, block_fref);
-      packet->duration_mandatory = duration;
+      packet->duration_mandatory = !!block.duration;
 
-      process_block_group_common(block_group, packet.get(), *block_track);
+      process_block_group_common(block, packet.get(), *block_track);
 
       static_cast<passthrough_packetizer_c *>(PTZR(block_track->ptzr))->process(packet);
     }
@@ -2433,16 +2532,15 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
   if (fref_found)
     block_fref += m_last_timecode;
 
-  for (auto block_idx = 0u, num_frames = block->NumberFrames(); block_idx < num_frames; ++block_idx) {
-    auto &data_buffer = block->GetBuffer(block_idx);
-    auto data         = std::make_shared<memory_c>(data_buffer.Buffer(), data_buffer.Size(), false);
+  for (auto block_idx = 0u; block_idx < num_frames; ++block_idx) {
+    auto data = block.frames[block_idx];
     block_track->content_decoder.reverse(data, CONTENT_ENCODING_SCOPE_BLOCK);
 
     if (('s' == block_track->type) && ('t' == block_track->sub_type)) {
       if ((2 < data->get_size()) || ((0 < data->get_size()) && (' ' != *data->get_buffer()) && (0 != *data->get_buffer()) && !iscr(*data->get_buffer()))) {
         auto packet = std::make_shared<packet_t>(data, m_last_timecode, block_duration, block_bref, block_fref);
 
-        process_block_group_common(block_group, packet.get(), *block_track);
+        process_block_group_common(block, packet.get(), *block_track);
 
         PTZR(block_track->ptzr)->process(packet);
       }
@@ -2450,17 +2548,17 @@ kax_reader_c::process_block_group(KaxCluster *cluster,
     } else {
       auto packet = std::make_shared<packet_t>(data, m_last_timecode + block_idx * frame_duration, block_duration, block_bref, block_fref);
 
-      if ((duration) && !duration->GetValue())
+      if (block.duration && !*block.duration)
         packet->duration_mandatory = true;
 
-      process_block_group_common(block_group, packet.get(), *block_track);
+      process_block_group_common(block, packet.get(), *block_track);
 
       PTZR(block_track->ptzr)->process(packet);
     }
   }
 
   block_track->previous_timecode  = m_last_timecode;
-  block_track->units_processed   += block->NumberFrames();
+  block_track->units_processed   += num_frames;
 }
 
 int
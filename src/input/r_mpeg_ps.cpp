@@ -20,7 +20,9 @@
 #include "common/error.h"
 #include "common/id_info.h"
 #include "common/math.h"
+#include "common/mm_io_x.h"
 #include "common/mp3.h"
+#include "common/mpeg.h"
 #include "common/mpeg1_2.h"
 #include "common/mpeg4_p2.h"
 #include "common/strings/formatting.h"
@@ -37,6 +39,8 @@
 #include "output/p_truehd.h"
 #include "output/p_vc1.h"
 
+#define PS_WINDOW_SIZE (1024 * 1024) // bytes read at once for parsing headers; must exceed the maximum PES packet size
+
 int
 mpeg_ps_reader_c::probe_file(mm_io_c *in,
                              uint64_t) {
@@ -88,6 +92,7 @@ mpeg_ps_reader_c::mpeg_ps_reader_c(const track_info_c &ti,
   : generic_reader_c(ti, in)
   , file_done(false)
   , m_probe_range{}
+  , m_window_start{}
   , m_debug_timecodes{"mpeg_ps|mpeg_ps_timecodes"}
   , m_debug_headers{  "mpeg_ps|mpeg_ps_headers"}
   , m_debug_packets{  "mpeg_ps|mpeg_ps_packets"}
@@ -254,10 +259,11 @@ mpeg_ps_reader_c::calculate_global_timecode_offset() {
 }
 
 bool
-mpeg_ps_reader_c::read_timestamp(int c,
+mpeg_ps_reader_c::read_timestamp(unsigned char const *buf,
                                  int64_t &timestamp) {
-  int d = m_in->read_uint16_be();
-  int e = m_in->read_uint16_be();
+  int c = buf[0];
+  int d = get_uint16_be(&buf[1]);
+  int e = get_uint16_be(&buf[3]);
 
   if (((c & 1) != 1) || ((d & 1) != 1) || ((e & 1) != 1))
     return false;
@@ -327,9 +333,17 @@ mpeg_ps_reader_c::parse_packet(mpeg_ps_id_t id,
                                bool read_data) {
   mpeg_ps_packet_c packet{id};
 
+  auto pos = m_in->getFilePointer();
+  auto ptr = ensure_window(pos, 2);
+  if (!ptr)
+    throw mtx::mm_io::end_of_file_x{};
+
   packet.m_id.sub_id   = 0;
-  packet.m_length      = m_in->read_uint16_be();
+  packet.m_length      = get_uint16_be(ptr);
   packet.m_full_length = packet.m_length;
+  pos                 += 2;
+
+  m_in->setFilePointer(pos);
 
   if (    (0xbc >  packet.m_id.id)
       || ((0xf0 <= packet.m_id.id) && (0xfd != packet.m_id.id))
@@ -339,15 +353,16 @@ mpeg_ps_reader_c::parse_packet(mpeg_ps_id_t id,
   }
 
   if (0xbe == packet.m_id.id) {        // padding stream
-    int64_t pos = m_in->getFilePointer();
-    m_in->skip(packet.m_length);
-    uint32_t header = m_in->read_uint32_be();
+    auto next = ensure_window(pos + packet.m_length, 4);
+    if (!next)
+      throw mtx::mm_io::end_of_file_x{};
+
+    uint32_t header = get_uint32_be(next);
     if (mpeg_is_start_code(header))
       m_in->setFilePointer(pos + packet.m_length);
 
     else {
       mxdebug_if(m_debug_packets, boost::format("mpeg_ps: [begin] padding stream length incorrect at %1%, find next header...\n") % (pos - 6));
-      m_in->setFilePointer(pos);
       header = 0xffffffff;
       if (resync_stream(header)) {
         packet.m_full_length = m_in->getFilePointer() - pos - 4;
@@ -362,10 +377,32 @@ mpeg_ps_reader_c::parse_packet(mpeg_ps_id_t id,
   if (0 == packet.m_length)
     return packet;
 
+  // The whole packet is parsed from memory. m_in is positioned after
+  // the bytes consumed once parsing is done. A packet cut off at the
+  // end of the file is parsed as far as its data is present; its
+  // payload is not valid, though.
+  auto data        = ensure_window(pos, packet.m_length);
+  auto num_missing = std::size_t{};
+
+  if (!data) {
+    // The window has been refilled starting at pos and contains
+    // everything up to the end of the file.
+    data             = m_window->get_buffer();
+    num_missing      = packet.m_length - m_window->get_size();
+    packet.m_length -= num_missing;
+  }
+
+  auto cursor = std::size_t{};
+  auto done   = [this, pos, num_missing, &cursor, &packet]() -> mpeg_ps_packet_c {
+    m_in->setFilePointer(pos + cursor);
+    packet.m_length += num_missing;
+    return packet;
+  };
+
   uint8_t c = 0;
   // Skip stuFFing bytes
   while (0 < packet.m_length) {
-    c = m_in->read_uint8();
+    c = data[cursor++];
     packet.m_length--;
     if (c != 0xff)
       break;
@@ -374,21 +411,36 @@ mpeg_ps_reader_c::parse_packet(mpeg_ps_id_t id,
   // Skip STD buffer size
   if ((c & 0xc0) == 0x40) {
     if (2 > packet.m_length)
-      return packet;
+      return done();
     packet.m_length -= 2;
-    m_in->skip(1);
-    c = m_in->read_uint8();
+    c                = data[cursor + 1];
+    cursor          += 2;
   }
 
   // Presentation time stamp
   if ((c & 0xf0) == 0x20) {
-    if ((4 > packet.m_length) || !read_timestamp(c, packet.m_pts))
-      return packet;
+    if (4 > packet.m_length)
+      return done();
+
+    auto valid  = read_timestamp(&data[cursor - 1], packet.m_pts);
+    cursor     += 4;
+    if (!valid)
+      return done();
     packet.m_length -= 4;
 
   } else if ((c & 0xf0) == 0x30) {
-    if ((9 > packet.m_length) || !read_timestamp(c, packet.m_pts) || !read_timestamp(m_in->read_uint8(), packet.m_dts))
-      return packet;
+    if (9 > packet.m_length)
+      return done();
+
+    auto valid  = read_timestamp(&data[cursor - 1], packet.m_pts);
+    cursor     += 4;
+    if (!valid)
+      return done();
+
+    valid   = read_timestamp(&data[cursor], packet.m_dts);
+    cursor += 5;
+    if (!valid)
+      return done();
     packet.m_length -= 4 + 5;
 
   } else if ((c & 0xc0) == 0x80) {
@@ -396,22 +448,20 @@ mpeg_ps_reader_c::parse_packet(mpeg_ps_id_t id,
       mxerror_fn(m_ti.m_fname, Y("Reading encrypted VOBs is not supported.\n"));
 
     if (2 > packet.m_length)
-      return packet;
+      return done();
 
-    unsigned int flags   = m_in->read_uint8();
-    unsigned int hdrlen  = m_in->read_uint8();
+    unsigned int flags   = data[cursor];
+    unsigned int hdrlen  = data[cursor + 1];
+    cursor              += 2;
     packet.m_length     -= 2;
 
     if (hdrlen > packet.m_length)
-      return packet;
+      return done();
 
     packet.m_length -= hdrlen;
 
-    auto af_header = memory_c::alloc(hdrlen);
-    if (m_in->read(af_header->get_buffer(), hdrlen) != hdrlen)
-      return packet;
-
-    bit_reader_c bc(af_header->get_buffer(), hdrlen);
+    bit_reader_c bc(&data[cursor], hdrlen);
+    cursor += hdrlen;
 
     try {
       // PTS
@@ -460,42 +510,42 @@ mpeg_ps_reader_c::parse_packet(mpeg_ps_id_t id,
 
     if (0xbd == packet.m_id.id) {        // DVD audio substream
       if (4 > packet.m_length)
-        return packet;
-      packet.m_id.sub_id = m_in->read_uint8();
+        return done();
+      packet.m_id.sub_id = data[cursor++];
       packet.m_length--;
 
       if ((packet.m_id.sub_id & 0xe0) == 0x20)
         // Subtitles, not supported yet.
-        return packet;
+        return done();
 
       else if (   ((0x80 <= packet.m_id.sub_id) && (0x8f >= packet.m_id.sub_id))
                || ((0x98 <= packet.m_id.sub_id) && (0xcf >= packet.m_id.sub_id))) {
         // Number of frames, startpos. MLP/TrueHD audio has a 4 byte header.
         auto audio_header_len = (0xb0 <= packet.m_id.sub_id) && (0xbf >= packet.m_id.sub_id) ? 4u : 3u;
         if (audio_header_len > packet.m_length)
-          return packet;
+          return done();
 
-        m_in->skip(audio_header_len);
+        cursor          += audio_header_len;
         packet.m_length -= audio_header_len;
       }
     }
 
   } else if (0x0f != c)
-    return packet;
+    return done();
 
   if (!read_data)
     packet.m_valid = true;
 
-  else if (0 != packet.m_length)
-    try {
-      packet.m_buffer = memory_c::alloc(packet.m_length);
-      packet.m_valid  = m_in->read(packet.m_buffer, packet.m_length) == packet.m_length;
+  else if (num_missing)
+    cursor += packet.m_length;
 
-    } catch (mtx::mm_io::exception &ex) {
-      packet.m_valid  = false;
-    }
+  else if (0 != packet.m_length) {
+    packet.m_buffer  = memory_c::clone(&data[cursor], packet.m_length);
+    packet.m_valid   = true;
+    cursor          += packet.m_length;
+  }
 
-  return packet;
+  return done();
 }
 
 void
@@ -1114,65 +1164,87 @@ mpeg_ps_reader_c::found_new_stream(mpeg_ps_id_t id) {
 bool
 mpeg_ps_reader_c::find_next_packet(mpeg_ps_id_t &id,
                                    int64_t max_file_pos) {
+  // Pack and system headers are skipped in memory. m_in is only
+  // positioned once the start code of the next packet has been found.
   try {
-    uint32_t header;
+    auto pos = m_in->getFilePointer();
+    auto ptr = ensure_window(pos, 4);
+    if (!ptr)
+      return false;
+
+    uint32_t header = get_uint32_be(ptr);
+    pos            += 4;
 
-    header = m_in->read_uint32_be();
     while (1) {
-      uint8_t byte;
+      std::size_t header_size;
 
-      if ((-1 != max_file_pos) && (m_in->getFilePointer() > static_cast<size_t>(max_file_pos)))
+      if ((-1 != max_file_pos) && (pos > static_cast<uint64_t>(max_file_pos)))
         return false;
 
       switch (header) {
         case MPEGVIDEO_PACKET_START_CODE:
-          if (-1 == version) {
-            byte = m_in->read_uint8();
-            if ((byte & 0xc0) != 0)
-              version = 2;      // MPEG-2 PS
-            else
-              version = 1;
-            m_in->skip(-1);
-          }
+          if (!(ptr = ensure_window(pos, 1)))
+            return false;
 
-          m_in->skip(2 * 4);   // pack header
-          if (2 == version) {
-            m_in->skip(1);
-            byte = m_in->read_uint8() & 0x07;
-            m_in->skip(byte);  // stuffing bytes
-          }
-          header = m_in->read_uint32_be();
+          if (-1 == version)
+            version = (ptr[0] & 0xc0) != 0 ? 2 : 1; // MPEG-2 PS : MPEG-1 PS
+
+          header_size = 2 == version ? 10 : 8;
+          if (!(ptr = ensure_window(pos, header_size)))
+            return false;
+
+          if (2 == version)
+            header_size += ptr[9] & 0x07; // stuffing bytes
+
+          if (!(ptr = ensure_window(pos, header_size + 4)))
+            return false;
+
+          header  = get_uint32_be(&ptr[header_size]);
+          pos    += header_size + 4;
           break;
 
         case MPEGVIDEO_SYSTEM_HEADER_START_CODE:
-          m_in->skip(2 * 4);   // system header
-          byte = m_in->read_uint8();
-          while ((byte & 0x80) == 0x80) {
-            m_in->skip(2);     // P-STD info
-            byte = m_in->read_uint8();
+          header_size = 2 * 4;
+          while (1) {
+            if (!(ptr = ensure_window(pos, header_size + 1)))
+              return false;
+            if ((ptr[header_size] & 0x80) != 0x80)
+              break;
+            header_size += 3; // P-STD info
           }
-          m_in->skip(-1);
-          header = m_in->read_uint32_be();
+
+          if (!(ptr = ensure_window(pos, header_size + 4)))
+            return false;
+
+          header  = get_uint32_be(&ptr[header_size]);
+          pos    += header_size + 4;
           break;
 
         case MPEGVIDEO_MPEG_PROGRAM_END_CODE:
+          m_in->setFilePointer(pos);
           if (!resync_stream(header))
             return false;
+          pos = m_in->getFilePointer();
           break;
 
         case MPEGVIDEO_PROGRAM_STREAM_MAP_START_CODE:
+          m_in->setFilePointer(pos);
           parse_program_stream_map();
           if (!resync_stream(header))
             return false;
+          pos = m_in->getFilePointer();
           break;
 
         default:
           if (!mpeg_is_start_code(header)) {
+            m_in->setFilePointer(pos);
             if (!resync_stream(header))
               return false;
+            pos = m_in->getFilePointer();
             continue;
           }
 
+          m_in->setFilePointer(pos);
           id.id = header & 0xff;
           return true;
 
@@ -1201,26 +1273,87 @@ mpeg_ps_reader_c::find_next_packet_for_id(mpeg_ps_id_t id,
 
 bool
 mpeg_ps_reader_c::resync_stream(uint32_t &header) {
-  mxdebug_if(m_debug_resync, boost::format("MPEG PS: synchronisation lost at %1%; looking for start code\n") % m_in->getFilePointer());
+  auto pos = m_in->getFilePointer();
 
-  try {
-    while (1) {
-      header <<= 8;
-      header  |= m_in->read_uint8();
-      if (mpeg_is_start_code(header))
-        break;
+  mxdebug_if(m_debug_resync, boost::format("MPEG PS: synchronisation lost at %1%; looking for start code\n") % pos);
+
+  // The start code may begin with the last three bytes of 'header'.
+  auto shifted_header = header;
+  for (auto idx = 0u; idx < 3; ++idx) {
+    auto ptr = ensure_window(pos + idx, 1);
+    if (!ptr) {
+      mxdebug_if(m_debug_resync, "resync failed: end of file reached\n");
+      return false;
     }
 
-    mxdebug_if(m_debug_resync, boost::format("resync succeeded at %1%, header 0x%|2$08x|\n") % (m_in->getFilePointer() - 4) % header);
+    shifted_header = (shifted_header << 8) | *ptr;
+    if (mpeg_is_start_code(shifted_header)) {
+      header = shifted_header;
+      m_in->setFilePointer(pos + idx + 1);
+      mxdebug_if(m_debug_resync, boost::format("resync succeeded at %1%, header 0x%|2$08x|\n") % (pos + idx + 1 - 4) % header);
+      return true;
+    }
+  }
 
-    return true;
+  // Otherwise search the following data window by window. A start
+  // code prefix at the end of a window is searched for again at the
+  // start of the next one.
+  while (1) {
+    auto ptr = ensure_window(pos, 4);
+    if (!ptr) {
+      mxdebug_if(m_debug_resync, "resync failed: end of file reached\n");
+      return false;
+    }
 
-  } catch (...) {
-    mxdebug_if(m_debug_resync, "resync failed: exception caught\n");
-    return false;
+    auto end   = m_window->get_buffer() + m_window->get_size();
+    auto found = mtx::mpeg::find_start_code(ptr, end);
+
+    if ((found + 3) < end) {
+      pos    += found - ptr;
+      header  = get_uint32_be(found);
+      m_in->setFilePointer(pos + 4);
+
+      mxdebug_if(m_debug_resync, boost::format("resync succeeded at %1%, header 0x%|2$08x|\n") % pos % header);
+
+      return true;
+    }
+
+    pos += found < end ? found - ptr : end - ptr - 2;
   }
 }
 
+/** \brief Make a range of the file available in memory
+
+   Returns a pointer to the byte at position \c pos if the read-ahead
+   window contains at least \c num_bytes bytes starting there.
+   Otherwise the window is refilled starting at \c pos. Returns \c
+   nullptr if the file ends before. The position of \c m_in isn't
+   changed.
+*/
+unsigned char const *
+mpeg_ps_reader_c::ensure_window(uint64_t pos,
+                                std::size_t num_bytes) {
+  if (m_window && (pos >= m_window_start) && ((pos + num_bytes) <= (m_window_start + m_window->get_size())))
+    return m_window->get_buffer() + (pos - m_window_start);
+
+  auto previous_pos = m_in->getFilePointer();
+  auto size         = std::max<std::size_t>(num_bytes, PS_WINDOW_SIZE);
+
+  m_window       = memory_c::alloc(size);
+  m_window_start = pos;
+
+  try {
+    m_in->setFilePointer(pos);
+    m_window->set_size(m_in->read(m_window->get_buffer(), size));
+  } catch (mtx::mm_io::exception &) {
+    m_window->set_size(0);
+  }
+
+  m_in->setFilePointer(previous_pos);
+
+  return m_window->get_size() >= num_bytes ? m_window->get_buffer() : nullptr;
+}
+
 void
 mpeg_ps_reader_c::create_packetizer(int64_t id) {
   if ((0 > id) || (tracks.size() <= static_cast<size_t>(id)))
@@ -1352,6 +1485,18 @@ mpeg_ps_reader_c::read(generic_packetizer_c *requested_ptzr,
         m_in->skip(bytes_to_skip);
       }
 
+      // The packet was parsed from the read-ahead window which usually
+      // contains its payload, too.
+      auto payload_pos = m_in->getFilePointer();
+      auto payload     = ensure_window(payload_pos, packet.m_length);
+
+      if (!payload) {
+        mxdebug_if(m_debug_packets, "mpeg_ps: file_done: m_in->read\n");
+        return finish();
+      }
+
+      m_in->setFilePointer(payload_pos + packet.m_length);
+
       if (0 < track->buffer_size) {
         if (((track->buffer_usage + packet.m_length) > track->buffer_size)) {
           packet_t *new_packet = new packet_t(new memory_c(track->buffer, track->buffer_usage, false));
@@ -1366,11 +1511,7 @@ mpeg_ps_reader_c::read(generic_packetizer_c *requested_ptzr,
         }
 
         track->assert_buffer_size(packet.m_length);
-
-        if (m_in->read(&track->buffer[track->buffer_usage], packet.m_length) != packet.m_length) {
-          mxdebug_if(m_debug_packets, "mpeg_ps: file_done: m_in->read\n");
-          return finish();
-        }
+        memcpy(&track->buffer[track->buffer_usage], payload, packet.m_length);
 
         if (-1 != timecode)
           track->multiple_timecodes_packet_extension->add(timecode, track->buffer_usage);
@@ -1378,14 +1519,7 @@ mpeg_ps_reader_c::read(generic_packetizer_c *requested_ptzr,
         track->buffer_usage += packet.m_length;
 
       } else {
-        auto buf = memory_c::alloc(packet.m_length);
-
-        if (m_in->read(buf, packet.m_length) != packet.m_length) {
-          mxdebug_if(m_debug_packets, "mpeg_ps: file_done: m_in->read\n");
-          return finish();
-        }
-
-        PTZR(track->ptzr)->process(new packet_t(buf, timecode));
+        PTZR(track->ptzr)->process(new packet_t(memory_c::clone(payload, packet.m_length), timecode));
       }
 
       return FILE_STATUS_MOREDATA;
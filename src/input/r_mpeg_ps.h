@@ -206,6 +206,10 @@ private:
 
   uint64_t m_probe_range;
 
+  // Read-ahead window that headers are parsed from; see ensure_window().
+  memory_cptr m_window;
+  uint64_t m_window_start;
+
   debugging_option_c m_debug_timecodes, m_debug_headers, m_debug_packets, m_debug_resync;
 
 public:
@@ -226,7 +230,7 @@ public:
   virtual void found_new_stream(mpeg_ps_id_t id);
 
   virtual bool read_timestamp(bit_reader_c &bc, int64_t &timestamp);
-  virtual bool read_timestamp(int c, int64_t &timestamp);
+  virtual bool read_timestamp(unsigned char const *buf, int64_t &timestamp);
   virtual mpeg_ps_packet_c parse_packet(mpeg_ps_id_t id, bool read_data = true);
   virtual bool find_next_packet(mpeg_ps_id_t &id, int64_t max_file_pos = -1);
   virtual bool find_next_packet_for_id(mpeg_ps_id_t id, int64_t max_file_pos = -1);
@@ -246,6 +250,7 @@ private:
   virtual void new_stream_a_pcm(mpeg_ps_id_t id, unsigned char *buf, unsigned int length, mpeg_ps_track_ptr &track);
   virtual void new_stream_a_truehd(mpeg_ps_id_t id, unsigned char *buf, unsigned int length, mpeg_ps_track_ptr &track);
   virtual bool resync_stream(uint32_t &header);
+  unsigned char const *ensure_window(uint64_t pos, std::size_t num_bytes);
   virtual file_status_e finish();
   void sort_tracks();
   void calculate_global_timecode_offset();
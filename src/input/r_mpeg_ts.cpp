@@ -59,6 +59,8 @@
 
 #define TS_PACKET_SIZE     188
 #define TS_MAX_PACKET_SIZE 204
+#define TS_NUM_PIDS        8192
+#define TS_READ_AHEAD      1024 // number of packets read at once while muxing
 
 #define TS_PAT_PID         0x0000
 #define TS_SDT_PID         0x0011
@@ -520,6 +522,8 @@ void
 track_c::set_pid(uint16_t new_pid) {
   pid = new_pid;
 
+  reader.invalidate_pid_tables();
+
   std::string arg;
   m_debug_delivery = debugging_c::requested("mpeg_ts")
                   || (   debugging_c::requested("delivery", &arg)
@@ -945,6 +949,11 @@ file_t::file_t(mm_io_cptr const &in)
   , m_detected_packet_size{}
   , m_num_pat_crc_errors{}
   , m_num_pmt_crc_errors{}
+  , m_num_buffered_packets{}
+  , m_next_buffered_packet{}
+  , m_buffered_packets_position{}
+  , m_packet_position{}
+  , m_pid_table_valid{}
   , m_validate_pat_crc{true}
   , m_validate_pmt_crc{true}
   , m_has_audio_or_video_track{}
@@ -964,9 +973,17 @@ file_t::get_queued_bytes()
 
 void
 file_t::reset_processing_state(processing_state_e new_state) {
-  m_state = new_state;
+  m_state           = new_state;
+  m_pid_table_valid = false;
   m_last_non_subtitle_pts.reset();
   m_last_non_subtitle_dts.reset();
+  clear_packet_buffer();
+}
+
+void
+file_t::clear_packet_buffer() {
+  m_num_buffered_packets = 0;
+  m_next_buffered_packet = 0;
 }
 
 bool
@@ -1099,8 +1116,10 @@ reader_c::read_headers_for_file(std::size_t file_num) {
       if (f.m_in->read(buf, f.m_detected_packet_size) != static_cast<unsigned int>(f.m_detected_packet_size))
         break;
 
+      f.m_packet_position = f.m_in->getFilePointer() - f.m_detected_packet_size;
+
       if (buf[0] != 0x47) {
-        if (resync(f.m_in->getFilePointer() - f.m_detected_packet_size))
+        if (resync(f.m_packet_position))
           continue;
         break;
       }
@@ -1231,8 +1250,10 @@ reader_c::determine_global_timestamp_offset() {
       if (f.m_in->read(buf, f.m_detected_packet_size) != static_cast<unsigned int>(f.m_detected_packet_size))
         break;
 
+      f.m_packet_position = f.m_in->getFilePointer() - f.m_detected_packet_size;
+
       if (buf[0] != 0x47) {
-        if (resync(f.m_in->getFilePointer() - f.m_detected_packet_size))
+        if (resync(f.m_packet_position))
           continue;
         break;
       }
@@ -1627,6 +1648,8 @@ reader_c::parse_pmt(track_c &track) {
 
   ++f.m_num_pmts_found;
 
+  invalidate_pid_tables();
+
   mxdebug_if(m_debug_pat_pmt,
              boost::format("parse_pmt: %1% num PMTs found %2% vs. to find %3%\n")
              % (  f.m_num_pmts_found  < f.m_num_pmts_to_find ? "find_ongoing"
@@ -1853,7 +1876,7 @@ reader_c::parse_pes(track_c &track) {
   }
 
   if (m_debug_packet) {
-    mxdebug(boost::format("parse_pes: PES info at file position %1% (file num %2%):\n") % (f.m_in->getFilePointer() - f.m_detected_packet_size) % track.m_file_num);
+    mxdebug(boost::format("parse_pes: PES info at file position %1% (file num %2%):\n") % f.m_packet_position % track.m_file_num);
     mxdebug(boost::format("parse_pes:    stream_id = %1% PID = %2%\n") % static_cast<unsigned int>(pes_header->stream_id) % track.pid);
     mxdebug(boost::format("parse_pes:    PES_packet_length = %1%, PES_header_data_length = %2%, data starts at %3%\n") % pes_size % static_cast<unsigned int>(pes_header->pes_header_data_length) % to_skip);
     mxdebug(boost::format("parse_pes:    PTS? %1% (%5% processed %6%) DTS? (%7% processed %8%) %2% ESCR = %3% ES_rate = %4%\n")
@@ -2143,6 +2166,9 @@ reader_c::create_packetizer(int64_t id) {
   if (!track->probed_ok || (0 == track->ptzr) || !demuxing_requested(type, id, track->language))
     return;
 
+  // Lookups prefer tracks with packetizers.
+  invalidate_pid_tables();
+
   m_ti.m_id       = id;
   m_ti.m_language = track->language;
 
@@ -2362,22 +2388,79 @@ reader_c::read(generic_packetizer_c *requested_ptzr,
 
   f.m_packet_sent_to_packetizer = false;
 
-  unsigned char buf[TS_MAX_PACKET_SIZE + 1];
-
   while (!f.m_packet_sent_to_packetizer) {
-    if (f.m_in->read(buf, f.m_detected_packet_size) != static_cast<unsigned int>(f.m_detected_packet_size))
+    auto packet = read_next_packet();
+    if (!packet)
       return finish();
 
-    if (buf[0] != 0x47) {
-      if (resync(f.m_in->getFilePointer() - f.m_detected_packet_size))
-        continue;
-      return finish();
+    parse_packet(packet);
+  }
+
+  return FILE_STATUS_MOREDATA;
+}
+
+unsigned int
+reader_c::count_packets_with_sync_byte(unsigned char const *buffer,
+                                       unsigned int num_packets,
+                                       unsigned int packet_size) {
+  // Only one byte per packet has to be looked at. Checking four
+  // packets per iteration keeps the common case of all of them being
+  // valid cheap.
+  auto idx = 0u;
+
+  for (; (idx + 4) <= num_packets; idx += 4) {
+    auto ptr = buffer + idx * packet_size;
+    if (   (ptr[0]               != 0x47)
+        || (ptr[packet_size]     != 0x47)
+        || (ptr[packet_size * 2] != 0x47)
+        || (ptr[packet_size * 3] != 0x47))
+      break;
+  }
+
+  while ((idx < num_packets) && (buffer[idx * packet_size] == 0x47))
+    ++idx;
+
+  return idx;
+}
+
+unsigned char *
+reader_c::read_next_packet() {
+  auto &f          = file();
+  auto packet_size = f.m_detected_packet_size;
+
+  while (f.m_next_buffered_packet >= f.m_num_buffered_packets) {
+    if (!f.m_packet_buffer)
+      f.m_packet_buffer = memory_c::alloc(TS_READ_AHEAD * packet_size);
+
+    f.clear_packet_buffer();
+
+    auto position    = f.m_in->getFilePointer();
+    auto num_read    = f.m_in->read(f.m_packet_buffer->get_buffer(), TS_READ_AHEAD * packet_size);
+    auto num_packets = num_read / packet_size;
+
+    if (!num_packets)
+      return nullptr;
+
+    f.m_num_buffered_packets      = count_packets_with_sync_byte(f.m_packet_buffer->get_buffer(), num_packets, packet_size);
+    f.m_buffered_packets_position = position;
+
+    if (!f.m_num_buffered_packets) {
+      if (!resync(position))
+        return nullptr;
+      continue;
     }
 
-    parse_packet(buf);
+    // Continue reading after the last valid packet. A packet with a
+    // broken sync byte will then be the first one of the next batch
+    // and trigger a resync, and an incomplete packet at the end of the
+    // file will be detected as such.
+    if (f.m_num_buffered_packets * packet_size != num_read)
+      f.m_in->setFilePointer(position + f.m_num_buffered_packets * packet_size);
   }
 
-  return FILE_STATUS_MOREDATA;
+  f.m_packet_position = f.m_buffered_packets_position + f.m_next_buffered_packet * packet_size;
+
+  return f.m_packet_buffer->get_buffer() + (f.m_next_buffered_packet++) * packet_size;
 }
 
 bfs::path
@@ -2492,7 +2575,22 @@ reader_c::resync(int64_t start_at) {
 }
 
 track_ptr
-reader_c::find_track_for_pid(uint16_t pid)
+reader_c::find_track_for_pid(uint16_t pid) {
+  auto &f = file();
+
+  // The list of tracks changes constantly while probing, and only few
+  // packets are looked at in that state.
+  if (processing_state_e::muxing != f.m_state)
+    return find_track_for_pid_in_track_list(pid);
+
+  if (!f.m_pid_table_valid)
+    build_pid_table();
+
+  return f.m_pid_table[pid & (TS_NUM_PIDS - 1)];
+}
+
+track_ptr
+reader_c::find_track_for_pid_in_track_list(uint16_t pid)
   const {
   auto &f = *m_files[m_current_file];
 
@@ -2514,6 +2612,25 @@ reader_c::find_track_for_pid(uint16_t pid)
   return {};
 }
 
+void
+reader_c::build_pid_table() {
+  auto &f = file();
+
+  f.m_pid_table.assign(TS_NUM_PIDS, track_ptr{});
+
+  for (auto const &track : m_tracks)
+    if ((track->m_file_num == m_current_file) && !f.m_pid_table[track->pid & (TS_NUM_PIDS - 1)])
+      f.m_pid_table[track->pid & (TS_NUM_PIDS - 1)] = find_track_for_pid_in_track_list(track->pid);
+
+  f.m_pid_table_valid = true;
+}
+
+void
+reader_c::invalidate_pid_tables() {
+  for (auto const &file : m_files)
+    file->m_pid_table_valid = false;
+}
+
 std::pair<unsigned char *, std::size_t>
 reader_c::determine_ts_payload_start(packet_header_t *hdr)
   const {
@@ -405,6 +405,16 @@ struct file_t {
   bool m_file_done, m_packet_sent_to_packetizer;
 
   unsigned int m_detected_packet_size, m_num_pat_crc_errors, m_num_pmt_crc_errors;
+
+  // While muxing packets are read in batches, and tracks are looked
+  // up via a table indexed by the PID. The file position of the packet
+  // being parsed is only used for debugging output.
+  memory_cptr m_packet_buffer;
+  unsigned int m_num_buffered_packets, m_next_buffered_packet;
+  uint64_t m_buffered_packets_position, m_packet_position;
+  std::vector<track_ptr> m_pid_table;
+  bool m_pid_table_valid;
+
   bool m_validate_pat_crc, m_validate_pmt_crc, m_has_audio_or_video_track;
 
   file_t(mm_io_cptr const &in);
@@ -412,6 +422,7 @@ struct file_t {
   int64_t get_queued_bytes() const;
   void reset_processing_state(processing_state_e new_state);
   bool all_pmts_found() const;
+  void clear_packet_buffer();
 };
 using file_cptr = std::shared_ptr<file_t>;
 
@@ -455,7 +466,10 @@ public:
 private:
   void read_headers_for_file(std::size_t file_num);
 
-  track_ptr find_track_for_pid(uint16_t pid) const;
+  track_ptr find_track_for_pid(uint16_t pid);
+  track_ptr find_track_for_pid_in_track_list(uint16_t pid) const;
+  void build_pid_table();
+  void invalidate_pid_tables();
   std::pair<unsigned char *, std::size_t> determine_ts_payload_start(packet_header_t *hdr) const;
   void setup_initial_tracks();
 
@@ -502,6 +516,8 @@ private:
   void process_chapter_entries();
 
   bool resync(int64_t start_at);
+  unsigned char *read_next_packet();
+  static unsigned int count_packets_with_sync_byte(unsigned char const *buffer, unsigned int num_packets, unsigned int packet_size);
 
   uint32_t calculate_crc(void const *buffer, size_t size) const;
 
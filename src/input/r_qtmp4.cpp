@@ -61,6 +61,16 @@ using namespace libmatroska;
 
 #define MAX_INTERLEAVING_BADNESS 0.4
 
+// Parameters for coalescing reads of sample data: the maximum size of
+// a single read, the maximum gap between two samples that is read
+// over instead of issuing a new read, the maximum number of index
+// entries looked at per track and the maximum amount of memory held by
+// blocks read ahead.
+#define READ_PLANNER_MAX_BLOCK_SIZE    (4 * 1024 * 1024)
+#define READ_PLANNER_MAX_GAP           (64 * 1024)
+#define READ_PLANNER_MAX_LOOKAHEAD     4096
+#define READ_PLANNER_MEMORY_BUDGET     (32 * 1024 * 1024)
+
 namespace mtx {
 
 class atom_chunk_size_x: public exception {
@@ -164,12 +174,15 @@ qtmp4_reader_c::qtmp4_reader_c(const track_info_c &ti,
   , m_fragment{}
   , m_track_for_fragment{}
   , m_timecodes_calculated{}
+  , m_read_blocks_size{}
+  , m_num_read_blocks{}
   , m_debug_chapters{    "qtmp4|qtmp4_full|qtmp4_chapters"}
   , m_debug_headers{     "qtmp4|qtmp4_full|qtmp4_headers"}
   , m_debug_tables{            "qtmp4_full|qtmp4_tables|qtmp4_tables_full"}
   , m_debug_tables_full{                               "qtmp4_tables_full"}
   , m_debug_interleaving{"qtmp4|qtmp4_full|qtmp4_interleaving"}
   , m_debug_resync{      "qtmp4|qtmp4_full|qtmp4_resync"}
+  , m_debug_read_planner{"qtmp4_read_planner"}
 {
 }
 
@@ -864,14 +877,22 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
   auto entries = m_in->read_uint32_be();
   auto &track  = *m_track_for_fragment;
 
-  if (track.raw_frame_offset_table.empty() && !track.sample_table.empty())
-    track.raw_frame_offset_table.emplace_back(track.sample_table.size(), 0);
+  if (track.raw_frame_offset_table.empty() && !track.sample_size_table.empty())
+    track.raw_frame_offset_table.emplace_back(track.sample_size_table.size(), 0);
 
   auto data_offset        = flags & QTMP4_TRUN_DATA_OFFSET ? m_in->read_uint32_be() : 0;
   auto first_sample_flags = flags & QTMP4_TRUN_FIRST_SAMPLE_FLAGS ? m_in->read_uint32_be() : m_fragment->sample_flags;
   auto offset             = m_fragment->base_data_offset + data_offset;
 
-  std::vector<uint32_t> all_sample_flags;
+  // All samples of a run are stored back to back. They're therefore
+  // recorded as a single chunk, and consecutive samples with the same
+  // duration or composition offset extend the previous table entry
+  // instead of adding one per sample.
+  if (entries)
+    track.chunk_table.emplace_back(entries, offset);
+
+  std::vector<uint32_t> all_sample_flags, all_durations, all_sizes, all_ctts_durations;
+  std::vector<uint64_t> all_positions;
   std::vector<bool> all_keyframe_flags;
 
   for (auto idx = 0u; idx < entries; ++idx) {
@@ -880,21 +901,35 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
     auto sample_flags    = flags & QTMP4_TRUN_SAMPLE_FLAGS      ? m_in->read_uint32_be() : idx > 0 ? m_fragment->sample_flags : first_sample_flags;
     auto ctts_duration   = flags & QTMP4_TRUN_SAMPLE_CTS_OFFSET ? m_in->read_uint32_be() : 0;
     auto keyframe        = !track.is_video()                    ? true                   : !(sample_flags & (QTMP4_FRAG_SAMPLE_FLAG_IS_NON_SYNC | QTMP4_FRAG_SAMPLE_FLAG_DEPENDS_YES));
+    auto frame_offset    = static_cast<int64_t>(mtx::math::to_signed(ctts_duration));
 
-    track.durmap_table.emplace_back(1, sample_duration);
-    track.sample_table.emplace_back(sample_size);
-    track.chunk_table.emplace_back(1, offset);
-    track.raw_frame_offset_table.emplace_back(1, mtx::math::to_signed(ctts_duration));
+    if (!track.durmap_table.empty() && (track.durmap_table.back().duration == sample_duration) && (track.durmap_table.back().number < std::numeric_limits<uint32_t>::max()))
+      ++track.durmap_table.back().number;
+    else
+      track.durmap_table.emplace_back(1, sample_duration);
+
+    if (!track.raw_frame_offset_table.empty() && (track.raw_frame_offset_table.back().offset == frame_offset) && (track.raw_frame_offset_table.back().count < std::numeric_limits<unsigned int>::max()))
+      ++track.raw_frame_offset_table.back().count;
+    else
+      track.raw_frame_offset_table.emplace_back(1, frame_offset);
+
+    track.sample_size_table.emplace_back(sample_size);
 
     if (keyframe)
       track.keyframe_table.emplace_back(track.num_frames_from_trun + 1);
 
+    if (m_debug_tables) {
+      all_sample_flags.emplace_back(sample_flags);
+      all_durations.emplace_back(sample_duration);
+      all_sizes.emplace_back(sample_size);
+      all_ctts_durations.emplace_back(ctts_duration);
+      all_positions.emplace_back(offset);
+      all_keyframe_flags.push_back(keyframe);
+    }
+
     offset += sample_size;
 
     track.num_frames_from_trun++;
-
-    all_sample_flags.emplace_back(sample_flags);
-    all_keyframe_flags.push_back(keyframe);
   }
 
   m_fragment->implicit_offset = offset;
@@ -905,22 +940,18 @@ qtmp4_reader_c::handle_trun_atom(qt_atom_t,
   if (!m_debug_tables)
     return;
 
-  auto fmt                = boost::format("%1%%2%: duration %3% size %4% data start %5% end %6% pts offset %7% key? %8% raw flags 0x%|9$08x|\n");
-  auto spc                = space((level + 2) * 2 + 1);
-  auto durmap_start       = track.durmap_table.size()           - entries;
-  auto sample_start       = track.sample_table.size()           - entries;
-  auto chunk_start        = track.chunk_table.size()            - entries;
-  auto frame_offset_start = track.raw_frame_offset_table.size() - entries;
-  auto end                = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), entries);
+  auto fmt = boost::format("%1%%2%: duration %3% size %4% data start %5% end %6% pts offset %7% key? %8% raw flags 0x%|9$08x|\n");
+  auto spc = space((level + 2) * 2 + 1);
+  auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), entries);
 
   for (auto idx = 0u; idx < end; ++idx)
     mxdebug(fmt
             % spc % idx
-            % track.durmap_table[durmap_start + idx].duration
-            % track.sample_table[sample_start + idx].size
-            % track.chunk_table[chunk_start + idx].pos
-            % (track.sample_table[sample_start + idx].size + track.chunk_table[chunk_start + idx].pos)
-            % track.raw_frame_offset_table[frame_offset_start + idx].offset
+            % all_durations[idx]
+            % all_sizes[idx]
+            % all_positions[idx]
+            % (all_sizes[idx] + all_positions[idx])
+            % mtx::math::to_signed(all_ctts_durations[idx])
             % static_cast<unsigned int>(all_keyframe_flags[idx])
             % all_sample_flags[idx]);
 }
@@ -1087,30 +1118,34 @@ qtmp4_reader_c::read_chapter_track() {
   if (m_demuxers.end() == chapter_dmx_itr)
     return;
 
-  if ((*chapter_dmx_itr)->sample_table.empty())
+  auto &chapter_dmx = **chapter_dmx_itr;
+
+  if (!chapter_dmx.m_num_samples)
     return;
 
   std::vector<qtmp4_chapter_entry_t> entries;
-  uint64_t pts_scale_gcd = boost::math::gcd(static_cast<uint64_t>(1000000000ull), static_cast<uint64_t>((*chapter_dmx_itr)->time_scale));
-  uint64_t pts_scale_num = 1000000000ull                                         / pts_scale_gcd;
-  uint64_t pts_scale_den = static_cast<uint64_t>((*chapter_dmx_itr)->time_scale) / pts_scale_gcd;
+  uint64_t pts_scale_gcd = boost::math::gcd(static_cast<uint64_t>(1000000000ull), static_cast<uint64_t>(chapter_dmx.time_scale));
+  uint64_t pts_scale_num = 1000000000ull                                 / pts_scale_gcd;
+  uint64_t pts_scale_den = static_cast<uint64_t>(chapter_dmx.time_scale) / pts_scale_gcd;
 
-  for (auto &sample : (*chapter_dmx_itr)->sample_table) {
-    if (2 >= sample.size)
-      continue;
+  chapter_dmx.for_each_sample([this, &entries, pts_scale_num, pts_scale_den](uint64_t, uint64_t pts, uint64_t pos, uint32_t size, int32_t) -> bool {
+    if (2 >= size)
+      return true;
 
-    m_in->setFilePointer(sample.pos, seek_beginning);
-    memory_cptr chunk(memory_c::alloc(sample.size));
-    if (m_in->read(chunk->get_buffer(), sample.size) != sample.size)
-      continue;
+    m_in->setFilePointer(pos, seek_beginning);
+    memory_cptr chunk(memory_c::alloc(size));
+    if (m_in->read(chunk->get_buffer(), size) != size)
+      return true;
 
     unsigned int name_len = get_uint16_be(chunk->get_buffer());
-    if ((name_len + 2) > sample.size)
-      continue;
+    if ((name_len + 2) > size)
+      return true;
 
     entries.push_back(qtmp4_chapter_entry_t(std::string(reinterpret_cast<char *>(chunk->get_buffer()) + 2, name_len),
-                                            sample.pts * pts_scale_num / pts_scale_den));
-  }
+                                            pts * pts_scale_num / pts_scale_den));
+
+    return true;
+  });
 
   recode_chapter_entries(entries);
   process_chapter_entries(0, entries);
@@ -1323,34 +1358,35 @@ qtmp4_reader_c::handle_stss_atom(qtmp4_demuxer_c &dmx,
 
 void
 qtmp4_reader_c::handle_stsz_atom(qtmp4_demuxer_c &dmx,
-                                 qt_atom_t,
+                                 qt_atom_t atom,
                                  int level) {
   m_in->skip(1 + 3);        // version & flags
   uint32_t sample_size = m_in->read_uint32_be();
   uint32_t count       = m_in->read_uint32_be();
 
   if (0 == sample_size) {
+    auto max_count = atom.size > (atom.hsize + 12) ? (atom.size - atom.hsize - 12) / 4 : 0;
+    dmx.sample_size_table.reserve(dmx.sample_size_table.size() + std::min<uint64_t>(count, max_count));
+
     size_t i;
     for (i = 0; i < count; ++i) {
-      qt_sample_t sample;
-
-      sample.size = m_in->read_uint32_be();
+      auto size = m_in->read_uint32_be();
 
       // This is a sanity check against damaged samples. I have one of
       // those in which one sample was suppposed to be > 2GB big.
-      if (sample.size >= 100 * 1024 * 1024)
-        sample.size = 0;
+      if (size >= 100 * 1024 * 1024)
+        size = 0;
 
-      dmx.sample_table.push_back(sample);
+      dmx.sample_size_table.push_back(size);
     }
 
     mxdebug_if(m_debug_headers, boost::format("%1%Sample size table: %2% entries\n") % space(level * 2 + 1) % count);
     if (m_debug_tables) {
       auto fmt = boost::format("%1%%2%: size %3%\n");
-      auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), dmx.sample_table.size());
+      auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), dmx.sample_size_table.size());
 
       for (auto idx = 0u; idx < end; ++idx)
-        mxdebug(fmt % space((level + 1) * 2 + 1) % idx % dmx.sample_table[idx].size);
+        mxdebug(fmt % space((level + 1) * 2 + 1) % idx % dmx.sample_size_table[idx]);
     }
 
   } else {
@@ -1562,36 +1598,33 @@ qtmp4_reader_c::read(generic_packetizer_c *ptzr,
   if (m_demuxers.size() == dmx_idx)
     return flush_packetizers();
 
- auto &dmx   = *m_demuxers[dmx_idx];
- auto &index = dmx.m_index[dmx.pos];
+  auto &dmx  = *m_demuxers[dmx_idx];
+  auto index = dmx.m_index[dmx.pos];
 
-  m_in->setFilePointer(index.file_pos);
-
-  int buffer_offset = 0;
   memory_cptr buffer;
 
-  if (   dmx.is_video()
-      && !dmx.pos
-      && dmx.codec.is(codec_c::type_e::V_MPEG4_P2)
-      && dmx.esds_parsed
-      && (dmx.esds.decoder_config)) {
-    buffer        = memory_c::alloc(index.size + dmx.esds.decoder_config->get_size());
-    buffer_offset = dmx.esds.decoder_config->get_size();
-
-    memcpy(buffer->get_buffer(), dmx.esds.decoder_config->get_buffer(), dmx.esds.decoder_config->get_size());
-
-  } else if (   dmx.is_video()
-             && dmx.codec.is(codec_c::type_e::V_PRORES)
-             && (index.size >= 8)) {
-    m_in->skip(8);
-    index.size -= 8;
-    buffer = memory_c::alloc(index.size);
+  try {
+    if (   dmx.is_video()
+        && !dmx.pos
+        && dmx.codec.is(codec_c::type_e::V_MPEG4_P2)
+        && dmx.esds_parsed
+        && (dmx.esds.decoder_config)) {
+      auto buffer_offset = dmx.esds.decoder_config->get_size();
+      auto data          = read_sample_data(index.file_pos, index.size);
+      buffer             = memory_c::alloc(index.size + buffer_offset);
+
+      memcpy(buffer->get_buffer(),                 dmx.esds.decoder_config->get_buffer(), buffer_offset);
+      memcpy(buffer->get_buffer() + buffer_offset, data->get_buffer(),                    index.size);
+
+    } else if (   dmx.is_video()
+               && dmx.codec.is(codec_c::type_e::V_PRORES)
+               && (index.size >= 8))
+      buffer = read_sample_data(index.file_pos + 8, index.size - 8);
 
-  } else {
-    buffer = memory_c::alloc(index.size);
-  }
+    else
+      buffer = read_sample_data(index.file_pos, index.size);
 
-  if (m_in->read(buffer->get_buffer() + buffer_offset, index.size) != index.size) {
+  } catch (mtx::mm_io::exception &) {
     mxwarn(boost::format(Y("Quicktime/MP4 reader: Could not read chunk number %1%/%2% with size %3% from position %4%. Aborting.\n"))
            % dmx.pos % dmx.m_index.size() % index.size % index.file_pos);
     return flush_packetizers();
@@ -1607,6 +1640,160 @@ qtmp4_reader_c::read(generic_packetizer_c *ptzr,
   return flush_packetizers();
 }
 
+/** \brief Read the data of a single sample
+
+   Badly interleaved files would require seeking back and forth
+   between the tracks for each sample. Therefore the data is read in
+   blocks that cover the requested sample and all samples of all
+   tracks following it in file order as long as they're close to each
+   other. Samples found in blocks read earlier are returned as slices
+   of those blocks without reading or copying them again.
+
+   The blocks are kept sorted by their file position. The ones read
+   first are dropped once the total size exceeds the memory budget.
+   A dropped block stays in memory for as long as slices of it are
+   in use, e.g. while their packets are queued. Such blocks count
+   against the budget, too. If they alone use up the budget then
+   only the requested sample is read.
+*/
+memory_cptr
+qtmp4_reader_c::read_sample_data(uint64_t file_pos,
+                                 uint64_t size) {
+  auto block = find_read_block(file_pos, size);
+  if (block)
+    return memory_c::slice(block->data, file_pos - block->file_pos, size);
+
+  m_in->setFilePointer(file_pos);
+
+  if (size >= READ_PLANNER_MAX_BLOCK_SIZE)
+    return m_in->read_slice(size);
+
+  auto pinned_size = get_pinned_read_blocks_size();
+  if ((pinned_size + READ_PLANNER_MAX_BLOCK_SIZE) > READ_PLANNER_MEMORY_BUDGET) {
+    mxdebug_if(m_debug_read_planner, boost::format("read_sample_data: sample at %1% size %2%: not reading ahead; pinned blocks: %3% with %4% bytes\n") % file_pos % size % m_pinned_read_blocks.size() % pinned_size);
+    return m_in->read_slice(size);
+  }
+
+  auto end  = plan_read_end(file_pos, size);
+  auto data = m_in->read_slice(end - file_pos);
+
+  mxdebug_if(m_debug_read_planner, boost::format("read_sample_data: sample at %1% size %2%: read %3% bytes; blocks held: %4% with %5% bytes; pinned blocks: %6% with %7% bytes\n")
+             % file_pos % size % (end - file_pos) % m_read_blocks.size() % m_read_blocks_size % m_pinned_read_blocks.size() % pinned_size);
+
+  auto insert_at = std::upper_bound(m_read_blocks.begin(), m_read_blocks.end(), file_pos, [](uint64_t pos, qt_read_block_t const &b) { return pos < b.file_pos; });
+  m_read_blocks.emplace(insert_at, file_pos, m_num_read_blocks++, data);
+  m_read_blocks_size += data->get_size();
+
+  while ((m_read_blocks.size() > 1) && ((m_read_blocks_size + pinned_size) > READ_PLANNER_MEMORY_BUDGET)) {
+    auto oldest         = brng::min_element(m_read_blocks, [](qt_read_block_t const &a, qt_read_block_t const &b) { return a.read_number < b.read_number; });
+    m_read_blocks_size -= oldest->data->get_size();
+
+    if (oldest->data.use_count() > 1) {
+      m_pinned_read_blocks.emplace_back(oldest->data);
+      pinned_size += oldest->data->get_size();
+    }
+
+    m_read_blocks.erase(oldest);
+  }
+
+  return memory_c::slice(data, 0, size);
+}
+
+/** \brief The amount of memory held by dropped blocks still in use
+
+   Forgets about the blocks that have been released in the meantime.
+*/
+uint64_t
+qtmp4_reader_c::get_pinned_read_blocks_size() {
+  auto size = uint64_t{};
+
+  brng::remove_erase_if(m_pinned_read_blocks, [&size](std::weak_ptr<memory_c> const &block) -> bool {
+    auto data = block.lock();
+    if (!data)
+      return true;
+
+    size += data->get_size();
+    return false;
+  });
+
+  return size;
+}
+
+/** \brief Find a block read earlier that contains a sample
+
+   Usually the block starting last at or before the sample contains
+   it. Blocks can overlap, though, if they were read out of file
+   order. As no block is larger than READ_PLANNER_MAX_BLOCK_SIZE the
+   search can stop at blocks starting that far before the sample.
+*/
+qt_read_block_t const *
+qtmp4_reader_c::find_read_block(uint64_t file_pos,
+                                uint64_t size)
+  const {
+  auto itr = std::upper_bound(m_read_blocks.begin(), m_read_blocks.end(), file_pos, [](uint64_t pos, qt_read_block_t const &b) { return pos < b.file_pos; });
+
+  while (itr != m_read_blocks.begin()) {
+    --itr;
+
+    if (itr->contains(file_pos, size))
+      return &*itr;
+
+    if ((itr->file_pos + READ_PLANNER_MAX_BLOCK_SIZE) < (file_pos + size))
+      break;
+  }
+
+  return nullptr;
+}
+
+/** \brief Determine how much to read for a sample
+
+   The upcoming samples of all tracks that are demuxed are merged in
+   file order. The block is extended for as long as the next sample
+   starts at most READ_PLANNER_MAX_GAP bytes after the current end and
+   the block doesn't grow beyond READ_PLANNER_MAX_BLOCK_SIZE.
+*/
+uint64_t
+qtmp4_reader_c::plan_read_end(uint64_t file_pos,
+                              uint64_t size)
+  const {
+  auto max_end   = std::min<uint64_t>(file_pos + READ_PLANNER_MAX_BLOCK_SIZE, m_size);
+  auto intervals = std::vector<std::pair<uint64_t, uint64_t>>{};
+
+  for (auto const &dmx : m_demuxers) {
+    if (-1 == dmx->ptzr)
+      continue;
+
+    // A cursor of its own leaves the index's cache for the sample
+    // being read alone.
+    auto last = std::min<std::size_t>(dmx->pos + READ_PLANNER_MAX_LOOKAHEAD, dmx->m_index.size());
+
+    for (auto cursor = dmx->m_index.cursor(dmx->pos); cursor.get_idx() < last; ++cursor) {
+      auto index     = cursor.get();
+      auto index_end = static_cast<uint64_t>(index.file_pos + index.size);
+
+      // Samples are usually stored in ascending order per track.
+      if (static_cast<uint64_t>(index.file_pos) >= max_end)
+        break;
+
+      if ((static_cast<uint64_t>(index.file_pos) >= file_pos) && (index_end <= max_end))
+        intervals.emplace_back(index.file_pos, index_end);
+    }
+  }
+
+  brng::sort(intervals);
+
+  auto end = file_pos + size;
+
+  for (auto const &interval : intervals) {
+    if (interval.first > (end + READ_PLANNER_MAX_GAP))
+      break;
+
+    end = std::max(end, interval.second);
+  }
+
+  return end;
+}
+
 memory_cptr
 qtmp4_reader_c::create_bitmap_info_header(qtmp4_demuxer_c &dmx,
                                           const char *fourcc,
@@ -1884,10 +2071,10 @@ qtmp4_reader_c::get_progress() {
   if (-1 == m_main_dmx)
     return 100;
 
-  auto &dmx       = *m_demuxers[m_main_dmx];
-  auto max_chunks = (0 == dmx.sample_size) ? dmx.sample_table.size() : dmx.chunk_table.size();
+  auto &dmx        = *m_demuxers[m_main_dmx];
+  auto num_entries = dmx.m_index.size();
 
-  return 100 * dmx.pos / max_chunks;
+  return num_entries ? 100 * dmx.pos / num_entries : 100;
 }
 
 void
@@ -1983,7 +2170,7 @@ void
 qtmp4_reader_c::detect_interleaving() {
   std::list<qtmp4_demuxer_cptr> demuxers_to_read;
   boost::remove_copy_if(m_demuxers, std::back_inserter(demuxers_to_read), [this](auto const &dmx) {
-    return !(dmx->ok && (dmx->is_audio() || dmx->is_video()) && this->demuxing_requested(dmx->type, dmx->id, dmx->language) && (dmx->sample_table.size() > 1));
+    return !(dmx->ok && (dmx->is_audio() || dmx->is_video()) && this->demuxing_requested(dmx->type, dmx->id, dmx->language) && (dmx->m_num_samples > 1));
   });
 
   if (demuxers_to_read.size() < 2) {
@@ -1991,12 +2178,17 @@ qtmp4_reader_c::detect_interleaving() {
     return;
   }
 
-  auto cmp = [](const qt_sample_t &s1, const qt_sample_t &s2) -> uint64_t { return s1.pos < s2.pos; };
-
   std::list<double> gradients;
   for (auto &dmx : demuxers_to_read) {
-    uint64_t min = boost::min_element(dmx->sample_table, cmp)->pos;
-    uint64_t max = boost::max_element(dmx->sample_table, cmp)->pos;
+    auto min = std::numeric_limits<uint64_t>::max();
+    auto max = uint64_t{};
+
+    dmx->for_each_sample([&min, &max](uint64_t, uint64_t, uint64_t pos, uint32_t, int32_t) -> bool {
+      min = std::min(min, pos);
+      max = std::max(max, pos);
+      return true;
+    });
+
     gradients.push_back(static_cast<double>(max - min) / m_in->get_size());
 
     mxdebug_if(m_debug_interleaving, boost::format("Interleaving: Track id %1% min %2% max %3% gradient %4%\n") % dmx->id % min % max % gradients.back());
@@ -2011,9 +2203,65 @@ qtmp4_reader_c::detect_interleaving() {
 
 // ----------------------------------------------------------------------
 
+/** \brief Call a function for each sample in decoding order
+
+   The timestamps, file positions and composition offsets aren't
+   stored per sample. They're calculated on the fly from the run-length
+   encoded duration, chunk and composition offset tables. The function
+   is called with the sample's number, timestamp, file position, size
+   and composition offset and returns \c false in order to stop the
+   iteration.
+*/
+template<typename Tfunction>
+void
+qtmp4_demuxer_c::for_each_sample(Tfunction const &function)
+  const {
+  auto durmap_idx        = std::size_t{};
+  auto durmap_left       = uint64_t{};
+  auto chunk_idx         = std::size_t{};
+  auto chunk_left        = uint64_t{};
+  auto chunk_pos         = uint64_t{};
+  auto frame_offset_idx  = std::size_t{};
+  auto frame_offset_left = uint64_t{};
+  auto pts               = uint64_t{};
+
+  for (auto sample_idx = uint64_t{}; sample_idx < m_num_samples; ++sample_idx) {
+    // m_num_samples is limited to the number of durations available.
+    while (!durmap_left)
+      durmap_left = durmap_table[durmap_idx++].number;
+
+    while (!chunk_left && (chunk_idx < chunk_table.size())) {
+      chunk_pos  = chunk_table[chunk_idx].pos;
+      chunk_left = chunk_table[chunk_idx].size;
+      ++chunk_idx;
+    }
+
+    while (!frame_offset_left && (frame_offset_idx < raw_frame_offset_table.size()))
+      frame_offset_left = raw_frame_offset_table[frame_offset_idx++].count;
+
+    auto size         = get_sample_size(sample_idx);
+    auto pos          = chunk_left        ? chunk_pos                                                                 : 0;
+    auto frame_offset = frame_offset_left ? static_cast<int32_t>(raw_frame_offset_table[frame_offset_idx - 1].offset) : 0;
+
+    if (!function(sample_idx, pts, pos, size, frame_offset))
+      return;
+
+    pts += durmap_table[durmap_idx - 1].duration;
+    --durmap_left;
+
+    if (chunk_left) {
+      chunk_pos += size;
+      --chunk_left;
+    }
+
+    if (frame_offset_left)
+      --frame_offset_left;
+  }
+}
+
 void
 qtmp4_demuxer_c::calculate_frame_rate() {
-  if ((1 == durmap_table.size()) && (0 != durmap_table[0].duration) && ((0 != sample_size) || (0 == frame_offset_table.size()))) {
+  if ((1 == durmap_table.size()) && (0 != durmap_table[0].duration) && ((0 != sample_size) || (0 == m_num_frame_offsets))) {
     // Constant frame_rate. Let's set the default duration.
     frame_rate.assign(time_scale, static_cast<int64_t>(durmap_table[0].duration));
     mxdebug_if(m_debug_frame_rate, boost::format("calculate_frame_rate: case 1: %1%/%2%\n") % frame_rate.numerator() % frame_rate.denominator());
@@ -2021,21 +2269,22 @@ qtmp4_demuxer_c::calculate_frame_rate() {
     return;
   }
 
-  if (sample_table.size() < 2) {
+  if (m_num_samples < 2) {
     mxdebug_if(m_debug_frame_rate, boost::format("calculate_frame_rate: case 2: sample table too small\n"));
     return;
   }
 
-  auto max_pts = sample_table[0].pts;
-  auto min_pts = max_pts;
+  auto max_pts = std::numeric_limits<uint64_t>::min();
+  auto min_pts = std::numeric_limits<uint64_t>::max();
 
-  for (auto const &sample : sample_table) {
-    max_pts = std::max(max_pts, sample.pts);
-    min_pts = std::min(min_pts, sample.pts);
-  }
+  for_each_sample([&min_pts, &max_pts](uint64_t, uint64_t pts, uint64_t, uint32_t, int32_t) -> bool {
+    max_pts = std::max(max_pts, pts);
+    min_pts = std::min(min_pts, pts);
+    return true;
+  });
 
   auto duration   = to_nsecs(max_pts - min_pts);
-  auto num_frames = sample_table.size() - 1;
+  auto num_frames = m_num_samples - 1;
   frame_rate      = mtx::frame_timing::determine_frame_rate(duration / num_frames);
 
   if (frame_rate) {
@@ -2051,9 +2300,13 @@ qtmp4_demuxer_c::calculate_frame_rate() {
 
   std::map<int64_t, int> duration_map;
 
-  std::accumulate(sample_table.begin() + 1, sample_table.end(), sample_table[0], [&duration_map](auto const &previous_sample, auto const &current_sample) -> auto {
-    duration_map[current_sample.pts - previous_sample.pts]++;
-    return current_sample;
+  auto previous_pts = uint64_t{};
+
+  for_each_sample([&duration_map, &previous_pts](uint64_t sample_idx, uint64_t pts, uint64_t, uint32_t, int32_t) -> bool {
+    if (sample_idx)
+      duration_map[static_cast<int64_t>(pts - previous_pts)]++;
+    previous_pts = pts;
+    return true;
   });
 
   auto most_common = std::accumulate(duration_map.begin(), duration_map.end(), std::pair<int64_t, int>(*duration_map.begin()),
@@ -2073,98 +2326,24 @@ qtmp4_demuxer_c::to_nsecs(int64_t value,
   return boost::rational_cast<int64_t>(int64_rational_c{value, time_scale_to_use ? *time_scale_to_use : time_scale} * int64_rational_c{1'000'000'000ll, 1});
 }
 
-void
-qtmp4_demuxer_c::calculate_timecodes_constant_sample_size() {
-  int const num_frame_offsets = frame_offset_table.size();
-  auto chunk_index            = 0;
-
-  for (auto const &chunk : chunk_table) {
-    auto frame_offset = chunk_index < num_frame_offsets ? frame_offset_table[chunk_index] : 0;
-
-    timecodes.push_back(to_nsecs(static_cast<uint64_t>(chunk.samples) * duration + frame_offset));
-    durations.push_back(to_nsecs(static_cast<uint64_t>(chunk.size)    * duration));
-    frame_indices.push_back(chunk_index);
-
-    ++chunk_index;
-  }
-}
-
-void
-qtmp4_demuxer_c::calculate_timecodes_variable_sample_size() {
-  auto const num_frame_offsets = frame_offset_table.size();
-  auto const num_samples       = sample_table.size();
-
-  std::vector<int64_t> timecodes_before_offsets;
-
-  timecodes.reserve(num_samples);
-  timecodes_before_offsets.reserve(num_samples);
-  durations.reserve(num_samples);
-  frame_indices.reserve(num_samples);
-
-  for (unsigned int frame = 0; num_samples > frame; ++frame) {
-    auto timecode = to_nsecs(sample_table[frame].pts);
-
-    frame_indices.push_back(frame);
-    timecodes_before_offsets.push_back(timecode);
-    timecodes.push_back(timecode + (frame < num_frame_offsets ? to_nsecs(frame_offset_table[frame]) : 0));
-  }
-
-  int64_t avg_duration = 0, num_good_frames = 0;
-
-  for (unsigned int frame = 0; num_samples > (frame + 1); ++frame) {
-    int64_t diff = timecodes_before_offsets[frame + 1] - timecodes_before_offsets[frame];
-
-    if (0 >= diff)
-      durations.push_back(0);
-    else {
-      ++num_good_frames;
-      avg_duration += diff;
-      durations.push_back(diff);
-    }
-  }
-
-  durations.push_back(0);
-
-  if (num_good_frames) {
-    avg_duration /= num_good_frames;
-    for (auto &duration : durations)
-      if (!duration)
-        duration = avg_duration;
-  }
-}
-
 void
 qtmp4_demuxer_c::calculate_timecodes() {
   if (m_timecodes_calculated)
     return;
 
-  if (0 != sample_size)
-    calculate_timecodes_constant_sample_size();
-  else
-    calculate_timecodes_variable_sample_size();
-
-  if (m_debug_tables) {
-    mxdebug(boost::format("Timestamps for track ID %1%:\n") % id);
-    auto fmt = boost::format("  %1%: pts %2%\n");
-    auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), timecodes.size());
-
-    for (auto idx = 0u; idx < end; ++idx)
-      mxdebug(fmt % idx % format_timestamp(timecodes[idx]));
-  }
-
   build_index();
   apply_edit_list();
 
+  m_index.shrink_to_fit();
+
+  mxdebug_if(m_debug_indexes, boost::format("Index for track ID %1%: %2% entries using %3% bytes\n") % id % m_index.size() % m_index.get_memory_usage());
+
   m_timecodes_calculated = true;
 }
 
 void
 qtmp4_demuxer_c::adjust_timecodes(int64_t delta) {
-  for (auto &timecode : timecodes)
-    timecode += delta;
-
-  for (auto &index : m_index)
-    index.timecode += delta;
+  m_index.adjust_timecodes(delta);
 }
 
 boost::optional<int64_t>
@@ -2174,7 +2353,12 @@ qtmp4_demuxer_c::min_timecode()
     return {};
   }
 
-  return boost::accumulate(m_index, std::numeric_limits<int64_t>::max(), [](int64_t min, auto const &entry) { return std::min(min, entry.timecode); });
+  auto min = std::numeric_limits<int64_t>::max();
+
+  for (auto idx = std::size_t{}, num_entries = m_index.size(); idx < num_entries; ++idx)
+    min = std::min(min, m_index[idx].timecode);
+
+  return min;
 }
 
 bool
@@ -2217,19 +2401,17 @@ qtmp4_demuxer_c::update_tables() {
   }
 
   // workaround for fixed-size video frames (dv and uncompressed), but
-  // also for audio with constant sample size
-  if (sample_table.empty() && (sample_size > 1)) {
-    for (i = 0; i < s; ++i) {
-      qt_sample_t sample;
+  // also for audio with constant sample size: all samples have the
+  // same size which is therefore not stored for each of them.
+  if (sample_size_table.empty() && (sample_size > 1)) {
+    m_uniform_sample_size = sample_size;
+    m_num_samples         = s;
+    sample_size           = 0;
 
-      sample.size = sample_size;
-      sample_table.push_back(sample);
-    }
-
-    sample_size = 0;
-  }
+  } else
+    m_num_samples = sample_size_table.size();
 
-  if (sample_table.empty()) {
+  if (!m_num_samples) {
     // constant sample size
     if ((1 == durmap_table.size()) || ((2 == durmap_table.size()) && (1 == durmap_table[1].number)))
       duration = durmap_table[0].duration;
@@ -2241,58 +2423,39 @@ qtmp4_demuxer_c::update_tables() {
     return true;
   }
 
-  // calc pts:
-  auto num_samples = sample_table.size();
-  s                = 0;
-  uint64_t pts     = 0;
+  // Timestamps, positions & pts/dts offsets are calculated on the fly
+  // by for_each_sample(). Only the number of samples that can be
+  // assigned a timestamp is determined here.
+  auto num_timestamps = boost::accumulate(durmap_table, uint64_t{}, [](uint64_t sum, qt_durmap_t const &durmap) { return sum + durmap.number; });
 
-  for (j = 0; (j < durmap_table.size()) && (s < num_samples); ++j) {
-    for (i = 0; (i < durmap_table[j].number) && (s < num_samples); ++i) {
-      sample_table[s].pts  = pts;
-      pts                 += durmap_table[j].duration;
-      ++s;
-    }
-  }
+  if (num_timestamps < m_num_samples) {
+    mxdebug_if(m_debug_headers, boost::format("Track %1%: fewer timestamps assigned than entries in the sample table: %2% < %3%; dropping the excessive items\n") % id % num_timestamps % m_num_samples);
+    m_num_samples = num_timestamps;
 
-  if (s < num_samples) {
-    mxdebug_if(m_debug_headers, boost::format("Track %1%: fewer timestamps assigned than entries in the sample table: %2% < %3%; dropping the excessive items\n") % id % s % num_samples);
-    sample_table.resize(s);
-    num_samples = s;
-  }
-
-  // calc sample offsets
-  s = 0;
-  for (j = 0; (j < chunk_table.size()) && (s < num_samples); ++j) {
-    uint64_t chunk_pos = chunk_table[j].pos;
-
-    for (i = 0; (i < chunk_table[j].size) && (s < num_samples); ++i) {
-      sample_table[s].pos  = chunk_pos;
-      chunk_pos           += sample_table[s].size;
-      ++s;
-    }
+    if (!m_uniform_sample_size)
+      sample_size_table.resize(m_num_samples);
   }
 
-  // calc pts/dts offsets
-  for (j = 0; j < raw_frame_offset_table.size(); ++j) {
-    size_t k;
-
-    for (k = 0; k < raw_frame_offset_table[j].count; ++k)
-      frame_offset_table.push_back(raw_frame_offset_table[j].offset);
-  }
+  m_num_frame_offsets = boost::accumulate(raw_frame_offset_table, uint64_t{}, [](uint64_t sum, qt_frame_offset_t const &frame_offset) { return sum + frame_offset.count; });
 
   m_tables_updated = true;
 
   if (!m_debug_tables)
     return true;
 
-  mxdebug(boost::format(" Frame offset table for track ID %1%: %2% entries\n")    % id % frame_offset_table.size());
-  mxdebug(boost::format(" Sample table contents for track ID %1%: %2% entries\n") % id % sample_table.size());
+  mxdebug(boost::format(" Frame offset table for track ID %1%: %2% entries\n")    % id % m_num_frame_offsets);
+  mxdebug(boost::format(" Sample table contents for track ID %1%: %2% entries\n") % id % m_num_samples);
 
   auto fmt = boost::format("   %1%: pts %2% size %3% pos %4%\n");
-  auto end = std::min<std::size_t>(!m_debug_tables_full ? 20 : std::numeric_limits<std::size_t>::max(), sample_table.size());
+  auto end = std::min<uint64_t>(!m_debug_tables_full ? 20 : std::numeric_limits<uint64_t>::max(), m_num_samples);
 
-  for (auto idx = 0u; idx < end; ++idx)
-    mxdebug(fmt % idx % sample_table[idx].pts % sample_table[idx].size % sample_table[idx].pos);
+  for_each_sample([&fmt, end](uint64_t sample_idx, uint64_t pts, uint64_t pos, uint32_t size, int32_t) -> bool {
+    if (sample_idx >= end)
+      return false;
+
+    mxdebug(fmt % sample_idx % pts % size % pos);
+    return true;
+  });
 
   return true;
 }
@@ -2306,12 +2469,10 @@ qtmp4_demuxer_c::apply_edit_list() {
              boost::format("Applying edit list for track %1%: %2% entries; track time scale %3%, global time scale %4%\n")
              % id % editlist_table.size() % time_scale % m_reader.m_time_scale);
 
-  std::vector<qt_index_t> edited_index;
+  qt_index_c edited_index;
 
   auto const num_edits         = editlist_table.size();
   auto const num_index_entries = m_index.size();
-  auto const index_begin       = m_index.begin();
-  auto const index_end         = m_index.end();
   auto const global_time_scale = m_reader.m_time_scale;
   auto timeline_cts            = int64_t{};
   auto info_fmt                = boost::format("%1% [segment_duration %2% media_time %3% media_rate %4%/%5%]");
@@ -2354,23 +2515,30 @@ qtmp4_demuxer_c::apply_edit_list() {
     auto const edit_duration  = to_nsecs(edit.segment_duration, global_time_scale);
     auto const edit_start_cts = to_nsecs(edit.media_time);
     auto const edit_end_cts   = edit_start_cts + edit_duration;
-    auto itr                  = boost::range::find_if(m_index, [edit_start_cts](auto const &entry) { return (entry.timecode + entry.duration - (entry.duration > 0 ? 1 : 0)) >= edit_start_cts; });
-    auto const frame_idx      = static_cast<uint64_t>(std::distance(index_begin, itr));
+    auto frame_idx            = std::size_t{};
+
+    for (; frame_idx < num_index_entries; ++frame_idx) {
+      auto entry = m_index[frame_idx];
+      if ((entry.timecode + entry.duration - (entry.duration > 0 ? 1 : 0)) >= edit_start_cts)
+        break;
+    }
 
     mxdebug_if(m_debug_editlists,
                boost::format("  %1%: normal entry; first frame %2% edit CTS %3%–%4% at timeline CTS %5%\n")
-               % info % (frame_idx >= num_index_entries ? -1 : frame_idx) % format_timestamp(edit_start_cts) % format_timestamp(edit_end_cts) % format_timestamp(timeline_cts));
+               % info % (frame_idx >= num_index_entries ? -1 : static_cast<int64_t>(frame_idx)) % format_timestamp(edit_start_cts) % format_timestamp(edit_end_cts) % format_timestamp(timeline_cts));
 
     // Find active key frame.
-    while ((itr != index_end) && (itr > index_begin) && !itr->is_keyframe) {
-      --itr;
+    while ((frame_idx < num_index_entries) && (frame_idx > 0) && !m_index.is_keyframe(frame_idx)) {
+      --frame_idx;
     }
 
-    while ((itr < index_end) && (!edit_duration || (itr->timecode < edit_end_cts))) {
-      itr->timecode = timeline_cts + itr->timecode - edit_start_cts;
-      edited_index.emplace_back(*itr);
+    for (; frame_idx < num_index_entries; ++frame_idx) {
+      auto entry = m_index[frame_idx];
+      if (edit_duration && (entry.timecode >= edit_end_cts))
+        break;
 
-      ++itr;
+      entry.timecode = timeline_cts + entry.timecode - edit_start_cts;
+      edited_index.push_back(entry);
     }
 
     timeline_cts += edit_end_cts - edit_start_cts;
@@ -2391,7 +2559,7 @@ qtmp4_demuxer_c::dump_index_entries(std::string const &message)
   auto end = std::min<std::size_t>(!m_debug_indexes_full ? 20 : std::numeric_limits<std::size_t>::max(), m_index.size());
 
   for (auto idx = 0u; idx < end; ++idx) {
-    auto const &entry = m_index[idx];
+    auto entry = m_index[idx];
     mxdebug(fmt % idx % format_timestamp(entry.timecode) % format_timestamp(entry.duration) % entry.is_keyframe % entry.file_pos % entry.size);
   }
 }
@@ -2410,61 +2578,115 @@ qtmp4_demuxer_c::build_index() {
     dump_index_entries("Index before edit list");
 }
 
-void
-qtmp4_demuxer_c::build_index_constant_sample_size_mode() {
-  auto is_audio              = 'a' == type;
-  auto sound_stsd_atom       = reinterpret_cast<sound_v1_stsd_atom_t *>(is_audio && stsd ? stsd->get_buffer() : nullptr);
+uint64_t
+qtmp4_demuxer_c::get_chunk_frame_size(qt_chunk_t const &chunk)
+  const {
+  if (1 != sample_size)
+    return static_cast<uint64_t>(chunk.size) * sample_size;
+
+  uint64_t frame_size = chunk.size;
+
+  if (!is_audio())
+    return frame_size;
+
+  auto sound_stsd_atom       = reinterpret_cast<sound_v1_stsd_atom_t *>(stsd ? stsd->get_buffer() : nullptr);
   auto v0_sample_size        = sound_stsd_atom       ? get_uint16_be(&sound_stsd_atom->v0.sample_size)        : 0;
   auto v0_audio_version      = sound_stsd_atom       ? get_uint16_be(&sound_stsd_atom->v0.version)            : 0;
   auto v1_bytes_per_frame    = 1 == v0_audio_version ? get_uint32_be(&sound_stsd_atom->v1.bytes_per_frame)    : 0;
   auto v1_samples_per_packet = 1 == v0_audio_version ? get_uint32_be(&sound_stsd_atom->v1.samples_per_packet) : 0;
 
-  size_t frame_idx;
-  for (frame_idx = 0; frame_idx < chunk_table.size(); ++frame_idx) {
-    uint64_t frame_size;
+  if ((0 != v1_bytes_per_frame) && (0 != v1_samples_per_packet)) {
+    frame_size *= v1_bytes_per_frame;
+    frame_size /= v1_samples_per_packet;
+  } else
+    frame_size  = frame_size * a_channels * v0_sample_size / 8;
 
-    if (1 != sample_size) {
-      frame_size = chunk_table[frame_idx].size * sample_size;
+  return frame_size;
+}
 
-    } else {
-      frame_size = chunk_table[frame_idx].size;
-
-      if (is_audio) {
-        if ((0 != v1_bytes_per_frame) && (0 != v1_samples_per_packet)) {
-          frame_size *= v1_bytes_per_frame;
-          frame_size /= v1_samples_per_packet;
-        } else
-          frame_size  = frame_size * a_channels * v0_sample_size / 8;
-      }
-    }
+void
+qtmp4_demuxer_c::build_index_constant_sample_size_mode() {
+  // Each chunk is one frame. The n-th chunk uses the n-th composition
+  // offset.
+  auto frame_offset_idx  = std::size_t{};
+  auto frame_offset_left = uint64_t{};
+
+  for (auto const &chunk : chunk_table) {
+    while (!frame_offset_left && (frame_offset_idx < raw_frame_offset_table.size()))
+      frame_offset_left = raw_frame_offset_table[frame_offset_idx++].count;
 
-    m_index.emplace_back(chunk_table[frame_idx].pos, frame_size, timecodes[frame_idx], durations[frame_idx], false);
+    auto frame_offset = frame_offset_left ? raw_frame_offset_table[frame_offset_idx - 1].offset : 0;
+
+    if (frame_offset_left)
+      --frame_offset_left;
+
+    m_index.emplace_back(chunk.pos, get_chunk_frame_size(chunk), to_nsecs(static_cast<int64_t>(static_cast<uint64_t>(chunk.samples) * duration) + frame_offset), to_nsecs(static_cast<uint64_t>(chunk.size) * duration), false);
   }
 }
 
 void
 qtmp4_demuxer_c::build_index_chunk_mode() {
-  for (std::size_t frame_idx = 0, num_frames = frame_indices.size(); frame_idx < num_frames; ++frame_idx) {
-    auto act_frame_idx = frame_indices[frame_idx];
-    auto &sample       = sample_table[act_frame_idx];
+  // A frame's duration is the difference between its timestamp and
+  // the following frame's timestamp (both without the pts/dts
+  // offsets). Frames for which that isn't positive as well as the
+  // last frame get the average duration of all other frames. That
+  // average is determined in a first pass.
+  int64_t avg_duration = 0, num_good_frames = 0, previous_timecode = 0;
+
+  for_each_sample([this, &avg_duration, &num_good_frames, &previous_timecode](uint64_t sample_idx, uint64_t pts, uint64_t, uint32_t, int32_t) -> bool {
+    auto timecode = to_nsecs(pts);
+    auto diff     = timecode - previous_timecode;
+
+    if (sample_idx && (0 < diff)) {
+      ++num_good_frames;
+      avg_duration += diff;
+    }
+
+    previous_timecode = timecode;
+    return true;
+  });
+
+  if (num_good_frames)
+    avg_duration /= num_good_frames;
 
-    m_index.emplace_back(sample.pos, sample.size, timecodes[frame_idx], durations[frame_idx], false);
+  // Each frame is added to the index once the following frame's
+  // timestamp is known.
+  auto previous = qt_index_t{};
+
+  for_each_sample([this, avg_duration, &previous, &previous_timecode](uint64_t sample_idx, uint64_t pts, uint64_t pos, uint32_t size, int32_t frame_offset) -> bool {
+    auto timecode = to_nsecs(pts);
+
+    if (sample_idx) {
+      auto diff         = timecode - previous_timecode;
+      previous.duration = 0 < diff ? diff : avg_duration;
+      m_index.push_back(previous);
+    }
+
+    previous          = qt_index_t{static_cast<int64_t>(pos), size, timecode + (frame_offset ? to_nsecs(frame_offset) : 0), 0, false};
+    previous_timecode = timecode;
+
+    return true;
+  });
+
+  if (m_num_samples) {
+    previous.duration = avg_duration;
+    m_index.push_back(previous);
   }
 }
 
 void
 qtmp4_demuxer_c::mark_key_frames_from_key_frame_table() {
+  auto num_index_entries = m_index.size();
+
   if (keyframe_table.empty()) {
-    for (auto &index : m_index)
-      index.is_keyframe = true;
+    for (auto idx = std::size_t{}; idx < num_index_entries; ++idx)
+      m_index.set_keyframe(idx);
     return;
   }
 
-  auto num_index_entries = m_index.size();
-
   for (auto const &keyframe_number : keyframe_table)
     if ((keyframe_number > 0) && (keyframe_number <= num_index_entries))
-      m_index[keyframe_number - 1].is_keyframe = true;
+      m_index.set_keyframe(keyframe_number - 1);
 }
 
 void
@@ -2482,7 +2704,7 @@ qtmp4_demuxer_c::mark_open_gop_random_access_points_as_key_frames() {
   for (auto const &s2g : table_itr->second) {
     if (s2g.group_description_index && ((s2g.group_description_index - 1) < num_random_access_points)) {
       for (auto end = std::min<size_t>(current_sample + s2g.sample_count, num_index_entries); current_sample < end; ++current_sample)
-        m_index[current_sample].is_keyframe = true;
+        m_index.set_keyframe(current_sample);
 
     } else
       current_sample += s2g.sample_count;
@@ -2497,26 +2719,38 @@ qtmp4_demuxer_c::read_first_bytes(int num_bytes) {
   if (!update_tables())
     return memory_cptr{};
 
-  calculate_timecodes();
-
   auto buf       = memory_c::alloc(num_bytes);
   size_t buf_pos = 0;
-  size_t idx_pos = 0;
+  auto read_ok   = true;
 
-  while ((0 < num_bytes) && (idx_pos < m_index.size())) {
-    qt_index_t &index          = m_index[idx_pos];
-    uint64_t num_bytes_to_read = std::min<int64_t>(num_bytes, index.size);
+  auto read_frame = [this, &buf, &buf_pos, &num_bytes, &read_ok](uint64_t file_pos, uint64_t size) -> bool {
+    uint64_t num_bytes_to_read = std::min<int64_t>(num_bytes, size);
 
-    m_reader.m_in->setFilePointer(index.file_pos);
-    if (m_reader.m_in->read(buf->get_buffer() + buf_pos, num_bytes_to_read) < num_bytes_to_read)
-      return memory_cptr{};
+    m_reader.m_in->setFilePointer(file_pos);
+    if (m_reader.m_in->read(buf->get_buffer() + buf_pos, num_bytes_to_read) < num_bytes_to_read) {
+      read_ok = false;
+      return false;
+    }
 
     num_bytes -= num_bytes_to_read;
     buf_pos   += num_bytes_to_read;
-    ++idx_pos;
-  }
 
-  return 0 == num_bytes ? buf : memory_cptr{};
+    return 0 < num_bytes;
+  };
+
+  // Walk the samples directly instead of building the index. That's
+  // all that's needed when only identifying a file.
+  if (0 != sample_size) {
+    for (auto const &chunk : chunk_table)
+      if ((0 == num_bytes) || !read_frame(chunk.pos, get_chunk_frame_size(chunk)))
+        break;
+
+  } else if (0 < num_bytes)
+    for_each_sample([&read_frame](uint64_t, uint64_t, uint64_t pos, uint32_t size, int32_t) -> bool {
+      return read_frame(pos, size);
+    });
+
+  return read_ok && (0 == num_bytes) ? buf : memory_cptr{};
 }
 
 bool
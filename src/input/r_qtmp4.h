@@ -21,6 +21,7 @@
 #include "common/dts.h"
 #include "common/fourcc.h"
 #include "common/mm_io.h"
+#include "common/qt_index.h"
 #include "input/qtmp4_atoms.h"
 #include "merge/generic_reader.h"
 #include "output/p_pcm.h"
@@ -102,26 +103,6 @@ struct qt_editlist_t {
   uint16_t media_rate_integer{}, media_rate_fraction{};
 };
 
-struct qt_sample_t {
-  int64_t  pts;
-  uint32_t size;
-  int64_t  pos;
-
-  qt_sample_t()
-    : pts{}
-    , size{}
-    , pos{}
-  {
-  }
-
-  qt_sample_t(uint32_t p_size)
-    : pts{}
-    , size{p_size}
-    , pos{}
-  {
-  }
-};
-
 struct qt_frame_offset_t {
   unsigned int count;
   int64_t offset;
@@ -139,30 +120,6 @@ struct qt_frame_offset_t {
   }
 };
 
-struct qt_index_t {
-  int64_t file_pos, size;
-  int64_t timecode, duration;
-  bool    is_keyframe;
-
-  qt_index_t()
-    : file_pos{}
-    , size{}
-    , timecode{}
-    , duration{}
-    , is_keyframe{}
-  {
-  };
-
-  qt_index_t(int64_t p_file_pos, int64_t p_size, int64_t p_timecode, int64_t p_duration, bool p_is_keyframe)
-    : file_pos{p_file_pos}
-    , size{p_size}
-    , timecode{p_timecode}
-    , duration{p_duration}
-    , is_keyframe{p_is_keyframe}
-  {
-  }
-};
-
 struct qt_track_defaults_t {
   unsigned int sample_description_id, sample_duration, sample_size, sample_flags;
 
@@ -212,6 +169,23 @@ struct qt_sample_to_group_t {
   }
 };
 
+// A range of the file read ahead by qtmp4_reader_c::read_sample_data().
+struct qt_read_block_t {
+  uint64_t file_pos{}, read_number{};
+  memory_cptr data;
+
+  qt_read_block_t(uint64_t p_file_pos, uint64_t p_read_number, memory_cptr const &p_data)
+    : file_pos{p_file_pos}
+    , read_number{p_read_number}
+    , data{p_data}
+  {
+  }
+
+  bool contains(uint64_t pos, uint64_t size) const {
+    return (pos >= file_pos) && ((pos + size) <= (file_pos + data->get_size()));
+  }
+};
+
 class qtmp4_reader_c;
 
 struct qtmp4_demuxer_c {
@@ -230,20 +204,22 @@ struct qtmp4_demuxer_c {
   int64_t time_scale, duration, global_duration, num_frames_from_trun;
   uint32_t sample_size;
 
-  std::vector<qt_sample_t> sample_table;
+  std::vector<uint32_t> sample_size_table;
   std::vector<qt_chunk_t> chunk_table;
   std::vector<qt_chunkmap_t> chunkmap_table;
   std::vector<qt_durmap_t> durmap_table;
   std::vector<uint32_t> keyframe_table;
   std::vector<qt_editlist_t> editlist_table;
   std::vector<qt_frame_offset_t> raw_frame_offset_table;
-  std::vector<int32_t> frame_offset_table;
   std::vector<qt_random_access_point_t> random_access_point_table;
   std::unordered_map<uint32_t, std::vector<qt_sample_to_group_t> > sample_to_group_tables;
 
-  std::vector<int64_t> timecodes, durations, frame_indices;
+  // Set by update_tables(). Sample sizes are only stored in
+  // sample_size_table if they aren't all the same.
+  uint64_t m_num_samples{}, m_num_frame_offsets{};
+  uint32_t m_uniform_sample_size{};
 
-  std::vector<qt_index_t> m_index;
+  qt_index_c m_index;
   std::vector<qt_fragment_t> m_fragments;
 
   int64_rational_c frame_rate;
@@ -324,6 +300,12 @@ struct qtmp4_demuxer_c {
 
   memory_cptr read_first_bytes(int num_bytes);
 
+  uint32_t get_sample_size(uint64_t sample_idx) const {
+    return m_uniform_sample_size ? m_uniform_sample_size : sample_size_table[sample_idx];
+  }
+
+  template<typename Tfunction> void for_each_sample(Tfunction const &function) const;
+
   bool is_audio() const;
   bool is_video() const;
   bool is_subtitles() const;
@@ -369,13 +351,11 @@ struct qtmp4_demuxer_c {
 private:
   void build_index_chunk_mode();
   void build_index_constant_sample_size_mode();
+  uint64_t get_chunk_frame_size(qt_chunk_t const &chunk) const;
   void dump_index_entries(std::string const &message) const;
   void mark_key_frames_from_key_frame_table();
   void mark_open_gop_random_access_points_as_key_frames();
 
-  void calculate_timecodes_constant_sample_size();
-  void calculate_timecodes_variable_sample_size();
-
   bool parse_esds_atom(mm_mem_io_c &memio, int level);
   uint32_t read_esds_descr_len(mm_mem_io_c &memio);
 };
@@ -451,7 +431,12 @@ private:
 
   bool m_timecodes_calculated;
 
-  debugging_option_c m_debug_chapters, m_debug_headers, m_debug_tables, m_debug_tables_full, m_debug_interleaving, m_debug_resync;
+  std::deque<qt_read_block_t> m_read_blocks; // sorted by file position
+  uint64_t m_read_blocks_size, m_num_read_blocks;
+  // Blocks dropped from m_read_blocks while slices of them were still in use
+  std::vector<std::weak_ptr<memory_c>> m_pinned_read_blocks;
+
+  debugging_option_c m_debug_chapters, m_debug_headers, m_debug_tables, m_debug_tables_full, m_debug_interleaving, m_debug_resync, m_debug_read_planner;
 
   friend class qtmp4_demuxer_c;
 
@@ -549,6 +534,11 @@ protected:
 
   virtual void detect_interleaving();
 
+  virtual memory_cptr read_sample_data(uint64_t file_pos, uint64_t size);
+  virtual qt_read_block_t const *find_read_block(uint64_t file_pos, uint64_t size) const;
+  virtual uint64_t plan_read_end(uint64_t file_pos, uint64_t size) const;
+  virtual uint64_t get_pinned_read_blocks_size();
+
   virtual std::string read_string_atom(qt_atom_t atom, size_t num_skipped);
 };
 
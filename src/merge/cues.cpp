@@ -13,8 +13,11 @@
 
 #include "common/common_pch.h"
 
+#include <queue>
+
 #include "common/debugging.h"
 #include "common/ebml.h"
+#include "common/endian.h"
 #include "common/fs_sys_helpers.h"
 #include "common/hacks.h"
 #include "common/math.h"
@@ -24,6 +27,95 @@
 #include "merge/libmatroska_extensions.h"
 #include "merge/output_control.h"
 
+namespace {
+
+// Number of cue points kept in memory before they're written to the
+// temporary file if the "spill_cues_to_disk" hack is engaged.
+size_t const s_max_points_in_memory = 1024 * 1024;
+size_t const s_points_per_read      = 16 * 1024;
+
+size_t const s_write_buffer_size    = 64 * 1024;
+// All cue point elements are small enough for one-byte sizes.
+size_t const s_max_point_size       = 0x7f + 4 + 1;
+
+bool
+cue_point_less(cue_point_t const &a,
+               cue_point_t const &b) {
+  if (a.timecode < b.timecode)
+    return true;
+  if (a.timecode > b.timecode)
+    return false;
+
+  return a.track_num < b.track_num;
+}
+
+unsigned char *
+put_element_head(unsigned char *buffer,
+                 EbmlId const &id,
+                 size_t content_size) {
+  id.Fill(buffer);
+  buffer    += EBML_ID_LENGTH(id);
+  *buffer++  = 0x80 | content_size;
+
+  return buffer;
+}
+
+unsigned char *
+put_uint_element(unsigned char *buffer,
+                 EbmlId const &id,
+                 uint64_t value,
+                 size_t num_bytes) {
+  buffer = put_element_head(buffer, id, num_bytes);
+  put_uint_be(buffer, value, num_bytes);
+
+  return buffer + num_bytes;
+}
+
+class spilled_run_reader_c {
+protected:
+  mm_io_c &m_file;
+  uint64_t m_file_position, m_num_left;
+  std::vector<cue_point_t> m_buffer;
+  size_t m_idx;
+
+public:
+  spilled_run_reader_c(mm_io_c &file,
+                       uint64_t file_position,
+                       uint64_t num_points)
+    : m_file(file)
+    , m_file_position{file_position}
+    , m_num_left{num_points}
+    , m_idx{}
+  {
+  }
+
+  bool
+  next(cue_point_t &point) {
+    if (m_idx == m_buffer.size()) {
+      if (!m_num_left)
+        return false;
+
+      auto num_points = std::min<uint64_t>(m_num_left, s_points_per_read);
+      auto num_bytes  = num_points * sizeof(cue_point_t);
+
+      m_buffer.resize(num_points);
+      m_file.setFilePointer(m_file_position);
+      if (m_file.read(m_buffer.data(), num_bytes) != num_bytes)
+        throw mtx::mm_io::end_of_file_x{};
+
+      m_file_position += num_bytes;
+      m_num_left      -= num_points;
+      m_idx            = 0;
+    }
+
+    point = m_buffer[m_idx++];
+
+    return true;
+  }
+};
+
+}
+
 cues_cptr cues_c::s_cues;
 
 cues_c::cues_c()
@@ -32,9 +124,14 @@ cues_c::cues_c()
   , m_no_cue_relative_position{hack_engaged(ENGAGE_NO_CUE_RELATIVE_POSITION)}
   , m_debug_cue_duration{         "cues|cues_cue_duration"}
   , m_debug_cue_relative_position{"cues|cues_cue_relative_position"}
+  , m_spill_to_disk{hack_engaged(ENGAGE_SPILL_CUES_TO_DISK)}
 {
 }
 
+cues_c::~cues_c() {
+  remove_spill_file();
+}
+
 void
 cues_c::set_duration_for_id_timecode(uint64_t id,
                                      uint64_t timecode,
@@ -75,13 +172,9 @@ cues_c::add(KaxCuePoint &point) {
 void
 cues_c::write(mm_io_c &out,
               KaxSeekHead &seek_head) {
-  if (!m_points.size() || !g_cue_writing_requested)
+  if ((m_points.empty() && m_spilled_runs.empty()) || !g_cue_writing_requested)
     return;
 
-  // auto start = mtx::sys::get_current_time_millis();
-  sort();
-  // auto end_sort = mtx::sys::get_current_time_millis();
-
   // Need to write the (empty) cues element so that its position will
   // be set for indexing in g_kax_sh_main. Necessary because there's
   // no API function to force the position to a certain value; nor is
@@ -95,54 +188,217 @@ cues_c::write(mm_io_c &out,
   // Write meta seek information if it is not disabled.
   seek_head.IndexThis(cues_dummy, *g_kax_segment);
 
-  // Forcefully write the correct head and copy its content from the
-  // temporary storage location.
-  auto total_size = calculate_total_size();
-  write_ebml_element_head(out, EBML_ID(KaxCues), total_size);
+  if (!m_spilled_runs.empty())
+    write_spilled_points(out);
+
+  else {
+    sort();
+
+    // Forcefully write the correct head and render the points
+    // directly after it.
+    write_ebml_element_head(out, EBML_ID(KaxCues), calculate_total_size());
+
+    auto point_itr = m_points.begin(), points_end = m_points.end();
+    write_points(out, [&point_itr, &points_end](cue_point_t &point) -> bool {
+      if (point_itr == points_end)
+        return false;
+      point = *point_itr++;
+      return true;
+    });
+  }
+
+  reset();
+}
+
+void
+cues_c::write_spilled_points(mm_io_c &out) {
+  try {
+    if (!m_points.empty())
+      spill_points();
+
+    // The total size must be known before the first point can be
+    // written. Summing up the sizes doesn't require merging the runs.
+    auto total_size = uint64_t{};
+
+    for (auto const &run : m_spilled_runs) {
+      spilled_run_reader_c reader{*m_spill_file, run.file_position, run.num_points};
+      cue_point_t point;
+
+      while (reader.next(point)) {
+        adjust_spilled_position(point, run.first_adjustment);
+        total_size += calculate_point_size(point);
+      }
+    }
+
+    write_ebml_element_head(out, EBML_ID(KaxCues), total_size);
+
+    // Each run is sorted. Merge them by always writing the smallest of
+    // the runs' current points.
+    using entry_t = std::pair<cue_point_t, size_t>;
+    auto greater  = [](entry_t const &a, entry_t const &b) { return cue_point_less(b.first, a.first); };
+
+    std::vector<spilled_run_reader_c> readers;
+    std::priority_queue<entry_t, std::vector<entry_t>, decltype(greater)> queue{greater};
+
+    for (auto const &run : m_spilled_runs)
+      readers.emplace_back(*m_spill_file, run.file_position, run.num_points);
+
+    auto fetch_next = [this, &readers, &queue](size_t idx) {
+      cue_point_t point;
+      if (!readers[idx].next(point))
+        return;
+
+      adjust_spilled_position(point, m_spilled_runs[idx].first_adjustment);
+      queue.emplace(point, idx);
+    };
+
+    for (auto idx = 0u; idx < readers.size(); ++idx)
+      fetch_next(idx);
+
+    write_points(out, [&queue, &fetch_next](cue_point_t &point) -> bool {
+      if (queue.empty())
+        return false;
+
+      auto idx = queue.top().second;
+      point    = queue.top().first;
+
+      queue.pop();
+      fetch_next(idx);
+
+      return true;
+    });
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxerror(boost::format(Y("Reading the cues from the temporary file '%1%' failed: %2%\n")) % m_spill_file_name % ex);
+  }
+}
+
+void
+cues_c::write_points(mm_io_c &out,
+                     std::function<bool(cue_point_t &)> const &next_point)
+  const {
+  auto buffer = memory_c::alloc(s_write_buffer_size);
+  auto data   = buffer->get_buffer();
+  auto fill   = size_t{};
+  cue_point_t point;
+
+  while (next_point(point)) {
+    if ((fill + s_max_point_size) > s_write_buffer_size) {
+      out.write(data, fill);
+      fill = 0;
+    }
 
-  for (auto &point : m_points) {
-    KaxCuePoint kc_point;
+    fill += render_point(point, &data[fill]);
+  }
 
-    GetChild<KaxCueTime>(kc_point).SetValue(point.timecode / g_timecode_scale);
+  if (fill)
+    out.write(data, fill);
+}
 
-    auto &positions = GetChild<KaxCueTrackPositions>(kc_point);
-    GetChild<KaxCueTrack>(positions).SetValue(point.track_num);
-    GetChild<KaxCueClusterPosition>(positions).SetValue(point.cluster_position);
+/* Renders the same elements in the same order as libmatroska would for
+   a KaxCuePoint with the same content; the result is exactly
+   calculate_point_size() bytes long.
+*/
+size_t
+cues_c::render_point(cue_point_t const &point,
+                     unsigned char *buffer)
+  const {
+  auto start         = buffer;
+  auto timecode      = point.timecode / g_timecode_scale;
 
-    auto codec_state_position = m_codec_state_position_map.find({ point.track_num, point.timecode });
-    if (codec_state_position != m_codec_state_position_map.end())
-      GetChild<KaxCueCodecState>(positions).SetValue(codec_state_position->second);
+  buffer             = put_element_head(buffer, EBML_ID(KaxCuePoint), 0);
+  auto point_content = buffer;
 
-    if (point.relative_position)
-      GetChild<KaxCueRelativePosition>(positions).SetValue(point.relative_position);
+  buffer             = put_uint_element(buffer, EBML_ID(KaxCueTime), timecode, calculate_bytes_for_uint(timecode));
+  buffer             = put_element_head(buffer, EBML_ID(KaxCueTrackPositions), 0);
+  auto pos_content   = buffer;
 
-    if (point.duration)
-      GetChild<KaxCueDuration>(positions).SetValue(RND_TIMECODE_SCALE(point.duration) / g_timecode_scale);
+  buffer             = put_uint_element(buffer, EBML_ID(KaxCueTrack),           point.track_num,        calculate_bytes_for_uint(point.track_num));
+  buffer             = put_uint_element(buffer, EBML_ID(KaxCueClusterPosition), point.cluster_position, calculate_bytes_for_uint(point.cluster_position));
 
-    kc_point.Render(out);
+  auto codec_state_position = m_codec_state_position_map.find({ point.track_num, point.timecode });
+  if (codec_state_position != m_codec_state_position_map.end())
+    buffer = put_uint_element(buffer, EBML_ID(KaxCueCodecState), codec_state_position->second, calculate_bytes_for_uint(codec_state_position->second));
+
+  if (point.relative_position)
+    buffer = put_uint_element(buffer, EBML_ID(KaxCueRelativePosition), point.relative_position, calculate_bytes_for_uint(point.relative_position));
+
+  if (point.duration) {
+    auto duration = RND_TIMECODE_SCALE(point.duration) / g_timecode_scale;
+    buffer        = put_uint_element(buffer, EBML_ID(KaxCueDuration), duration, calculate_bytes_for_uint(duration));
   }
 
+  pos_content[-1]   = 0x80 | (buffer - pos_content);
+  point_content[-1] = 0x80 | (buffer - point_content);
+
+  return buffer - start;
+}
+
+void
+cues_c::spill_points() {
+  static debugging_option_c s_debug{"cues|cues_spill"};
+
+  try {
+    if (!m_spill_file) {
+      m_spill_file_name = (bfs::temp_directory_path() / bfs::unique_path("mkvmerge-cues-%%%%-%%%%-%%%%-%%%%.tmp")).string();
+      m_spill_file      = std::make_shared<mm_file_io_c>(m_spill_file_name, MODE_CREATE);
+    }
+
+    sort();
+
+    m_spill_file->setFilePointer(0, seek_end);
+    m_spilled_runs.push_back({ m_spill_file->getFilePointer(), m_points.size(), m_position_adjustments.size() });
+    m_spill_file->write(m_points.data(), m_points.size() * sizeof(cue_point_t));
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxerror(boost::format(Y("Writing the cues to the temporary file '%1%' failed: %2%\n")) % m_spill_file_name % ex);
+
+  } catch (bfs::filesystem_error &ex) {
+    mxerror(boost::format(Y("Creating a temporary file for the cues failed: %1%\n")) % ex.what());
+  }
+
+  mxdebug_if(s_debug, boost::format("cues_spill: wrote run %1% with %2% points to %3%\n") % m_spilled_runs.size() % m_points.size() % m_spill_file_name);
+
   m_points.clear();
-  m_codec_state_position_map.clear();
   m_num_cue_points_postprocessed = 0;
+}
 
-  // auto end_all = mtx::sys::get_current_time_millis();
-  // mxinfo(boost::format("dur sort %1% write %2% total %3%\n") % (end_sort - start) % (end_all - end_sort) % (end_all - start));
+void
+cues_c::adjust_spilled_position(cue_point_t &point,
+                                size_t first_adjustment)
+  const {
+  // Only adjustments made after the run was written apply to it.
+  for (auto idx = first_adjustment, end = m_position_adjustments.size(); idx < end; ++idx)
+    if (point.cluster_position >= m_position_adjustments[idx].first)
+      point.cluster_position += m_position_adjustments[idx].second;
 }
 
 void
-cues_c::sort() {
-  brng::sort(m_points, [](cue_point_t const &a, cue_point_t const &b) -> bool {
-      if (a.timecode < b.timecode)
-        return true;
-      if (a.timecode > b.timecode)
-        return false;
+cues_c::remove_spill_file() {
+  m_spill_file.reset();
 
-      if (a.track_num < b.track_num)
-        return true;
+  if (m_spill_file_name.empty())
+    return;
 
-      return false;
-    });
+  boost::system::error_code ec;
+  bfs::remove(m_spill_file_name, ec);
+  m_spill_file_name.clear();
+}
+
+void
+cues_c::reset() {
+  m_points.clear();
+  m_codec_state_position_map.clear();
+  m_num_cue_points_postprocessed = 0;
+  m_spilled_runs.clear();
+  m_position_adjustments.clear();
+
+  remove_spill_file();
+}
+
+void
+cues_c::sort() {
+  brng::sort(m_points, cue_point_less);
 }
 
 std::multimap<id_timecode_t, uint64_t>
@@ -179,9 +435,21 @@ cues_c::postprocess_cues(KaxCues &cues,
                          KaxCluster &cluster) {
   add(cues);
 
-  if (m_no_cue_duration && m_no_cue_relative_position)
-    return;
+  if (!m_no_cue_duration || !m_no_cue_relative_position)
+    postprocess_new_points(cluster);
+
+  m_num_cue_points_postprocessed = m_points.size();
+
+  m_id_timecode_duration_multimap.clear();
+
+  // Points can only be written to the temporary file once their
+  // durations and relative positions are known.
+  if (m_spill_to_disk && (m_points.size() >= s_max_points_in_memory))
+    spill_points();
+}
 
+void
+cues_c::postprocess_new_points(KaxCluster &cluster) {
   auto cluster_data_start_pos = cluster.GetElementPosition() + cluster.HeadSize();
   auto block_positions        = calculate_block_positions(cluster);
   std::map<id_timecode_t, size_t> nblocks_processed; //# blocks processed so far with given track #/timecode
@@ -234,10 +502,6 @@ cues_c::postprocess_cues(KaxCues &cues,
                boost::format("cue_duration: looking for <%1%:%2%>: %3%\n")
                % point->track_num % point->timecode % (duration_itr == m_id_timecode_duration_multimap.end() ? static_cast<int64_t>(-1) : duration_itr->second));
   }
-
-  m_num_cue_points_postprocessed = m_points.size();
-
-  m_id_timecode_duration_multimap.clear();
 }
 
 uint64_t
@@ -282,7 +546,7 @@ cues_c::adjust_positions(uint64_t old_position,
                          uint64_t delta) {
   auto s_debug_rerender_track_headers = debugging_option_c{"rerender|rerender_track_headers"};
 
-  if (!delta || (m_points.empty() && m_codec_state_position_map.empty()))
+  if (!delta || (m_points.empty() && m_codec_state_position_map.empty() && m_spilled_runs.empty()))
     return;
 
   mxdebug_if(s_debug_rerender_track_headers,
@@ -296,6 +560,11 @@ cues_c::adjust_positions(uint64_t old_position,
   for (auto &element : m_codec_state_position_map)
     if (element.second >= old_position)
       element.second += delta;
+
+  // Points already written to the temporary file are adjusted when
+  // they're read back.
+  if (!m_spilled_runs.empty())
+    m_position_adjustments.emplace_back(old_position, delta);
 }
 
 cues_c &
@@ -34,6 +34,11 @@ using cues_cptr = std::shared_ptr<cues_c>;
 
 class cues_c {
 protected:
+  struct spilled_run_t {
+    uint64_t file_position, num_points;
+    size_t first_adjustment;
+  };
+
   std::vector<cue_point_t> m_points;
   std::multimap<id_timecode_t, uint64_t> m_id_timecode_duration_multimap;
   std::map<id_timecode_t, uint64_t> m_codec_state_position_map;
@@ -42,11 +47,19 @@ protected:
   bool m_no_cue_duration, m_no_cue_relative_position;
   debugging_option_c m_debug_cue_duration, m_debug_cue_relative_position;
 
+  // Only used if the "spill_cues_to_disk" hack is engaged.
+  bool m_spill_to_disk;
+  std::string m_spill_file_name;
+  mm_io_cptr m_spill_file;
+  std::vector<spilled_run_t> m_spilled_runs;
+  std::vector<std::pair<uint64_t, uint64_t>> m_position_adjustments;
+
 protected:
   static cues_cptr s_cues;
 
 public:
   cues_c();
+  ~cues_c();
 
   void add(KaxCues &cues);
   void add(KaxCuePoint &point);
@@ -60,6 +73,16 @@ public:
 
 protected:
   void sort();
+  void postprocess_new_points(KaxCluster &cluster);
+  void reset();
+
+  void spill_points();
+  void remove_spill_file();
+  void write_spilled_points(mm_io_c &out);
+  void adjust_spilled_position(cue_point_t &point, size_t first_adjustment) const;
+
+  void write_points(mm_io_c &out, std::function<bool(cue_point_t &)> const &next_point) const;
+  size_t render_point(cue_point_t const &point, unsigned char *buffer) const;
   std::multimap<id_timecode_t, uint64_t> calculate_block_positions(KaxCluster &cluster) const;
   uint64_t calculate_total_size() const;
   uint64_t calculate_point_size(cue_point_t const &point) const;
@@ -362,6 +362,8 @@ generic_packetizer_c::set_tag_track_uid() {
 
 bool
 generic_packetizer_c::set_uid(uint64_t uid) {
+  auto lock = lock_output();
+
   if (!is_unique_number(uid, UNIQUE_TRACK_IDS))
     return false;
 
@@ -412,6 +414,8 @@ generic_packetizer_c::set_track_type(int type,
 
 void
 generic_packetizer_c::set_track_name(const std::string &name) {
+  auto lock = lock_output();
+
   m_ti.m_track_name = name;
   if (m_track_entry && !name.empty())
     GetChild<KaxTrackName>(m_track_entry).SetValueUTF8(m_ti.m_track_name);
@@ -419,6 +423,8 @@ generic_packetizer_c::set_track_name(const std::string &name) {
 
 void
 generic_packetizer_c::set_codec_id(const std::string &id) {
+  auto lock = lock_output();
+
   m_hcodec_id = id;
   if (m_track_entry && !id.empty())
     GetChild<KaxCodecID>(m_track_entry).SetValue(m_hcodec_id);
@@ -426,6 +432,8 @@ generic_packetizer_c::set_codec_id(const std::string &id) {
 
 void
 generic_packetizer_c::set_codec_private(memory_cptr const &buffer) {
+  auto lock = lock_output();
+
   if (buffer && buffer->get_size()) {
     m_hcodec_private = buffer->clone();
 
@@ -438,6 +446,8 @@ generic_packetizer_c::set_codec_private(memory_cptr const &buffer) {
 
 void
 generic_packetizer_c::set_track_min_cache(int min_cache) {
+  auto lock = lock_output();
+
   m_htrack_min_cache = min_cache;
   if (m_track_entry)
     GetChild<KaxTrackMinCache>(m_track_entry).SetValue(min_cache);
@@ -445,6 +455,8 @@ generic_packetizer_c::set_track_min_cache(int min_cache) {
 
 void
 generic_packetizer_c::set_track_max_cache(int max_cache) {
+  auto lock = lock_output();
+
   m_htrack_max_cache = max_cache;
   if (m_track_entry)
     GetChild<KaxTrackMaxCache>(m_track_entry).SetValue(max_cache);
@@ -453,6 +465,8 @@ generic_packetizer_c::set_track_max_cache(int max_cache) {
 void
 generic_packetizer_c::set_track_default_duration(int64_t def_dur,
                                                  bool force) {
+  auto lock = lock_output();
+
   if (!force && m_default_duration_forced)
     return;
 
@@ -468,6 +482,8 @@ generic_packetizer_c::set_track_default_duration(int64_t def_dur,
 
 void
 generic_packetizer_c::set_track_max_additionals(int max_add_block_ids) {
+  auto lock = lock_output();
+
   m_htrack_max_add_block_ids = max_add_block_ids;
   if (m_track_entry)
     GetChild<KaxMaxBlockAdditionID>(m_track_entry).SetValue(max_add_block_ids);
@@ -481,6 +497,8 @@ generic_packetizer_c::get_track_default_duration()
 
 void
 generic_packetizer_c::set_track_forced_flag(bool forced_track) {
+  auto lock = lock_output();
+
   m_ti.m_forced_track = forced_track;
   if (m_track_entry)
     GetChild<KaxTrackFlagForced>(m_track_entry).SetValue(forced_track ? 1 : 0);
@@ -488,6 +506,8 @@ generic_packetizer_c::set_track_forced_flag(bool forced_track) {
 
 void
 generic_packetizer_c::set_track_enabled_flag(bool enabled_track) {
+  auto lock = lock_output();
+
   m_ti.m_enabled_track = enabled_track;
   if (m_track_entry)
     GetChild<KaxTrackFlagEnabled>(m_track_entry).SetValue(enabled_track ? 1 : 0);
@@ -495,6 +515,8 @@ generic_packetizer_c::set_track_enabled_flag(bool enabled_track) {
 
 void
 generic_packetizer_c::set_track_seek_pre_roll(timestamp_c const &seek_pre_roll) {
+  auto lock = lock_output();
+
   m_seek_pre_roll = seek_pre_roll;
   if (m_track_entry)
     GetChild<KaxSeekPreRoll>(m_track_entry).SetValue(seek_pre_roll.to_ns());
@@ -504,6 +526,8 @@ generic_packetizer_c::set_track_seek_pre_roll(timestamp_c const &seek_pre_roll)
 
 void
 generic_packetizer_c::set_codec_delay(timestamp_c const &codec_delay) {
+  auto lock = lock_output();
+
   m_codec_delay = codec_delay;
   if (m_track_entry)
     GetChild<KaxCodecDelay>(m_track_entry).SetValue(codec_delay.to_ns());
@@ -513,6 +537,8 @@ generic_packetizer_c::set_codec_delay(timestamp_c const &codec_delay) {
 
 void
 generic_packetizer_c::set_audio_sampling_freq(float freq) {
+  auto lock = lock_output();
+
   m_haudio_sampling_freq = freq;
   if (m_track_entry)
     GetChild<KaxAudioSamplingFreq>(GetChild<KaxTrackAudio>(m_track_entry)).SetValue(m_haudio_sampling_freq);
@@ -520,6 +546,8 @@ generic_packetizer_c::set_audio_sampling_freq(float freq) {
 
 void
 generic_packetizer_c::set_audio_output_sampling_freq(float freq) {
+  auto lock = lock_output();
+
   m_haudio_output_sampling_freq = freq;
   if (m_track_entry)
     GetChild<KaxAudioOutputSamplingFreq>(GetChild<KaxTrackAudio>(m_track_entry)).SetValue(m_haudio_output_sampling_freq);
@@ -527,6 +555,8 @@ generic_packetizer_c::set_audio_output_sampling_freq(float freq) {
 
 void
 generic_packetizer_c::set_audio_channels(int channels) {
+  auto lock = lock_output();
+
   m_haudio_channels = channels;
   if (m_track_entry)
     GetChild<KaxAudioChannels>(GetChild<KaxTrackAudio>(*m_track_entry)).SetValue(m_haudio_channels);
@@ -534,6 +564,8 @@ generic_packetizer_c::set_audio_channels(int channels) {
 
 void
 generic_packetizer_c::set_audio_bit_depth(int bit_depth) {
+  auto lock = lock_output();
+
   m_haudio_bit_depth = bit_depth;
   if (m_track_entry)
     GetChild<KaxAudioBitDepth>(GetChild<KaxTrackAudio>(*m_track_entry)).SetValue(m_haudio_bit_depth);
@@ -541,6 +573,8 @@ generic_packetizer_c::set_audio_bit_depth(int bit_depth) {
 
 void
 generic_packetizer_c::set_video_interlaced_flag(bool interlaced) {
+  auto lock = lock_output();
+
   m_hvideo_interlaced_flag = interlaced ? 1 : 0;
   if (m_track_entry)
     GetChild<KaxVideoFlagInterlaced>(GetChild<KaxTrackVideo>(*m_track_entry)).SetValue(m_hvideo_interlaced_flag);
@@ -548,6 +582,8 @@ generic_packetizer_c::set_video_interlaced_flag(bool interlaced) {
 
 void
 generic_packetizer_c::set_video_pixel_width(int width) {
+  auto lock = lock_output();
+
   m_hvideo_pixel_width = width;
   if (m_track_entry)
     GetChild<KaxVideoPixelWidth>(GetChild<KaxTrackVideo>(*m_track_entry)).SetValue(m_hvideo_pixel_width);
@@ -555,6 +591,8 @@ generic_packetizer_c::set_video_pixel_width(int width) {
 
 void
 generic_packetizer_c::set_video_pixel_height(int height) {
+  auto lock = lock_output();
+
   m_hvideo_pixel_height = height;
   if (m_track_entry)
     GetChild<KaxVideoPixelHeight>(GetChild<KaxTrackVideo>(*m_track_entry)).SetValue(m_hvideo_pixel_height);
@@ -569,6 +607,8 @@ generic_packetizer_c::set_video_pixel_dimensions(int width,
 
 void
 generic_packetizer_c::set_video_display_width(int width) {
+  auto lock = lock_output();
+
   m_hvideo_display_width = width;
   if (m_track_entry)
     GetChild<KaxVideoDisplayWidth>(GetChild<KaxTrackVideo>(*m_track_entry)).SetValue(m_hvideo_display_width);
@@ -576,6 +616,8 @@ generic_packetizer_c::set_video_display_width(int width) {
 
 void
 generic_packetizer_c::set_video_display_height(int height) {
+  auto lock = lock_output();
+
   m_hvideo_display_height = height;
   if (m_track_entry)
     GetChild<KaxVideoDisplayHeight>(GetChild<KaxTrackVideo>(*m_track_entry)).SetValue(m_hvideo_display_height);
@@ -631,6 +673,8 @@ generic_packetizer_c::set_as_default_track(int type,
 
 void
 generic_packetizer_c::set_language(const std::string &language) {
+  auto lock = lock_output();
+
   m_ti.m_language = language;
   if (m_track_entry)
     GetChild<KaxTrackLanguage>(m_track_entry).SetValue(m_ti.m_language);
@@ -642,6 +686,8 @@ generic_packetizer_c::set_video_pixel_cropping(int left,
                                                int right,
                                                int bottom,
                                                option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_pixel_cropping.set(pixel_crop_t{left, top, right, bottom}, source);
 
   if (m_track_entry) {
@@ -658,6 +704,8 @@ generic_packetizer_c::set_video_pixel_cropping(int left,
 void
 generic_packetizer_c::set_video_colour_matrix(int matrix_index,
                                               option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_colour_matrix.set(matrix_index, source);
   if (   m_track_entry
       && (matrix_index >= 0)
@@ -671,6 +719,8 @@ generic_packetizer_c::set_video_colour_matrix(int matrix_index,
 void
 generic_packetizer_c::set_video_bits_per_channel(int num_bits,
                                                  option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_bits_per_channel.set(num_bits, source);
   if (m_track_entry && (num_bits >= 0)) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -682,6 +732,8 @@ generic_packetizer_c::set_video_bits_per_channel(int num_bits,
 void
 generic_packetizer_c::set_video_chroma_subsample(const chroma_subsample_t &subsample,
                                                  option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_chroma_subsample.set(chroma_subsample_t(subsample.hori, subsample.vert), source);
   if (   m_track_entry
       && (   (subsample.hori >= 0)
@@ -698,6 +750,8 @@ generic_packetizer_c::set_video_chroma_subsample(const chroma_subsample_t &subsa
 void
 generic_packetizer_c::set_video_cb_subsample(const cb_subsample_t &subsample,
                                              option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_cb_subsample.set(cb_subsample_t(subsample.hori, subsample.vert), source);
   if (   m_track_entry
       && (   (subsample.hori >= 0)
@@ -714,6 +768,8 @@ generic_packetizer_c::set_video_cb_subsample(const cb_subsample_t &subsample,
 void
 generic_packetizer_c::set_video_chroma_siting(const chroma_siting_t &siting,
                                               option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_chroma_siting.set(chroma_siting_t(siting.hori, siting.vert), source);
   if (   m_track_entry
       && (   ((siting.hori >= 0) && (siting.hori <= 2))
@@ -730,6 +786,8 @@ generic_packetizer_c::set_video_chroma_siting(const chroma_siting_t &siting,
 void
 generic_packetizer_c::set_video_colour_range(int range,
                                              option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_colour_range.set(range, source);
   if (m_track_entry && (range >= 0) && (range <= 3)) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -741,6 +799,8 @@ generic_packetizer_c::set_video_colour_range(int range,
 void
 generic_packetizer_c::set_video_colour_transfer_character(int transfer_index,
                                                           option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_colour_transfer.set(transfer_index, source);
   if (m_track_entry && (transfer_index >= 0) && (transfer_index <= 18)) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -752,6 +812,8 @@ generic_packetizer_c::set_video_colour_transfer_character(int transfer_index,
 void
 generic_packetizer_c::set_video_colour_primaries(int primary_index,
                                                  option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_colour_primaries.set(primary_index, source);
   if (     m_track_entry
       && (primary_index >= 0)
@@ -765,6 +827,8 @@ generic_packetizer_c::set_video_colour_primaries(int primary_index,
 void
 generic_packetizer_c::set_video_max_cll(int max_cll,
                                         option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_max_cll.set(max_cll, source);
   if (m_track_entry && (max_cll >= 0)) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -776,6 +840,8 @@ generic_packetizer_c::set_video_max_cll(int max_cll,
 void
 generic_packetizer_c::set_video_max_fall(int max_fall,
                                          option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_max_fall.set(max_fall, source);
   if (m_track_entry && (max_fall >= 0)) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -787,6 +853,8 @@ generic_packetizer_c::set_video_max_fall(int max_fall,
 void
 generic_packetizer_c::set_video_chroma_coordinates(chroma_coordinates_t const &coordinates,
                                                    option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_chroma_coordinates.set(coordinates, source);
   if (   m_track_entry
       && (   ((coordinates.red_x   >= 0) && (coordinates.red_x   <= 1))
@@ -815,6 +883,8 @@ generic_packetizer_c::set_video_chroma_coordinates(chroma_coordinates_t const &c
 void
 generic_packetizer_c::set_video_white_colour_coordinates(white_colour_coordinates_t const &coordinates,
                                                          option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_white_coordinates.set(white_colour_coordinates_t(coordinates.x, coordinates.y), source);
   if (   m_track_entry
       && (   ((coordinates.x >= 0) && (coordinates.x <= 1))
@@ -831,6 +901,8 @@ generic_packetizer_c::set_video_white_colour_coordinates(white_colour_coordinate
 void
 generic_packetizer_c::set_video_max_luminance(float luminance,
                                               option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_max_luminance.set(luminance, source);
   if (   m_track_entry
       && (luminance >= 0)
@@ -844,6 +916,8 @@ generic_packetizer_c::set_video_max_luminance(float luminance,
 void
 generic_packetizer_c::set_video_min_luminance(float luminance,
                                               option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_min_luminance.set(luminance, source);
   if (m_track_entry && (luminance >= 0) && (luminance <= 999.9999)) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -861,6 +935,8 @@ generic_packetizer_c::set_video_pixel_cropping(const pixel_crop_t &cropping,
 void
 generic_packetizer_c::set_video_field_order(uint64_t order,
                                             option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_field_order.set(order, source);
   if (m_track_entry && m_ti.m_field_order) {
     auto &video = GetChild<KaxTrackVideo>(m_track_entry);
@@ -871,6 +947,8 @@ generic_packetizer_c::set_video_field_order(uint64_t order,
 void
 generic_packetizer_c::set_video_stereo_mode(stereo_mode_c::mode stereo_mode,
                                             option_source_e source) {
+  auto lock = lock_output();
+
   m_ti.m_stereo_mode.set(stereo_mode, source);
 
   if (m_track_entry && (stereo_mode_c::unspecified != m_ti.m_stereo_mode.get()))
@@ -889,6 +967,10 @@ generic_packetizer_c::set_video_stereo_mode_impl(EbmlMaster &video,
 
 void
 generic_packetizer_c::set_headers() {
+  // Several packetizers call this again once they've parsed their
+  // first frames, possibly in a reader thread.
+  auto lock = lock_output();
+
   if (0 < m_connected_to) {
     mxerror(boost::format("generic_packetizer_c::set_headers(): connected_to > 0 (type: %1%). %2%\n") % typeid(*this).name() % BUGMSG);
     return;
@@ -1176,6 +1258,19 @@ generic_packetizer_c::fix_headers() {
   m_track_entry->SetGlobalTimecodeScale((int64_t)g_timecode_scale);
 }
 
+/** \brief Upper bound for how much the track headers may grow
+
+   Packetizers that fill in parts of their track headers only after
+   having seen the first frames (e.g. the codec private data) return
+   the number of bytes they may need in addition to the space already
+   used by their headers.
+*/
+uint64_t
+generic_packetizer_c::get_max_header_growth()
+  const {
+  return 0;
+}
+
 void
 generic_packetizer_c::compress_packet(packet_t &packet) {
   if (!m_compressor) {
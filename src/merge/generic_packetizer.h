@@ -16,6 +16,7 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
 #include <deque>
 
 #include "common/option_with_source.h"
@@ -50,7 +51,8 @@ protected:
   std::deque<packet_cptr> m_packet_queue, m_deferred_packets;
   int m_next_packet_wo_assigned_timecode;
 
-  int64_t m_free_refs, m_next_free_refs, m_enqueued_bytes;
+  int64_t m_free_refs, m_next_free_refs;
+  std::atomic<int64_t> m_enqueued_bytes;
   int64_t m_safety_last_timecode, m_safety_last_duration;
 
   KaxTrackEntry *m_track_entry;
@@ -125,6 +127,11 @@ public:
   inline int64_t get_queued_bytes() const {
     return m_enqueued_bytes;
   }
+  // Packets taken from the packetizer but not yet handed to the main
+  // loop, e.g. by the reader threads, still count as queued.
+  inline void account_queued_bytes(int64_t num_bytes) {
+    m_enqueued_bytes += num_bytes;
+  }
 
   inline void set_free_refs(int64_t free_refs) {
     m_free_refs      = m_next_free_refs;
@@ -133,8 +140,14 @@ public:
   inline int64_t get_free_refs() const {
     return m_free_refs;
   }
+  // With the "parallel_reading" hack engaged, process() runs in a
+  // reader thread. The set_*() functions, set_headers() and
+  // rerender_track_headers() lock the output themselves. Subclasses
+  // that modify m_track_entry or m_ti directly while processing must
+  // hold lock_output() while doing so.
   virtual void set_headers();
   virtual void fix_headers();
+  virtual uint64_t get_max_header_growth() const;
   inline int process(packet_t *packet) {
     return process(packet_cptr(packet));
   }
@@ -435,6 +435,11 @@ generic_reader_c::display_identification_results_as_text() {
 
 void
 generic_reader_c::display_identification_results_as_json() {
+  display_json_output(get_identification_results_as_json());
+}
+
+nlohmann::json
+generic_reader_c::get_identification_results_as_json() {
   auto verbose_info_to_object = [](mtx::id::verbose_info_t const &verbose_info) -> nlohmann::json {
     auto object = nlohmann::json{};
     for (auto const &property : verbose_info)
@@ -494,7 +499,7 @@ generic_reader_c::display_identification_results_as_json() {
       };
   }
 
-  display_json_output(json);
+  return json;
 }
 
 std::string
@@ -540,6 +545,11 @@ generic_reader_c::set_probe_range_percentage(int64_rational_c const &probe_range
   s_probe_range_percentage = probe_range_percentage;
 }
 
+int64_rational_c
+generic_reader_c::get_probe_range_percentage() {
+  return s_probe_range_percentage;
+}
+
 int64_t
 generic_reader_c::calculate_probe_range(int64_t file_size,
                                         int64_t fixed_minimum)
@@ -124,11 +124,13 @@ public:
   virtual attach_mode_e attachment_requested(int64_t id);
 
   virtual void display_identification_results();
+  virtual nlohmann::json get_identification_results_as_json();
 
   virtual int64_t calculate_probe_range(int64_t file_size, int64_t fixed_minimum) const;
 
 public:
   static void set_probe_range_percentage(int64_rational_c const &probe_range_percentage);
+  static int64_rational_c get_probe_range_percentage();
 
 protected:
   virtual bool demuxing_requested(char type, int64_t id, boost::optional<std::string> const &language = boost::none) const;
@@ -0,0 +1,232 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   persistent cache for identification results
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/checksums/base.h"
+#include "common/fs_sys_helpers.h"
+#include "common/id_info.h"
+#include "common/mm_io_x.h"
+#include "common/random.h"
+#include "common/strings/formatting.h"
+#include "common/version.h"
+#include "merge/id_cache.h"
+#include "merge/id_result.h"
+
+namespace mtx { namespace id_cache {
+
+namespace {
+
+// Number of bytes at the start and at the end of the file that are
+// hashed in addition to checking its size and modification time.
+size_t const s_num_bytes_to_hash = 64 * 1024;
+
+bool s_enabled = false;
+debugging_option_c s_debug{"id_cache"};
+
+std::string
+md5_as_hex(std::string const &data) {
+  return to_hex(mtx::checksum::calculate(mtx::checksum::algorithm_e::md5, data.c_str(), data.size()), true);
+}
+
+bfs::path
+cache_file_name(std::string const &file_name,
+                std::string const &options) {
+  auto folder = mtx::sys::get_cache_folder();
+  if (folder.empty())
+    return {};
+
+  auto absolute_name = bfs::system_complete(bfs::path{file_name}).string();
+
+  return folder / "identification" / (md5_as_hex(absolute_name + '\0' + options) + ".json");
+}
+
+bfs::path
+current_executable() {
+#if defined(SYS_WINDOWS)
+  return mtx::sys::get_installation_path() / (get_program_name() + ".exe");
+#else
+  auto exe = bfs::path{"/proc/self/exe"};
+  boost::system::error_code ec;
+  if (bfs::exists(exe, ec))
+    return exe;
+
+  return mtx::sys::get_installation_path() / get_program_name();
+#endif
+}
+
+// Returns an empty string if the executable cannot be found. Nothing
+// is cached in that case.
+std::string const &
+build_identity() {
+  static boost::optional<std::string> s_identity;
+
+  if (!s_identity) {
+    boost::system::error_code ec_size, ec_mtime;
+    auto exe   = current_executable();
+    auto size  = bfs::file_size(exe, ec_size);
+    auto mtime = bfs::last_write_time(exe, ec_mtime);
+
+    s_identity = (ec_size || ec_mtime) ? std::string{} : (boost::format("%1% %2% %3%") % get_current_version().to_string() % size % static_cast<int64_t>(mtime)).str();
+
+    mxdebug_if(s_debug, boost::format("id_cache: build identity of %1%: '%2%'\n") % exe.string() % *s_identity);
+  }
+
+  return *s_identity;
+}
+
+std::string
+calculate_digest(std::string const &file_name) {
+  auto mtime  = bfs::last_write_time(bfs::path{file_name});
+  auto hasher = mtx::checksum::for_algorithm(mtx::checksum::algorithm_e::md5);
+
+  mm_file_io_c in{file_name};
+  auto size   = static_cast<uint64_t>(in.get_size());
+  auto buffer = memory_c::alloc(s_num_bytes_to_hash);
+
+  hasher->add(buffer->get_buffer(), in.read(buffer->get_buffer(), std::min<uint64_t>(size, s_num_bytes_to_hash)));
+
+  if (size > s_num_bytes_to_hash) {
+    in.setFilePointer(std::max<uint64_t>(size - s_num_bytes_to_hash, s_num_bytes_to_hash));
+    hasher->add(buffer->get_buffer(), in.read(buffer->get_buffer(), s_num_bytes_to_hash));
+  }
+
+  auto properties = (boost::format("%1% %2% %3% %4%") % size % static_cast<int64_t>(mtime) % build_identity() % ID_JSON_FORMAT_VERSION).str();
+  hasher->add(properties.c_str(), properties.size());
+  hasher->finish();
+
+  return to_hex(hasher->get_result(), true);
+}
+
+bool
+refers_to_other_files(nlohmann::json const &identification) {
+  // Playlists and files that are read together with their siblings
+  // (e.g. VTS_01_1.VOB, VTS_01_2.VOB…) depend on more than the one
+  // file the digest is calculated for.
+  auto container = identification.find("container");
+  if (container == identification.end())
+    return true;
+
+  auto properties = container->find("properties");
+  if (properties == container->end())
+    return false;
+
+  return (properties->find(mtx::id::other_file)    != properties->end())
+      || (properties->find(mtx::id::playlist)      != properties->end())
+      || (properties->find(mtx::id::playlist_file) != properties->end());
+}
+
+}
+
+void
+enable(bool enabled) {
+  s_enabled = enabled;
+}
+
+void
+disable() {
+  enable(false);
+}
+
+bool
+is_enabled() {
+  return s_enabled && !build_identity().empty();
+}
+
+boost::optional<entry_t>
+fetch(std::string const &file_name,
+      std::string const &options) {
+  if (!is_enabled())
+    return {};
+
+  try {
+    auto cache_file = cache_file_name(file_name, options);
+    if (cache_file.empty() || !bfs::exists(cache_file))
+      return {};
+
+    auto content = mm_file_io_c::slurp(cache_file.string());
+    auto json    = mtx::json::parse(std::string{reinterpret_cast<char const *>(content->get_buffer()), content->get_size()});
+
+    if (json["digest"].get<std::string>() != calculate_digest(file_name)) {
+      mxdebug_if(s_debug, boost::format("id_cache: entry for %1% is outdated\n") % file_name);
+      return {};
+    }
+
+    auto entry           = entry_t{};
+    entry.type           = static_cast<file_type_e>(json["type"].get<int>());
+    entry.identification = json["identification"];
+
+    for (auto const &warning : json["warnings"])
+      entry.warnings.push_back(warning.get<std::string>());
+
+    mxdebug_if(s_debug, boost::format("id_cache: using entry %1% for %2%\n") % cache_file.string() % file_name);
+
+    return entry;
+
+  } catch (std::exception const &ex) {
+    // Includes unreadable or corrupt cache files as well as the
+    // source file not existing. The normal code path takes care of
+    // reporting the latter.
+    mxdebug_if(s_debug, boost::format("id_cache: cannot fetch entry for %1%: %2%\n") % file_name % ex.what());
+  }
+
+  return {};
+}
+
+void
+store(std::string const &file_name,
+      std::string const &options,
+      entry_t const &entry) {
+  if (!is_enabled() || refers_to_other_files(entry.identification))
+    return;
+
+  auto cache_file = bfs::path{};
+  auto temp_file  = bfs::path{};
+
+  try {
+    cache_file = cache_file_name(file_name, options);
+    if (cache_file.empty())
+      return;
+
+    auto json = nlohmann::json{
+      { "digest",         calculate_digest(file_name)                           },
+      { "file_name",      bfs::system_complete(bfs::path{file_name}).string()   },
+      { "type",           static_cast<int>(entry.type)                          },
+      { "identification", entry.identification                                  },
+      { "warnings",       entry.warnings                                        },
+    };
+
+    // Write to a temporary file first so that a concurrently running
+    // mkvmerge never sees a partially written entry.
+    temp_file = cache_file;
+    temp_file.replace_extension((boost::format(".%|1$016x|.tmp") % random_c::generate_64bits()).str());
+
+    {
+      mm_file_io_c out{temp_file.string(), MODE_CREATE};
+      out.write(mtx::json::dump(json));
+    }
+
+    bfs::rename(temp_file, cache_file);
+
+    mxdebug_if(s_debug, boost::format("id_cache: stored entry %1% for %2%\n") % cache_file.string() % file_name);
+
+  } catch (std::exception const &ex) {
+    mxdebug_if(s_debug, boost::format("id_cache: cannot store entry for %1%: %2%\n") % file_name % ex.what());
+
+    boost::system::error_code ec;
+    if (!temp_file.empty())
+      bfs::remove(temp_file, ec);
+  }
+}
+
+}}
@@ -0,0 +1,54 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   persistent cache for identification results
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_ID_CACHE_H
+#define MTX_MERGE_ID_CACHE_H
+
+#include "common/common_pch.h"
+
+#include <boost/optional.hpp>
+
+#include "common/file_types.h"
+#include "common/json.h"
+
+/* Identifying a file means probing it for all supported types and
+   parsing its headers. The results are stored on disk so that
+   identifying the same unchanged file again is cheap.
+
+   Entries are looked up by the file's absolute name. They are only
+   used if the file's size, its modification time and a hash over its
+   first and last few kilobytes are still the same as when the entry
+   was created. The same goes for the size and the modification time
+   of the executable as development builds don't change the version
+   number each time a reader changes.
+
+   The cache is off unless enabled explicitly.
+*/
+namespace mtx { namespace id_cache {
+
+struct entry_t {
+  file_type_e type{FILE_TYPE_IS_UNKNOWN};
+  nlohmann::json identification;
+  std::vector<std::string> warnings;
+};
+
+void enable(bool enabled = true);
+void disable();
+bool is_enabled();
+
+boost::optional<entry_t> fetch(std::string const &file_name, std::string const &options);
+void store(std::string const &file_name, std::string const &options, entry_t const &entry);
+
+}}
+
+#endif // MTX_MERGE_ID_CACHE_H
@@ -46,6 +46,7 @@
 #include "common/extern_data.h"
 #include "common/file_types.h"
 #include "common/fs_sys_helpers.h"
+#include "common/hacks.h"
 #include "common/iso639.h"
 #include "common/kax_analyzer.h"
 #include "common/list_utils.h"
@@ -63,6 +64,7 @@
 #include "merge/cluster_helper.h"
 #include "merge/filelist.h"
 #include "merge/generic_reader.h"
+#include "merge/id_cache.h"
 #include "merge/output_control.h"
 #include "merge/reader_detection_and_creation.h"
 #include "merge/track_info.h"
@@ -329,6 +331,11 @@ set_usage() {
                   "                           Sets maximum size to probe for tracks in percent\n"
                   "                           of the total file size for certain file types\n"
                   "                           (default: 0.3).\n");
+  usage_text += Y("  --identification-cache   Use and update the cache of identification\n"
+                  "                           results ('-J' only).\n");
+  usage_text += Y("  --no-identification-cache\n"
+                  "                           Neither use nor update the cache of\n"
+                  "                           identification results (default).\n");
   usage_text += Y("  -l, --list-types         Lists supported source file types.\n");
   usage_text += Y("  --list-languages         Lists all ISO639 languages and their\n"
                   "                           ISO639-2 codes.\n");
@@ -445,6 +452,40 @@ display_unsupported_file_type(filelist_t const &file) {
   mxerror(boost::format(Y("The type of file '%1%' is not supported.\n")) % file.name);
 }
 
+static std::string
+identification_cache_options(filelist_t const &file) {
+  auto probe_range = generic_reader_c::get_probe_range_percentage();
+  auto hacks       = std::vector<std::string>{};
+
+  // Several hacks change what the readers report.
+  for (auto id = 0u; id <= ENGAGE_MAX_IDX; ++id)
+    if (hack_engaged(id))
+      hacks.push_back(::to_string(id));
+
+  return (boost::format("multi_file:%1% probe_range:%2%/%3% locale:%4% hacks:%5%")
+          % !file.ti->m_disable_multi_file
+          % probe_range.numerator() % probe_range.denominator()
+          % translation_c::get_active_translation().get_locale()
+          % boost::join(hacks, ",")).str();
+}
+
+static bool
+display_cached_identification(filelist_t const &file) {
+  auto entry = mtx::id_cache::fetch(file.name, identification_cache_options(file));
+  if (!entry)
+    return false;
+
+  // Warnings are part of the JSON output. Issue them again so that
+  // the output is identical to the uncached one.
+  for (auto const &warning : entry->warnings)
+    mxwarn(warning);
+
+  entry->identification["file_name"] = file.name;
+  display_json_output(entry->identification);
+
+  return true;
+}
+
 /** \brief Identify a file type and its contents
 
    This function called for \c --identify. It sets up dummy track info
@@ -469,6 +510,13 @@ identify(std::string &filename) {
   file.name           = filename;
   file.all_names.push_back(filename);
 
+  auto use_cache = mtx::id_cache::is_enabled() && (identification_output_format_e::json == g_identification_output_format);
+
+  if (use_cache && display_cached_identification(file)) {
+    g_files.clear();
+    return;
+  }
+
   get_file_type(file);
 
   if (FILE_TYPE_IS_UNKNOWN == file.type)
@@ -477,6 +525,10 @@ identify(std::string &filename) {
   create_readers();
 
   file.reader->identify();
+
+  if (use_cache)
+    mtx::id_cache::store(file.name, identification_cache_options(file), { file.type, file.reader->get_identification_results_as_json(), get_json_warnings() });
+
   file.reader->display_identification_results();
 
   g_files.clear();
@@ -2087,6 +2139,14 @@ handle_identification_args(std::vector<std::string> &args) {
       parse_arg_probe_range(next_arg);
       args.erase(this_arg_itr, next_arg_itr + 1);
 
+    } else if (*this_arg_itr == "--identification-cache") {
+      mtx::id_cache::enable();
+      this_arg_itr = args.erase(this_arg_itr);
+
+    } else if (*this_arg_itr == "--no-identification-cache") {
+      mtx::id_cache::disable();
+      this_arg_itr = args.erase(this_arg_itr);
+
     } else
       ++this_arg_itr;
   }
@@ -0,0 +1,65 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   running per-packet jobs in worker threads while keeping packet order
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/thread_pool.h"
+#include "merge/ordered_packet_jobs.h"
+
+ordered_packet_jobs_c::ordered_packet_jobs_c(bool parallel)
+  : m_max_pending{parallel ? 2 * mtx::thread_pool_c::global().get_num_threads() : 1}
+  , m_parallel{parallel}
+{
+}
+
+ordered_packet_jobs_c::~ordered_packet_jobs_c() {
+  // The jobs may still reference their packetizer.
+  for (auto &job : m_jobs)
+    job.done.wait();
+}
+
+void
+ordered_packet_jobs_c::add(packet_cptr const &packet,
+                           std::function<void(packet_t &)> const &job) {
+  if (!m_parallel) {
+    std::packaged_task<void()> task{[&job, &packet]() { job(*packet); }};
+    m_jobs.push_back({ packet, task.get_future() });
+    task();
+    return;
+  }
+
+  // Readers may re-use buffers they don't own once the packetizer
+  // returns. The job may run after that, though.
+  packet->data->grab();
+
+  m_jobs.push_back({ packet, mtx::thread_pool_c::global().submit([job, packet]() { job(*packet); }) });
+}
+
+void
+ordered_packet_jobs_c::collect(std::function<void(packet_cptr const &)> const &handler,
+                               bool wait_for_all) {
+  while (!m_jobs.empty()) {
+    auto &front = m_jobs.front();
+
+    if (   !wait_for_all
+        && (m_jobs.size() <= m_max_pending)
+        && (front.done.wait_for(std::chrono::seconds{0}) != std::future_status::ready))
+      break;
+
+    auto job = std::move(front);
+    m_jobs.pop_front();
+
+    job.done.get();
+    handler(job.packet);
+  }
+}
@@ -0,0 +1,61 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   running per-packet jobs in worker threads while keeping packet order
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_ORDERED_PACKET_JOBS_H
+#define MTX_MERGE_ORDERED_PACKET_JOBS_H
+
+#include "common/common_pch.h"
+
+#include <future>
+
+#include "merge/packet.h"
+
+/* Lets a packetizer transform the content of its packets on the
+   global thread pool. Packets are handed back in the order they've
+   been added in, regardless of the order the jobs finish in. If
+   running in parallel is not requested then each job is run right
+   away in the calling thread, so that packetizers can use the same
+   code for both cases.
+
+   Jobs must only access the packet they're given and data that
+   doesn't change while they're queued.
+*/
+class ordered_packet_jobs_c {
+private:
+  struct job_t {
+    packet_cptr packet;
+    std::future<void> done;
+  };
+
+  std::deque<job_t> m_jobs;
+  std::size_t m_max_pending;
+  bool m_parallel;
+
+public:
+  ordered_packet_jobs_c(bool parallel);
+  ~ordered_packet_jobs_c();
+
+  void add(packet_cptr const &packet, std::function<void(packet_t &)> const &job);
+
+  // Calls 'handler' for each packet whose job has finished, stopping
+  // at the first one that hasn't. Waits for the oldest jobs while too
+  // many are pending or for all of them if 'wait_for_all' is
+  // set. Exceptions thrown by a job are re-thrown here.
+  void collect(std::function<void(packet_cptr const &)> const &handler, bool wait_for_all);
+
+  bool empty() const {
+    return m_jobs.empty();
+  }
+};
+
+#endif  // MTX_MERGE_ORDERED_PACKET_JOBS_H
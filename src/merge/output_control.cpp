@@ -18,6 +18,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <cmath>
 #include <iostream>
+#include <mutex>
 #include <typeinfo>
 
 #include <ebml/EbmlHead.h>
@@ -53,6 +54,7 @@
 #include "common/date_time.h"
 #include "common/debugging.h"
 #include "common/ebml.h"
+#include "common/file_relocation.h"
 #include "common/fs_sys_helpers.h"
 #include "common/hacks.h"
 #include "common/mm_io_x.h"
@@ -68,6 +70,7 @@
 #include "merge/generic_packetizer.h"
 #include "merge/generic_reader.h"
 #include "merge/output_control.h"
+#include "merge/reader_threads.h"
 #include "merge/webm.h"
 
 using namespace libmatroska;
@@ -190,6 +193,12 @@ static boost::posix_time::ptime s_writing_date;
 static auto s_required_matroska_version      = 1u;
 static auto s_required_matroska_read_version = 1u;
 
+// Only used if the "parallel_reading" hack is engaged. The mutex
+// serializes writing to the output file between the main loop and
+// packetizers that re-render the track headers from a reader thread.
+static std::unique_ptr<reader_threads_c> s_reader_threads;
+static std::recursive_mutex s_output_mutex;
+
 /** \brief Add a segment family UID to the list if it doesn't exist already.
 
   \param family This segment family element is converted to a 128 bit
@@ -318,7 +327,8 @@ display_progress(bool is_100percent = false) {
     s_display_reader = determine_display_reader();
 
   bool display_progress  = false;
-  int current_percentage = (s_display_reader->get_progress() + s_display_files_done * 100) / s_display_path_length;
+  auto reader_progress   = s_reader_threads ? s_reader_threads->get_progress(*s_display_reader) : s_display_reader->get_progress();
+  int current_percentage = (reader_progress + s_display_files_done * 100) / s_display_path_length;
   int64_t current_time   = mtx::sys::get_current_time_millis();
 
   if (   (-1 == s_previous_percentage)
@@ -410,7 +420,12 @@ add_packetizer_globally(generic_packetizer_c *packetizer) {
   if (-1 == pack.file)
     mxerror(boost::format(Y("filelist_t not found for generic_packetizer_c. %1%\n")) % BUGMSG);
 
-  g_packetizers.push_back(pack);
+  // Readers running in a thread of their own must not modify the list
+  // the main loop is iterating over.
+  if (s_reader_threads)
+    s_reader_threads->add_packetizer(pack);
+  else
+    g_packetizers.push_back(pack);
 }
 
 static void
@@ -450,8 +465,14 @@ set_timecode_scale() {
   mxdebug_if(debug, boost::format("timecode_scale: %1% max ns per cluster: %2%\n") % g_timecode_scale % g_max_ns_per_cluster);
 }
 
+std::unique_lock<std::recursive_mutex>
+lock_output() {
+  return std::unique_lock<std::recursive_mutex>{s_output_mutex};
+}
+
 bool
 set_required_matroska_version(unsigned int required_version) {
+  auto lock                   = lock_output();
   auto previous               = s_required_matroska_version;
   s_required_matroska_version = std::max(s_required_matroska_version, required_version);
   auto version_changed        = s_required_matroska_version != previous;
@@ -464,6 +485,7 @@ set_required_matroska_version(unsigned int required_version) {
 
 bool
 set_required_matroska_read_version(unsigned int required_read_version) {
+  auto lock                        = lock_output();
   auto previous                    = s_required_matroska_read_version;
   s_required_matroska_read_version = std::max(s_required_matroska_read_version, required_read_version);
 
@@ -542,6 +564,29 @@ generate_segment_uids() {
   s_seguid_next.generate_random();
 }
 
+/** \brief Space to reserve for track headers that grow during muxing
+
+   Some packetizers only know parts of their track headers after
+   having seen the first frames. If the headers don't fit into the
+   void afterwards, all data written so far has to be moved. Only
+   done if the "predict_header_growth" hack is engaged as it changes
+   the layout of the output file.
+*/
+static uint64_t
+predict_header_growth() {
+  if (!hack_engaged(ENGAGE_PREDICT_HEADER_GROWTH))
+    return 0;
+
+  auto growth = uint64_t{};
+  for (auto &ptzr : g_packetizers)
+    if (ptzr.packetizer)
+      growth += ptzr.packetizer->get_max_header_growth();
+
+  mxdebug_if(s_debug_rerender_track_headers, boost::format("[rerender] predicted header growth: %1%\n") % growth);
+
+  return growth;
+}
+
 /** \brief Render the basic EBML and Matroska headers
 
    Renders the segment information and track headers. Also reserves
@@ -685,7 +730,7 @@ render_headers(mm_io_c *out) {
       // Reserve some small amount of space for header changes by the
       // packetizers.
       s_void_after_track_headers = std::make_unique<EbmlVoid>();
-      s_void_after_track_headers->SetSize(1024 + full_header_size - g_kax_tracks->ElementSize(false));
+      s_void_after_track_headers->SetSize(1024 + full_header_size - g_kax_tracks->ElementSize(false) + predict_header_growth());
       s_void_after_track_headers->Render(*out);
     }
 
@@ -734,11 +779,7 @@ relocate_written_data(uint64_t data_start_pos,
     return;
 
   auto rel_pos_from_end = s_out->get_size() - s_out->getFilePointer();
-  auto const block_size = 1024llu * 1024;
   auto to_relocate      = s_out->get_size() - data_start_pos;
-  auto relocated        = 0llu;
-  auto af_buffer        = memory_c::alloc(block_size);
-  auto buffer           = af_buffer->get_buffer();
 
   mxdebug_if(s_debug_rerender_track_headers,
              boost::format("[rerender] relocate_written_data: void pos %1% void size %2% = data_start_pos %3% s_out size %4% delta %5% to_relocate %6% rel_pos_from_end %7%\n")
@@ -752,30 +793,11 @@ relocate_written_data(uint64_t data_start_pos,
   s_out->write(dummy_data->c_str(), dummy_data->length());
   s_out->restore_pos();
 
-  // Copy the data from back to front in order not to overwrite
-  // existing data in case it overlaps which is likely.
-  while (relocated < to_relocate) {
-    auto to_copy = std::min(block_size, to_relocate - relocated);
-    auto src_pos = data_start_pos + to_relocate - relocated - to_copy;
-    auto dst_pos = src_pos + delta;
-
-    mxdebug_if(s_debug_rerender_track_headers, boost::format("[rerender]   relocating %1% bytes from %2% to %3%\n") % to_copy % src_pos % dst_pos);
-
-    s_out->setFilePointer(src_pos);
-    auto num_read = s_out->read(buffer, to_copy);
-
-    if (num_read != to_copy) {
-      mxinfo(boost::format(Y("Error reading from the file '%1%'.\n")) % s_out->get_file_name());
-      mxdebug_if(s_debug_rerender_track_headers, boost::format("[rerender]   relocation failed; read only %1% bytes\n") % num_read);
-    }
-
-    s_out->setFilePointer(dst_pos);
-    auto num_written = s_out->write(buffer, num_read);
-
-    if (num_written != num_read)
-      mxdebug_if(s_debug_rerender_track_headers, boost::format("[rerender]   relocation failed; wrote only %1% of %2% bytes\n") % num_written % num_read);
+  try {
+    mtx::file::move_towards_end(*s_out, data_start_pos, to_relocate, delta);
 
-    relocated += to_copy;
+  } catch (mtx::mm_io::exception &ex) {
+    mxerror(boost::format(Y("The data in the file '%1%' could not be moved in order to make room for the track headers: %2%\n")) % s_out->get_file_name() % ex.error());
   }
 
   if (s_kax_as) {
@@ -846,6 +868,8 @@ shrink_void_and_rerender_track_headers(int64_t new_void_size) {
 */
 void
 rerender_track_headers() {
+  std::lock_guard<std::recursive_mutex> lock{s_output_mutex};
+
   g_kax_tracks->UpdateSize(false);
 
   auto position_before    = s_out->getFilePointer();
@@ -860,9 +884,18 @@ rerender_track_headers() {
              % new_tracks_end_pos % data_start_pos % data_size % s_void_after_track_headers->GetElementPosition() % s_void_after_track_headers->ElementSize(true) % new_void_size);
 
   if (data_size  && (new_tracks_end_pos >= (data_start_pos - 3))) {
-    auto delta      = 1024 + new_tracks_end_pos - data_start_pos;
+    // Leave room for 1 KB of growth. If the file system can insert
+    // space into files then the distance is rounded up to its block
+    // size so that the data doesn't have to be copied. The void
+    // covers the padding. Test runs require reproducible output.
+    auto delta       = 1024 + new_tracks_end_pos - data_start_pos;
+    auto granularity = hack_engaged(ENGAGE_NO_VARIABLE_DATA) ? 0 : mtx::file::get_insert_range_granularity(*s_out);
+
+    if (granularity)
+      delta = (delta + granularity - 1) / granularity * granularity;
+
     data_start_pos += delta;
-    new_void_size   = 1024;
+    new_void_size   = data_start_pos - new_tracks_end_pos;
 
     relocate_written_data(data_start_pos - delta, delta);
   }
@@ -1339,7 +1372,9 @@ create_next_output_file() {
 
   // Open the output file.
   try {
-    s_out = !g_cluster_helper->discarding() ? mm_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024) : mm_io_cptr{ new mm_null_io_c{this_outfile} };
+    s_out = g_cluster_helper->discarding()           ? mm_io_cptr{ new mm_null_io_c{this_outfile} }
+          : hack_engaged(ENGAGE_NO_ASYNC_WRITING) ? mm_write_buffer_io_c::open(this_outfile, 20 * 1024 * 1024)
+          :                                         mm_async_write_buffer_io_c::open(this_outfile, 8 * 1024 * 1024, 4);
   } catch (mtx::mm_io::exception &ex) {
     mxerror(boost::format(Y("The file '%1%' could not be opened for writing: %2%.\n")) % this_outfile % ex);
   }
@@ -1627,6 +1662,9 @@ finish_file(bool last_file,
   if (g_kax_segment->ForceSize(final_file_size - g_kax_segment->GetElementPosition() - g_kax_segment->HeadSize()))
     g_kax_segment->OverwriteHead(*s_out);
 
+  // Closing explicitly makes errors from pending writes surface here
+  // instead of in the destructor.
+  s_out->close();
   s_out.reset();
 
   g_kax_segment.reset();
@@ -2027,20 +2065,81 @@ discard_queued_packets() {
   g_cluster_helper->discard_queued_packets();
 }
 
+static void
+pull_packetizers_for_packets_from_reader_threads() {
+  auto idx = 0u;
+
+  // Packetizers created by the readers in the meantime are adopted
+  // only after the existing ones have been pulled from. Otherwise one
+  // created right before its reader's last packetizer finished could
+  // be missed.
+  do {
+    for (; idx < g_packetizers.size(); ++idx) {
+      auto &ptzr = g_packetizers[idx];
+
+      if (ptzr.pack || (FILE_STATUS_DONE_AND_DRY == ptzr.status))
+        continue;
+
+      ptzr.old_status = ptzr.status;
+      ptzr.status     = s_reader_threads->get_packet(ptzr, ptzr.pack);
+
+      check_and_handle_end_of_input_after_pulling(ptzr);
+    }
+  } while (s_reader_threads->adopt_new_packetizers(g_packetizers));
+}
+
+static bool
+can_use_reader_threads() {
+  static auto s_debug = debugging_option_c{"reader_threads"};
+
+  if (!hack_engaged(ENGAGE_PARALLEL_READING))
+    return false;
+
+  // Appending and splitting both modify the packetizers from the
+  // main loop. Playlists switch readers in the middle of a file.
+  auto has_playlist = brng::find_if(g_files, [](filelist_cptr const &file) { return file->is_playlist; }) != g_files.end();
+  auto possible     = !s_appending_files && !g_cluster_helper->splitting() && !has_playlist;
+
+  mxdebug_if(s_debug, boost::format("reader_threads: possible? %1% (appending %2% splitting %3% playlist %4%)\n") % possible % s_appending_files % g_cluster_helper->splitting() % has_playlist);
+
+  return possible;
+}
+
+static bool
+all_packetizers_done_and_dry() {
+  return brng::find_if(g_packetizers, [](packetizer_t const &ptzr) { return FILE_STATUS_DONE_AND_DRY != ptzr.status; }) == g_packetizers.end();
+}
+
 /** \brief Request packets and handle the next one
 
    Requests packets from each packetizer, selects the packet with the
    lowest timecode and hands it over to the cluster helper for
    rendering.  Also displays the progress.
+
+   If the "parallel_reading" hack is engaged then the readers and
+   their packetizers run in one thread per source file. Packets are
+   still selected and added in the same order as without threads.
 */
 void
 main_loop() {
+  if (can_use_reader_threads()) {
+    s_reader_threads = std::make_unique<reader_threads_c>(g_packetizers, 32);
+    s_reader_threads->start();
+  }
+
   // Let's go!
   while (1) {
     // Step 1: Make sure a packet is available for each output
     // as long we haven't already processed the last one.
-    pull_packetizers_for_packets();
-    auto force_pulled = force_pull_packetizers_of_fully_held_files();
+    auto force_pulled = false;
+
+    if (s_reader_threads)
+      pull_packetizers_for_packets_from_reader_threads();
+
+    else {
+      pull_packetizers_for_packets();
+      force_pulled = force_pull_packetizers_of_fully_held_files();
+    }
 
     // Step 2: Pick the packet with the lowest timecode and
     // stuff it into the Matroska file.
@@ -2052,6 +2151,8 @@ main_loop() {
     if (winner && winner->pack) {
       packet_cptr pack = winner->pack;
 
+      std::lock_guard<std::recursive_mutex> lock{s_output_mutex};
+
       // Step 3: Add the winning packet to a cluster. Full clusters will be
       // rendered automatically.
       g_cluster_helper->add_packet(pack);
@@ -2069,10 +2170,19 @@ main_loop() {
       if (1 <= verbose)
         display_progress();
 
-    } else if (!appended_a_track && !force_pulled) // exit if there are no more packets
+    } else if (s_reader_threads && !all_packetizers_done_and_dry())
+      // All remaining packetizers are held back by their readers.
+      s_reader_threads->wait_for_progress();
+
+    else if (!appended_a_track && !force_pulled) // exit if there are no more packets
       break;
   }
 
+  if (s_reader_threads) {
+    s_reader_threads->stop();
+    s_reader_threads.reset();
+  }
+
   // Render all remaining packets (if there are any).
   if (g_cluster_helper && (0 < g_cluster_helper->get_packet_count()))
     g_cluster_helper->render();
@@ -2095,6 +2205,10 @@ destroy_readers() {
 */
 void
 cleanup() {
+  // The reader threads must not access the readers and packetizers
+  // after they've been destroyed.
+  s_reader_threads.reset();
+
   if (s_out) {
     // If cleanup was called as a result of an exception during
     // writing due to the file system being full, the destructor would
@@ -2140,4 +2254,7 @@ cleanup() {
   g_seguid_link_previous.reset();
   g_seguid_link_next.reset();
   g_forced_seguids.clear();
+
+  // Blocks kept for re-use aren't needed anymore once muxing is done.
+  mtx::mem::pool_c::release_cached_blocks();
 }
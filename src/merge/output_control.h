@@ -18,6 +18,7 @@
 #include "common/common_pch.h"
 
 #include <deque>
+#include <mutex>
 #include <unordered_map>
 
 #include "common/bitvalue.h"
@@ -207,6 +208,11 @@ void finish_file(bool last_file, bool create_new_file = false, bool previously_d
 void force_close_output_file();
 void rerender_track_headers();
 void rerender_ebml_head();
+
+// Readers and packetizers may run in threads of their own if the
+// "parallel_reading" hack is engaged. Hold this lock while modifying
+// the track headers or other global output state.
+std::unique_lock<std::recursive_mutex> lock_output();
 std::string create_output_name();
 
 bool set_required_matroska_version(unsigned int required_version);
@@ -0,0 +1,66 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   reading source files and running their packetizers in worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_PRIVATE_READER_THREADS_H
+#define MTX_MERGE_PRIVATE_READER_THREADS_H
+
+#include "common/common_pch.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class generic_packetizer_c;
+class generic_reader_c;
+
+struct reader_threads_c::impl_t {
+public:
+  struct slot_t {
+    generic_packetizer_c *packetizer{};
+    file_status_e status{FILE_STATUS_MOREDATA}, old_status{FILE_STATUS_MOREDATA};
+    std::deque<std::pair<packet_cptr, int64_t>> queue;
+    bool holding{}, finished{}, reported_done{};
+  };
+
+  struct worker_t {
+    std::vector<slot_t *> slots;
+    std::thread thread;
+  };
+
+  // Slots are looked up by their packetizers as the main loop's
+  // list of packetizer_t may be re-allocated when new ones are added.
+  std::vector<std::unique_ptr<slot_t>> slots;
+  std::unordered_map<generic_packetizer_c const *, slot_t *> slots_by_packetizer;
+  std::unordered_map<generic_reader_c const *, int> progress;
+  std::vector<std::unique_ptr<worker_t>> workers;
+  std::unordered_map<int64_t, worker_t *> workers_by_file;
+  std::vector<packetizer_t> new_packetizers;
+
+  std::mutex mutex;
+  std::condition_variable produced, consumed;
+  uint64_t num_consumed{};
+  std::size_t max_queued_packets{};
+  bool started{}, stopping{};
+  std::exception_ptr error;
+
+  debugging_option_c debug{"reader_threads"};
+
+public:
+  packet_cptr pull(slot_t &slot, bool force);
+  bool publish(slot_t &slot, packet_cptr const &packet);
+};
+
+#endif // MTX_MERGE_PRIVATE_READER_THREADS_H
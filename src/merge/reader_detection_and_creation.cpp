@@ -13,6 +13,8 @@
 #include "common/common_pch.h"
 
 // #include "common/logger.h"
+#include "common/hacks.h"
+#include "common/mm_mmap_io.h"
 #include "common/mm_mpls_multi_file_io.h"
 #include "common/mm_read_buffer_io.h"
 #include "common/strings/formatting.h"
@@ -71,10 +73,13 @@ file_names_to_paths(const std::vector<std::string> &file_names) {
 static mm_io_cptr
 open_input_file(filelist_t &file) {
   try {
-    if (file.all_names.size() == 1)
-      return mm_io_cptr(new mm_read_buffer_io_c(new mm_file_io_c(file.name), 1 << 17));
+    if (file.all_names.size() == 1) {
+      // Mapped files raise SIGBUS if they're truncated while being
+      // read. Therefore mapping must be asked for explicitly.
+      auto in = hack_engaged(ENGAGE_MMAP_INPUT) ? mm_mmap_io_c::open(file.name) : mm_io_cptr{};
+      return in ? in : mm_io_cptr(new mm_read_buffer_io_c(new mm_file_io_c(file.name), 1 << 17));
 
-    else {
+    } else {
       std::vector<bfs::path> paths = file_names_to_paths(file.all_names);
       return mm_io_cptr(new mm_read_buffer_io_c(new mm_multi_file_io_c(paths, file.name), 1 << 17));
     }
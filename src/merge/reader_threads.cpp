@@ -0,0 +1,398 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   reading source files and running their packetizers in worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "merge/generic_packetizer.h"
+#include "merge/generic_reader.h"
+#include "merge/output_control.h"
+#include "merge/reader_threads.h"
+#include "merge/private/reader_threads.h"
+
+reader_threads_c::reader_threads_c(std::vector<packetizer_t> const &packetizers,
+                                   std::size_t max_queued_packets)
+  : m{new reader_threads_c::impl_t{}}
+{
+  m->max_queued_packets = std::max<std::size_t>(max_queued_packets, 1);
+
+  for (auto const &ptzr : packetizers)
+    add_slot(ptzr);
+}
+
+reader_threads_c::~reader_threads_c() {
+  stop();
+}
+
+void
+reader_threads_c::start() {
+  std::lock_guard<std::mutex> lock{m->mutex};
+
+  mxdebug_if(m->debug, boost::format("reader_threads: starting %1% thread(s) for %2% packetizer(s), at most %3% queued packet(s) each\n") % m->workers.size() % m->slots.size() % m->max_queued_packets);
+
+  m->started = true;
+
+  for (auto idx = 0u; idx < m->workers.size(); ++idx)
+    m->workers[idx]->thread = std::thread{[this, idx]() { run(idx); }};
+}
+
+void
+reader_threads_c::stop() {
+  std::vector<impl_t::worker_t *> workers;
+
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    m->stopping = true;
+
+    for (auto &worker : m->workers)
+      workers.push_back(worker.get());
+  }
+
+  m->consumed.notify_all();
+
+  // Never join the calling thread, e.g. if a worker ends up here
+  // while the program is exiting.
+  for (auto worker : workers)
+    if (worker->thread.joinable() && (worker->thread.get_id() != std::this_thread::get_id()))
+      worker->thread.join();
+}
+
+/** \brief Create the slot for a packetizer
+
+   The packetizer is run by the worker that is responsible for its
+   source file. A new worker is started if there's none for the file
+   yet. The caller must hold the mutex unless the threads haven't been
+   started yet.
+*/
+void
+reader_threads_c::add_slot(packetizer_t const &ptzr) {
+  if (m->slots_by_packetizer.count(ptzr.packetizer))
+    return;
+
+  auto slot        = std::make_unique<impl_t::slot_t>();
+  slot->packetizer = ptzr.packetizer;
+  slot->status     = ptzr.status;
+  slot->old_status = ptzr.old_status;
+
+  auto &worker     = m->workers_by_file[ptzr.file];
+  if (!worker) {
+    m->workers.emplace_back(std::make_unique<impl_t::worker_t>());
+    worker = m->workers.back().get();
+
+    if (m->started) {
+      auto idx       = m->workers.size() - 1;
+      worker->thread = std::thread{[this, idx]() { run(idx); }};
+    }
+  }
+
+  worker->slots.push_back(slot.get());
+  m->slots_by_packetizer[ptzr.packetizer] = slot.get();
+  m->slots.emplace_back(std::move(slot));
+
+  mxdebug_if(m->debug && m->started, boost::format("reader_threads: added packetizer for track %1% of file %2%\n") % ptzr.packetizer->m_ti.m_id % ptzr.file);
+}
+
+/** \brief Take over a packetizer a reader created after the threads
+    were started
+
+   Usually called from a worker thread. The packetizer's worker
+   starts pulling from it right away. The main loop picks it up with
+   adopt_new_packetizers().
+*/
+void
+reader_threads_c::add_packetizer(packetizer_t const &ptzr) {
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+
+    add_slot(ptzr);
+    m->new_packetizers.push_back(ptzr);
+  }
+
+  m->consumed.notify_all();
+  m->produced.notify_all();
+}
+
+/** \brief Append the packetizers added since the last call to the list
+
+   Returns whether or not any packetizer has been added.
+*/
+bool
+reader_threads_c::adopt_new_packetizers(std::vector<packetizer_t> &packetizers) {
+  std::lock_guard<std::mutex> lock{m->mutex};
+
+  if (m->new_packetizers.empty())
+    return false;
+
+  brng::copy(m->new_packetizers, std::back_inserter(packetizers));
+  m->new_packetizers.clear();
+
+  return true;
+}
+
+/** \brief Fetch the next packet for a packetizer
+
+   Blocks until the packetizer's worker has either queued a packet,
+   the packetizer has run dry or its reader is holding it back.
+   Errors that occurred in a worker thread are reported here.
+
+   Packetizers that haven't been handed over with add_packetizer()
+   are taken over here.
+*/
+file_status_e
+reader_threads_c::get_packet(packetizer_t &ptzr,
+                             packet_cptr &packet) {
+  std::unique_lock<std::mutex> lock{m->mutex};
+
+  if (!m->slots_by_packetizer.count(ptzr.packetizer)) {
+    add_slot(ptzr);
+
+    lock.unlock();
+    m->consumed.notify_all();
+    lock.lock();
+  }
+
+  auto &slot = *m->slots_by_packetizer[ptzr.packetizer];
+
+  m->produced.wait(lock, [this, &slot]() { return m->error || !slot.queue.empty() || slot.finished || slot.holding; });
+
+  if (m->error)
+    handle_error(lock);
+
+  if (!slot.queue.empty()) {
+    packet = slot.queue.front().first;
+    slot.packetizer->account_queued_bytes(-slot.queue.front().second);
+    slot.queue.pop_front();
+    ++m->num_consumed;
+
+    lock.unlock();
+    m->consumed.notify_all();
+
+    return FILE_STATUS_MOREDATA;
+  }
+
+  if (slot.finished) {
+    slot.reported_done = true;
+    return FILE_STATUS_DONE;
+  }
+
+  return FILE_STATUS_HOLDING;
+}
+
+/** \brief Wait until at least one packetizer has something new to offer
+
+   Used by the main loop when none of the packetizers delivered a
+   packet because all of them are being held back by their readers.
+*/
+void
+reader_threads_c::wait_for_progress() {
+  std::unique_lock<std::mutex> lock{m->mutex};
+
+  m->produced.wait(lock, [this]() {
+    return m->error
+        || !m->new_packetizers.empty()
+        || brng::find_if(m->slots, [](std::unique_ptr<impl_t::slot_t> const &slot) { return !slot->queue.empty() || (slot->finished && !slot->reported_done); }) != m->slots.end();
+  });
+
+  if (m->error)
+    handle_error(lock);
+}
+
+/** \brief The progress a reader made as last reported by its worker
+
+   Readers must not be queried directly while their workers are
+   reading from them.
+*/
+int
+reader_threads_c::get_progress(generic_reader_c const &reader) {
+  std::lock_guard<std::mutex> lock{m->mutex};
+  auto itr = m->progress.find(&reader);
+
+  return itr != m->progress.end() ? itr->second : 0;
+}
+
+/** \brief Report an error that occurred in a worker thread
+
+   All workers are stopped first. Messages passed to mxerror() in a
+   worker are reported again in the calling thread which terminates
+   the program as usual. All other exceptions are re-thrown.
+*/
+void
+reader_threads_c::handle_error(std::unique_lock<std::mutex> &lock) {
+  auto error = m->error;
+
+  lock.unlock();
+  stop();
+
+  try {
+    std::rethrow_exception(error);
+
+  } catch (mtx::output::error_x &ex) {
+    mxerror(ex.error());
+  }
+}
+
+void
+reader_threads_c::run(std::size_t worker_idx) {
+  // New workers may be added while this one is running.
+  auto &worker = [this, worker_idx]() -> impl_t::worker_t & {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    return *m->workers[worker_idx];
+  }();
+
+  mxerror_throws_in_this_thread();
+
+  try {
+    while (true) {
+      std::vector<impl_t::slot_t *> to_pull;
+      auto num_unfinished = 0u;
+      auto num_consumed   = uint64_t{};
+      auto num_slots      = std::size_t{};
+
+      {
+        std::lock_guard<std::mutex> lock{m->mutex};
+
+        if (m->stopping)
+          break;
+
+        num_consumed = m->num_consumed;
+        num_slots    = worker.slots.size();
+
+        for (auto slot : worker.slots) {
+          if (slot->finished)
+            continue;
+
+          ++num_unfinished;
+          if (slot->queue.size() < m->max_queued_packets)
+            to_pull.push_back(slot);
+        }
+      }
+
+      // Readers may still create packetizers later on. Keep the
+      // worker around until the main loop stops the threads.
+      if (!num_unfinished) {
+        std::unique_lock<std::mutex> lock{m->mutex};
+        m->consumed.wait(lock, [this, &worker, num_slots]() { return m->stopping || (worker.slots.size() != num_slots); });
+        continue;
+      }
+
+      auto made_progress = false;
+      auto num_holding   = 0u;
+
+      for (auto slot : to_pull) {
+        if (m->publish(*slot, m->pull(*slot, false)))
+          made_progress = true;
+
+        else if (FILE_STATUS_HOLDING == slot->status)
+          ++num_holding;
+      }
+
+      if (made_progress)
+        continue;
+
+      // Same as force_pull_packetizers_of_fully_held_files(): if the
+      // reader holds back all of its packetizers then it must be
+      // forced to deliver something.
+      if (num_holding && (num_holding == num_unfinished)) {
+        for (auto slot : to_pull)
+          if (!slot->packetizer->packet_available())
+            m->publish(*slot, m->pull(*slot, true));
+        continue;
+      }
+
+      // All remaining queues are full. Wait for the main loop to
+      // consume something.
+      std::unique_lock<std::mutex> lock{m->mutex};
+      m->consumed.wait(lock, [this, num_consumed]() { return m->stopping || (m->num_consumed != num_consumed); });
+    }
+
+  } catch (...) {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    if (!m->error)
+      m->error = std::current_exception();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{m->mutex};
+    for (auto slot : worker.slots)
+      slot->finished = true;
+  }
+
+  m->produced.notify_all();
+}
+
+/** \brief Pull the next packet from a packetizer
+
+   Mirrors what the serial main loop does in
+   pull_packetizers_for_packets() and
+   force_pull_packetizers_of_fully_held_files().
+*/
+packet_cptr
+reader_threads_c::impl_t::pull(slot_t &slot,
+                               bool force) {
+  if (force) {
+    slot.old_status = slot.status;
+    slot.status     = slot.packetizer->read(true);
+
+    return slot.packetizer->get_packet();
+  }
+
+  if (FILE_STATUS_HOLDING == slot.status)
+    slot.status = FILE_STATUS_MOREDATA;
+
+  slot.old_status = slot.status;
+
+  while (   (FILE_STATUS_MOREDATA == slot.status)
+         && !slot.packetizer->packet_available())
+    slot.status = slot.packetizer->read(false);
+
+  if (   (FILE_STATUS_MOREDATA != slot.status)
+      && (FILE_STATUS_MOREDATA == slot.old_status))
+    slot.packetizer->force_duration_on_last_packet();
+
+  return slot.packetizer->get_packet();
+}
+
+bool
+reader_threads_c::impl_t::publish(slot_t &slot,
+                                  packet_cptr const &packet) {
+  auto made_progress   = true;
+  auto reader_progress = slot.packetizer->m_reader->get_progress();
+  auto num_bytes       = packet ? static_cast<int64_t>(packet->calculate_uncompressed_size()) : int64_t{};
+
+  // Keep the packet counted as long as it waits in the queue so that
+  // the reader holds back its packetizers just like in serial mode.
+  if (packet)
+    slot.packetizer->account_queued_bytes(num_bytes);
+
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    progress[slot.packetizer->m_reader] = reader_progress;
+
+    if (packet) {
+      slot.queue.emplace_back(packet, num_bytes);
+      slot.holding = false;
+
+    } else if (FILE_STATUS_DONE == slot.status) {
+      slot.finished = true;
+      slot.holding  = false;
+
+    } else {
+      slot.holding  = FILE_STATUS_HOLDING == slot.status;
+      made_progress = false;
+    }
+  }
+
+  produced.notify_all();
+
+  return made_progress;
+}
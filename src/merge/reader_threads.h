@@ -0,0 +1,65 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   reading source files and running their packetizers in worker threads
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_MERGE_READER_THREADS_H
+#define MTX_MERGE_READER_THREADS_H
+
+#include "common/common_pch.h"
+
+#include <mutex>
+
+#include "merge/file_status.h"
+#include "merge/packet.h"
+
+class generic_reader_c;
+struct packetizer_t;
+
+/* Runs each source file's reader and its packetizers on a thread of
+   its own. The main loop stays the only consumer: it fetches the
+   packets in the same order as the serial code would, so the
+   output does not depend on which mode is used.
+
+   Errors in a worker thread, including calls to mxerror(), are
+   forwarded to the main loop and reported there.
+
+   Packetizers that readers create while the threads are running are
+   handed over with add_packetizer(). The main loop adopts them with
+   adopt_new_packetizers() so that its list of packetizers is never
+   modified from another thread.
+*/
+class reader_threads_c {
+private:
+  struct impl_t;
+  std::unique_ptr<impl_t> m;
+
+public:
+  reader_threads_c(std::vector<packetizer_t> const &packetizers, std::size_t max_queued_packets);
+  ~reader_threads_c();
+
+  void start();
+  void stop();
+
+  void add_packetizer(packetizer_t const &ptzr);
+  bool adopt_new_packetizers(std::vector<packetizer_t> &packetizers);
+
+  file_status_e get_packet(packetizer_t &ptzr, packet_cptr &packet);
+  void wait_for_progress();
+  int get_progress(generic_reader_c const &reader);
+
+private:
+  void add_slot(packetizer_t const &ptzr);
+  void run(std::size_t worker_idx);
+  void handle_error(std::unique_lock<std::mutex> &lock);
+};
+
+#endif // MTX_MERGE_READER_THREADS_H
@@ -699,8 +699,8 @@ Tab::createAttachmentFromFile(QString const &fileName) {
                                       new KaxFileUID,  uid)
   };
 
-  fileData->SetBuffer(content->get_buffer(), content->get_size());
   content->lock();
+  fileData->SetBuffer(content->get_buffer(), content->get_size());
   attachment->PushElement(*fileData);
 
   return attachment;
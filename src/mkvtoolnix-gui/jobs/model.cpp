@@ -5,6 +5,9 @@
 #include <QMutexLocker>
 #include <QSettings>
 #include <QTimer>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+# include <QStorageInfo>
+#endif
 
 #include "common/list_utils.h"
 #include "common/qt.h"
@@ -389,24 +392,26 @@ Model::startNextAutoJob() {
   if (!m_started)
     return;
 
-  Job *toStart = nullptr;
-  for (auto row = 0, numRows = rowCount(); row < numRows; ++row) {
-    auto job = m_jobsById[idFromRow(row)].get();
-
-    if (Job::Running == job->status())
-      return;
-    if (!toStart && (Job::PendingAuto == job->status()))
-      toStart = job;
-  }
+  // Starting a job changes its status which in turn calls this
+  // function again. Therefore start one job at a time and count the
+  // running ones afresh each time.
+  while (true) {
+    auto toStart = findNextAutoJobToStart();
+    if (!toStart)
+      break;
 
-  if (toStart) {
     MainWindow::watchCurrentJobTab()->connectToJob(*toStart);
 
     toStart->start();
     updateJobStats();
-    return;
+
+    if (Job::PendingAuto == toStart->status())
+      break;
   }
 
+  if (hasRunningJobs())
+    return;
+
   // All jobs are done. Clear total progress.
   m_toBeProcessed.clear();
   updateProgress();
@@ -418,6 +423,58 @@ Model::startNextAutoJob() {
     emit queueStatusChanged(QueueStatus::Stopped);
 }
 
+Job *
+Model::findNextAutoJobToStart() {
+  auto const &cfg          = Util::Settings::get();
+  auto maxRunning          = std::max(cfg.m_maxConcurrentJobs, 1);
+  auto maxRunningPerDrive  = cfg.m_maxConcurrentJobsPerDrive;
+  auto numRunning          = 0;
+  auto numRunningPerDrive  = QHash<QString, int>{};
+  auto pending             = QList<Job *>{};
+
+  for (auto row = 0, numRows = rowCount(); row < numRows; ++row) {
+    auto job = m_jobsById[idFromRow(row)].get();
+
+    if (Job::Running == job->status()) {
+      ++numRunning;
+      if (maxRunningPerDrive)
+        ++numRunningPerDrive[destinationDrive(*job)];
+
+    } else if (Job::PendingAuto == job->status())
+      pending << job;
+  }
+
+  if (numRunning >= maxRunning)
+    return nullptr;
+
+  for (auto const &job : pending) {
+    if (!maxRunningPerDrive)
+      return job;
+
+    // Jobs whose destination is unknown aren't restricted.
+    auto drive = destinationDrive(*job);
+    if (drive.isEmpty() || (numRunningPerDrive[drive] < maxRunningPerDrive))
+      return job;
+  }
+
+  return nullptr;
+}
+
+QString
+Model::destinationDrive(Job const &job) {
+  auto folder = job.outputFolder();
+  if (folder.isEmpty())
+    return {};
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+  auto storage = QStorageInfo{folder};
+  if (storage.isValid())
+    return QString::fromUtf8(storage.device());
+#endif
+
+  return QDir{folder}.absolutePath();
+}
+
 void
 Model::startJobImmediately(Job &job) {
   QMutexLocker locked{&m_mutex};
@@ -117,6 +117,8 @@ protected:
   void updateJobStats();
   void updateNumUnacknowledgedWarningsOrErrors();
 
+  Job *findNextAutoJobToStart();
+
   void processAutomaticJobRemoval(uint64_t id, Job::Status status);
   void scheduleJobForRemoval(uint64_t id);
 
@@ -126,6 +128,7 @@ protected:
 
 public:
   static void convertJobQueueToSeparateIniFiles();
+  static QString destinationDrive(Job const &job);
 };
 
 }}}
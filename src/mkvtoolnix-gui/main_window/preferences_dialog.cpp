@@ -62,6 +62,8 @@ PreferencesDialog::PreferencesDialog(QWidget *parent,
   ui->cbGuiRemoveOldJobs->setChecked(m_cfg.m_removeOldJobs);
   ui->sbGuiRemoveOldJobsDays->setValue(m_cfg.m_removeOldJobsDays);
   adjustRemoveOldJobsControls();
+  ui->sbGuiMaxConcurrentJobs->setValue(m_cfg.m_maxConcurrentJobs);
+  ui->sbGuiMaxConcurrentJobsPerDrive->setValue(m_cfg.m_maxConcurrentJobsPerDrive);
   setupJobRemovalPolicy();
 
   setupCommonLanguages();
@@ -230,6 +232,11 @@ PreferencesDialog::setupToolTips() {
   Util::setToolTip(ui->cbGuiResetJobWarningErrorCountersOnExit, QY("If enabled, the warning and error counters of all jobs and the global counters in the status bar will be reset to 0 when the program exits."));
   Util::setToolTip(ui->cbGuiRemoveOldJobs,                      QY("If enabled, the GUI will remove completed jobs older than the configured number of days no matter their status on exit."));
   Util::setToolTip(ui->sbGuiRemoveOldJobsDays,                  QY("If enabled, the GUI will remove completed jobs older than the configured number of days no matter their status on exit."));
+  Util::setToolTip(ui->sbGuiMaxConcurrentJobs,                  QY("This is the maximum number of jobs from the queue that are run at the same time."));
+  Util::setToolTip(ui->sbGuiMaxConcurrentJobsPerDrive,
+                   Q("%1 %2")
+                   .arg(QY("This is the maximum number of jobs from the queue writing to the same drive that are run at the same time."))
+                   .arg(QY("Running several jobs writing to the same hard disk usually slows all of them down.")));
 
   Util::setToolTip(ui->cbGuiRemoveJobs,
                    Q("%1 %2")
@@ -651,6 +658,8 @@ PreferencesDialog::save() {
   m_cfg.m_jobRemovalPolicy                   = static_cast<Util::Settings::JobRemovalPolicy>(idx);
   m_cfg.m_removeOldJobs                      = ui->cbGuiRemoveOldJobs->isChecked();
   m_cfg.m_removeOldJobsDays                  = ui->sbGuiRemoveOldJobsDays->value();
+  m_cfg.m_maxConcurrentJobs                  = ui->sbGuiMaxConcurrentJobs->value();
+  m_cfg.m_maxConcurrentJobsPerDrive          = ui->sbGuiMaxConcurrentJobsPerDrive->value();
 
   m_cfg.m_chapterNameTemplate                = ui->leCENameTemplate->text();
   m_cfg.m_ceTextFileCharacterSet             = ui->cbCETextFileCharacterSet->currentData().toString();
@@ -273,6 +273,8 @@ Settings::load() {
   m_jobRemovalPolicy                   = static_cast<JobRemovalPolicy>(reg.value("jobRemovalPolicy", static_cast<int>(JobRemovalPolicy::Never)).toInt());
   m_removeOldJobs                      = reg.value("removeOldJobs",                                  true).toBool();
   m_removeOldJobsDays                  = reg.value("removeOldJobsDays",                              14).toInt();
+  m_maxConcurrentJobs                  = std::max(reg.value("maxConcurrentJobs",                      1).toInt(), 1);
+  m_maxConcurrentJobsPerDrive          = std::max(reg.value("maxConcurrentJobsPerDrive",              0).toInt(), 0);
 
   m_disableAnimations                  = reg.value("disableAnimations", false).toBool();
   m_showToolSelector                   = reg.value("showToolSelector", true).toBool();
@@ -518,6 +520,8 @@ Settings::save()
   reg.setValue("jobRemovalPolicy",                   static_cast<int>(m_jobRemovalPolicy));
   reg.setValue("removeOldJobs",                      m_removeOldJobs);
   reg.setValue("removeOldJobsDays",                  m_removeOldJobsDays);
+  reg.setValue("maxConcurrentJobs",                  m_maxConcurrentJobs);
+  reg.setValue("maxConcurrentJobsPerDrive",          m_maxConcurrentJobsPerDrive);
 
   reg.setValue("disableAnimations",                  m_disableAnimations);
   reg.setValue("showToolSelector",                   m_showToolSelector);
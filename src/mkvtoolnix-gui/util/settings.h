@@ -152,6 +152,7 @@ public:
   JobRemovalPolicy m_jobRemovalPolicy;
   bool m_removeOldJobs;
   int m_removeOldJobsDays;
+  int m_maxConcurrentJobs, m_maxConcurrentJobsPerDrive;
   bool m_useDefaultJobDescription, m_showOutputOfAllJobs, m_switchToJobOutputAfterStarting, m_resetJobWarningErrorCountersOnExit;
 
   bool m_checkForUpdates;
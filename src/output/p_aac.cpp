@@ -69,8 +69,9 @@ aac_packetizer_c::handle_parsed_audio_config() {
   m_ti.m_private_data        = raw_config;
   m_packet_duration          = m_timestamp_calculator.get_duration(m_config.samples_per_frame).to_ns();
 
-  set_headers();
+  auto lock = lock_output();
 
+  set_headers();
   rerender_track_headers();
 }
 
@@ -34,6 +34,7 @@ public:
   virtual int process(packet_cptr packet);
   virtual void add_extra_data(memory_cptr data);
   virtual void set_headers();
+  virtual uint64_t get_max_header_growth() const;
   virtual void set_container_default_field_duration(int64_t default_duration);
   virtual unsigned int get_nalu_size_length() const;
 
@@ -18,6 +18,7 @@
 #include "common/endian.h"
 #include "common/hacks.h"
 #include "common/hevc.h"
+#include "common/mpeg.h"
 #include "common/strings/formatting.h"
 #include "merge/output_control.h"
 #include "output/p_hevc.h"
@@ -31,7 +32,7 @@ hevc_video_packetizer_c(generic_reader_c *p_reader,
   : generic_video_packetizer_c{p_reader, p_ti, MKV_V_MPEGH_HEVC, fps, width, height}
   , m_nalu_size_len_src{}
   , m_nalu_size_len_dst{}
-  , m_max_nalu_size{}
+  , m_nalu_jobs{hack_engaged(ENGAGE_PARALLEL_NALU_PROCESSING)}
 {
   m_relaxed_timecode_checking = true;
 
@@ -80,14 +81,32 @@ hevc_video_packetizer_c::process(packet_cptr packet) {
 
   m_ref_timecode = packet->timecode;
 
-  if (m_nalu_size_len_dst && (m_nalu_size_len_dst != m_nalu_size_len_src))
-    change_nalu_size_len(packet);
+  if (!m_nalu_size_len_dst || (m_nalu_size_len_dst == m_nalu_size_len_src)) {
+    add_packet(packet);
+    return FILE_STATUS_MOREDATA;
+  }
 
-  add_packet(packet);
+  m_nalu_jobs.add(packet, [this](packet_t &packet_to_process) { change_nalu_size_len(packet_to_process); });
+  add_processed_packets(false);
 
   return FILE_STATUS_MOREDATA;
 }
 
+void
+hevc_video_packetizer_c::flush_impl() {
+  add_processed_packets(true);
+}
+
+void
+hevc_video_packetizer_c::add_processed_packets(bool wait_for_all) {
+  try {
+    m_nalu_jobs.collect([this](packet_cptr const &packet) { add_packet(packet); }, wait_for_all);
+
+  } catch (mtx::mpeg::nalu_size_length_x &) {
+    mxerror_tid(m_ti.m_fname, m_ti.m_id, boost::format(Y("The chosen NALU size length of %1% is too small. Try using '4'.\n")) % m_nalu_size_len_dst);
+  }
+}
+
 connection_result_e
 hevc_video_packetizer_c::can_connect_to(generic_packetizer_c *src,
                                         std::string &error_message) {
@@ -121,71 +140,15 @@ hevc_video_packetizer_c::setup_nalu_size_len_change() {
 
   m_nalu_size_len_dst    = m_ti.m_nalu_size_length;
   private_data[4]     = (private_data[4] & 0xfc) | (m_nalu_size_len_dst - 1);
-  m_max_nalu_size        = 1ll << (8 * m_nalu_size_len_dst);
 
   set_codec_private(m_ti.m_private_data);
 
   mxverb(2, boost::format("HEVC: Adjusting NALU size length from %1% to %2%\n") % m_nalu_size_len_src % m_nalu_size_len_dst);
 }
 
+// Runs in a worker thread if parallel NALU processing is engaged.
 void
-hevc_video_packetizer_c::change_nalu_size_len(packet_cptr packet) {
-  unsigned char *src = packet->data->get_buffer();
-  int size           = packet->data->get_size();
-
-  if (!src || !size)
-    return;
-
-  std::vector<int> nalu_sizes;
-
-  int src_pos = 0;
-
-  // Find all NALU sizes in this packet.
-  while (src_pos < size) {
-    if ((size - src_pos) < m_nalu_size_len_src)
-      break;
-
-    int nalu_size = 0;
-    int i;
-    for (i = 0; i < m_nalu_size_len_src; ++i)
-      nalu_size = (nalu_size << 8) + src[src_pos + i];
-
-    if ((size - src_pos - m_nalu_size_len_src) < nalu_size)
-      nalu_size = size - src_pos - m_nalu_size_len_src;
-
-    if (nalu_size > m_max_nalu_size)
-      mxerror_tid(m_ti.m_fname, m_ti.m_id, boost::format(Y("The chosen NALU size length of %1% is too small. Try using '4'.\n")) % m_nalu_size_len_dst);
-
-    src_pos += m_nalu_size_len_src + nalu_size;
-
-    nalu_sizes.push_back(nalu_size);
-  }
-
-  // Allocate memory if the new NALU size length is greater
-  // than the previous one. Otherwise reuse the existing memory.
-  if (m_nalu_size_len_dst > m_nalu_size_len_src) {
-    int new_size = size + nalu_sizes.size() * (m_nalu_size_len_dst - m_nalu_size_len_src);
-    packet->data = memory_cptr(new memory_c((unsigned char *)safemalloc(new_size), new_size, true));
-  }
-
-  // Copy the NALUs and write the new sized length field.
-  unsigned char *dst = packet->data->get_buffer();
-  src_pos            = 0;
-  int dst_pos        = 0;
-
-  size_t i;
-  for (i = 0; nalu_sizes.size() > i; ++i) {
-    int nalu_size = nalu_sizes[i];
-
-    int shift;
-    for (shift = 0; shift < m_nalu_size_len_dst; ++shift)
-      dst[dst_pos + shift] = (nalu_size >> (8 * (m_nalu_size_len_dst - 1 - shift))) & 0xff;
-
-    memmove(&dst[dst_pos + m_nalu_size_len_dst], &src[src_pos + m_nalu_size_len_src], nalu_size);
-
-    src_pos += m_nalu_size_len_src + nalu_size;
-    dst_pos += m_nalu_size_len_dst + nalu_size;
-  }
-
-  packet->data->set_size(dst_pos);
+hevc_video_packetizer_c::change_nalu_size_len(packet_t &packet)
+  const {
+  mtx::mpeg::change_nalu_size_length(packet.data, m_nalu_size_len_src, m_nalu_size_len_dst);
 }
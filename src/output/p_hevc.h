@@ -15,12 +15,13 @@
 
 #include "common/common_pch.h"
 
+#include "merge/ordered_packet_jobs.h"
 #include "output/p_generic_video.h"
 
 class hevc_video_packetizer_c: public generic_video_packetizer_c {
 protected:
   int m_nalu_size_len_src, m_nalu_size_len_dst;
-  int64_t m_max_nalu_size;
+  ordered_packet_jobs_c m_nalu_jobs;
 
 public:
   hevc_video_packetizer_c(generic_reader_c *p_reader, track_info_c &p_ti, double fps, int width, int height);
@@ -35,8 +36,10 @@ public:
 
 protected:
   virtual void extract_aspect_ratio();
+  virtual void flush_impl();
   virtual void setup_nalu_size_len_change();
-  virtual void change_nalu_size_len(packet_cptr packet);
+  virtual void add_processed_packets(bool wait_for_all);
+  virtual void change_nalu_size_len(packet_t &packet) const;
 };
 
 #endif  // MTX_P_HEVC_H
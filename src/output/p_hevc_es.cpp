@@ -219,3 +219,23 @@ hevc_es_video_packetizer_c::can_connect_to(generic_packetizer_c *src,
 
   return CAN_CONNECT_YES;
 }
+
+uint64_t
+hevc_es_video_packetizer_c::get_max_header_growth()
+  const {
+  // The HEVCC is only known once the first frames have been parsed:
+  // 23 bytes of fixed fields followed by one array each for the VPS,
+  // the SPS and the PPS. Each array has three bytes of type and count
+  // fields and a two byte length field per parameter set. Parameter
+  // sets are assumed to be at most 1 KB; real ones are much
+  // smaller. Display dimensions and the default duration may be added,
+  // too. Each element takes at most three bytes for its ID, eight
+  // bytes for its size and eight bytes for an integer value.
+  auto const max_parameter_set_size = 1024u;
+  auto const hevcc_size             = 23 + 3 * (3 + 2 + max_parameter_set_size);
+  auto const codec_private_size     = 2 + 8 + hevcc_size; // CodecPrivate
+  auto const display_size           = 2 * (2 + 8 + 8);    // DisplayWidth, DisplayHeight
+  auto const default_duration_size  = 3 + 8 + 8;         // DefaultDuration
+
+  return codec_private_size + display_size + default_duration_size;
+}
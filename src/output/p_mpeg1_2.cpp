@@ -288,3 +288,20 @@ mpeg1_2_video_packetizer_c::create_private_data() {
     rerender_track_headers();
   }
 }
+
+uint64_t
+mpeg1_2_video_packetizer_c::get_max_header_growth()
+  const {
+  // The sequence header becomes the codec private data once it has
+  // been found: 12 bytes plus two optional quantiser matrices of 64
+  // bytes each, followed by a sequence extension (10 bytes) and a
+  // sequence display extension (at most 12 bytes). The aspect ratio
+  // is taken from it, too, resulting in display dimensions. Each
+  // element takes at most two bytes for its ID, eight bytes for its
+  // size and eight bytes for an integer value.
+  auto const sequence_header_size = 12 + 2 * 64 + 10 + 12;
+  auto const codec_private_size   = 2 + 8 + sequence_header_size; // CodecPrivate
+  auto const display_size         = 2 * (2 + 8 + 8);              // DisplayWidth, DisplayHeight
+
+  return (m_hcodec_private ? 0 : codec_private_size) + display_size;
+}
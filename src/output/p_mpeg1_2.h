@@ -33,6 +33,7 @@ public:
   virtual ~mpeg1_2_video_packetizer_c();
 
   virtual int process(packet_cptr packet);
+  virtual uint64_t get_max_header_growth() const;
 
   virtual translatable_string_c get_format_name() const {
     return YT("MPEG-1/2");
@@ -319,6 +319,8 @@ mpeg4_p2_video_packetizer_c::extract_aspect_ratio(const unsigned char *buffer,
   uint32_t num, den;
   if (mpeg4::p2::extract_par(buffer, size, num, den)) {
     m_aspect_ratio_extracted = true;
+
+    auto lock = lock_output();
     set_video_aspect_ratio((double)m_hvideo_pixel_width / (double)m_hvideo_pixel_height * (double)num / (double)den, false, OPTION_SOURCE_BITSTREAM);
 
     generic_packetizer_c::set_headers();
@@ -348,6 +350,8 @@ mpeg4_p2_video_packetizer_c::extract_size(const unsigned char *buffer,
     m_size_extracted = true;
 
     if (!m_reader->m_appending && ((xtr_width != static_cast<uint32_t>(m_hvideo_pixel_width)) || (xtr_height != static_cast<uint32_t>(m_hvideo_pixel_height)))) {
+      auto lock = lock_output();
+
       set_video_pixel_width(xtr_width);
       set_video_pixel_height(xtr_height);
 
@@ -372,3 +376,20 @@ mpeg4_p2_video_packetizer_c::extract_size(const unsigned char *buffer,
   } else if (50 <= m_frames_output)
     m_aspect_ratio_extracted = true;
 }
+
+uint64_t
+mpeg4_p2_video_packetizer_c::get_max_header_growth()
+  const {
+  // In native mode the configuration data (the visual object
+  // sequence, visual object and video object layer headers) is taken
+  // from the first frame. They're assumed to be at most 512 bytes
+  // which leaves room for the two optional quantiser matrices of 64
+  // bytes each. The pixel and display dimensions may be extracted,
+  // too. Each element takes at most two bytes for its ID, eight bytes
+  // for its size and eight bytes for an integer value.
+  auto const max_config_data_size = 512u;
+  auto const codec_private_size   = 2 + 8 + max_config_data_size; // CodecPrivate
+  auto const dimensions_size      = 4 * (2 + 8 + 8);              // PixelWidth, PixelHeight, DisplayWidth, DisplayHeight
+
+  return (m_ti.m_private_data ? 0 : codec_private_size) + dimensions_size;
+}
@@ -60,6 +60,7 @@ public:
   virtual ~mpeg4_p2_video_packetizer_c();
 
   virtual int process(packet_cptr packet);
+  virtual uint64_t get_max_header_growth() const;
 
   virtual translatable_string_c get_format_name() const {
     return YT("MPEG-4");
@@ -36,6 +36,16 @@ attachment_target_c::attachment_target_c()
 attachment_target_c::~attachment_target_c() {
 }
 
+target_cptr
+attachment_target_c::clone()
+  const {
+  // The file's content is only ever read and can therefore be shared.
+  auto target = std::make_shared<attachment_target_c>(*this);
+  target->m_id_manager.reset();
+
+  return target;
+}
+
 void
 attachment_target_c::set_id_manager(attachment_id_manager_cptr const &id_manager) {
   m_id_manager = id_manager;
@@ -86,6 +86,8 @@ public:
   attachment_target_c();
   virtual ~attachment_target_c() override;
 
+  virtual target_cptr clone() const override;
+
   virtual void set_id_manager(attachment_id_manager_cptr const &id_manager);
 
   virtual void validate() override;
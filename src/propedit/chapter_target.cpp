@@ -26,6 +26,18 @@ chapter_target_c::chapter_target_c()
 chapter_target_c::~chapter_target_c() {
 }
 
+target_cptr
+chapter_target_c::clone()
+  const {
+  auto target = std::make_shared<chapter_target_c>(*this);
+
+  // The new chapters are moved into the file's chapters by execute().
+  if (m_new_chapters)
+    target->m_new_chapters.reset(static_cast<KaxChapters *>(m_new_chapters->Clone()));
+
+  return target;
+}
+
 bool
 chapter_target_c::operator ==(target_c const &cmp)
   const {
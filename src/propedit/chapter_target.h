@@ -26,6 +26,8 @@ public:
   chapter_target_c();
   virtual ~chapter_target_c() override;
 
+  virtual target_cptr clone() const override;
+
   virtual void validate() override;
 
   virtual bool operator ==(target_c const &cmp) const override;
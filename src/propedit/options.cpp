@@ -14,6 +14,8 @@
 #include <matroska/KaxTag.h>
 #include <matroska/KaxTags.h>
 
+#include "common/mm_io_x.h"
+#include "common/strings/editing.h"
 #include "propedit/chapter_target.h"
 #include "propedit/options.h"
 #include "propedit/propedit.h"
@@ -23,13 +25,14 @@
 
 options_c::options_c()
   : m_show_progress(false)
+  , m_num_jobs{}
   , m_parse_mode(kax_analyzer_c::parse_mode_fast)
 {
 }
 
 void
 options_c::validate() {
-  if (m_file_name.empty())
+  if (m_file_names.empty())
     mxerror(Y("No file name given.\n"));
 
   if (!has_changes())
@@ -102,10 +105,27 @@ options_c::add_delete_track_statistics_tags(tag_target_c::tag_operation_mode_e o
 
 void
 options_c::set_file_name(const std::string &file_name) {
-  if (!m_file_name.empty())
-    mxerror(boost::format(Y("More than one file name has been given ('%1%' and '%2%').\n")) % m_file_name % file_name);
+  m_file_names.push_back(file_name);
 
-  m_file_name = file_name;
+  if (1 == m_file_names.size())
+    m_file_name = file_name;
+}
+
+void
+options_c::add_file_list(std::string const &list_file_name) {
+  try {
+    mm_text_io_c in{new mm_file_io_c{list_file_name}};
+    std::string line;
+
+    while (in.getline2(line)) {
+      strip(line);
+      if (!line.empty())
+        set_file_name(line);
+    }
+
+  } catch (mtx::mm_io::exception &ex) {
+    mxerror(boost::format(Y("The file '%1%' could not be opened for reading: %2%.\n")) % list_file_name % ex);
+  }
 }
 
 void
@@ -125,12 +145,14 @@ options_c::dump_info()
   const
 {
   mxinfo(boost::format("options:\n"
-                       "  file_name:     %1%\n"
+                       "  file_names:    %1%\n"
                        "  show_progress: %2%\n"
-                       "  parse_mode:    %3%\n")
-         % m_file_name
+                       "  parse_mode:    %3%\n"
+                       "  num_jobs:      %4%\n")
+         % boost::join(m_file_names, " ")
          % m_show_progress
-         % static_cast<int>(m_parse_mode));
+         % static_cast<int>(m_parse_mode)
+         % m_num_jobs);
 
   for (auto &target : m_targets)
     target->dump_info();
@@ -143,6 +165,20 @@ options_c::has_changes()
   return !m_targets.empty();
 }
 
+options_cptr
+options_c::clone_for_file(std::string const &file_name)
+  const {
+  auto options          = std::make_shared<options_c>();
+  options->m_file_name  = file_name;
+  options->m_file_names = { file_name };
+  options->m_parse_mode = m_parse_mode;
+
+  for (auto const &target : m_targets)
+    options->m_targets.push_back(target->clone());
+
+  return options;
+}
+
 void
 options_c::remove_empty_targets() {
   boost::remove_erase_if(m_targets, [](target_cptr &target) { return !target->has_changes(); });
@@ -22,8 +22,10 @@
 class options_c {
 public:
   std::string m_file_name;
+  std::vector<std::string> m_file_names;
   std::vector<target_cptr> m_targets;
   bool m_show_progress;
+  unsigned int m_num_jobs;
   kax_analyzer_c::parse_mode_e m_parse_mode;
 
 public:
@@ -38,10 +40,13 @@ public:
   void add_attachment_command(attachment_target_c::command_e command, std::string const &spec, attachment_target_c::options_t const &options);
   void add_delete_track_statistics_tags(tag_target_c::tag_operation_mode_e operation_mode);
   void set_file_name(const std::string &file_name);
+  void add_file_list(std::string const &list_file_name);
   void set_parse_mode(const std::string &parse_mode);
   void dump_info() const;
   bool has_changes() const;
 
+  std::shared_ptr<options_c> clone_for_file(std::string const &file_name) const;
+
   void find_elements(kax_analyzer_c *analyzer);
 
   void execute(kax_analyzer_c &analzyer);
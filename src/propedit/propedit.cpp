@@ -10,18 +10,52 @@
 
 #include "common/common_pch.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <matroska/KaxChapters.h>
 #include <matroska/KaxInfo.h>
 #include <matroska/KaxTags.h>
 #include <matroska/KaxTracks.h>
 
 #include "common/command_line.h"
+#include "common/error.h"
 #include "common/list_utils.h"
 #include "common/mm_io_x.h"
+#include "common/strings/editing.h"
 #include "common/unique_numbers.h"
 #include "common/version.h"
 #include "propedit/propedit_cli_parser.h"
 
+namespace {
+
+// In batch mode errors only abort the file they occur in.
+class file_error_x: public mtx::exception {
+protected:
+  std::string m_message;
+
+public:
+  file_error_x(std::string const &message)
+    : m_message{message}
+  {
+    strip(m_message, true);
+  }
+
+  virtual const char *what() const throw() override {
+    return m_message.c_str();
+  }
+};
+
+struct file_result_t {
+  std::string m_file_name;
+  bool m_modified{};
+  boost::optional<std::string> m_error;
+  std::vector<std::string> m_warnings;
+};
+
+}
+
 static void
 display_update_element_result(const EbmlCallbacks &callbacks,
                               kax_analyzer_c::update_element_result_e result) {
@@ -106,8 +140,8 @@ write_changes(options_cptr &options,
   }
 }
 
-static void
-run(options_cptr &options) {
+static bool
+process_file(options_cptr &options) {
   console_kax_analyzer_cptr analyzer;
 
   try {
@@ -155,10 +189,133 @@ run(options_cptr &options) {
 
     mxinfo(Y("Done.\n"));
 
-  } else
-    mxinfo(Y("No changes were made.\n"));
+    return true;
+  }
 
-  mxexit();
+  mxinfo(Y("No changes were made.\n"));
+
+  return false;
+}
+
+/* Applies the same changes to several files using a pool of worker
+   threads. The command line has been parsed and validated once; each
+   file gets its own copy of the parsed targets as they keep the
+   elements read from the file.
+
+   Messages from the workers are collected per file instead of being
+   output right away. Errors only abort the file they occur in. The
+   results are listed in the order the files were given once all of
+   them have been processed.
+*/
+static void
+run_batch(options_cptr &options) {
+  auto const &file_names = options->m_file_names;
+  auto num_jobs          = std::min<std::size_t>(options->m_num_jobs ? options->m_num_jobs : std::max(std::thread::hardware_concurrency(), 1u), file_names.size());
+
+  std::vector<file_result_t> results(file_names.size());
+  std::atomic<std::size_t> next_idx{0};
+  std::mutex mutex;
+  std::map<std::thread::id, file_result_t *> results_by_thread;
+
+  auto current_result = [&]() -> file_result_t * {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto itr = results_by_thread.find(std::this_thread::get_id());
+    return itr != results_by_thread.end() ? itr->second : nullptr;
+  };
+
+  auto previous_info_handler    = get_mxmsg_handler(MXMSG_INFO);
+  auto previous_warning_handler = get_mxmsg_handler(MXMSG_WARNING);
+  auto previous_error_handler   = get_mxmsg_handler(MXMSG_ERROR);
+
+  set_mxmsg_handler(MXMSG_INFO, [&](unsigned int level, std::string const &message) {
+    if (!current_result())
+      previous_info_handler(level, message);
+  });
+
+  set_mxmsg_handler(MXMSG_WARNING, [&](unsigned int level, std::string const &message) {
+    auto result = current_result();
+    if (!result) {
+      previous_warning_handler(level, message);
+      return;
+    }
+
+    auto warning = message;
+    strip(warning, true);
+    result->m_warnings.push_back(warning);
+  });
+
+  set_mxmsg_handler(MXMSG_ERROR, [&](unsigned int level, std::string const &message) {
+    if (!current_result())
+      previous_error_handler(level, message);
+    throw file_error_x{message};
+  });
+
+  auto worker = [&]() {
+    while (true) {
+      auto idx = next_idx++;
+      if (idx >= file_names.size())
+        return;
+
+      auto &result       = results[idx];
+      result.m_file_name = file_names[idx];
+
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        results_by_thread[std::this_thread::get_id()] = &result;
+      }
+
+      try {
+        auto file_options = options->clone_for_file(result.m_file_name);
+        result.m_modified = process_file(file_options);
+
+      } catch (mtx::exception &ex) {
+        result.m_error = ex.error();
+      } catch (std::exception &ex) {
+        result.m_error = std::string{ex.what()};
+      }
+
+      std::lock_guard<std::mutex> lock{mutex};
+      results_by_thread.erase(std::this_thread::get_id());
+    }
+  };
+
+  mxinfo(boost::format(Y("Editing %1% files with %2% threads.\n")) % file_names.size() % num_jobs);
+
+  std::vector<std::thread> threads;
+  for (auto idx = 1u; idx < num_jobs; ++idx)
+    threads.emplace_back(worker);
+
+  worker();
+
+  for (auto &thread : threads)
+    thread.join();
+
+  set_mxmsg_handler(MXMSG_INFO,    previous_info_handler);
+  set_mxmsg_handler(MXMSG_WARNING, previous_warning_handler);
+  set_mxmsg_handler(MXMSG_ERROR,   previous_error_handler);
+
+  auto num_modified = 0u, num_failed = 0u;
+
+  for (auto const &result : results) {
+    for (auto const &warning : result.m_warnings)
+      mxwarn_fn(result.m_file_name, warning + "\n");
+
+    if (result.m_error) {
+      mxmsg(MXMSG_ERROR, (boost::format(Y("'%1%': %2%\n")) % result.m_file_name % *result.m_error).str());
+      ++num_failed;
+
+    } else if (result.m_modified) {
+      mxinfo_fn(result.m_file_name, Y("The changes have been written.\n"));
+      ++num_modified;
+
+    } else
+      mxinfo_fn(result.m_file_name, Y("No changes were made.\n"));
+  }
+
+  mxinfo(boost::format(Y("%1% files modified, %2% files unchanged, %3% files failed.\n")) % num_modified % (results.size() - num_modified - num_failed) % num_failed);
+
+  if (num_failed)
+    mxexit(2);
 }
 
 static
@@ -185,7 +342,10 @@ main(int argc,
     options->dump_info();
   }
 
-  run(options);
+  if (1 == options->m_file_names.size())
+    process_file(options);
+  else
+    run_batch(options);
 
   mxexit();
 }
@@ -199,15 +199,32 @@ propedit_cli_parser_c::set_file_name() {
   m_options->set_file_name(m_current_arg);
 }
 
+void
+propedit_cli_parser_c::add_file_list() {
+  m_options->add_file_list(m_next_arg);
+}
+
+void
+propedit_cli_parser_c::set_num_jobs() {
+  auto num_jobs = 0u;
+  if (!parse_number(m_next_arg, num_jobs) || !num_jobs)
+    mxerror(boost::format(Y("Invalid number of jobs in '%1% %2%'.\n")) % m_current_arg % m_next_arg);
+
+  m_options->m_num_jobs = num_jobs;
+}
+
 #define OPT(spec, func, description) add_option(spec, std::bind(&propedit_cli_parser_c::func, this), description)
 
 void
 propedit_cli_parser_c::init_parser() {
-  add_information(YT("mkvpropedit [options] <file> <actions>"));
+  add_information(YT("mkvpropedit [options] <file> [<file> ...] <actions>"));
 
   add_section_header(YT("Options"));
   OPT("l|list-property-names",      list_property_names, YT("List all valid property names and exit"));
   OPT("p|parse-mode=<mode>",        set_parse_mode,      YT("Sets the Matroska parser mode to 'fast' (default) or 'full'"));
+  OPT("file-list=<list-file>",      add_file_list,       YT("Edit all files whose names are listed in 'list-file', one per line"));
+  OPT("jobs=<n>",                   set_num_jobs,        YT("Edit up to 'n' files at the same time if more than one file is given "
+                                                            "(default: the number of processors)"));
 
   add_section_header(YT("Actions for handling properties"));
   OPT("e|edit=<selector>",          add_target,          YT("Sets the Matroska file section that all following add/set/delete "
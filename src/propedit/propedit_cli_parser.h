@@ -38,6 +38,8 @@ protected:
   void add_chapters();
   void set_parse_mode();
   void set_file_name();
+  void add_file_list();
+  void set_num_jobs();
 
   void set_attachment_name();
   void set_attachment_description();
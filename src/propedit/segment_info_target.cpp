@@ -27,6 +27,15 @@ segment_info_target_c::segment_info_target_c()
 segment_info_target_c::~segment_info_target_c() {
 }
 
+target_cptr
+segment_info_target_c::clone()
+  const {
+  auto target = std::make_shared<segment_info_target_c>(*this);
+  clone_changes(target->m_changes);
+
+  return target;
+}
+
 bool
 segment_info_target_c::operator ==(target_c const &cmp)
   const {
@@ -26,6 +26,8 @@ public:
   segment_info_target_c();
   virtual ~segment_info_target_c() override;
 
+  virtual target_cptr clone() const override;
+
   virtual void validate() override;
 
   virtual void add_change(change_c::change_type_e type, const std::string &spec) override;
@@ -47,6 +47,19 @@ tag_target_c::tag_target_c(tag_operation_mode_e operation_mode)
 tag_target_c::~tag_target_c() {
 }
 
+target_cptr
+tag_target_c::clone()
+  const {
+  auto target = std::make_shared<tag_target_c>(*this);
+  clone_changes(target->m_changes);
+
+  // The new tags are moved into the file's tags by execute().
+  if (m_new_tags)
+    target->m_new_tags.reset(static_cast<KaxTags *>(m_new_tags->Clone()));
+
+  return target;
+}
+
 bool
 tag_target_c::operator ==(target_c const &cmp)
   const {
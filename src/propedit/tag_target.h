@@ -50,6 +50,8 @@ public:
   tag_target_c(tag_operation_mode_e operation_mode);
   virtual ~tag_target_c() override;
 
+  virtual target_cptr clone() const override;
+
   virtual void validate() override;
 
   virtual bool operator ==(target_c const &cmp) const override;
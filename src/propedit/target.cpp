@@ -75,6 +75,12 @@ target_c::add_or_replace_all_master_elements(EbmlMaster *source) {
   }
 }
 
+void
+target_c::clone_changes(std::vector<change_cptr> &changes) {
+  for (auto &change : changes)
+    change = std::make_shared<change_c>(*change);
+}
+
 std::string const &
 target_c::get_spec()
   const {
@@ -40,6 +40,11 @@ public:
   target_c();
   virtual ~target_c();
 
+  // Creates an independent copy of the parsed target that can be
+  // applied to another file. Must be called before
+  // set_level1_element().
+  virtual std::shared_ptr<target_c> clone() const = 0;
+
   virtual void validate() = 0;
 
   virtual void dump_info() const = 0;
@@ -66,6 +71,8 @@ public:
 
 protected:
   virtual void add_or_replace_all_master_elements(EbmlMaster *source);
+
+  static void clone_changes(std::vector<change_cptr> &changes);
 };
 using target_cptr = std::shared_ptr<target_c>;
 
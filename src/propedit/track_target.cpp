@@ -29,6 +29,15 @@ track_target_c::track_target_c(std::string const &spec)
 track_target_c::~track_target_c() {
 }
 
+target_cptr
+track_target_c::clone()
+  const {
+  auto target = std::make_shared<track_target_c>(*this);
+  clone_changes(target->m_changes);
+
+  return target;
+}
+
 bool
 track_target_c::operator ==(target_c const &cmp)
   const {
@@ -38,6 +38,8 @@ public:
   track_target_c(std::string const &spec);
   virtual ~track_target_c() override;
 
+  virtual target_cptr clone() const override;
+
   virtual void validate() override;
 
   virtual void add_change(change_c::change_type_e type, const std::string &spec) override;
@@ -0,0 +1,196 @@
+/*
+   bench - micro and macro benchmarks for MKVToolNix
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/command_line.h"
+#include "common/strings/parsing.h"
+#include "common/version.h"
+#include "tests/bench/benchmark.h"
+#include "tests/bench/generators.h"
+
+using namespace mtxbench;
+
+namespace {
+
+std::string s_generate_type, s_generate_file_name;
+bool s_list{};
+
+void
+setup_help_and_version_info() {
+  version_info = get_version_info("bench", vif_full);
+  usage_text   = "bench [options]\n"
+         "\n"
+         "Runs benchmarks on synthetic data and outputs the results in JSON\n"
+         "format. Macro benchmarks run mkvmerge and are only run if the path\n"
+         "to mkvmerge is given.\n"
+         "\n"
+         "Benchmark options:\n"
+         "\n"
+         "  --filter text             Only run benchmarks whose name contains 'text'\n"
+         "  --min-time seconds        Run each micro benchmark for at least this long\n"
+         "                            (default: 0.5)\n"
+         "  --min-iterations n        Run each micro benchmark at least n times\n"
+         "                            (default: 3)\n"
+         "  --macro-iterations n      Run each macro benchmark n times (default: 3)\n"
+         "  --mkvmerge path           Run the macro benchmarks with this mkvmerge\n"
+         "  --work-dir dir            Create generated & output files in 'dir'\n"
+         "                            (default: a temporary directory)\n"
+         "  --output file             Write the JSON results to 'file' instead of\n"
+         "                            stdout\n"
+         "  --compare file            Compare the results with those of an earlier\n"
+         "                            run stored in 'file'\n"
+         "  --label text              Store 'text' in the results, e.g. a commit ID\n"
+         "  --list                    List the available benchmarks\n"
+         "  --generate type file      Only write a generated file; 'type' is one\n"
+         "                            of avc, hevc, vc1, dts, aac, ts and mp4\n"
+         "\n"
+         "General options:\n"
+         "\n"
+         "  -h, --help                This help text\n"
+         "  -V, --version             Print version information\n";
+}
+
+void
+parse_args(std::vector<std::string> &args) {
+  for (auto current = args.begin(), end = args.end(); current != end; ++current) {
+    auto arg      = *current;
+    auto next     = current + 1;
+    auto next_arg = next != end ? *next : "";
+
+    auto require_argument = [&]() {
+      if (next_arg.empty())
+        mxerror(boost::format("Missing argument to %1%\n") % arg);
+      ++current;
+    };
+
+    if (arg == "--list")
+      s_list = true;
+
+    else if (arg == "--filter") {
+      require_argument();
+      g_options.m_filter = next_arg;
+
+    } else if (arg == "--min-time") {
+      require_argument();
+      if (!parse_number(next_arg, g_options.m_min_time) || (0 > g_options.m_min_time))
+        mxerror(boost::format("Invalid argument to %1%: %2%\n") % arg % next_arg);
+
+    } else if (arg == "--min-iterations") {
+      require_argument();
+      if (!parse_number(next_arg, g_options.m_min_iterations) || !g_options.m_min_iterations)
+        mxerror(boost::format("Invalid argument to %1%: %2%\n") % arg % next_arg);
+
+    } else if (arg == "--macro-iterations") {
+      require_argument();
+      if (!parse_number(next_arg, g_options.m_macro_iterations) || !g_options.m_macro_iterations)
+        mxerror(boost::format("Invalid argument to %1%: %2%\n") % arg % next_arg);
+
+    } else if (arg == "--mkvmerge") {
+      require_argument();
+      g_options.m_mkvmerge = next_arg;
+
+    } else if (arg == "--work-dir") {
+      require_argument();
+      g_options.m_work_dir = next_arg;
+
+    } else if (arg == "--output") {
+      require_argument();
+      g_options.m_output_file_name = next_arg;
+
+    } else if (arg == "--compare") {
+      require_argument();
+      g_options.m_compare_file_name = next_arg;
+
+    } else if (arg == "--label") {
+      require_argument();
+      g_options.m_label = next_arg;
+
+    } else if (arg == "--generate") {
+      if ((next == end) || ((next + 1) == end))
+        mxerror(boost::format("Missing arguments to %1%\n") % arg);
+
+      s_generate_type      = *next;
+      s_generate_file_name = *(next + 1);
+      current             += 2;
+
+    } else
+      mxerror(boost::format("Unknown option '%1%'\n") % arg);
+  }
+}
+
+std::vector<benchmark_t>
+select_benchmarks() {
+  auto selected = std::vector<benchmark_t>{};
+
+  for (auto const &benchmark : get_benchmarks()) {
+    if ((kind_e::macro == benchmark.m_kind) && g_options.m_mkvmerge.empty())
+      continue;
+
+    if (g_options.m_filter.empty() || (benchmark.m_name.find(g_options.m_filter) != std::string::npos))
+      selected.push_back(benchmark);
+  }
+
+  brng::sort(selected, [](benchmark_t const &a, benchmark_t const &b) { return a.m_name < b.m_name; });
+
+  return selected;
+}
+
+} // anonymous namespace
+
+int
+main(int argc,
+     char **argv) {
+  mtx_common_init("bench", argv[0]);
+  setup_help_and_version_info();
+
+  auto args = command_line_utf8(argc, argv);
+  while (handle_common_cli_args(args, ""))
+    ;
+
+  parse_args(args);
+
+  if (!s_generate_type.empty()) {
+    if (!generate::file(s_generate_type, s_generate_file_name))
+      mxerror(boost::format("Unknown type '%1%'\n") % s_generate_type);
+
+    mxexit();
+  }
+
+  auto benchmarks = select_benchmarks();
+
+  if (s_list) {
+    for (auto const &benchmark : benchmarks)
+      mxinfo(boost::format("%1%\n") % benchmark.m_name);
+
+    mxexit();
+  }
+
+  auto remove_work_dir = false;
+
+  if (!g_options.m_mkvmerge.empty() && g_options.m_work_dir.empty()) {
+    g_options.m_work_dir = (bfs::temp_directory_path() / bfs::unique_path("mtxbench-%%%%-%%%%-%%%%")).string();
+    remove_work_dir      = true;
+  }
+
+  if (!g_options.m_work_dir.empty())
+    bfs::create_directories(g_options.m_work_dir);
+
+  auto results = run(benchmarks);
+  write_results(results);
+
+  if (!g_options.m_compare_file_name.empty())
+    compare_results(results);
+
+  if (remove_work_dir)
+    bfs::remove_all(g_options.m_work_dir);
+
+  mxexit();
+}
@@ -0,0 +1,159 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   benchmark registration and runner
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <chrono>
+
+#include "common/json.h"
+#include "common/mm_io.h"
+#include "common/version.h"
+#include "tests/bench/benchmark.h"
+
+namespace mtxbench {
+
+options_t g_options;
+
+registration_c::registration_c(char const *name,
+                               kind_e kind,
+                               function_t const &function) {
+  get_benchmarks().push_back({ name, kind, function });
+}
+
+std::vector<benchmark_t> &
+get_benchmarks() {
+  static std::vector<benchmark_t> s_benchmarks;
+  return s_benchmarks;
+}
+
+static double
+get_mb_per_second(result_t const &result) {
+  return result.m_median_ns ? result.m_bytes_per_iteration * 1000.0 / result.m_median_ns : 0.0;
+}
+
+static result_t
+run_one(benchmark_t const &benchmark) {
+  using clock_t = std::chrono::steady_clock;
+
+  auto result           = result_t{};
+  result.m_name         = benchmark.m_name;
+  result.m_kind         = benchmark.m_kind;
+  auto is_micro         = kind_e::micro == benchmark.m_kind;
+  auto min_iterations   = is_micro ? g_options.m_min_iterations : g_options.m_macro_iterations;
+  auto min_time         = std::chrono::duration<double>(is_micro ? g_options.m_min_time : 0.0);
+  auto durations        = std::vector<double>{};
+
+  // One iteration for warming up caches and creating the input data.
+  result.m_bytes_per_iteration = benchmark.m_function();
+
+  auto start = clock_t::now();
+
+  while ((durations.size() < min_iterations) || ((clock_t::now() - start) < min_time)) {
+    auto iteration_start = clock_t::now();
+    benchmark.m_function();
+    durations.push_back(std::chrono::duration<double, std::nano>(clock_t::now() - iteration_start).count());
+  }
+
+  brng::sort(durations);
+
+  result.m_iterations = durations.size();
+  result.m_min_ns     = durations.front();
+  result.m_median_ns  = durations[durations.size() / 2];
+  result.m_mean_ns    = std::accumulate(durations.begin(), durations.end(), 0.0) / durations.size();
+
+  return result;
+}
+
+std::vector<result_t>
+run(std::vector<benchmark_t> const &benchmarks) {
+  // Progress is only shown if the JSON output doesn't go to stdout.
+  auto show_progress = !g_options.m_output_file_name.empty();
+  auto results       = std::vector<result_t>{};
+
+  for (auto const &benchmark : benchmarks) {
+    if (show_progress) {
+      mxinfo(boost::format("%|1$-40s| ") % benchmark.m_name);
+      g_mm_stdio->flush();
+    }
+
+    auto result = run_one(benchmark);
+
+    if (show_progress)
+      mxinfo(boost::format("%|1$12.3f| ms %|2$10.1f| MB/s %|3$6d| iterations\n") % (result.m_median_ns / 1000000.0) % get_mb_per_second(result) % result.m_iterations);
+
+    results.push_back(result);
+  }
+
+  return results;
+}
+
+void
+write_results(std::vector<result_t> const &results) {
+  auto json_results = nlohmann::json::array();
+
+  for (auto const &result : results)
+    json_results.push_back(nlohmann::json{
+      { "name",                result.m_name                                             },
+      { "kind",                kind_e::micro == result.m_kind ? "micro" : "macro"        },
+      { "iterations",          result.m_iterations                                       },
+      { "bytes_per_iteration", result.m_bytes_per_iteration                              },
+      { "min_ns",              result.m_min_ns                                           },
+      { "median_ns",           result.m_median_ns                                        },
+      { "mean_ns",             result.m_mean_ns                                          },
+      { "mb_per_second",       get_mb_per_second(result)                                 },
+    });
+
+  auto json = nlohmann::json{
+    { "version",    get_version_info("mkvtoolnix benchmarks", vif_full) },
+    { "label",      g_options.m_label                                  },
+    { "timestamp",  static_cast<int64_t>(std::time(nullptr))          },
+    { "benchmarks", json_results                                      },
+  };
+
+  auto content = mtx::json::dump(json, 2) + "\n";
+
+  if (g_options.m_output_file_name.empty()) {
+    mxinfo(content);
+    return;
+  }
+
+  mm_file_io_c out{g_options.m_output_file_name, MODE_CREATE};
+  out.puts(content);
+}
+
+// Prints the change of the median time relative to the results of an
+// earlier run, e.g. one made with the previous commit.
+void
+compare_results(std::vector<result_t> const &results) {
+  mm_file_io_c in{g_options.m_compare_file_name};
+  std::string content;
+  in.read(content, in.get_size());
+
+  auto previous = std::map<std::string, double>{};
+
+  for (auto const &json_result : mtx::json::parse(content)["benchmarks"])
+    previous[json_result["name"].get<std::string>()] = json_result["median_ns"].get<double>();
+
+  for (auto const &result : results) {
+    auto itr = previous.find(result.m_name);
+    if ((itr == previous.end()) || !itr->second) {
+      mxinfo(boost::format("%|1$-40s| %|2$12.3f| ms (no previous result)\n") % result.m_name % (result.m_median_ns / 1000000.0));
+      continue;
+    }
+
+    mxinfo(boost::format("%|1$-40s| %|2$12.3f| ms -> %|3$12.3f| ms %|4$+8.1f|%%\n")
+           % result.m_name % (itr->second / 1000000.0) % (result.m_median_ns / 1000000.0) % ((result.m_median_ns / itr->second - 1.0) * 100.0));
+  }
+}
+
+}
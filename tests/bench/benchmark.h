@@ -0,0 +1,79 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   benchmark registration and runner
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_TESTS_BENCH_BENCHMARK_H
+#define MTX_TESTS_BENCH_BENCHMARK_H
+
+#include "common/common_pch.h"
+
+namespace mtxbench {
+
+enum class kind_e {
+    micro
+  , macro
+};
+
+struct options_t {
+  std::string m_filter, m_output_file_name, m_compare_file_name, m_label, m_mkvmerge, m_work_dir;
+  double m_min_time{0.5};
+  unsigned int m_min_iterations{3}, m_macro_iterations{3};
+};
+
+extern options_t g_options;
+
+/* A benchmark runs one iteration per call of its function and returns
+   the number of bytes it has processed. Input data should be created
+   once outside of the function, e.g. in a function-local static
+   variable, so that its creation isn't measured.
+*/
+using function_t = std::function<uint64_t()>;
+
+struct benchmark_t {
+  std::string m_name;
+  kind_e m_kind;
+  function_t m_function;
+};
+
+struct result_t {
+  std::string m_name;
+  kind_e m_kind;
+  unsigned int m_iterations{};
+  uint64_t m_bytes_per_iteration{};
+  double m_min_ns{}, m_median_ns{}, m_mean_ns{};
+};
+
+class registration_c {
+public:
+  registration_c(char const *name, kind_e kind, function_t const &function);
+};
+
+std::vector<benchmark_t> &get_benchmarks();
+
+std::vector<result_t> run(std::vector<benchmark_t> const &benchmarks);
+void write_results(std::vector<result_t> const &results);
+void compare_results(std::vector<result_t> const &results);
+
+}
+
+#define MTXBENCH_NAME2(group, name) mtxbench_ ## group ## _ ## name
+#define MTXBENCH_REGISTRATION2(group, name) s_mtxbench_registration_ ## group ## _ ## name
+
+#define MTXBENCH_DEFINE(group, name, kind)                                                                                              \
+  static uint64_t MTXBENCH_NAME2(group, name)();                                                                                        \
+  static mtxbench::registration_c MTXBENCH_REGISTRATION2(group, name){#group "." #name, mtxbench::kind_e::kind, MTXBENCH_NAME2(group, name)}; \
+  static uint64_t MTXBENCH_NAME2(group, name)()
+
+#define MTXBENCH(group, name)       MTXBENCH_DEFINE(group, name, micro)
+#define MTXBENCH_MACRO(group, name) MTXBENCH_DEFINE(group, name, macro)
+
+#endif // MTX_TESTS_BENCH_BENCHMARK_H
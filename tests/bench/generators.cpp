@@ -0,0 +1,795 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   generators for synthetic benchmark input
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include <random>
+
+#include "common/bit_writer.h"
+#include "common/bswap.h"
+#include "common/checksums/base.h"
+#include "common/endian.h"
+#include "common/mm_io.h"
+#include "common/mpeg.h"
+#include "tests/bench/generators.h"
+
+namespace mtxbench { namespace generate {
+
+namespace {
+
+unsigned int const s_gop_size = 8;
+
+class buffer_c {
+protected:
+  mm_mem_io_c m_out{nullptr, 0, 1024 * 1024};
+  std::vector<uint64_t> m_atom_starts;
+
+public:
+  mm_mem_io_c &
+  out() {
+    return m_out;
+  }
+
+  uint64_t
+  size() {
+    return m_out.getFilePointer();
+  }
+
+  memory_cptr
+  get() {
+    return memory_c::clone(m_out.get_buffer(), size());
+  }
+
+  void
+  start_atom(char const *type) {
+    m_atom_starts.push_back(size());
+    m_out.write_uint32_be(0);
+    m_out.write(type, 4);
+  }
+
+  void
+  start_full_atom(char const *type,
+                  unsigned int version,
+                  unsigned int flags) {
+    start_atom(type);
+    m_out.write_uint32_be((version << 24) | flags);
+  }
+
+  void
+  end_atom() {
+    auto end   = size();
+    auto start = m_atom_starts.back();
+    m_atom_starts.pop_back();
+
+    m_out.setFilePointer(start);
+    m_out.write_uint32_be(end - start);
+    m_out.setFilePointer(end);
+  }
+
+  void
+  zeros(std::size_t num) {
+    for (auto idx = 0u; idx < num; ++idx)
+      m_out.write_uint8(0);
+  }
+};
+
+// Filler bytes are drawn from [min_value, max_value]. Excluding 0x00
+// means that neither start codes nor emulation prevention bytes can
+// occur.
+memory_cptr
+filler(std::size_t size,
+       uint32_t seed,
+       unsigned int min_value = 0x01,
+       unsigned int max_value = 0xfe) {
+  auto buffer    = memory_c::alloc(size);
+  auto ptr       = buffer->get_buffer();
+  auto generator = std::mt19937{seed};
+  auto range     = max_value - min_value + 1;
+
+  for (auto idx = 0u; idx < size; ++idx)
+    ptr[idx] = min_value + (generator() % range);
+
+  return buffer;
+}
+
+void
+put_unsigned_golomb(bit_writer_c &w,
+                    unsigned int value) {
+  auto code     = value + 1;
+  auto num_bits = 0u;
+
+  while ((code >> (num_bits + 1)) != 0)
+    ++num_bits;
+
+  w.put_bits(num_bits, 0);
+  w.put_bits(num_bits + 1, code);
+}
+
+void
+put_rbsp_trailing_bits(bit_writer_c &w) {
+  w.put_bit(1);
+  w.byte_align();
+}
+
+// Converts the header in 'w' to NALU format and appends 'payload_size'
+// bytes of filler.
+void
+put_nalu(buffer_c &out,
+         bit_writer_c &w,
+         std::size_t payload_size,
+         uint32_t seed) {
+  static unsigned char const s_start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+  out.out().write(s_start_code, 4);
+  out.out().write(mtx::mpeg::rbsp_to_nalu(w.get_buffer()));
+
+  if (payload_size)
+    out.out().write(filler(payload_size, seed));
+}
+
+memory_cptr
+avc_frame(unsigned int frame_num,
+          std::size_t frame_size) {
+  buffer_c out;
+  auto gop_idx = frame_num % s_gop_size;
+  auto is_idr  = !gop_idx;
+
+  if (is_idr) {
+    // Baseline profile, 1280x720, POC type 0, no VUI
+    auto sps = bit_writer_c{};
+    sps.put_bits(8, 0x67);
+    sps.put_bits(8, 66);              // profile_idc
+    sps.put_bits(8, 0xc0);            // constraint_set0/1_flag
+    sps.put_bits(8, 31);              // level_idc
+    put_unsigned_golomb(sps, 0);      // seq_parameter_set_id
+    put_unsigned_golomb(sps, 0);      // log2_max_frame_num_minus4
+    put_unsigned_golomb(sps, 0);      // pic_order_cnt_type
+    put_unsigned_golomb(sps, 0);      // log2_max_pic_order_cnt_lsb_minus4
+    put_unsigned_golomb(sps, 1);      // num_ref_frames
+    sps.put_bit(0);                   // gaps_in_frame_num_value_allowed_flag
+    put_unsigned_golomb(sps, 80 - 1); // pic_width_in_mbs_minus1
+    put_unsigned_golomb(sps, 45 - 1); // pic_height_in_map_units_minus1
+    sps.put_bit(1);                   // frame_mbs_only_flag
+    sps.put_bit(1);                   // direct_8x8_inference_flag
+    sps.put_bit(0);                   // frame_cropping_flag
+    sps.put_bit(0);                   // vui_parameters_present_flag
+    put_rbsp_trailing_bits(sps);
+    put_nalu(out, sps, 0, 0);
+
+    auto pps = bit_writer_c{};
+    pps.put_bits(8, 0x68);
+    put_unsigned_golomb(pps, 0);      // pic_parameter_set_id
+    put_unsigned_golomb(pps, 0);      // seq_parameter_set_id
+    pps.put_bit(0);                   // entropy_coding_mode_flag
+    pps.put_bit(0);                   // pic_order_present_flag
+    put_unsigned_golomb(pps, 0);      // num_slice_groups_minus1
+    put_unsigned_golomb(pps, 0);      // num_ref_idx_l0_active_minus1
+    put_unsigned_golomb(pps, 0);      // num_ref_idx_l1_active_minus1
+    pps.put_bits(3, 0);               // weighted_pred_flag, weighted_bipred_idc
+    put_unsigned_golomb(pps, 0);      // pic_init_qp_minus26
+    put_unsigned_golomb(pps, 0);      // pic_init_qs_minus26
+    put_unsigned_golomb(pps, 0);      // chroma_qp_index_offset
+    pps.put_bits(3, 0b100);           // deblocking_filter_control_present_flag, constrained_intra_pred_flag, redundant_pic_cnt_present_flag
+    put_rbsp_trailing_bits(pps);
+    put_nalu(out, pps, 0, 0);
+  }
+
+  auto slice = bit_writer_c{};
+  slice.put_bits(8, is_idr ? 0x65 : 0x41);
+  put_unsigned_golomb(slice, 0);                 // first_mb_in_slice
+  put_unsigned_golomb(slice, is_idr ? 7 : 5);    // slice_type: I or P
+  put_unsigned_golomb(slice, 0);                 // pic_parameter_set_id
+  slice.put_bits(4, gop_idx);                    // frame_num
+  if (is_idr)
+    put_unsigned_golomb(slice, (frame_num / s_gop_size) % 2); // idr_pic_id
+  slice.put_bits(4, (gop_idx * 2) % 16);         // pic_order_cnt_lsb
+  put_rbsp_trailing_bits(slice);
+
+  auto header_size = out.size() + slice.get_buffer()->get_size() + 4;
+  put_nalu(out, slice, frame_size > header_size ? frame_size - header_size : 1, frame_num);
+
+  return out.get();
+}
+
+memory_cptr
+hevc_frame(unsigned int frame_num,
+           std::size_t frame_size) {
+  buffer_c out;
+  auto gop_idx = frame_num % s_gop_size;
+  auto is_idr  = !gop_idx;
+
+  auto put_nalu_header = [](bit_writer_c &w, unsigned int type) {
+    w.put_bit(0);                     // forbidden_zero_bit
+    w.put_bits(6, type);              // nal_unit_type
+    w.put_bits(6, 0);                 // nuh_layer_id
+    w.put_bits(3, 1);                 // nuh_temporal_id_plus1
+  };
+
+  auto put_profile_tier_level = [](bit_writer_c &w) {
+    w.put_bits(2, 0);                 // general_profile_space
+    w.put_bit(0);                     // general_tier_flag
+    w.put_bits(5, 1);                 // general_profile_idc: Main
+    w.put_bits(32, 0x60000000);       // general_profile_compatibility_flag[]
+    w.put_bits(4, 0b1001);            // progressive_source, interlaced_source, non_packed_constraint, frame_only_constraint
+    w.put_bits(44, 0);                // general_reserved_zero_44bits
+    w.put_bits(8, 93);                // general_level_idc
+  };
+
+  if (is_idr) {
+    auto vps = bit_writer_c{};
+    put_nalu_header(vps, 32);
+    vps.put_bits(4, 0);               // vps_video_parameter_set_id
+    vps.put_bits(2, 3);               // vps_reserved_three_2bits
+    vps.put_bits(6, 0);               // vps_max_layers_minus1
+    vps.put_bits(3, 0);               // vps_max_sub_layers_minus1
+    vps.put_bit(1);                   // vps_temporal_id_nesting_flag
+    vps.put_bits(16, 0xffff);         // vps_reserved_0xffff_16bits
+    put_profile_tier_level(vps);
+    vps.put_bit(1);                   // vps_sub_layer_ordering_info_present_flag
+    put_unsigned_golomb(vps, 1);      // vps_max_dec_pic_buffering_minus1
+    put_unsigned_golomb(vps, 0);      // vps_max_num_reorder_pics
+    put_unsigned_golomb(vps, 0);      // vps_max_latency_increase_plus1
+    vps.put_bits(6, 0);               // vps_max_layer_id
+    put_unsigned_golomb(vps, 0);      // vps_num_layer_sets_minus1
+    vps.put_bit(0);                   // vps_timing_info_present_flag
+    vps.put_bit(0);                   // vps_extension_flag
+    put_rbsp_trailing_bits(vps);
+    put_nalu(out, vps, 0, 0);
+
+    auto sps = bit_writer_c{};
+    put_nalu_header(sps, 33);
+    sps.put_bits(4, 0);               // sps_video_parameter_set_id
+    sps.put_bits(3, 0);               // sps_max_sub_layers_minus1
+    sps.put_bit(1);                   // sps_temporal_id_nesting_flag
+    put_profile_tier_level(sps);
+    put_unsigned_golomb(sps, 0);      // sps_seq_parameter_set_id
+    put_unsigned_golomb(sps, 1);      // chroma_format_idc: 4:2:0
+    put_unsigned_golomb(sps, 1280);   // pic_width_in_luma_samples
+    put_unsigned_golomb(sps, 720);    // pic_height_in_luma_samples
+    sps.put_bit(0);                   // conformance_window_flag
+    put_unsigned_golomb(sps, 0);      // bit_depth_luma_minus8
+    put_unsigned_golomb(sps, 0);      // bit_depth_chroma_minus8
+    put_unsigned_golomb(sps, 4);      // log2_max_pic_order_cnt_lsb_minus4
+    sps.put_bit(1);                   // sps_sub_layer_ordering_info_present_flag
+    put_unsigned_golomb(sps, 1);      // sps_max_dec_pic_buffering_minus1
+    put_unsigned_golomb(sps, 0);      // sps_max_num_reorder_pics
+    put_unsigned_golomb(sps, 0);      // sps_max_latency_increase_plus1
+    put_unsigned_golomb(sps, 0);      // log2_min_luma_coding_block_size_minus3
+    put_unsigned_golomb(sps, 3);      // log2_diff_max_min_luma_coding_block_size
+    put_unsigned_golomb(sps, 0);      // log2_min_transform_block_size_minus2
+    put_unsigned_golomb(sps, 3);      // log2_diff_max_min_transform_block_size
+    put_unsigned_golomb(sps, 0);      // max_transform_hierarchy_depth_inter
+    put_unsigned_golomb(sps, 0);      // max_transform_hierarchy_depth_intra
+    sps.put_bits(4, 0);               // scaling_list_enabled_flag, amp_enabled_flag, sample_adaptive_offset_enabled_flag, pcm_enabled_flag
+    put_unsigned_golomb(sps, 0);      // num_short_term_ref_pic_sets
+    sps.put_bits(5, 0);               // long_term_ref_pics_present_flag, sps_temporal_mvp_enabled_flag, strong_intra_smoothing_enabled_flag, vui_parameters_present_flag, sps_extension_flag
+    put_rbsp_trailing_bits(sps);
+    put_nalu(out, sps, 0, 0);
+
+    auto pps = bit_writer_c{};
+    put_nalu_header(pps, 34);
+    put_unsigned_golomb(pps, 0);      // pps_pic_parameter_set_id
+    put_unsigned_golomb(pps, 0);      // pps_seq_parameter_set_id
+    pps.put_bits(5, 0);               // dependent_slice_segments_enabled_flag, output_flag_present_flag, num_extra_slice_header_bits
+    put_rbsp_trailing_bits(pps);
+    put_nalu(out, pps, 0, 0);
+  }
+
+  auto slice = bit_writer_c{};
+  put_nalu_header(slice, is_idr ? 19 : 1); // IDR_W_RADL or TRAIL_R
+  slice.put_bit(1);                        // first_slice_segment_in_pic_flag
+  if (is_idr)
+    slice.put_bit(0);                      // no_output_of_prior_pics_flag
+  put_unsigned_golomb(slice, 0);           // slice_pic_parameter_set_id
+  put_unsigned_golomb(slice, is_idr ? 2 : 1); // slice_type: I or P
+  if (!is_idr)
+    slice.put_bits(8, gop_idx);            // slice_pic_order_cnt_lsb
+  put_rbsp_trailing_bits(slice);
+
+  auto header_size = out.size() + slice.get_buffer()->get_size() + 4;
+  put_nalu(out, slice, frame_size > header_size ? frame_size - header_size : 1, frame_num);
+
+  return out.get();
+}
+
+memory_cptr
+vc1_frame(unsigned int frame_num,
+          std::size_t frame_size) {
+  buffer_c out;
+  auto is_key = !(frame_num % s_gop_size);
+
+  auto put_packet = [&out](uint32_t marker, bit_writer_c &w, std::size_t payload_size, uint32_t seed) {
+    out.out().write_uint32_be(marker);
+    out.out().write(w.get_buffer());
+    if (payload_size)
+      out.out().write(filler(payload_size, seed));
+  };
+
+  if (is_key) {
+    // Advanced profile, 1280x720, 25 FPS
+    auto seqhdr = bit_writer_c{};
+    seqhdr.put_bits(2, 3);            // profile: advanced
+    seqhdr.put_bits(3, 2);            // level
+    seqhdr.put_bits(2, 1);            // chroma format: 4:2:0
+    seqhdr.put_bits(3 + 5 + 1, 0);    // frame & bit rate quantizer, postproc flag
+    seqhdr.put_bits(12, 1280 / 2 - 1);
+    seqhdr.put_bits(12, 720 / 2 - 1);
+    seqhdr.put_bits(4, 0);            // pulldown, interlace, tfcntr, finterp
+    seqhdr.put_bit(1);                // reserved
+    seqhdr.put_bit(0);                // psf
+    seqhdr.put_bit(1);                // display_ext
+    seqhdr.put_bits(14, 1280 - 1);
+    seqhdr.put_bits(14, 720 - 1);
+    seqhdr.put_bit(0);                // aspect_ratio_flag
+    seqhdr.put_bit(1);                // framerate_flag
+    seqhdr.put_bit(0);                // framerateind
+    seqhdr.put_bits(8, 2);            // frameratenr: 25
+    seqhdr.put_bits(4, 1);            // frameratedr: 1000
+    seqhdr.put_bit(0);                // color_format_flag
+    seqhdr.put_bit(0);                // hrd_param_flag
+    put_rbsp_trailing_bits(seqhdr);
+    put_packet(0x0000010f, seqhdr, 0, 0);
+
+    auto entrypoint = bit_writer_c{};
+    entrypoint.put_bits(13, 0b0100100001000); // broken_link ... quantizer; closed_entry, loopfilter & vstransform set
+    entrypoint.put_bits(3, 0);                // coded_size_flag, range_mapy_flag, range_mapuv_flag
+    put_rbsp_trailing_bits(entrypoint);
+    put_packet(0x0000010e, entrypoint, 0, 0);
+  }
+
+  auto frame = bit_writer_c{};
+  if (is_key)
+    frame.put_bits(3, 0b110);         // ptype: I
+  else
+    frame.put_bit(0);                 // ptype: P
+  put_rbsp_trailing_bits(frame);
+
+  auto header_size = out.size() + frame.get_buffer()->get_size() + 4;
+  put_packet(0x0000010d, frame, frame_size > header_size ? frame_size - header_size : 1, frame_num);
+
+  return out.get();
+}
+
+memory_cptr
+dts_frame(unsigned int frame_num) {
+  // 5.1 channels, 48 kHz, 768 kbit/s, 512 samples
+  auto const frame_size = 1024u;
+  auto w                = bit_writer_c{};
+
+  w.put_bits(32, 0x7ffe8001);         // sync word
+  w.put_bit(1);                       // frame type: normal
+  w.put_bits(5, 31);                  // deficit sample count
+  w.put_bit(0);                       // CRC present
+  w.put_bits(7, 16 - 1);              // number of PCM sample blocks
+  w.put_bits(14, frame_size - 1);
+  w.put_bits(6, 9);                   // audio channel arrangement: 3/2
+  w.put_bits(4, 13);                  // core sampling frequency: 48 kHz
+  w.put_bits(5, 15);                  // transmission bit rate: 768 kbit/s
+  w.put_bits(5, 0);                   // down mix, dynamic range, time stamp, auxiliary data, HDCD
+  w.put_bits(3, 0);                   // extension audio descriptor
+  w.put_bits(2, 0);                   // extended coding, audio sync word insertion
+  w.put_bits(2, 1);                   // LFE
+  w.put_bits(2, 0);                   // predictor history, multirate interpolator
+  w.put_bits(4, 7);                   // encoder software revision
+  w.put_bits(2, 0);                   // copy history
+  w.put_bits(3, 0);                   // source PCM resolution: 16 bits
+  w.put_bits(2, 0);                   // front & surround sum/difference
+  w.put_bits(4, 0);                   // dialog normalization
+  w.byte_align();
+
+  auto header = w.get_buffer();
+  buffer_c out;
+
+  out.out().write(header);
+  // Restricting the filler to 0x01 - 0x3f avoids all DTS sync words.
+  out.out().write(filler(frame_size - header->get_size(), frame_num, 0x01, 0x3f));
+
+  return out.get();
+}
+
+memory_cptr
+aac_frame(unsigned int frame_num,
+          std::size_t frame_size,
+          bool with_adts_header) {
+  buffer_c out;
+
+  if (with_adts_header) {
+    auto w = bit_writer_c{};
+
+    w.put_bits(12, 0xfff);            // sync word
+    w.put_bit(0);                     // ID: MPEG-4
+    w.put_bits(2, 0);                 // layer
+    w.put_bit(1);                     // protection absent
+    w.put_bits(2, 1);                 // profile: LC
+    w.put_bits(4, 3);                 // sampling frequency index: 48 kHz
+    w.put_bit(0);                     // private
+    w.put_bits(3, 2);                 // channel configuration
+    w.put_bits(4, 0);                 // original/copy, home, copyright ID bit & start
+    w.put_bits(13, frame_size);
+    w.put_bits(11, 0x7ff);            // buffer fullness
+    w.put_bits(2, 0);                 // number of raw data blocks - 1
+
+    auto header = w.get_buffer();
+    out.out().write(header);
+    frame_size -= header->get_size();
+  }
+
+  out.out().write(filler(frame_size, frame_num));
+
+  return out.get();
+}
+
+std::size_t
+aac_frame_size(unsigned int frame_num) {
+  return 300 + (frame_num * 37) % 100;
+}
+
+memory_cptr
+concatenate(std::function<memory_cptr(unsigned int)> const &generator,
+            unsigned int num_frames) {
+  buffer_c out;
+
+  for (auto frame_num = 0u; frame_num < num_frames; ++frame_num)
+    out.out().write(generator(frame_num));
+
+  return out.get();
+}
+
+// Splits a PES packet into transport stream packets.
+void
+put_ts_packets(buffer_c &out,
+               unsigned int pid,
+               unsigned int &continuity_counter,
+               unsigned char const *ptr,
+               std::size_t remaining) {
+  auto first = true;
+
+  while (remaining) {
+    unsigned char packet[188];
+    auto num_bytes = std::min<std::size_t>(remaining, 184);
+    auto stuffing  = 184 - num_bytes;
+
+    packet[0] = 0x47;
+    packet[1] = (first ? 0x40 : 0x00) | ((pid >> 8) & 0x1f);
+    packet[2] = pid & 0xff;
+    packet[3] = (stuffing ? 0x30 : 0x10) | (continuity_counter & 0x0f);
+
+    if (stuffing) {
+      // Adaptation field for stuffing
+      packet[4] = stuffing - 1;
+      if (1 < stuffing) {
+        packet[5] = 0x00;
+        std::memset(&packet[6], 0xff, stuffing - 2);
+      }
+    }
+
+    std::memcpy(&packet[4 + stuffing], ptr, num_bytes);
+    out.out().write(packet, 188);
+
+    ptr                += num_bytes;
+    remaining          -= num_bytes;
+    first               = false;
+    continuity_counter  = (continuity_counter + 1) & 0x0f;
+  }
+}
+
+void
+put_psi_section(buffer_c &out,
+                unsigned int pid,
+                unsigned int &continuity_counter,
+                std::vector<unsigned char> section) {
+  // section_length covers everything after the length field
+  // including the CRC.
+  auto section_length = section.size() - 3 + 4;
+  section[1]          = 0xb0 | ((section_length >> 8) & 0x0f);
+  section[2]          = section_length & 0xff;
+
+  auto crc = mtx::bswap_32(mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::crc32_ieee, section.data(), section.size(), 0xffffffff));
+  for (auto shift = 24; shift >= 0; shift -= 8)
+    section.push_back((crc >> shift) & 0xff);
+
+  // pointer_field, then stuffing up to the end of the packet
+  section.insert(section.begin(), 0x00);
+  section.resize(184, 0xff);
+
+  put_ts_packets(out, pid, continuity_counter, section.data(), section.size());
+}
+
+memory_cptr
+pes_packet(unsigned int stream_id,
+           uint64_t pts,
+           memory_c const &payload) {
+  buffer_c out;
+  auto pes_length  = payload.get_size() + 8;
+
+  out.out().write_uint32_be(0x00000100 | stream_id);
+  out.out().write_uint16_be(pes_length <= 0xffff ? pes_length : 0);
+  out.out().write_uint8(0x80);        // marker bits
+  out.out().write_uint8(0x80);        // PTS present
+  out.out().write_uint8(5);           // PES header data length
+  out.out().write_uint8(0x21 | ((pts >> 29) & 0x0e));
+  out.out().write_uint16_be(0x0001 | ((pts >> 14) & 0xfffe));
+  out.out().write_uint16_be(0x0001 | ((pts <<  1) & 0xfffe));
+  out.out().write(payload.get_buffer(), payload.get_size());
+
+  return out.get();
+}
+
+} // anonymous namespace
+
+memory_cptr
+random_data(std::size_t size,
+            uint32_t seed) {
+  return filler(size, seed, 0x00, 0xff);
+}
+
+memory_cptr
+avc_es(unsigned int num_frames,
+       std::size_t frame_size) {
+  return concatenate([frame_size](unsigned int frame_num) { return avc_frame(frame_num, frame_size); }, num_frames);
+}
+
+memory_cptr
+hevc_es(unsigned int num_frames,
+        std::size_t frame_size) {
+  return concatenate([frame_size](unsigned int frame_num) { return hevc_frame(frame_num, frame_size); }, num_frames);
+}
+
+memory_cptr
+vc1_es(unsigned int num_frames,
+       std::size_t frame_size) {
+  return concatenate([frame_size](unsigned int frame_num) { return vc1_frame(frame_num, frame_size); }, num_frames);
+}
+
+memory_cptr
+dts(unsigned int num_frames) {
+  return concatenate(dts_frame, num_frames);
+}
+
+memory_cptr
+aac_adts(unsigned int num_frames,
+         std::size_t frame_size) {
+  return concatenate([frame_size](unsigned int frame_num) { return aac_frame(frame_num, frame_size, true); }, num_frames);
+}
+
+memory_cptr
+mpeg_ts(unsigned int num_video_frames) {
+  auto const pmt_pid   = 0x0100u;
+  auto const video_pid = 0x1011u;
+  auto const audio_pid = 0x1100u;
+
+  buffer_c out;
+  auto audio_frame_num = 0u;
+  unsigned int pat_cc{}, pmt_cc{}, video_cc{}, audio_cc{};
+
+  for (auto frame_num = 0u; frame_num < num_video_frames; ++frame_num) {
+    if (!(frame_num % s_gop_size)) {
+      put_psi_section(out, 0x0000, pat_cc, {
+        0x00, 0x00, 0x00,                                      // table ID, section length
+        0x00, 0x01, 0xc1, 0x00, 0x00,                          // transport stream ID, version, section numbers
+        0x00, 0x01, static_cast<unsigned char>(0xe0 | (pmt_pid >> 8)), static_cast<unsigned char>(pmt_pid & 0xff),
+      });
+
+      put_psi_section(out, pmt_pid, pmt_cc, {
+        0x02, 0x00, 0x00,                                      // table ID, section length
+        0x00, 0x01, 0xc1, 0x00, 0x00,                          // program number, version, section numbers
+        static_cast<unsigned char>(0xe0 | (video_pid >> 8)), static_cast<unsigned char>(video_pid & 0xff), // PCR PID
+        0xf0, 0x00,                                            // program info length
+        0x1b, static_cast<unsigned char>(0xe0 | (video_pid >> 8)), static_cast<unsigned char>(video_pid & 0xff), 0xf0, 0x00,
+        0x0f, static_cast<unsigned char>(0xe0 | (audio_pid >> 8)), static_cast<unsigned char>(audio_pid & 0xff), 0xf0, 0x00,
+      });
+    }
+
+    // 25 FPS video, 48 kHz audio with 1024 samples per frame
+    auto video_pts = 90000ull + frame_num * 3600;
+    auto video_pes = pes_packet(0xe0, video_pts, *avc_frame(frame_num, 20000));
+    put_ts_packets(out, video_pid, video_cc, video_pes->get_buffer(), video_pes->get_size());
+
+    while (true) {
+      auto audio_pts = 90000ull + audio_frame_num * 1024 * 90000 / 48000;
+      if (audio_pts > video_pts)
+        break;
+
+      auto audio_pes = pes_packet(0xc0, audio_pts, *aac_frame(audio_frame_num, aac_frame_size(audio_frame_num), true));
+      put_ts_packets(out, audio_pid, audio_cc, audio_pes->get_buffer(), audio_pes->get_size());
+      ++audio_frame_num;
+    }
+  }
+
+  return out.get();
+}
+
+memory_cptr
+mp4(unsigned int num_frames) {
+  auto const sample_rate       = 48000u;
+  auto const samples_per_frame = 1024u;
+  auto const frames_per_chunk  = 16u;
+  auto duration                = num_frames * samples_per_frame;
+  buffer_c out;
+  auto &o                      = out.out();
+  auto chunk_offsets           = std::vector<uint64_t>{};
+
+  out.start_atom("ftyp");
+  o.write("isom", 4);
+  o.write_uint32_be(0x200);
+  o.write("isommp41", 8);
+  out.end_atom();
+
+  out.start_atom("mdat");
+  for (auto frame_num = 0u; frame_num < num_frames; ++frame_num) {
+    if (!(frame_num % frames_per_chunk))
+      chunk_offsets.push_back(out.size());
+    o.write(aac_frame(frame_num, aac_frame_size(frame_num), false));
+  }
+  out.end_atom();
+
+  auto put_matrix = [&o]() {
+    for (auto value : std::vector<uint32_t>{ 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 })
+      o.write_uint32_be(value);
+  };
+
+  out.start_atom("moov");
+
+  out.start_full_atom("mvhd", 0, 0);
+  o.write_uint32_be(0);               // creation time
+  o.write_uint32_be(0);               // modification time
+  o.write_uint32_be(sample_rate);     // time scale
+  o.write_uint32_be(duration);
+  o.write_uint32_be(0x00010000);      // rate
+  o.write_uint16_be(0x0100);          // volume
+  out.zeros(10);
+  put_matrix();
+  out.zeros(24);
+  o.write_uint32_be(2);               // next track ID
+  out.end_atom();
+
+  out.start_atom("trak");
+
+  out.start_full_atom("tkhd", 0, 7);
+  o.write_uint32_be(0);               // creation time
+  o.write_uint32_be(0);               // modification time
+  o.write_uint32_be(1);               // track ID
+  out.zeros(4);
+  o.write_uint32_be(duration);
+  out.zeros(8 + 2 + 2);               // reserved, layer, alternate group
+  o.write_uint16_be(0x0100);          // volume
+  out.zeros(2);
+  put_matrix();
+  out.zeros(4 + 4);                   // width, height
+  out.end_atom();
+
+  out.start_atom("mdia");
+
+  out.start_full_atom("mdhd", 0, 0);
+  o.write_uint32_be(0);               // creation time
+  o.write_uint32_be(0);               // modification time
+  o.write_uint32_be(sample_rate);     // time scale
+  o.write_uint32_be(duration);
+  o.write_uint16_be(0x55c4);          // language: und
+  o.write_uint16_be(0);
+  out.end_atom();
+
+  out.start_full_atom("hdlr", 0, 0);
+  o.write_uint32_be(0);
+  o.write("soun", 4);
+  out.zeros(12);
+  o.write("SoundHandler", 13);
+  out.end_atom();
+
+  out.start_atom("minf");
+
+  out.start_full_atom("smhd", 0, 0);
+  out.zeros(4);
+  out.end_atom();
+
+  out.start_atom("dinf");
+  out.start_full_atom("dref", 0, 0);
+  o.write_uint32_be(1);
+  out.start_full_atom("url ", 0, 1);
+  out.end_atom();
+  out.end_atom();
+  out.end_atom();
+
+  out.start_atom("stbl");
+
+  out.start_full_atom("stsd", 0, 0);
+  o.write_uint32_be(1);
+  out.start_atom("mp4a");
+  out.zeros(6);
+  o.write_uint16_be(1);               // data reference index
+  out.zeros(8);
+  o.write_uint16_be(2);               // channels
+  o.write_uint16_be(16);              // sample size
+  out.zeros(4);
+  o.write_uint32_be(sample_rate << 16);
+
+  out.start_full_atom("esds", 0, 0);
+  static unsigned char const s_es_descriptor[] = {
+    0x03, 0x19, 0x00, 0x01, 0x00,     // ES descriptor: length, ES ID, flags
+    0x04, 0x11, 0x40, 0x15,           // decoder config descriptor: length, object type (AAC), stream type (audio)
+    0x00, 0x06, 0x00,                 // buffer size
+    0x00, 0x02, 0x00, 0x00,           // max bit rate
+    0x00, 0x02, 0x00, 0x00,           // average bit rate
+    0x05, 0x02, 0x11, 0x90,           // decoder specific info: AAC LC, 48 kHz, 2 channels
+    0x06, 0x01, 0x02,                 // SL config descriptor
+  };
+  o.write(s_es_descriptor, sizeof(s_es_descriptor));
+  out.end_atom();
+
+  out.end_atom();                     // mp4a
+  out.end_atom();                     // stsd
+
+  out.start_full_atom("stts", 0, 0);
+  o.write_uint32_be(1);
+  o.write_uint32_be(num_frames);
+  o.write_uint32_be(samples_per_frame);
+  out.end_atom();
+
+  auto num_in_last_chunk = num_frames % frames_per_chunk;
+
+  out.start_full_atom("stsc", 0, 0);
+  o.write_uint32_be(num_in_last_chunk ? 2 : 1);
+  o.write_uint32_be(1);
+  o.write_uint32_be(frames_per_chunk);
+  o.write_uint32_be(1);
+  if (num_in_last_chunk) {
+    o.write_uint32_be(chunk_offsets.size());
+    o.write_uint32_be(num_in_last_chunk);
+    o.write_uint32_be(1);
+  }
+  out.end_atom();
+
+  out.start_full_atom("stsz", 0, 0);
+  o.write_uint32_be(0);
+  o.write_uint32_be(num_frames);
+  for (auto frame_num = 0u; frame_num < num_frames; ++frame_num)
+    o.write_uint32_be(aac_frame_size(frame_num));
+  out.end_atom();
+
+  out.start_full_atom("stco", 0, 0);
+  o.write_uint32_be(chunk_offsets.size());
+  for (auto offset : chunk_offsets)
+    o.write_uint32_be(offset);
+  out.end_atom();
+
+  out.end_atom();                     // stbl
+  out.end_atom();                     // minf
+  out.end_atom();                     // mdia
+  out.end_atom();                     // trak
+  out.end_atom();                     // moov
+
+  return out.get();
+}
+
+bool
+file(std::string const &type,
+     std::string const &file_name) {
+  auto content = type == "avc"  ? avc_es(2500, 20000)
+               : type == "hevc" ? hevc_es(2500, 20000)
+               : type == "vc1"  ? vc1_es(2500, 20000)
+               : type == "dts"  ? dts(10000)
+               : type == "aac"  ? aac_adts(10000, 400)
+               : type == "ts"   ? mpeg_ts(2500)
+               : type == "mp4"  ? mp4(10000)
+               :                  memory_cptr{};
+
+  if (!content)
+    return false;
+
+  mm_file_io_c out{file_name, MODE_CREATE};
+  out.write(content);
+
+  return true;
+}
+
+}}
@@ -0,0 +1,58 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   generators for synthetic benchmark input
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#ifndef MTX_TESTS_BENCH_GENERATORS_H
+#define MTX_TESTS_BENCH_GENERATORS_H
+
+#include "common/common_pch.h"
+
+namespace mtxbench { namespace generate {
+
+/* All generators are deterministic. The streams they create are
+   syntactically valid as far as mkvtoolnix' parsers are concerned:
+   parameter sets, frame & slice headers are complete, but the payload
+   is filler that cannot be decoded. The payload never contains start
+   codes or sync words.
+*/
+
+// Pseudo random bytes.
+memory_cptr random_data(std::size_t size, uint32_t seed = 0);
+
+// h.264 elementary stream, 8 frames per GOP, 25 FPS
+memory_cptr avc_es(unsigned int num_frames, std::size_t frame_size);
+
+// h.265 elementary stream, 8 frames per GOP, 25 FPS
+memory_cptr hevc_es(unsigned int num_frames, std::size_t frame_size);
+
+// VC-1 advanced profile elementary stream, 8 frames per GOP
+memory_cptr vc1_es(unsigned int num_frames, std::size_t frame_size);
+
+// DTS core audio, 48 kHz, 512 samples per frame
+memory_cptr dts(unsigned int num_frames);
+
+// AAC LC in ADTS, 48 kHz stereo, 1024 samples per frame
+memory_cptr aac_adts(unsigned int num_frames, std::size_t frame_size);
+
+// MPEG transport stream with one h.264 and one AAC track
+memory_cptr mpeg_ts(unsigned int num_video_frames);
+
+// MP4 file with one AAC track
+memory_cptr mp4(unsigned int num_frames);
+
+// Writes one of the above to a file. 'type' is one of "avc", "hevc",
+// "vc1", "dts", "aac", "ts" and "mp4". Returns false for unknown types.
+bool file(std::string const &type, std::string const &file_name);
+
+}}
+
+#endif // MTX_TESTS_BENCH_GENERATORS_H
@@ -0,0 +1,104 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   macro benchmarks running mkvmerge on generated files
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "tests/bench/benchmark.h"
+#include "tests/bench/generators.h"
+
+using namespace mtxbench;
+
+namespace {
+
+std::string
+work_file(std::string const &name) {
+  return (bfs::path{g_options.m_work_dir} / name).string();
+}
+
+void
+run_mkvmerge(std::string const &arguments) {
+  auto command = (boost::format("\"%1%\" -q %2%") % g_options.m_mkvmerge % arguments).str();
+  auto result  = std::system(command.c_str());
+
+  // mkvmerge exits with 1 if only warnings were emitted. On POSIX
+  // systems the exit code is returned in the second byte.
+  if ((0 != result) && (1 != result) && ((1 << 8) != result))
+    mxerror(boost::format("Running '%1%' failed with status %2%.\n") % command % result);
+}
+
+// Input files are generated when they're needed the first time and
+// reused for all iterations.
+std::string const &
+input_file(std::string const &type) {
+  static std::map<std::string, std::string> s_file_names;
+
+  auto &file_name = s_file_names[type];
+  if (!file_name.empty())
+    return file_name;
+
+  file_name = work_file("input." + type);
+
+  // The Matroska file is created by muxing the transport stream so
+  // that it contains both a video and an audio track.
+  if (type == "mkv")
+    run_mkvmerge((boost::format("-o \"%1%\" \"%2%\"") % file_name % input_file("ts")).str());
+
+  else if (!mtxbench::generate::file(type, file_name))
+    mxerror(boost::format("Unknown input type '%1%'.\n") % type);
+
+  return file_name;
+}
+
+uint64_t
+mux(std::string const &type) {
+  auto const &source = input_file(type);
+  run_mkvmerge((boost::format("-o \"%1%\" \"%2%\"") % work_file("output.mkv") % source).str());
+
+  return bfs::file_size(source);
+}
+
+} // anonymous namespace
+
+// Elementary stream readers
+MTXBENCH_MACRO(mkvmerge, avc_es) {
+  return mux("avc");
+}
+
+MTXBENCH_MACRO(mkvmerge, hevc_es) {
+  return mux("hevc");
+}
+
+MTXBENCH_MACRO(mkvmerge, vc1_es) {
+  return mux("vc1");
+}
+
+MTXBENCH_MACRO(mkvmerge, dts) {
+  return mux("dts");
+}
+
+MTXBENCH_MACRO(mkvmerge, aac) {
+  return mux("aac");
+}
+
+// Container readers
+MTXBENCH_MACRO(mkvmerge, mpeg_ts) {
+  return mux("ts");
+}
+
+MTXBENCH_MACRO(mkvmerge, mp4) {
+  return mux("mp4");
+}
+
+MTXBENCH_MACRO(mkvmerge, matroska) {
+  return mux("mkv");
+}
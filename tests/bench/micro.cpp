@@ -0,0 +1,278 @@
+/*
+   mkvmerge -- utility for splicing together matroska files
+   from component media subtypes
+
+   Distributed under the GPL v2
+   see the file COPYING for details
+   or visit http://www.gnu.org/copyleft/gpl.html
+
+   micro benchmarks for I/O classes, checksums & bitstream parsers
+
+   Written by Moritz Bunkus <moritz@bunkus.org>.
+*/
+
+#include "common/common_pch.h"
+
+#include "common/aac.h"
+#include "common/bit_reader.h"
+#include "common/checksums/base.h"
+#include "common/dts.h"
+#include "common/hevc.h"
+#include "common/mm_io.h"
+#include "common/mm_read_buffer_io.h"
+#include "common/mm_write_buffer_io.h"
+#include "common/mpeg4_p10.h"
+#include "common/vc1.h"
+#include "tests/bench/benchmark.h"
+#include "tests/bench/generators.h"
+
+namespace {
+
+std::size_t const s_chunk_size = 64 * 1024;
+
+memory_cptr const &
+random_input() {
+  static auto s_data = mtxbench::generate::random_data(16 * 1024 * 1024);
+  return s_data;
+}
+
+// Feeds the data to a parser in chunks the way the readers do.
+template<typename Tparser>
+void
+add_in_chunks(Tparser &parser,
+              memory_c const &data) {
+  for (auto offset = 0u, size = static_cast<unsigned int>(data.get_size()); offset < size; offset += s_chunk_size)
+    parser.add_bytes(data.get_buffer() + offset, std::min<std::size_t>(s_chunk_size, size - offset));
+}
+
+// Keeps the compiler from optimizing away calculations whose results
+// aren't used otherwise.
+void
+do_not_optimize(uint64_t value) {
+  static volatile uint64_t s_sink;
+  s_sink = value;
+}
+
+uint64_t
+checksum(mtx::checksum::algorithm_e algorithm) {
+  auto &data = *random_input();
+  do_not_optimize(mtx::checksum::calculate(algorithm, data)->get_buffer()[0]);
+  return data.get_size();
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------
+// I/O
+
+MTXBENCH(io, read_buffer_ts_packets) {
+  auto &data = *random_input();
+  mm_read_buffer_io_c in{new mm_mem_io_c{data}, 128 * 1024};
+  unsigned char packet[188];
+
+  while (in.read(packet, 188) == 188)
+    ;
+
+  return data.get_size();
+}
+
+MTXBENCH(io, read_buffer_uint32) {
+  auto &data = *random_input();
+  mm_read_buffer_io_c in{new mm_mem_io_c{data}};
+  auto num   = data.get_size() / 4;
+  auto sum   = 0u;
+
+  for (auto idx = 0u; idx < num; ++idx)
+    sum += in.read_uint32_be();
+
+  do_not_optimize(sum);
+
+  return data.get_size();
+}
+
+MTXBENCH(io, write_buffer_small_writes) {
+  auto &data = *random_input();
+  mm_write_buffer_io_c out{new mm_null_io_c{"null"}, 128 * 1024};
+
+  for (auto offset = 0u, size = static_cast<unsigned int>(data.get_size()); offset < size; offset += 20)
+    out.write(data.get_buffer() + offset, std::min(20u, size - offset));
+
+  out.flush();
+
+  return data.get_size();
+}
+
+MTXBENCH(io, write_buffer_large_writes) {
+  auto &data = *random_input();
+  mm_write_buffer_io_c out{new mm_null_io_c{"null"}, 128 * 1024};
+
+  for (auto offset = 0u, size = static_cast<unsigned int>(data.get_size()); offset < size; offset += 1024 * 1024)
+    out.write(data.get_buffer() + offset, std::min(1024u * 1024u, size - offset));
+
+  out.flush();
+
+  return data.get_size();
+}
+
+// ---------------------------------------------------------------------
+// Checksums
+
+MTXBENCH(checksum, adler32) {
+  return checksum(mtx::checksum::algorithm_e::adler32);
+}
+
+MTXBENCH(checksum, crc8_atm) {
+  return checksum(mtx::checksum::algorithm_e::crc8_atm);
+}
+
+MTXBENCH(checksum, crc16_ansi) {
+  return checksum(mtx::checksum::algorithm_e::crc16_ansi);
+}
+
+MTXBENCH(checksum, crc32_ieee) {
+  return checksum(mtx::checksum::algorithm_e::crc32_ieee);
+}
+
+MTXBENCH(checksum, crc32_ieee_le) {
+  return checksum(mtx::checksum::algorithm_e::crc32_ieee_le);
+}
+
+MTXBENCH(checksum, md5) {
+  return checksum(mtx::checksum::algorithm_e::md5);
+}
+
+// ---------------------------------------------------------------------
+// Bit reader
+
+MTXBENCH(bit_reader, get_bits) {
+  auto &data = *random_input();
+  auto r     = bit_reader_c{data.get_buffer(), data.get_size()};
+  auto num   = data.get_size() * 8 / 13;
+  auto sum   = 0ull;
+
+  for (auto idx = 0u; idx < num; ++idx)
+    sum += r.get_bits(13);
+
+  do_not_optimize(sum);
+
+  return data.get_size();
+}
+
+MTXBENCH(bit_reader, get_unsigned_golomb) {
+  static auto s_data = mtxbench::generate::avc_es(400, 2000);
+
+  // The slice payload is random, therefore it contains codes of all
+  // lengths.
+  auto r   = bit_reader_c{s_data->get_buffer(), s_data->get_size()};
+  auto sum = 0ull;
+
+  try {
+    while (r.get_remaining_bits() > 64)
+      sum += r.get_unsigned_golomb();
+  } catch (mtx::mm_io::end_of_file_x &) {
+  }
+
+  do_not_optimize(sum);
+
+  return s_data->get_size();
+}
+
+// ---------------------------------------------------------------------
+// Elementary stream parsers
+
+MTXBENCH(parser, avc_es) {
+  static auto s_data = mtxbench::generate::avc_es(500, 20000);
+
+  mpeg4::p10::avc_es_parser_c parser;
+  parser.ignore_nalu_size_length_errors();
+
+  auto drain = [&parser]() {
+    while (parser.frame_available())
+      parser.get_frame();
+  };
+
+  for (auto offset = 0u, size = static_cast<unsigned int>(s_data->get_size()); offset < size; offset += s_chunk_size) {
+    parser.add_bytes(s_data->get_buffer() + offset, std::min<std::size_t>(s_chunk_size, size - offset));
+    drain();
+  }
+
+  parser.flush();
+  drain();
+
+  return s_data->get_size();
+}
+
+MTXBENCH(parser, hevc_es) {
+  static auto s_data = mtxbench::generate::hevc_es(500, 20000);
+
+  mtx::hevc::es_parser_c parser;
+  parser.ignore_nalu_size_length_errors();
+
+  auto drain = [&parser]() {
+    while (parser.frame_available())
+      parser.get_frame();
+  };
+
+  for (auto offset = 0u, size = static_cast<unsigned int>(s_data->get_size()); offset < size; offset += s_chunk_size) {
+    parser.add_bytes(s_data->get_buffer() + offset, std::min<std::size_t>(s_chunk_size, size - offset));
+    drain();
+  }
+
+  parser.flush();
+  drain();
+
+  return s_data->get_size();
+}
+
+MTXBENCH(parser, vc1_es) {
+  static auto s_data = mtxbench::generate::vc1_es(500, 20000);
+
+  mtx::vc1::es_parser_c parser;
+
+  auto drain = [&parser]() {
+    while (parser.is_frame_available())
+      parser.get_frame();
+  };
+
+  for (auto offset = 0u, size = static_cast<unsigned int>(s_data->get_size()); offset < size; offset += s_chunk_size) {
+    parser.add_bytes(s_data->get_buffer() + offset, std::min<std::size_t>(s_chunk_size, size - offset));
+    drain();
+  }
+
+  parser.flush();
+  drain();
+
+  return s_data->get_size();
+}
+
+MTXBENCH(parser, dts) {
+  static auto s_data = mtxbench::generate::dts(5000);
+
+  auto ptr    = s_data->get_buffer();
+  auto size   = s_data->get_size();
+  auto offset = 0u;
+
+  while (offset < size) {
+    mtx::dts::header_t header;
+    auto pos = mtx::dts::find_header(ptr + offset, size - offset, header, true);
+    if (0 > pos)
+      break;
+
+    offset += pos + header.frame_byte_size;
+  }
+
+  return size;
+}
+
+MTXBENCH(parser, aac_adts) {
+  static auto s_data = mtxbench::generate::aac_adts(20000, 400);
+
+  aac::parser_c parser;
+  add_in_chunks(parser, *s_data);
+  parser.flush();
+
+  while (parser.frames_available())
+    parser.get_frame();
+
+  return s_data->get_size();
+}
@@ -0,0 +1,12 @@
+#!/usr/bin/ruby -w
+
+# T_609parallel_reading
+describe "mkvmerge / reading source files in parallel must not change the output"
+
+[ "data/avi/v-h264-aac.avi data/subtitles/srt/vde.srt",
+  "data/mkv/complex.mkv data/mp4/10-DanseMacabreOp.40.m4a",
+  "data/ts/h264_dts_hd_ma_pgsub.m2ts data/vob/video_1.mpg",
+].each do |files|
+  test_merge files
+  test_merge files, :args => "--engage parallel_reading"
+end
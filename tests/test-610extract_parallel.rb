@@ -0,0 +1,13 @@
+#!/usr/bin/ruby -w
+
+# T_610extract_parallel
+describe "mkvextract / extracting tracks in parallel must not change the output"
+
+test_merge "data/avi/v-h264-aac.avi data/subtitles/srt/vde.srt", :keep_tmp => true
+
+{ "sequential" => "", "parallel" => "--parallel" }.each do |name, args|
+  test "#{name} extraction" do
+    extract "#{args} #{tmp}", 0 => "#{tmp}-0", 1 => "#{tmp}-1", 2 => "#{tmp}-2"
+    (0..2).collect { |idx| hash_file "#{tmp}-#{idx}" }.join('+')
+  end
+end
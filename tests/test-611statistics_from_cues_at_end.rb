@@ -0,0 +1,23 @@
+#!/usr/bin/ruby -w
+
+# T_611statistics_from_cues_at_end
+describe "mkvinfo / statistics from cues located after the clusters without a seek head entry for them"
+
+test "data/avi/v-h264-aac.avi" do
+  merge "data/avi/v-h264-aac.avi", :output => "#{tmp}-src"
+
+  # Change the ID in the seek head's entry for the cues so that they
+  # are only found after all clusters have been read.
+  content = IO.binread("#{tmp}-src")
+  content.gsub!("\x53\xAB\x84\x1C\x53\xBB\x6B".force_encoding("BINARY"), "\x53\xAB\x84\x1C\x53\xBB\x6C".force_encoding("BINARY"))
+  IO.binwrite("#{tmp}-src", content)
+
+  info "--statistics #{tmp}-src",           :output => "#{tmp}-1"
+  info "--statistics-from-cues #{tmp}-src", :output => "#{tmp}-2"
+
+  result = (1..2).collect { |idx| hash_file "#{tmp}-#{idx}" }.join('-')
+
+  unlink_tmp_files
+
+  result
+end
@@ -0,0 +1,17 @@
+#!/usr/bin/ruby -w
+
+# T_612extract_range
+describe "mkvextract / extracting a range with and without cues"
+
+[ "", "--no-cues" ].each do |args|
+  test "data/avi/v-h264-aac.avi #{args}".strip do
+    merge "#{args} data/avi/v-h264-aac.avi", :output => "#{tmp}-src"
+    extract "--range 00:00:02-00:00:05 #{tmp}-src", 0 => "#{tmp}-0", 1 => "#{tmp}-1"
+
+    result = (0..1).collect { |idx| hash_file "#{tmp}-#{idx}" }.join('+')
+
+    unlink_tmp_files
+
+    result
+  end
+end
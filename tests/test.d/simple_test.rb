@@ -245,7 +245,7 @@ class SimpleTest
     verbose = !options[:verbose].nil? ? options[:verbose]                             : true
     format  = options[:format]        ? options[:format].to_s.downcase.gsub(/_/, '-') : verbose ? 'verbose-text' : 'text'
 
-    command = "../src/mkvmerge --identify --identification-format #{format} --engage no_variable_data #{args.first}"
+    command = "../src/mkvmerge --identify --identification-format #{format} --no-identification-cache --engage no_variable_data #{args.first}"
 
     self.sys command, :exit_code => options[:exit_code]
   end
@@ -254,7 +254,7 @@ class SimpleTest
     options = args.extract_options!
     fail ArgumentError if args.empty?
 
-    command = "../src/mkvmerge --identify --identification-format json --engage no_variable_data #{args.first}"
+    command = "../src/mkvmerge --identify --identification-format json --no-identification-cache --engage no_variable_data #{args.first}"
 
     output, _ = self.sys(command, :exit_code => options[:exit_code])
 
@@ -304,4 +304,80 @@ TEST(BitReader, ExceptionOnReadingBeyondEOF) {
   EXPECT_THROW(b.get_bytes(target, 2), mtx::mm_io::end_of_file_x);
 }
 
+
+TEST(BitReader, LongUnsignedGolomb) {
+  // 39 zero bits, a one bit and 39 bits of value spanning more than
+  // one refill of the cache
+  unsigned char value[11];
+  std::memset(value, 0, 11);
+  value[4] = 0x01;
+  value[5] = 0x12;
+  value[6] = 0x34;
+  value[7] = 0x56;
+  value[8] = 0x78;
+  value[9] = 0x9a;
+  auto b = bit_reader_c{value, 11};
+
+  EXPECT_EQ((1ull << 39) - 1 + (0x123456789aull >> 1), b.get_unsigned_golomb());
+  EXPECT_EQ(79, b.get_bit_position());
+  EXPECT_EQ( 9, b.get_remaining_bits());
+
+  b = bit_reader_c{value, 4};
+  EXPECT_THROW(b.get_unsigned_golomb(), mtx::mm_io::end_of_file_x);
+  EXPECT_TRUE(b.eof());
+}
+
+TEST(BitReader, GetBitsAcrossCacheRefills) {
+  unsigned char value[24];
+  for (auto idx = 0u; idx < 24; ++idx)
+    value[idx] = idx * 0x25 + 0x13;
+
+  // Compare with reading bit by bit for all possible widths.
+  for (auto width = 1u; width <= 64; ++width) {
+    auto b         = bit_reader_c{value, 24};
+    auto reference = bit_reader_c{value, 24};
+
+    while (b.get_remaining_bits() >= static_cast<int>(width)) {
+      auto expected = uint64_t{};
+      for (auto bit = 0u; bit < width; ++bit)
+        expected = (expected << 1) | reference.get_bit();
+
+      EXPECT_EQ(expected, b.get_bits(width));
+      EXPECT_EQ(reference.get_bit_position(), b.get_bit_position());
+    }
+  }
+
+  auto b = bit_reader_c{value, 24};
+  EXPECT_EQ(0x1338 >> 3, b.get_bits(13));
+  EXPECT_EQ(0x1338 &  7, b.get_bits(3));
+  EXPECT_EQ(get_uint64_be(&value[2]), b.get_bits(64));
+  EXPECT_EQ(get_uint64_be(&value[10]), b.peek_bits(64));
+  EXPECT_EQ(80, b.get_bit_position());
+}
+
+TEST(BitReader, SkipBitsAcrossCacheRefills) {
+  unsigned char value[32];
+  for (auto idx = 0u; idx < 32; ++idx)
+    value[idx] = idx;
+  auto b = bit_reader_c{value, 32};
+
+  EXPECT_EQ(0x00, b.get_bits(4));
+  EXPECT_NO_THROW(b.skip_bits(100));
+  EXPECT_EQ(104, b.get_bit_position());
+  EXPECT_EQ(0x0d, b.get_bits(8));
+
+  EXPECT_NO_THROW(b.skip_bits(3));
+  b.byte_align();
+  EXPECT_EQ(120, b.get_bit_position());
+  EXPECT_EQ(0x0f, b.peek_bits(8));
+
+  EXPECT_NO_THROW(b.skip_bits(136));
+  EXPECT_EQ(0, b.get_remaining_bits());
+  EXPECT_FALSE(b.eof());
+  EXPECT_THROW(b.peek_bits(1), mtx::mm_io::end_of_file_x);
+  EXPECT_FALSE(b.eof());
+  EXPECT_THROW(b.skip_bits(1), mtx::mm_io::end_of_file_x);
+  EXPECT_TRUE(b.eof());
+}
+
 }
@@ -0,0 +1,63 @@
+#include "common/common_pch.h"
+
+#include <random>
+
+#include "common/bswap.h"
+#include "common/cpu_features.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// Swaps buffers of all supported word lengths and of sizes that leave
+// remainders for the scalar code after the SIMD blocks, both into a
+// separate buffer and in place.
+void
+compare_with_naive_swap() {
+  std::mt19937 generator{42};
+
+  for (auto word_length : std::vector<std::size_t>{ 1, 2, 3, 4, 5, 6, 8 })
+    for (auto num_words = 0u; num_words < 200; ++num_words) {
+      auto num_bytes = num_words * word_length;
+      auto src       = std::vector<unsigned char>(num_bytes);
+      auto dst       = std::vector<unsigned char>(num_bytes);
+      auto expected  = std::vector<unsigned char>(num_bytes);
+
+      for (auto &byte : src)
+        byte = generator() & 0xff;
+
+      for (auto word = 0u; word < num_bytes; word += word_length)
+        std::reverse_copy(&src[word], &src[word + word_length], &expected[word]);
+
+      mtx::bswap_buffer(src.data(), dst.data(), num_bytes, word_length);
+      EXPECT_EQ(expected, dst) << "word length " << word_length << " num words " << num_words;
+
+      mtx::bswap_buffer(src.data(), src.data(), num_bytes, word_length);
+      EXPECT_EQ(expected, src) << "in place, word length " << word_length << " num words " << num_words;
+    }
+}
+
+TEST(BSwap, SingleValues) {
+  EXPECT_EQ(0x2301u,               mtx::bswap_16(0x0123u));
+  EXPECT_EQ(0x67452301u,           mtx::bswap_32(0x01234567u));
+  EXPECT_EQ(0xefcdab8967452301ull, mtx::bswap_64(0x0123456789abcdefull));
+}
+
+TEST(BSwap, BufferMatchesNaiveSwap) {
+  compare_with_naive_swap();
+}
+
+TEST(BSwap, BufferWithoutSIMDMatchesNaiveSwap) {
+  mtx::cpu::disable_simd(true);
+  compare_with_naive_swap();
+  mtx::cpu::disable_simd(false);
+}
+
+TEST(BSwap, BufferSizeNotDivisibleByWordLength) {
+  unsigned char buffer[5]{};
+
+  EXPECT_THROW(mtx::bswap_buffer(buffer, buffer, 5, 2), std::invalid_argument);
+  EXPECT_THROW(mtx::bswap_buffer(buffer, buffer, 5, 3), std::invalid_argument);
+}
+
+}
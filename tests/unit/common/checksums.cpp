@@ -1,13 +1,57 @@
 #include "common/common_pch.h"
 
+#include <random>
+
 #include "gtest/gtest.h"
 
 #include "common/checksums/base.h"
+#include "common/cpu_features.h"
 #include "common/mm_io.h"
 #include "tests/unit/util.h"
 
 namespace {
 
+uint32_t
+crc32_ieee_le_bitwise(unsigned char const *buffer,
+                      size_t size,
+                      uint32_t crc) {
+  for (auto idx = 0u; idx < size; ++idx) {
+    crc ^= buffer[idx];
+    for (auto bit = 0u; bit < 8; ++bit)
+      crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+  }
+
+  return crc;
+}
+
+void
+compare_with_byte_by_byte() {
+  std::mt19937 generator{42};
+  std::vector<unsigned char> data(1000);
+  for (auto &byte : data)
+    byte = generator();
+
+  auto algorithms = { mtx::checksum::algorithm_e::crc8_atm,   mtx::checksum::algorithm_e::crc16_ansi,    mtx::checksum::algorithm_e::crc16_ccitt,
+                      mtx::checksum::algorithm_e::crc32_ieee, mtx::checksum::algorithm_e::crc32_ieee_le };
+
+  // Different offsets and sizes cover unaligned data as well as all
+  // combinations of full blocks and remaining bytes.
+  for (auto offset = 0u; offset < 8; ++offset)
+    for (auto size = 0u; size < 300; size += 1 + offset) {
+      auto ptr = &data[offset];
+
+      for (auto algorithm : algorithms) {
+        auto worker = mtx::checksum::for_algorithm(algorithm, 0xffffffff);
+        for (auto idx = 0u; idx < size; ++idx)
+          worker->add(&ptr[idx], 1);
+
+        EXPECT_EQ(dynamic_cast<mtx::checksum::uint_result_c &>(*worker).get_result_as_uint(), mtx::checksum::calculate_as_uint(algorithm, ptr, size, 0xffffffff));
+      }
+
+      EXPECT_EQ(crc32_ieee_le_bitwise(ptr, size, 0xffffffff), mtx::checksum::calculate_as_uint(mtx::checksum::algorithm_e::crc32_ieee_le, ptr, size, 0xffffffff));
+    }
+}
+
 class ChecksumTest: public ::testing::Test {
 public:
   memory_cptr m_data, m_data_md5, m_onetwothree_md5;
@@ -134,4 +178,14 @@ TEST_F(ChecksumTest, FileChunked1000) {
   EXPECT_EQ(*m_data_md5, *calculate_bin(mtx::checksum::algorithm_e::md5,                       1000));
 }
 
+TEST(Checksum, BlockwiseMatchesByteByByte) {
+  compare_with_byte_by_byte();
+}
+
+TEST(Checksum, BlockwiseWithoutSIMDMatchesByteByByte) {
+  mtx::cpu::disable_simd(true);
+  compare_with_byte_by_byte();
+  mtx::cpu::disable_simd(false);
+}
+
 }
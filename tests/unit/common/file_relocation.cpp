@@ -0,0 +1,84 @@
+#include "common/common_pch.h"
+
+#include "common/file_relocation.h"
+#include "common/mm_io.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+class FileRelocation: public ::testing::Test {
+protected:
+  bfs::path m_dir, m_file;
+  std::string m_content;
+
+  virtual void SetUp() override {
+    m_dir  = bfs::temp_directory_path() / bfs::unique_path("mtx-file-relocation-%%%%-%%%%-%%%%");
+    m_file = m_dir / "data.bin";
+
+    bfs::create_directories(m_dir);
+
+    m_content.resize(3 * 65536 + 123);
+    for (auto idx = 0u; idx < m_content.size(); ++idx)
+      m_content[idx] = static_cast<char>((idx * 7 + idx / 251) & 0xff);
+  }
+
+  virtual void TearDown() override {
+    boost::system::error_code ec;
+    bfs::remove_all(m_dir, ec);
+  }
+
+  // Writes the content, extends the file by 'distance' bytes the
+  // same way mkvmerge does, moves everything from 'position' onwards
+  // and returns the file's content afterwards.
+  std::string relocate(uint64_t position,
+                       uint64_t distance) {
+    {
+      mm_file_io_c file{m_file.string(), MODE_CREATE};
+      file.write(m_content);
+      file.write(std::string(distance, '\0'));
+
+      mtx::file::move_towards_end(file, position, m_content.size() - position, distance);
+    }
+
+    auto result = mm_file_io_c::slurp(m_file.string());
+
+    return { reinterpret_cast<char const *>(result->get_buffer()), result->get_size() };
+  }
+
+  void verify(std::string const &result,
+              uint64_t position,
+              uint64_t distance) {
+    ASSERT_EQ(m_content.size() + distance, result.size());
+    EXPECT_TRUE(result.substr(0, position) == m_content.substr(0, position));
+    EXPECT_TRUE(result.substr(position + distance) == m_content.substr(position));
+  }
+};
+
+TEST_F(FileRelocation, ArbitraryDistance) {
+  verify(relocate(1000, 777), 1000, 777);
+}
+
+TEST_F(FileRelocation, PositionZero) {
+  verify(relocate(0, 5000), 0, 5000);
+}
+
+TEST_F(FileRelocation, MultipleOfInsertRangeGranularity) {
+  // Inserts the space with the file system's help if the file system
+  // supports it and copies otherwise. The result must be the same.
+  auto granularity = uint64_t{};
+  {
+    mm_file_io_c file{m_file.string(), MODE_CREATE};
+    granularity = mtx::file::get_insert_range_granularity(file);
+  }
+
+  auto distance = granularity ? 2 * granularity : 8192;
+
+  verify(relocate(12345, distance), 12345, distance);
+}
+
+TEST_F(FileRelocation, NothingToMove) {
+  verify(relocate(m_content.size(), 100), m_content.size(), 100);
+}
+
+}
@@ -0,0 +1,141 @@
+#include "common/common_pch.h"
+
+#include "common/kax_cluster_parser.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+memory_cptr
+make_cluster(std::vector<unsigned char> const &data) {
+  return memory_c::clone(data.data(), data.size());
+}
+
+std::string
+frame_content(memory_cptr const &frame) {
+  return std::string{reinterpret_cast<char const *>(frame->get_buffer()), frame->get_size()};
+}
+
+TEST(KaxClusterParser, SimpleBlocks) {
+  auto cluster = make_cluster({
+    0xe7, 0x82, 0x03, 0xe8,                                     // timestamp 1000
+    0xa3, 0x87, 0x81, 0x00, 0x00, 0x80, 'a', 'b', 'c',          // track 1, +0, keyframe
+    0xec, 0x81, 0x00,                                           // void
+    0xa3, 0x86, 0x82, 0xff, 0xf6, 0x01, 'd', 'e',               // track 2, -10, discardable
+  });
+
+  kax_cluster_parser_c parser;
+
+  ASSERT_TRUE(parser.parse(cluster, 1000000));
+  EXPECT_EQ(1000u, parser.get_timestamp());
+  ASSERT_EQ(2u, parser.get_num_blocks());
+
+  auto const &b1 = parser.get_block(0);
+  EXPECT_TRUE(b1.is_simple_block);
+  EXPECT_EQ(1u, b1.track_number);
+  EXPECT_EQ(1000000000, b1.timestamp);
+  EXPECT_TRUE(b1.is_keyframe);
+  EXPECT_FALSE(b1.is_discardable);
+  ASSERT_EQ(1u, b1.frames.size());
+  EXPECT_EQ("abc", frame_content(b1.frames[0]));
+  EXPECT_TRUE(b1.frames[0]->is_slice());
+
+  auto const &b2 = parser.get_block(1);
+  EXPECT_EQ(2u, b2.track_number);
+  EXPECT_EQ(990000000, b2.timestamp);
+  EXPECT_FALSE(b2.is_keyframe);
+  EXPECT_TRUE(b2.is_discardable);
+  EXPECT_EQ("de", frame_content(b2.frames[0]));
+}
+
+TEST(KaxClusterParser, Lacing) {
+  // Xiph: three frames of 2, 256 and 1 bytes
+  std::vector<unsigned char> data{ 0xa3, 0x41, 0x0b, 0x81, 0x00, 0x00, 0x02, 0x02, 0x02, 0xff, 0x01, 'x', 'y' };
+  data.insert(data.end(), 256, 'z');
+  data.push_back('w');
+
+  std::vector<unsigned char> const other_lacing{
+    // EBML: three frames of 3, 1 and 2 bytes
+    0xa3, 0x8d, 0x81, 0x00, 0x00, 0x06, 0x02, 0x83, 0xbd,
+      'a', 'b', 'c', 'd', 'e', 'f',
+    // Fixed: two frames of 2 bytes
+    0xa3, 0x89, 0x81, 0x00, 0x00, 0x04, 0x01, 'g', 'h', 'i', 'j',
+  };
+  data.insert(data.end(), other_lacing.begin(), other_lacing.end());
+
+  kax_cluster_parser_c parser;
+
+  ASSERT_TRUE(parser.parse(make_cluster(data), 1));
+  ASSERT_EQ(3u, parser.get_num_blocks());
+
+  auto const &xiph = parser.get_block(0).frames;
+  ASSERT_EQ(3u, xiph.size());
+  EXPECT_EQ("xy",                  frame_content(xiph[0]));
+  EXPECT_EQ(std::string(256, 'z'), frame_content(xiph[1]));
+  EXPECT_EQ("w",                   frame_content(xiph[2]));
+
+  auto const &ebml = parser.get_block(1).frames;
+  ASSERT_EQ(3u, ebml.size());
+  EXPECT_EQ("abc", frame_content(ebml[0]));
+  EXPECT_EQ("d",   frame_content(ebml[1]));
+  EXPECT_EQ("ef",  frame_content(ebml[2]));
+
+  auto const &fixed = parser.get_block(2).frames;
+  ASSERT_EQ(2u, fixed.size());
+  EXPECT_EQ("gh", frame_content(fixed[0]));
+  EXPECT_EQ("ij", frame_content(fixed[1]));
+}
+
+TEST(KaxClusterParser, BlockGroups) {
+  auto cluster = make_cluster({
+    0xe7, 0x81, 0x0a,                                           // timestamp 10
+    0xa0, 0x9d,                                                 // block group
+      0xa1, 0x85, 0x81, 0x00, 0x05, 0x00, 'a',                  //   block: track 1, +5
+      0x9b, 0x81, 0x28,                                         //   duration 40
+      0xfb, 0x81, 0xd8,                                         //   reference -40
+      0x75, 0xa2, 0x82, 0x01, 0x00,                             //   discard padding 256
+      0x75, 0xa1, 0x88,                                         //   block additions
+        0xa6, 0x86,                                             //     block more
+          0xee, 0x81, 0x01,                                     //       ID 1
+          0xa5, 0x81, 'z',                                      //       additional
+    0xa0, 0x83, 0x9b, 0x81, 0x01,                               // block group without block
+  });
+
+  kax_cluster_parser_c parser;
+
+  ASSERT_TRUE(parser.parse(cluster, 1000));
+  ASSERT_EQ(1u, parser.get_num_blocks());
+
+  auto const &block = parser.get_block(0);
+  EXPECT_FALSE(block.is_simple_block);
+  EXPECT_EQ(15000, block.timestamp);
+  ASSERT_TRUE(!!block.duration);
+  EXPECT_EQ(40u, *block.duration);
+  ASSERT_EQ(1u, block.references.size());
+  EXPECT_EQ(-40, block.references[0]);
+  ASSERT_TRUE(!!block.discard_padding);
+  EXPECT_EQ(256, *block.discard_padding);
+  ASSERT_EQ(1u, block.additions.size());
+  EXPECT_EQ("z", frame_content(block.additions[0]));
+}
+
+TEST(KaxClusterParser, Unsupported) {
+  kax_cluster_parser_c parser;
+
+  // Encrypted block
+  EXPECT_FALSE(parser.parse(make_cluster({ 0xaf, 0x81, 0x00 }), 1));
+
+  // Block group with unknown size
+  EXPECT_FALSE(parser.parse(make_cluster({ 0xa0, 0xff, 0xa1, 0x84, 0x81, 0x00, 0x00, 0x00 }), 1));
+
+  // Element exceeding the cluster
+  EXPECT_FALSE(parser.parse(make_cluster({ 0xa3, 0x88, 0x81, 0x00, 0x00, 0x00 }), 1));
+
+  // Xiph lace sizes exceeding the block
+  EXPECT_FALSE(parser.parse(make_cluster({ 0xa3, 0x86, 0x81, 0x00, 0x00, 0x02, 0x01, 0x10 }), 1));
+
+  // Fixed lacing with sizes that aren't a multiple of the number of frames
+  EXPECT_FALSE(parser.parse(make_cluster({ 0xa3, 0x88, 0x81, 0x00, 0x00, 0x04, 0x01, 'a', 'b', 'c' }), 1));
+}
+
+}
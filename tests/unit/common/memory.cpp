@@ -1,5 +1,7 @@
 #include "common/common_pch.h"
 
+#include <thread>
+
 #include "common/memory.h"
 
 #include "gtest/gtest.h"
@@ -30,4 +32,202 @@ TEST(Memory, OperatorNotEq) {
   EXPECT_TRUE(*m1 != "world");
 }
 
+TEST(Memory, ResizePooled) {
+  auto m = memory_c::alloc(100);
+  std::memset(m->get_buffer(), 42, 100);
+
+  m->resize(120);
+  EXPECT_EQ(120u, m->get_size());
+  EXPECT_EQ(42, m->get_buffer()[99]);
+
+  m->resize(100000);
+  EXPECT_EQ(100000u, m->get_size());
+  EXPECT_EQ(42, m->get_buffer()[0]);
+  EXPECT_EQ(42, m->get_buffer()[99]);
+
+  m->resize(10);
+  EXPECT_EQ(10u, m->get_size());
+  EXPECT_EQ(42, m->get_buffer()[9]);
+}
+
+TEST(Memory, LockPooled) {
+  auto m = memory_c::clone("hello world");
+  m->set_offset(6);
+  m->lock();
+
+  // The caller owns the buffer now.
+  auto buffer = m->get_buffer();
+  EXPECT_EQ(5u, m->get_size());
+  EXPECT_EQ(0, std::memcmp(buffer, "world", 5));
+
+  m.reset();
+  free(buffer);
+}
+
+TEST(Memory, PoolReleaseCachedBlocks) {
+  mtx::mem::pool_c::release_cached_blocks();
+
+  auto capacity = std::size_t{};
+  auto block    = mtx::mem::pool_c::allocate(1000, capacity);
+  ASSERT_NE(nullptr, block);
+
+  mtx::mem::pool_c::release(block, capacity);
+  EXPECT_EQ(capacity, mtx::mem::pool_c::get_cached_size());
+
+  mtx::mem::pool_c::release_cached_blocks();
+  EXPECT_EQ(0u, mtx::mem::pool_c::get_cached_size());
+}
+
+TEST(Memory, PoolLimitsTotalCachedSize) {
+  mtx::mem::pool_c::release_cached_blocks();
+
+  // Enough blocks to fill six size classes to their own limit.
+  auto blocks = std::vector<std::pair<void *, std::size_t>>{};
+
+  for (auto size : { 1280, 1536, 1792, 2048, 2560, 3072 }) {
+    auto capacity = std::size_t{};
+    auto num      = (16 * 1024 + size - 1) / size;
+
+    for (auto idx = 0; idx < num; ++idx) {
+      auto block = mtx::mem::pool_c::allocate(size * 1024, capacity);
+      ASSERT_NE(nullptr, block);
+      blocks.emplace_back(block, capacity);
+    }
+  }
+
+  for (auto const &block : blocks)
+    mtx::mem::pool_c::release(block.first, block.second);
+
+  EXPECT_GT(mtx::mem::pool_c::get_cached_size(), 0u);
+  EXPECT_LE(mtx::mem::pool_c::get_cached_size(), 64u * 1024 * 1024);
+
+  mtx::mem::pool_c::release_cached_blocks();
+  EXPECT_EQ(0u, mtx::mem::pool_c::get_cached_size());
+}
+
+TEST(Memory, CloneNullptr) {
+  auto m = memory_c::clone(nullptr, 10);
+
+  EXPECT_FALSE(m->is_allocated());
+  EXPECT_EQ(0u, m->get_size());
+}
+
+TEST(Memory, Slice) {
+  auto backing = memory_c::clone("hello world");
+  auto slice   = memory_c::slice(backing, 6, 5);
+
+  EXPECT_TRUE(slice->is_slice());
+  EXPECT_EQ(backing->get_buffer() + 6, slice->get_buffer());
+  EXPECT_TRUE(*slice == "world");
+
+  // Slices have their own offsets.
+  slice->set_offset(1);
+  EXPECT_TRUE(*slice == "orld");
+  EXPECT_TRUE(*backing == "hello world");
+
+  // The slice keeps the backing buffer alive. Grabbing doesn't copy
+  // as the backing owns its buffer.
+  auto buffer = slice->get_buffer();
+  backing.reset();
+  slice->grab();
+  EXPECT_EQ(buffer, slice->get_buffer());
+  EXPECT_TRUE(*slice == "orld");
+
+  EXPECT_THROW(memory_c::slice(slice, 2, 3), bool);
+}
+
+TEST(Memory, SliceOfSlice) {
+  auto backing = memory_c::clone("hello world");
+  auto slice1  = memory_c::slice(backing, 2, 8);
+  auto slice2  = memory_c::slice(slice1, 4, 3);
+
+  EXPECT_TRUE(*slice2 == "wor");
+
+  slice1.reset();
+  backing.reset();
+
+  EXPECT_TRUE(*slice2 == "wor");
+}
+
+TEST(Memory, CopiesReleasedInSeveralThreads) {
+  auto backing = memory_c::clone("hello world");
+  auto slice   = memory_c::slice(backing, 6, 5);
+  backing.reset();
+
+  std::vector<std::thread> threads;
+
+  for (auto idx = 0; idx < 4; ++idx)
+    threads.emplace_back([&slice]() {
+      for (auto copy_idx = 0; copy_idx < 10000; ++copy_idx) {
+        memory_c copy{*slice};
+        EXPECT_EQ(0, std::memcmp(copy.get_buffer(), "world", 5));
+      }
+    });
+
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_TRUE(slice->is_unique());
+  EXPECT_TRUE(*slice == "world");
+}
+
+TEST(Memory, SliceResize) {
+  auto backing = memory_c::clone("hello world");
+  auto slice   = memory_c::slice(backing, 0, 5);
+
+  slice->resize(7);
+  EXPECT_FALSE(slice->is_slice());
+  EXPECT_NE(backing->get_buffer(), slice->get_buffer());
+  EXPECT_EQ(0, std::memcmp(slice->get_buffer(), "hello", 5));
+  EXPECT_TRUE(*backing == "hello world");
+}
+
+TEST(Memory, SliceOfUnownedBufferIsCopiedOnGrab) {
+  unsigned char buffer[] = "hello world";
+  auto backing           = std::make_shared<memory_c>(buffer, 11, false);
+  auto slice             = memory_c::slice(backing, 6, 5);
+
+  slice->grab();
+  EXPECT_FALSE(slice->is_slice());
+  EXPECT_NE(buffer + 6, slice->get_buffer());
+  EXPECT_TRUE(*slice == "world");
+}
+
+TEST(Memory, SliceOfTakenOverBufferIsNotCopiedOnGrab) {
+  auto buffer   = static_cast<unsigned char *>(malloc(11));
+  auto released = false;
+
+  std::memcpy(buffer, "hello world", 11);
+
+  auto backing = memory_c::take_ownership(buffer, 11, [buffer, &released]() {
+    free(buffer);
+    released = true;
+  });
+  auto slice   = memory_c::slice(backing, 6, 5);
+
+  slice->grab();
+  EXPECT_TRUE(slice->is_slice());
+  EXPECT_EQ(buffer + 6, slice->get_buffer());
+
+  backing.reset();
+  EXPECT_FALSE(released);
+  EXPECT_TRUE(*slice == "world");
+
+  slice.reset();
+  EXPECT_TRUE(released);
+}
+
+TEST(Memory, UnlaceXiphReturnsSlices) {
+  auto laced  = lace_memory_xiph({ memory_c::clone("abc"), memory_c::clone("defgh") });
+  auto blocks = unlace_memory_xiph(laced);
+
+  ASSERT_EQ(2u, blocks.size());
+  EXPECT_TRUE(blocks[0]->is_slice());
+  EXPECT_TRUE(*blocks[0] == "abc");
+  EXPECT_TRUE(*blocks[1] == "defgh");
+
+  laced.reset();
+  EXPECT_TRUE(*blocks[1] == "defgh");
+}
+
 }
@@ -4,6 +4,9 @@
 #include "tests/unit/util.h"
 
 #include "common/mm_io_x.h"
+#include "common/mm_mmap_io.h"
+#include "common/mm_read_buffer_io.h"
+#include "common/mm_write_buffer_io.h"
 
 namespace {
 
@@ -16,4 +19,94 @@ TEST(MmIo, Slurp) {
   ASSERT_THROW(mm_file_io_c::slurp("doesnotexist"), mtx::mm_io::exception);
 }
 
+TEST(MmIo, AsyncWriteBuffer) {
+  std::string expected;
+  for (auto idx = 0; idx < 1000; ++idx)
+    expected += (boost::format("line %1%\n") % idx).str();
+
+  mm_mem_io_c mem{nullptr, 0, 1024};
+  auto out = std::make_shared<mm_async_write_buffer_io_c>(&mem, 64, 2, false);
+
+  out->write(expected.substr(0, 5000));
+  EXPECT_EQ(5000u, out->getFilePointer());
+  EXPECT_EQ(5000,  out->get_size());
+
+  // Overwrite something that's likely still pending.
+  out->setFilePointer(4990);
+  out->write(std::string(10, 'x'));
+
+  // Reading must see everything written so far.
+  std::string read_back;
+  out->setFilePointer(4980);
+  EXPECT_EQ(20u, out->read(read_back, 20));
+  EXPECT_EQ(expected.substr(4980, 10) + std::string(10, 'x'), read_back);
+
+  out->setFilePointer(4990);
+  out->write(expected.substr(4990));
+  EXPECT_EQ(static_cast<int64_t>(expected.size()), out->get_size());
+
+  out->flush();
+  EXPECT_EQ(expected, mem.get_content());
+
+  ASSERT_NO_THROW(out->close());
+}
+
+TEST(MmIo, ReadAheadBuffer) {
+  std::string content;
+  for (auto idx = 0; idx < 1000; ++idx)
+    content += (boost::format("line %1%\n") % idx).str();
+
+  mm_mem_io_c mem{reinterpret_cast<unsigned char const *>(content.c_str()), content.size()};
+  auto in = std::make_shared<mm_read_ahead_buffer_io_c>(&mem, 64, 4, false);
+
+  std::string read_back;
+  EXPECT_EQ(100u, in->read(read_back, 100));
+  EXPECT_EQ(content.substr(0, 100), read_back);
+  EXPECT_EQ(100u, in->getFilePointer());
+
+  // Seeking far ahead restarts reading ahead at the new position.
+  in->setFilePointer(5000);
+  EXPECT_EQ(300u, in->read(read_back, 300));
+  EXPECT_EQ(content.substr(5000, 300), read_back);
+
+  // Seeking back into data that has already been read.
+  in->setFilePointer(4990);
+  EXPECT_EQ(20u, in->read(read_back, 20));
+  EXPECT_EQ(content.substr(4990, 20), read_back);
+
+  in->setFilePointer(content.size() - 10);
+  EXPECT_EQ(10u, in->read(read_back, 20));
+  EXPECT_EQ(content.substr(content.size() - 10), read_back);
+  EXPECT_TRUE(in->eof());
+
+  ASSERT_NO_THROW(in->close());
+}
+
+TEST(MmIo, Mmap) {
+  auto in = mm_mmap_io_c::open("tests/unit/data/text/chunky_bacon.txt");
+  if (!in)
+    return;                     // not supported on this platform
+
+  EXPECT_EQ(13, in->get_size());
+
+  std::string read_back;
+  EXPECT_EQ(6u, in->read(read_back, 6));
+  EXPECT_EQ(std::string{"Chunky"}, read_back);
+
+  in->skip(1);
+  auto slice = in->read_slice(5);
+  EXPECT_TRUE(slice->is_slice());
+  EXPECT_EQ(std::string{"Bacon"}, slice->to_string());
+  EXPECT_EQ(12u, in->getFilePointer());
+
+  EXPECT_THROW(in->read_slice(2), mtx::mm_io::end_of_file_x);
+
+  // The mapping outlives the file as long as slices of it exist.
+  in->close();
+  in.reset();
+  EXPECT_EQ(std::string{"Bacon"}, slice->to_string());
+
+  EXPECT_FALSE(!!mm_mmap_io_c::open("doesnotexist"));
+}
+
 }
@@ -0,0 +1,152 @@
+#include "common/common_pch.h"
+
+#include <random>
+
+#include "common/cpu_features.h"
+#include "common/mpeg.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+std::size_t
+naive_find(std::vector<unsigned char> const &data,
+           std::vector<unsigned char> const &pattern,
+           std::size_t start) {
+  for (auto pos = start; (pos + pattern.size()) <= data.size(); ++pos)
+    if (std::equal(pattern.begin(), pattern.end(), data.begin() + pos))
+      return pos;
+
+  return data.size();
+}
+
+std::vector<unsigned char>
+random_data(std::mt19937 &rng,
+            std::size_t size) {
+  std::vector<unsigned char> data(size);
+
+  // Lots of zeros and ones in order to produce many (partial) start
+  // codes.
+  for (auto &byte : data) {
+    auto value = rng() % 8;
+    byte       = value < 4 ? 0x00 : value < 6 ? 0x01 : static_cast<unsigned char>(rng());
+  }
+
+  return data;
+}
+
+void
+compare_with_naive_search() {
+  std::mt19937 rng{42};
+  auto const start_code = std::vector<unsigned char>{ 0x00, 0x00, 0x01 };
+  auto const marker     = std::vector<unsigned char>{ 0x00, 0x00, 0x01, 0xb6 };
+
+  for (auto round = 0; round < 200; ++round) {
+    auto data = random_data(rng, rng() % 300);
+    auto end  = data.data() + data.size();
+
+    for (auto start = 0u; start <= data.size(); ++start) {
+      ASSERT_EQ(naive_find(data, start_code, start), static_cast<std::size_t>(mtx::mpeg::find_start_code(data.data() + start, end) - data.data()));
+      ASSERT_EQ(naive_find(data, marker,     start), static_cast<std::size_t>(mtx::mpeg::find_marker(data.data() + start, end, 0x000001b6) - data.data()));
+    }
+  }
+}
+
+// Builds a frame of NALUs with random content and size fields of
+// 'length' bytes.
+std::vector<unsigned char>
+make_frame(std::mt19937 &rng,
+           std::vector<std::size_t> const &nalu_sizes,
+           std::size_t length) {
+  std::vector<unsigned char> frame;
+
+  for (auto nalu_size : nalu_sizes) {
+    for (auto shift = length; shift > 0; --shift)
+      frame.push_back((nalu_size >> ((shift - 1) * 8)) & 0xff);
+
+    for (auto idx = 0u; idx < nalu_size; ++idx)
+      frame.push_back(rng() & 0xff);
+  }
+
+  return frame;
+}
+
+std::vector<unsigned char>
+change_nalu_size_length(std::vector<unsigned char> const &frame,
+                        std::size_t src_length,
+                        std::size_t dst_length) {
+  auto data = memory_c::clone(frame.data(), frame.size());
+  mtx::mpeg::change_nalu_size_length(data, src_length, dst_length);
+
+  return { data->get_buffer(), data->get_buffer() + data->get_size() };
+}
+
+TEST(Mpeg, FindStartCode) {
+  unsigned char const data[] = { 0x12, 0x00, 0x00, 0x00, 0x01, 0x67, 0x00, 0x00, 0x01 };
+
+  EXPECT_EQ(&data[2], mtx::mpeg::find_start_code(&data[0], &data[9]));
+  EXPECT_EQ(&data[6], mtx::mpeg::find_start_code(&data[3], &data[9]));
+  EXPECT_EQ(&data[8], mtx::mpeg::find_start_code(&data[3], &data[8]));
+  EXPECT_EQ(&data[0], mtx::mpeg::find_start_code(&data[0], &data[0]));
+  EXPECT_EQ(&data[9], mtx::mpeg::find_marker(&data[0], &data[9], 0x42424344));
+  EXPECT_EQ(&data[1], mtx::mpeg::find_marker(&data[0], &data[9], 0x00000001));
+}
+
+TEST(Mpeg, FindStartCodeMatchesNaiveSearch) {
+  compare_with_naive_search();
+}
+
+TEST(Mpeg, FindStartCodeWithoutSIMDMatchesNaiveSearch) {
+  mtx::cpu::disable_simd(true);
+  compare_with_naive_search();
+  mtx::cpu::disable_simd(false);
+}
+
+TEST(Mpeg, ChangeNaluSizeLength) {
+  std::mt19937 rng{42};
+
+  for (auto round = 0; round < 100; ++round) {
+    auto nalu_sizes = std::vector<std::size_t>(rng() % 10);
+    for (auto &nalu_size : nalu_sizes)
+      nalu_size = rng() % 256;
+
+    for (auto src_length : std::vector<std::size_t>{ 1, 2, 4 }) {
+      for (auto dst_length : std::vector<std::size_t>{ 1, 2, 3, 4 }) {
+        std::mt19937 same_content{static_cast<std::mt19937::result_type>(round)};
+        auto src = make_frame(same_content, nalu_sizes, src_length);
+        same_content.seed(round);
+        auto expected = make_frame(same_content, nalu_sizes, dst_length);
+
+        EXPECT_EQ(expected, change_nalu_size_length(src, src_length, dst_length)) << "round " << round << " from " << src_length << " to " << dst_length;
+      }
+    }
+  }
+}
+
+TEST(Mpeg, ChangeNaluSizeLengthTruncatedData) {
+  // The second NALU claims more bytes than present; the trailing byte
+  // is too short for a size field.
+  auto frame = std::vector<unsigned char>{ 0x00, 0x00, 0x00, 0x02, 0x65, 0x66, 0x00, 0x00, 0x00, 0x09, 0x41, 0x42, 0x00 };
+
+  EXPECT_EQ((std::vector<unsigned char>{ 0x00, 0x02, 0x65, 0x66, 0x00, 0x03, 0x41, 0x42, 0x00 }), change_nalu_size_length(frame, 4, 2));
+  EXPECT_EQ((std::vector<unsigned char>{ 0x00, 0x00, 0x02, 0x65, 0x66 }),                         change_nalu_size_length({ 0x00, 0x02, 0x65, 0x66, 0x00 }, 2, 3));
+}
+
+TEST(Mpeg, ChangeNaluSizeLengthTooSmall) {
+  auto frame = std::vector<unsigned char>(4 + 0x10000);
+  frame[1]   = 0x01;
+  auto data  = memory_c::clone(frame.data(), frame.size());
+
+  try {
+    mtx::mpeg::change_nalu_size_length(data, 4, 2);
+    FAIL() << "no exception thrown";
+
+  } catch (mtx::mpeg::nalu_size_length_x &ex) {
+    EXPECT_EQ(3u, ex.get_required_length());
+  }
+
+  EXPECT_EQ(frame.size(), data->get_size());
+  EXPECT_EQ(0x01, data->get_buffer()[1]);
+}
+
+}
@@ -0,0 +1,174 @@
+#include "common/common_pch.h"
+
+#include <limits>
+
+#include "common/qt_index.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+void
+expect_entry_eq(qt_index_t const &expected,
+                qt_index_t const &actual) {
+  EXPECT_EQ(expected.file_pos,    actual.file_pos);
+  EXPECT_EQ(expected.size,        actual.size);
+  EXPECT_EQ(expected.timecode,    actual.timecode);
+  EXPECT_EQ(expected.duration,    actual.duration);
+  EXPECT_EQ(expected.is_keyframe, actual.is_keyframe);
+}
+
+std::vector<qt_index_t>
+create_entries(std::size_t num_entries) {
+  std::vector<qt_index_t> entries;
+  auto file_pos = int64_t{48};
+  auto timecode = int64_t{};
+
+  for (auto idx = 0u; idx < num_entries; ++idx) {
+    // Frames in decoding order with composition offsets, i.e. the
+    // timestamps aren't monotonic, and with a gap every now and then.
+    auto size     = static_cast<int64_t>(1000 + (idx * 7919) % 50000);
+    auto duration = int64_t{40000000} + (idx % 3);
+    auto offset   = (idx % 4) == 1 ? int64_t{80000000} : (idx % 4) == 2 ? int64_t{-40000000} : int64_t{};
+
+    entries.emplace_back(file_pos, size, timecode + offset, duration, !(idx % 12));
+
+    file_pos += size + ((idx % 10) == 9 ? 123456 : 0);
+    timecode += duration;
+  }
+
+  return entries;
+}
+
+TEST(QtIndex, EncodeDecode) {
+  auto entries = create_entries(1000);
+  qt_index_c index;
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  ASSERT_EQ(entries.size(), index.size());
+
+  for (auto idx = 0u; idx < entries.size(); ++idx)
+    expect_entry_eq(entries[idx], index[idx]);
+}
+
+TEST(QtIndex, ExtremeValues) {
+  qt_index_c index;
+  std::vector<qt_index_t> entries{
+    { 0,                                      0,                                     0,                                     0,                                     false },
+    { std::numeric_limits<int64_t>::max(),    std::numeric_limits<int64_t>::max(),   std::numeric_limits<int64_t>::min(),   std::numeric_limits<int64_t>::max(),   true  },
+    { 1,                                      -1,                                    std::numeric_limits<int64_t>::max(),   std::numeric_limits<int64_t>::min(),   false },
+    { std::numeric_limits<int64_t>::min(),    0,                                     -1,                                    1,                                     true  },
+  };
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  for (auto idx = 0u; idx < entries.size(); ++idx)
+    expect_entry_eq(entries[idx], index[idx]);
+}
+
+TEST(QtIndex, RandomAccessAcrossBlocks) {
+  auto entries = create_entries(qt_index_c::block_size * 5 + 3);
+  qt_index_c index;
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  // Jump back and forth between the blocks so that the cached block
+  // has to be replaced each time.
+  for (auto idx : std::vector<std::size_t>{ entries.size() - 1, 0, qt_index_c::block_size, qt_index_c::block_size - 1, 3 * qt_index_c::block_size + 17, 1, entries.size() - 1 })
+    expect_entry_eq(entries[idx], index[idx]);
+}
+
+TEST(QtIndex, PushBackInvalidatesCachedBlock) {
+  auto entries = create_entries(10);
+  qt_index_c index;
+
+  index.push_back(entries[0]);
+  expect_entry_eq(entries[0], index[0]);
+
+  for (auto idx = 1u; idx < entries.size(); ++idx) {
+    index.push_back(entries[idx]);
+    expect_entry_eq(entries[idx], index[idx]);
+  }
+}
+
+TEST(QtIndex, Cursor) {
+  auto entries = create_entries(qt_index_c::block_size * 3 + 5);
+  qt_index_c index;
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  index.adjust_timecodes(-1000);
+
+  auto cursor = index.cursor(qt_index_c::block_size - 2);
+
+  for (auto idx = qt_index_c::block_size - 2; idx < entries.size(); ++idx, ++cursor) {
+    ASSERT_FALSE(cursor.at_end());
+    EXPECT_EQ(idx, cursor.get_idx());
+
+    // Random access in between mustn't disturb the cursor and vice versa.
+    auto expected      = entries[idx];
+    expected.timecode -= 1000;
+
+    expect_entry_eq(expected, cursor.get());
+    expect_entry_eq(expected, index[idx]);
+    EXPECT_EQ(entries[0].timecode - 1000, index[0].timecode);
+  }
+
+  EXPECT_TRUE(cursor.at_end());
+}
+
+TEST(QtIndex, CursorSeesEntriesAddedLater) {
+  auto entries = create_entries(5);
+  qt_index_c index;
+
+  index.push_back(entries[0]);
+
+  auto cursor = index.cursor();
+  expect_entry_eq(entries[0], cursor.get());
+
+  for (auto idx = 1u; idx < entries.size(); ++idx) {
+    index.push_back(entries[idx]);
+    expect_entry_eq(entries[idx], (++cursor).get());
+  }
+}
+
+TEST(QtIndex, KeyFramesAndTimestampAdjustment) {
+  auto entries = create_entries(100);
+  qt_index_c index;
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  index.set_keyframe(5);
+  index.adjust_timecodes(-1000);
+
+  for (auto idx = 0u; idx < entries.size(); ++idx) {
+    auto entry = index[idx];
+    EXPECT_EQ(entries[idx].timecode - 1000, entry.timecode);
+    EXPECT_EQ(entries[idx].is_keyframe || (5 == idx), index.is_keyframe(idx));
+    EXPECT_EQ(index.is_keyframe(idx), entry.is_keyframe);
+  }
+
+  // Entries added after the adjustment are stored as they are.
+  index.push_back(qt_index_t{1, 2, 3, 4, true});
+  expect_entry_eq(qt_index_t{1, 2, 3, 4, true}, index[index.size() - 1]);
+}
+
+TEST(QtIndex, Compact) {
+  auto entries = create_entries(10000);
+  qt_index_c index;
+
+  for (auto const &entry : entries)
+    index.push_back(entry);
+
+  index.shrink_to_fit();
+
+  EXPECT_LT(index.get_memory_usage(), entries.size() * 16);
+}
+
+}
@@ -0,0 +1,50 @@
+#include "common/common_pch.h"
+
+#include <atomic>
+
+#include "common/thread_pool.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(ThreadPool, RunsAllJobs) {
+  std::atomic<int> sum{};
+  std::vector<std::future<void>> results;
+
+  {
+    mtx::thread_pool_c pool{4};
+
+    EXPECT_EQ(4u, pool.get_num_threads());
+
+    for (auto idx = 1; idx <= 1000; ++idx)
+      results.emplace_back(pool.submit([&sum, idx]() { sum += idx; }));
+
+    for (auto &result : results)
+      result.get();
+
+    EXPECT_EQ(500500, sum);
+
+    // Jobs still queued are run on destruction.
+    for (auto idx = 1; idx <= 100; ++idx)
+      pool.submit([&sum]() { ++sum; });
+  }
+
+  EXPECT_EQ(500600, sum);
+}
+
+TEST(ThreadPool, PropagatesExceptions) {
+  mtx::thread_pool_c pool{2};
+
+  auto failed    = pool.submit([]() { throw std::runtime_error{"failed"}; });
+  auto succeeded = pool.submit([]() { });
+
+  EXPECT_THROW(failed.get(), std::runtime_error);
+  EXPECT_NO_THROW(succeeded.get());
+}
+
+TEST(ThreadPool, DefaultSize) {
+  EXPECT_LE(1u, mtx::thread_pool_c::global().get_num_threads());
+}
+
+}
@@ -0,0 +1,115 @@
+#include "common/common_pch.h"
+
+#include "common/id_info.h"
+#include "common/mm_io.h"
+#include "merge/id_cache.h"
+
+#include "gtest/gtest.h"
+
+#if !defined(SYS_WINDOWS)
+
+namespace {
+
+class IdCache: public ::testing::Test {
+protected:
+  bfs::path m_dir, m_file;
+  boost::optional<std::string> m_previous_cache_home;
+
+  virtual void SetUp() override {
+    m_dir  = bfs::temp_directory_path() / bfs::unique_path("mtx-id-cache-%%%%-%%%%-%%%%");
+    m_file = m_dir / "source.bin";
+
+    bfs::create_directories(m_dir);
+    write_source("first version");
+
+    auto cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home)
+      m_previous_cache_home.reset(cache_home);
+
+    setenv("XDG_CACHE_HOME", (m_dir / "cache").string().c_str(), 1);
+
+    mtx::id_cache::enable();
+  }
+
+  virtual void TearDown() override {
+    mtx::id_cache::disable();
+
+    if (m_previous_cache_home)
+      setenv("XDG_CACHE_HOME", m_previous_cache_home->c_str(), 1);
+    else
+      unsetenv("XDG_CACHE_HOME");
+
+    boost::system::error_code ec;
+    bfs::remove_all(m_dir, ec);
+  }
+
+  void write_source(std::string const &content) {
+    mm_file_io_c out{m_file.string(), MODE_CREATE};
+    out.write(content);
+  }
+
+  mtx::id_cache::entry_t make_entry(nlohmann::json const &properties = nlohmann::json::object()) {
+    auto entry           = mtx::id_cache::entry_t{};
+    entry.type           = FILE_TYPE_MATROSKA;
+    entry.identification = nlohmann::json{
+      { "container", {
+          { "recognized", true       },
+          { "properties", properties },
+        } },
+    };
+    entry.warnings.push_back("some warning");
+
+    return entry;
+  }
+};
+
+TEST_F(IdCache, StoreAndFetch) {
+  auto entry = make_entry();
+  mtx::id_cache::store(m_file.string(), "options", entry);
+
+  auto fetched = mtx::id_cache::fetch(m_file.string(), "options");
+  ASSERT_TRUE(!!fetched);
+  EXPECT_EQ(FILE_TYPE_MATROSKA, fetched->type);
+  EXPECT_EQ(entry.identification, fetched->identification);
+  EXPECT_EQ(entry.warnings, fetched->warnings);
+}
+
+TEST_F(IdCache, DisabledCacheIsNeitherUsedNorUpdated) {
+  mtx::id_cache::store(m_file.string(), "options", make_entry());
+
+  mtx::id_cache::disable();
+  EXPECT_FALSE(mtx::id_cache::is_enabled());
+  EXPECT_FALSE(!!mtx::id_cache::fetch(m_file.string(), "options"));
+
+  mtx::id_cache::store(m_file.string(), "other options", make_entry());
+
+  mtx::id_cache::enable();
+  EXPECT_TRUE(!!mtx::id_cache::fetch(m_file.string(), "options"));
+  EXPECT_FALSE(!!mtx::id_cache::fetch(m_file.string(), "other options"));
+}
+
+TEST_F(IdCache, DifferentOptionsDontMatch) {
+  mtx::id_cache::store(m_file.string(), "hacks:1", make_entry());
+
+  EXPECT_FALSE(!!mtx::id_cache::fetch(m_file.string(), "hacks:"));
+  EXPECT_TRUE(!!mtx::id_cache::fetch(m_file.string(), "hacks:1"));
+}
+
+TEST_F(IdCache, ChangedFileInvalidatesEntry) {
+  mtx::id_cache::store(m_file.string(), "options", make_entry());
+
+  // Same size, possibly even the same modification time.
+  write_source("other version");
+
+  EXPECT_FALSE(!!mtx::id_cache::fetch(m_file.string(), "options"));
+}
+
+TEST_F(IdCache, EntriesReferringToOtherFilesAreNotStored) {
+  mtx::id_cache::store(m_file.string(), "options", make_entry({ { mtx::id::playlist, true } }));
+
+  EXPECT_FALSE(!!mtx::id_cache::fetch(m_file.string(), "options"));
+}
+
+}
+
+#endif  // !SYS_WINDOWS
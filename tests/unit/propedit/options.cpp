@@ -0,0 +1,48 @@
+#include "common/common_pch.h"
+
+#include "propedit/options.h"
+#include "propedit/track_target.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(PropeditOptions, MultipleFileNames) {
+  options_c options;
+
+  options.set_file_name("a.mkv");
+  options.set_file_name("b.mkv");
+
+  EXPECT_EQ("a.mkv", options.m_file_name);
+  ASSERT_EQ(2u, options.m_file_names.size());
+  EXPECT_EQ("b.mkv", options.m_file_names[1]);
+}
+
+TEST(PropeditOptions, CloneForFile) {
+  options_c options;
+
+  options.set_file_name("a.mkv");
+  options.set_file_name("b.mkv");
+
+  auto target = options.add_track_or_segmentinfo_target("track:v1");
+  target->add_change(change_c::ct_set, "language=ger");
+
+  auto clone = options.clone_for_file("b.mkv");
+
+  EXPECT_EQ("b.mkv", clone->m_file_name);
+  ASSERT_EQ(1u, clone->m_file_names.size());
+  ASSERT_EQ(1u, clone->m_targets.size());
+
+  auto &original_track = dynamic_cast<track_target_c &>(*target);
+  auto &cloned_track   = dynamic_cast<track_target_c &>(*clone->m_targets[0]);
+
+  EXPECT_NE(&original_track, &cloned_track);
+  EXPECT_TRUE(original_track == cloned_track);
+
+  ASSERT_EQ(1u, cloned_track.m_changes.size());
+  EXPECT_NE(original_track.m_changes[0].get(), cloned_track.m_changes[0].get());
+  EXPECT_EQ("language", cloned_track.m_changes[0]->m_name);
+  EXPECT_EQ("ger",      cloned_track.m_changes[0]->m_value);
+}
+
+}